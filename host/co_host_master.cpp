@@ -0,0 +1,1307 @@
+//====================================================================================================================//
+// File:          co_host_master.cpp                                                                                  //
+// Description:   Host stand-in for the CANopen master library                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "canopen_master.h"
+#include "qco_event.hpp"
+
+#include <errno.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  HOST_VERSION_STRING        "CANopen master host stand-in 1.0"
+
+#define  HOST_TMR_PERIOD_DEFAULT    ((uint32_t)   1000)        // period of ComMgrNetTimerEvent() in [us]
+#define  HOST_SDO_TIMEOUT_DEFAULT   ((uint16_t)   1000)        // SDO timeout in [ms]
+#define  HOST_DETECT_TIME           ((uint32_t) 500000)        // duration of master detection in [us]
+
+#define  HOST_SDO_ABORT_TIMEOUT     ((uint32_t) 0x05040000)    // abort code: SDO protocol timed out
+#define  HOST_SDO_ABORT_COMMAND     ((uint32_t) 0x05040001)    // abort code: command specifier not valid
+
+
+//-------------------------------------------------------------------------------------------------------
+// state of an SDO client transfer
+//
+enum HostSdoState_e {
+   eHOST_SDO_IDLE = 0,
+   eHOST_SDO_UPLOAD,
+   eHOST_SDO_SEGMENT,
+   eHOST_SDO_DOWNLOAD
+};
+
+
+//-------------------------------------------------------------------------------------------------------
+// single step of a node service, optional objects may be missing on the device
+//
+typedef struct HostSdoStep_s {
+   uint16_t    uwIndex;
+   uint8_t     ubSubIndex;
+   bool        btOptional;
+} HostSdoStep_ts;
+
+
+static const HostSdoStep_ts   atsGetInfoStepsS[] = {
+   { 0x1000, 0, false },
+   { 0x1001, 0, false },
+   { 0x1008, 0, true  },
+   { 0x1018, 1, false },
+   { 0x1018, 2, true  },
+   { 0x1018, 3, true  },
+   { 0x1018, 4, true  }
+};
+
+static const HostSdoStep_ts   atsSetHbStepsS[] = {
+   { 0x1017, 0, false }
+};
+
+
+//-------------------------------------------------------------------------------------------------------
+// SDO client transfer of a node service
+//
+typedef struct HostSdo_s {
+   uint8_t                 ubState;
+   uint8_t                 ubToggle;
+   uint8_t                 ubStepCnt;
+   uint8_t                 ubStep;
+   const HostSdoStep_ts *  ptsSteps;
+   uint16_t                uwTimeout;
+   uint16_t                uwValue;
+   uint32_t                ulCount;
+   uint64_t                uqDeadline;
+   CoObject_ts             tsObject;
+   uint32_t                ulAbort;
+} HostSdo_ts;
+
+
+//-------------------------------------------------------------------------------------------------------
+// state of a remote node
+//
+typedef struct HostNode_s {
+   ComNode_ts *   ptsNode;
+   uint8_t        ubHbState;
+   bool           btHbActive;
+   uint16_t       uwHbConsTime;
+   uint64_t       uqHbDeadline;
+   uint8_t        aubEmcy[8];
+   HostSdo_ts     tsSdo;
+} HostNode_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoHostNet
+** \brief   CANopen network of the host stand-in
+**
+** All times are derived from the number of calls of ComMgrNetTimerEvent(), so the behaviour of
+** the stand-in is deterministic for a given sequence of received frames.
+*/
+class CoHostNet {
+
+public:
+   CoHostNet();
+
+   ComStatus_tv   init(uint8_t ubNetV, uint8_t ubCanIfV, uint8_t ubNodeIdV);
+
+   void           release(void);
+
+   bool           isValid(void) const  { return (slSocketP >= 0); }
+
+   HostNode_ts *  node(uint8_t ubNodeIdV);
+
+   void           process(void);
+
+   void           timerEvent(uint32_t ulPeriodV);
+
+   void           start(void);
+
+   void           startDetection(void);
+
+   ComStatus_tv   startSdo(uint8_t ubNodeIdV, uint8_t ubMarkerV, const HostSdoStep_ts * ptsStepsV,
+                           uint8_t ubStepCntV, uint16_t uwValueV);
+
+   void           transmit(uint32_t ulCobIdV, uint8_t ubDlcV, const uint8_t * pubDataV);
+
+   uint32_t       ulSyncCycleP;
+   bool           btSyncEnableP;
+   uint16_t       uwHbProdTimeP;
+
+private:
+   void           busError(const struct can_frame & tsFrameR);
+
+   void           finishSdo(uint8_t ubNodeIdV, uint32_t ulAbortV);
+
+   void           heartbeatReceived(uint8_t ubNodeIdV, uint8_t ubStateV);
+
+   void           nextSdoStep(uint8_t ubNodeIdV);
+
+   void           sdoReceived(uint8_t ubNodeIdV, const struct can_frame & tsFrameR);
+
+   void           storeValue(HostNode_ts * ptsNodeV, uint32_t ulValueV);
+
+   int32_t        slSocketP;
+   uint8_t        ubNetP;
+   uint8_t        ubNodeIdP;
+   bool           btStartedP;
+
+   bool           btDetectP;
+   uint64_t       uqDetectEndP;
+
+   uint64_t       uqTimeP;
+   uint64_t       uqSyncNextP;
+   uint64_t       uqHbProdNextP;
+
+   CpState_ts     tsBusStateP;
+
+   HostNode_ts    atsNodeP[COM_NODE_ID_MAX];
+};
+
+
+static CoHostNet  aclHostNetS[COM_NET_MAX];
+static uint32_t   ulTmrPeriodS = HOST_TMR_PERIOD_DEFAULT;
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static CoHostNet *   hostNet(uint8_t ubNetV);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// hostNet()                                                                                                          //
+// return the network for the given number, nullptr if the network is not initialised                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+static CoHostNet * hostNet(uint8_t ubNetV)
+{
+   if ((ubNetV < eCOM_NET_1) || (ubNetV > COM_NET_MAX))
+   {
+      return (nullptr);
+   }
+
+   CoHostNet * pclNetT = &aclHostNetS[ubNetV - eCOM_NET_1];
+   if (!pclNetT->isValid())
+   {
+      return (nullptr);
+   }
+
+   return (pclNetT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::CoHostNet()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoHostNet::CoHostNet()
+{
+   slSocketP = -1;
+   release();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::busError()                                                                                              //
+// evaluate an error frame of the SocketCAN driver                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::busError(const struct can_frame & tsFrameR)
+{
+   uint8_t  ubStateT = tsBusStateP.ubCanErrState;
+
+   if (tsFrameR.can_id & CAN_ERR_BUSOFF)
+   {
+      ubStateT = eCP_STATE_BUS_OFF;
+   }
+   else if (tsFrameR.can_id & CAN_ERR_CRTL)
+   {
+      if (tsFrameR.data[1] & (CAN_ERR_CRTL_RX_PASSIVE | CAN_ERR_CRTL_TX_PASSIVE))
+      {
+         ubStateT = eCP_STATE_BUS_PASSIVE;
+      }
+      else if (tsFrameR.data[1] & (CAN_ERR_CRTL_RX_WARNING | CAN_ERR_CRTL_TX_WARNING))
+      {
+         ubStateT = eCP_STATE_BUS_WARN;
+      }
+#ifdef CAN_ERR_CRTL_ACTIVE
+      else if (tsFrameR.data[1] & CAN_ERR_CRTL_ACTIVE)
+      {
+         ubStateT = eCP_STATE_BUS_ACTIVE;
+      }
+#endif
+   }
+   else if (tsFrameR.can_id & CAN_ERR_RESTARTED)
+   {
+      ubStateT = eCP_STATE_BUS_ACTIVE;
+   }
+
+   tsBusStateP.ubCanTrmErrCnt = tsFrameR.data[6];
+   tsBusStateP.ubCanRcvErrCnt = tsFrameR.data[7];
+
+   if (ubStateT != tsBusStateP.ubCanErrState)
+   {
+      tsBusStateP.ubCanErrState = ubStateT;
+      emit QCoEvent::instance()->comMgrEventBus(ubNetP, &tsBusStateP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::finishSdo()                                                                                             //
+// report the end of a node service                                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::finishSdo(uint8_t ubNodeIdV, uint32_t ulAbortV)
+{
+   HostSdo_ts * ptsSdoT = &atsNodeP[ubNodeIdV - 1].tsSdo;
+
+   ptsSdoT->ubState = eHOST_SDO_IDLE;
+   ptsSdoT->ulAbort = ulAbortV;
+   emit QCoEvent::instance()->comSdoEventObjectReady(ubNetP, ubNodeIdV, &ptsSdoT->tsObject, &ptsSdoT->ulAbort);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::heartbeatReceived()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::heartbeatReceived(uint8_t ubNodeIdV, uint8_t ubStateV)
+{
+   HostNode_ts * ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+
+   //---------------------------------------------------------------------------------------------------
+   // the heartbeat consumer is started by the first heartbeat after the consumer time is set
+   //
+   if (ptsNodeT->uwHbConsTime > 0)
+   {
+      ptsNodeT->btHbActive   = true;
+      ptsNodeT->uqHbDeadline = uqTimeP + (((uint64_t) ptsNodeT->uwHbConsTime) * 1000);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a boot-up message is reported always, other states only on a change
+   //
+   if ((ubStateV == eCOM_NMT_STATE_BOOTUP) || (ubStateV != ptsNodeT->ubHbState))
+   {
+      ptsNodeT->ubHbState = ubStateV;
+      emit QCoEvent::instance()->comNmtEventStateChange(ubNetP, ubNodeIdV, ubStateV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::init()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv CoHostNet::init(uint8_t ubNetV, uint8_t ubCanIfV, uint8_t ubNodeIdV)
+{
+   struct ifreq         tsIfReqT;
+   struct sockaddr_can  tsAddrT;
+   can_err_mask_t       ulErrMaskT = CAN_ERR_CRTL | CAN_ERR_BUSOFF | CAN_ERR_RESTARTED;
+
+   release();
+
+   slSocketP = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+   if (slSocketP < 0)
+   {
+      return (eCOM_ERR_CHANNEL);
+   }
+
+   memset(&tsIfReqT, 0, sizeof(tsIfReqT));
+   snprintf(tsIfReqT.ifr_name, IFNAMSIZ, "can%d", ubCanIfV);
+
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.can_family = AF_CAN;
+
+   if ((ioctl(slSocketP, SIOCGIFINDEX, &tsIfReqT) < 0) ||
+       (setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &ulErrMaskT, sizeof(ulErrMaskT)) < 0))
+   {
+      release();
+      return (eCOM_ERR_CHANNEL);
+   }
+
+   tsAddrT.can_ifindex = tsIfReqT.ifr_ifindex;
+   if (bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0)
+   {
+      release();
+      return (eCOM_ERR_CHANNEL);
+   }
+
+   ubNetP    = ubNetV;
+   ubNodeIdP = ubNodeIdV;
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::nextSdoStep()                                                                                           //
+// start the next SDO transfer of a node service or report the end of the service                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::nextSdoStep(uint8_t ubNodeIdV)
+{
+   HostSdo_ts *   ptsSdoT = &atsNodeP[ubNodeIdV - 1].tsSdo;
+   uint8_t        aubDataT[8];
+
+   if (ptsSdoT->ubStep >= ptsSdoT->ubStepCnt)
+   {
+      finishSdo(ubNodeIdV, 0);
+      return;
+   }
+
+   const HostSdoStep_ts * ptsStepT = &ptsSdoT->ptsSteps[ptsSdoT->ubStep];
+
+   ptsSdoT->tsObject.uwIndex    = ptsStepT->uwIndex;
+   ptsSdoT->tsObject.ubSubIndex = ptsStepT->ubSubIndex;
+   ptsSdoT->ulCount             = 0;
+   ptsSdoT->ubToggle            = 0;
+   ptsSdoT->uqDeadline          = uqTimeP + (((uint64_t) ptsSdoT->uwTimeout) * 1000);
+
+   memset(&aubDataT[0], 0, sizeof(aubDataT));
+   aubDataT[1] = (uint8_t) (ptsStepT->uwIndex);
+   aubDataT[2] = (uint8_t) (ptsStepT->uwIndex >> 8);
+   aubDataT[3] = ptsStepT->ubSubIndex;
+
+   if (ptsSdoT->tsObject.ubMarker == eCOM_SDO_MARKER_NODE_SET_HEARTBEAT)
+   {
+      //-------------------------------------------------------------------------------------------
+      // expedited download of two bytes
+      //
+      aubDataT[0] = 0x2B;
+      aubDataT[4] = (uint8_t) (ptsSdoT->uwValue);
+      aubDataT[5] = (uint8_t) (ptsSdoT->uwValue >> 8);
+      ptsSdoT->ubState = eHOST_SDO_DOWNLOAD;
+   }
+   else
+   {
+      aubDataT[0] = 0x40;
+      ptsSdoT->ubState = eHOST_SDO_UPLOAD;
+   }
+
+   transmit(0x600 + ubNodeIdV, 8, &aubDataT[0]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::node()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+HostNode_ts * CoHostNet::node(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV < 1) || (ubNodeIdV > COM_NODE_ID_MAX))
+   {
+      return (nullptr);
+   }
+
+   return (&atsNodeP[ubNodeIdV - 1]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::process()                                                                                               //
+// read all pending frames from the socket                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::process(void)
+{
+   struct can_frame  tsFrameT;
+
+   while (read(slSocketP, &tsFrameT, sizeof(tsFrameT)) == (ssize_t) sizeof(tsFrameT))
+   {
+      if (tsFrameT.can_id & CAN_ERR_FLAG)
+      {
+         busError(tsFrameT);
+         continue;
+      }
+
+      if (tsFrameT.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG))
+      {
+         continue;
+      }
+
+      uint32_t ulCobIdT  = tsFrameT.can_id & CAN_SFF_MASK;
+      uint8_t  ubNodeIdT = (uint8_t) (ulCobIdT & 0x7F);
+
+      if (ulCobIdT == 0x000)
+      {
+         //-----------------------------------------------------------------------------------
+         // NMT command of another master
+         //
+         if (btDetectP)
+         {
+            btDetectP = false;
+            emit QCoEvent::instance()->comNmtEventMasterDetection(ubNetP, eCOM_NMT_DETECT_ACTIVE_MASTER);
+         }
+         continue;
+      }
+
+      if (ubNodeIdT == 0)
+      {
+         continue;
+      }
+
+      switch (ulCobIdT & 0x780)
+      {
+         //-----------------------------------------------------------------------------------
+         // TPDO1 of the node, received by the master as RPDO with the number of the node
+         //
+         case 0x180:
+            emit QCoEvent::instance()->comPdoEventReceive(ubNetP, ubNodeIdT);
+            break;
+
+         case 0x080:
+            memset(&atsNodeP[ubNodeIdT - 1].aubEmcy[0], 0, 8);
+            memcpy(&atsNodeP[ubNodeIdT - 1].aubEmcy[0], &tsFrameT.data[0], tsFrameT.can_dlc);
+            emit QCoEvent::instance()->comEmcyConsEventReceive(ubNetP, ubNodeIdT);
+            break;
+
+         case 0x580:
+            sdoReceived(ubNodeIdT, tsFrameT);
+            break;
+
+         case 0x700:
+            if (tsFrameT.can_dlc > 0)
+            {
+               heartbeatReceived(ubNodeIdT, tsFrameT.data[0] & 0x7F);
+            }
+            break;
+
+         default:
+            break;
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::release()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::release(void)
+{
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+   }
+
+   slSocketP     = -1;
+   ubNetP        = 0;
+   ubNodeIdP     = 0;
+   btStartedP    = false;
+   ulSyncCycleP  = 0;
+   btSyncEnableP = false;
+   uwHbProdTimeP = 0;
+   btDetectP     = false;
+   uqDetectEndP  = 0;
+   uqTimeP       = 0;
+   uqSyncNextP   = 0;
+   uqHbProdNextP = 0;
+
+   memset(&tsBusStateP, 0, sizeof(tsBusStateP));
+   memset(&atsNodeP[0], 0, sizeof(atsNodeP));
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= COM_NODE_ID_MAX; ubNodeIdT++)
+   {
+      atsNodeP[ubNodeIdT - 1].ubHbState       = 0xFF;
+      atsNodeP[ubNodeIdT - 1].tsSdo.uwTimeout = HOST_SDO_TIMEOUT_DEFAULT;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::sdoReceived()                                                                                           //
+// evaluate the response of an SDO server                                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::sdoReceived(uint8_t ubNodeIdV, const struct can_frame & tsFrameR)
+{
+   HostNode_ts *  ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   HostSdo_ts *   ptsSdoT  = &ptsNodeT->tsSdo;
+   uint8_t        ubCmdT   = tsFrameR.data[0];
+   uint8_t        aubDataT[8];
+
+   if ((ptsSdoT->ubState == eHOST_SDO_IDLE) || (tsFrameR.can_dlc < 8))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // abort of the server, optional objects are skipped
+   //
+   if (ubCmdT == 0x80)
+   {
+      uint32_t ulAbortT = ((uint32_t) tsFrameR.data[4])         | (((uint32_t) tsFrameR.data[5]) << 8) |
+                          (((uint32_t) tsFrameR.data[6]) << 16) | (((uint32_t) tsFrameR.data[7]) << 24);
+
+      if (ptsSdoT->ptsSteps[ptsSdoT->ubStep].btOptional)
+      {
+         ptsSdoT->ubStep++;
+         nextSdoStep(ubNodeIdV);
+      }
+      else
+      {
+         finishSdo(ubNodeIdV, ulAbortT);
+      }
+      return;
+   }
+
+   memset(&aubDataT[0], 0, sizeof(aubDataT));
+
+   switch (ptsSdoT->ubState)
+   {
+      case eHOST_SDO_UPLOAD:
+         if ((ubCmdT & 0xE0) != 0x40)
+         {
+            break;
+         }
+
+         if (ubCmdT & 0x02)
+         {
+            //-----------------------------------------------------------------------------------
+            // expedited upload
+            //
+            uint8_t  ubSizeT  = (ubCmdT & 0x01) ? (4 - ((ubCmdT >> 2) & 0x03)) : 4;
+            uint32_t ulValueT = 0;
+
+            for (uint8_t ubByteT = 0; ubByteT < ubSizeT; ubByteT++)
+            {
+               ulValueT |= ((uint32_t) tsFrameR.data[4 + ubByteT]) << (8 * ubByteT);
+            }
+
+            if (ptsSdoT->tsObject.uwIndex == 0x1008)
+            {
+               for (uint8_t ubByteT = 0; ubByteT < ubSizeT; ubByteT++)
+               {
+                  storeValue(ptsNodeT, tsFrameR.data[4 + ubByteT]);
+               }
+            }
+            else
+            {
+               storeValue(ptsNodeT, ulValueT);
+            }
+
+            ptsSdoT->ubStep++;
+            nextSdoStep(ubNodeIdV);
+         }
+         else
+         {
+            //-----------------------------------------------------------------------------------
+            // segmented upload, request the first segment
+            //
+            ptsSdoT->ubState    = eHOST_SDO_SEGMENT;
+            ptsSdoT->uqDeadline = uqTimeP + (((uint64_t) ptsSdoT->uwTimeout) * 1000);
+            aubDataT[0] = 0x60;
+            transmit(0x600 + ubNodeIdV, 8, &aubDataT[0]);
+         }
+         return;
+
+      case eHOST_SDO_SEGMENT:
+      {
+         if (((ubCmdT & 0xE0) != 0x00) || (((ubCmdT >> 4) & 0x01) != ptsSdoT->ubToggle))
+         {
+            break;
+         }
+
+         uint8_t ubSizeT = 7 - ((ubCmdT >> 1) & 0x07);
+         for (uint8_t ubByteT = 0; ubByteT < ubSizeT; ubByteT++)
+         {
+            storeValue(ptsNodeT, tsFrameR.data[1 + ubByteT]);
+         }
+
+         if (ubCmdT & 0x01)
+         {
+            ptsSdoT->ubStep++;
+            nextSdoStep(ubNodeIdV);
+         }
+         else
+         {
+            ptsSdoT->ubToggle   ^= 1;
+            ptsSdoT->uqDeadline  = uqTimeP + (((uint64_t) ptsSdoT->uwTimeout) * 1000);
+            aubDataT[0] = 0x60 | (ptsSdoT->ubToggle << 4);
+            transmit(0x600 + ubNodeIdV, 8, &aubDataT[0]);
+         }
+         return;
+      }
+
+      case eHOST_SDO_DOWNLOAD:
+         if (ubCmdT != 0x60)
+         {
+            break;
+         }
+         ptsSdoT->ubStep++;
+         nextSdoStep(ubNodeIdV);
+         return;
+
+      default:
+         return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // unexpected response: abort the transfer
+   //
+   aubDataT[0] = 0x80;
+   aubDataT[1] = (uint8_t) (ptsSdoT->tsObject.uwIndex);
+   aubDataT[2] = (uint8_t) (ptsSdoT->tsObject.uwIndex >> 8);
+   aubDataT[3] = ptsSdoT->tsObject.ubSubIndex;
+   aubDataT[4] = (uint8_t) (HOST_SDO_ABORT_COMMAND);
+   aubDataT[5] = (uint8_t) (HOST_SDO_ABORT_COMMAND >> 8);
+   aubDataT[6] = (uint8_t) (HOST_SDO_ABORT_COMMAND >> 16);
+   aubDataT[7] = (uint8_t) (HOST_SDO_ABORT_COMMAND >> 24);
+   transmit(0x600 + ubNodeIdV, 8, &aubDataT[0]);
+   finishSdo(ubNodeIdV, HOST_SDO_ABORT_COMMAND);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::start()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::start(void)
+{
+   btStartedP = true;
+
+   tsBusStateP.ubCanErrState = eCP_STATE_BUS_ACTIVE;
+   emit QCoEvent::instance()->comMgrEventBus(ubNetP, &tsBusStateP);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::startDetection()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::startDetection(void)
+{
+   btDetectP    = true;
+   uqDetectEndP = uqTimeP + HOST_DETECT_TIME;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::startSdo()                                                                                              //
+// start a node service, i.e. a sequence of SDO transfers                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv CoHostNet::startSdo(uint8_t ubNodeIdV, uint8_t ubMarkerV, const HostSdoStep_ts * ptsStepsV,
+                                 uint8_t ubStepCntV, uint16_t uwValueV)
+{
+   HostNode_ts * ptsNodeT = node(ubNodeIdV);
+
+   if (ptsNodeT == nullptr)
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   if (ptsNodeT->tsSdo.ubState != eHOST_SDO_IDLE)
+   {
+      return (eCOM_ERR_SDO_BUSY);
+   }
+
+   if ((ubMarkerV == eCOM_SDO_MARKER_NODE_GET_INFO) && (ptsNodeT->ptsNode != nullptr))
+   {
+      ComNodeSetDefault(ptsNodeT->ptsNode);
+   }
+
+   ptsNodeT->tsSdo.tsObject.ubMarker = ubMarkerV;
+   ptsNodeT->tsSdo.ptsSteps          = ptsStepsV;
+   ptsNodeT->tsSdo.ubStepCnt         = ubStepCntV;
+   ptsNodeT->tsSdo.ubStep            = 0;
+   ptsNodeT->tsSdo.uwValue           = uwValueV;
+   nextSdoStep(ubNodeIdV);
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::storeValue()                                                                                            //
+// store an uploaded value in the node structure, the device name is stored byte by byte                              //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::storeValue(HostNode_ts * ptsNodeV, uint32_t ulValueV)
+{
+   ComNode_ts * ptsComNodeT = ptsNodeV->ptsNode;
+   HostSdo_ts * ptsSdoT     = &ptsNodeV->tsSdo;
+
+   if (ptsComNodeT == nullptr)
+   {
+      return;
+   }
+
+   switch (ptsSdoT->tsObject.uwIndex)
+   {
+      case 0x1000:
+         ptsComNodeT->ulIdx1000_DT = ulValueV;
+         break;
+
+      case 0x1001:
+         ptsComNodeT->ubIdx1001_ER = (uint8_t) ulValueV;
+         break;
+
+      case 0x1008:
+         if (ptsSdoT->ulCount < (sizeof(ptsComNodeT->aubIdx1008_DN) - 1))
+         {
+            ptsComNodeT->aubIdx1008_DN[ptsSdoT->ulCount] = (uint8_t) ulValueV;
+         }
+         ptsSdoT->ulCount++;
+         break;
+
+      case 0x1018:
+         if (ptsSdoT->tsObject.ubSubIndex == 1) ptsComNodeT->ulIdx1018_VI = ulValueV;
+         if (ptsSdoT->tsObject.ubSubIndex == 2) ptsComNodeT->ulIdx1018_PC = ulValueV;
+         if (ptsSdoT->tsObject.ubSubIndex == 3) ptsComNodeT->ulIdx1018_RN = ulValueV;
+         if (ptsSdoT->tsObject.ubSubIndex == 4) ptsComNodeT->ulIdx1018_SN = ulValueV;
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::timerEvent()                                                                                            //
+// advance the time of the network by one timer period                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::timerEvent(uint32_t ulPeriodV)
+{
+   uqTimeP += ulPeriodV;
+
+   if (!btStartedP)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // end of the master detection
+   //
+   if (btDetectP && (uqTimeP >= uqDetectEndP))
+   {
+      btDetectP = false;
+      emit QCoEvent::instance()->comNmtEventMasterDetection(ubNetP, eCOM_NMT_DETECT_TIMEOUT);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // SYNC producer, a late timer does not produce a burst of SYNC messages
+   //
+   if (btSyncEnableP && (ulSyncCycleP > 0) && (uqTimeP >= uqSyncNextP))
+   {
+      transmit(0x080, 0, nullptr);
+      uqSyncNextP += ulSyncCycleP;
+      if (uqSyncNextP <= uqTimeP)
+      {
+         uqSyncNextP = uqTimeP + ulSyncCycleP;
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat producer of the master, the master is always operational
+   //
+   if ((uwHbProdTimeP > 0) && (uqTimeP >= uqHbProdNextP))
+   {
+      uint8_t ubStateT = eCOM_NMT_STATE_OPERATIONAL;
+
+      transmit(0x700 + ubNodeIdP, 1, &ubStateT);
+      uqHbProdNextP = uqTimeP + (((uint64_t) uwHbProdTimeP) * 1000);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat consumer and SDO timeouts
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= COM_NODE_ID_MAX; ubNodeIdT++)
+   {
+      HostNode_ts * ptsNodeT = &atsNodeP[ubNodeIdT - 1];
+
+      if (ptsNodeT->btHbActive && (uqTimeP >= ptsNodeT->uqHbDeadline))
+      {
+         ptsNodeT->btHbActive = false;
+         ptsNodeT->ubHbState  = 0xFF;
+         emit QCoEvent::instance()->comNmtEventHeartbeat(ubNetP, ubNodeIdT);
+      }
+
+      HostSdo_ts * ptsSdoT = &ptsNodeT->tsSdo;
+      if ((ptsSdoT->ubState != eHOST_SDO_IDLE) && (uqTimeP >= ptsSdoT->uqDeadline))
+      {
+         uint8_t aubDataT[8] = { 0x80,
+                                 (uint8_t) (ptsSdoT->tsObject.uwIndex),
+                                 (uint8_t) (ptsSdoT->tsObject.uwIndex >> 8),
+                                 ptsSdoT->tsObject.ubSubIndex,
+                                 (uint8_t) (HOST_SDO_ABORT_TIMEOUT),
+                                 (uint8_t) (HOST_SDO_ABORT_TIMEOUT >> 8),
+                                 (uint8_t) (HOST_SDO_ABORT_TIMEOUT >> 16),
+                                 (uint8_t) (HOST_SDO_ABORT_TIMEOUT >> 24) };
+
+         transmit(0x600 + ubNodeIdT, 8, &aubDataT[0]);
+         ptsSdoT->ubState = eHOST_SDO_IDLE;
+         emit QCoEvent::instance()->comSdoEventTimeout(ubNetP, ubNodeIdT, ptsSdoT->tsObject.uwIndex,
+                                                       ptsSdoT->tsObject.ubSubIndex);
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoHostNet::transmit()                                                                                              //
+// transmit a frame, the frame is dropped if the transmit queue of the socket is full                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoHostNet::transmit(uint32_t ulCobIdV, uint8_t ubDlcV, const uint8_t * pubDataV)
+{
+   struct can_frame  tsFrameT;
+
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_id  = ulCobIdV;
+   tsFrameT.can_dlc = ubDlcV;
+   if (ubDlcV > 0)
+   {
+      memcpy(&tsFrameT.data[0], pubDataV, ubDlcV);
+   }
+
+   if (write(slSocketP, &tsFrameT, sizeof(tsFrameT)) != (ssize_t) sizeof(tsFrameT))
+   {
+      if (errno != EAGAIN)
+      {
+         perror("CANopen host stand-in");
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComEmcyConsGetData()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComEmcyConsGetData(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t * pubDataV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   HostNode_ts * ptsNodeT = pclNetT->node(ubNodeIdV);
+   if (ptsNodeT == nullptr)
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   memcpy(pubDataV, &ptsNodeT->aubEmcy[0], sizeof(ptsNodeT->aubEmcy));
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrGetVersionString()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+const char * ComMgrGetVersionString(uint8_t ubVersionV)
+{
+   Q_UNUSED(ubVersionV);
+
+   return (HOST_VERSION_STRING);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrInit()                                                                                                       //
+// the bitrate is set by the configuration of the SocketCAN interface, the mode is always NMT master                  //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrInit(uint8_t ubCanIfV, uint8_t ubNetV, uint8_t ubBitrateV, uint8_t ubNodeIdV, uint8_t ubModeV)
+{
+   ComStatus_tv   tvResultT;
+
+   Q_UNUSED(ubBitrateV);
+
+   if ((ubNetV < eCOM_NET_1) || (ubNetV > COM_NET_MAX))
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   if ((ubNodeIdV < 1) || (ubNodeIdV > COM_NODE_ID_MAX))
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   if (ubModeV != eCOM_MODE_NMT_MASTER)
+   {
+      return (eCOM_ERR_NOT_SUPPORTED);
+   }
+
+   tvResultT = aclHostNetS[ubNetV - eCOM_NET_1].init(ubNetV, ubCanIfV, ubNodeIdV);
+   if (tvResultT != eCOM_ERR_OK)
+   {
+      return (tvResultT);
+   }
+
+   return (ComMgrUserInit(ubNetV));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrNetTimerEvent()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrNetTimerEvent(uint8_t ubNetV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->timerEvent(ulTmrPeriodS);
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrNodeAdd()                                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrNodeAdd(uint8_t ubNetV, uint8_t ubNodeIdV, ComNode_ts * ptsNodeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   HostNode_ts * ptsNodeT = pclNetT->node(ubNodeIdV);
+   if (ptsNodeT == nullptr)
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   ptsNodeT->ptsNode = ptsNodeV;
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrProcess()                                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrProcess(uint8_t ubNetV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->process();
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrRelease()                                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrRelease(uint8_t ubNetV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->release();
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComMgrStart()                                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComMgrStart(uint8_t ubNetV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->start();
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNmtMasterDetection()                                                                                            //
+// the result is reported after HOST_DETECT_TIME, or earlier if an NMT command of another master is received          //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNmtMasterDetection(uint8_t ubNetV, uint8_t ubPriorityV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   Q_UNUSED(ubPriorityV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->startDetection();
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNmtSetHbConsTime()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNmtSetHbConsTime(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   HostNode_ts * ptsNodeT = pclNetT->node(ubNodeIdV);
+   if (ptsNodeT == nullptr)
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   ptsNodeT->uwHbConsTime = uwTimeV;
+   if (uwTimeV == 0)
+   {
+      ptsNodeT->btHbActive = false;
+   }
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNmtSetHbProdTime()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNmtSetHbProdTime(uint8_t ubNetV, uint16_t uwTimeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->uwHbProdTimeP = uwTimeV;
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNmtSetNodeState()                                                                                               //
+// transmit an NMT command, node-ID 0 addresses all nodes                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNmtSetNodeState(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubStateV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+   uint8_t     aubDataT[2];
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   if (ubNodeIdV > COM_NODE_ID_MAX)
+   {
+      return (eCOM_ERR_NODE_ID);
+   }
+
+   switch (ubStateV)
+   {
+      case eCOM_NMT_STATE_OPERATIONAL:    aubDataT[0] = 0x01;  break;
+      case eCOM_NMT_STATE_STOPPED:        aubDataT[0] = 0x02;  break;
+      case eCOM_NMT_STATE_PREOPERATIONAL: aubDataT[0] = 0x80;  break;
+      case eCOM_NMT_STATE_RESET_NODE:     aubDataT[0] = 0x81;  break;
+      case eCOM_NMT_STATE_RESET_COM:      aubDataT[0] = 0x82;  break;
+      default:
+         return (eCOM_ERR_NOT_SUPPORTED);
+   }
+
+   aubDataT[1] = ubNodeIdV;
+   pclNetT->transmit(0x000, 2, &aubDataT[0]);
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNodeGetInfo()                                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNodeGetInfo(uint8_t ubNetV, uint8_t ubNodeIdV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   return (pclNetT->startSdo(ubNodeIdV, eCOM_SDO_MARKER_NODE_GET_INFO, &atsGetInfoStepsS[0],
+                             sizeof(atsGetInfoStepsS) / sizeof(atsGetInfoStepsS[0]), 0));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNodeSetDefault()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void ComNodeSetDefault(ComNode_ts * ptsNodeV)
+{
+   if (ptsNodeV != nullptr)
+   {
+      memset(ptsNodeV, 0, sizeof(ComNode_ts));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComNodeSetHbProdTime()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComNodeSetHbProdTime(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   return (pclNetT->startSdo(ubNodeIdV, eCOM_SDO_MARKER_NODE_SET_HEARTBEAT, &atsSetHbStepsS[0], 1, uwTimeV));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComSdoSetTimeout()                                                                                                 //
+// node-ID 0 sets the timeout of all nodes                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComSdoSetTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= COM_NODE_ID_MAX; ubNodeIdT++)
+   {
+      if ((ubNodeIdV == 0) || (ubNodeIdV == ubNodeIdT))
+      {
+         pclNetT->node(ubNodeIdT)->tsSdo.uwTimeout = uwTimeV;
+      }
+   }
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComSyncEnable()                                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComSyncEnable(uint8_t ubNetV, uint8_t ubEnableV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->btSyncEnableP = (ubEnableV != 0);
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComSyncSetCycleTime()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+ComStatus_tv ComSyncSetCycleTime(uint8_t ubNetV, uint32_t ulCycleTimeV)
+{
+   CoHostNet * pclNetT = hostNet(ubNetV);
+
+   if (pclNetT == nullptr)
+   {
+      return (eCOM_ERR_NET);
+   }
+
+   pclNetT->ulSyncCycleP = ulCycleTimeV;
+
+   return (eCOM_ERR_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// ComTmrSetPeriod()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void ComTmrSetPeriod(uint32_t ulPeriodV)
+{
+   if (ulPeriodV > 0)
+   {
+      ulTmrPeriodS = ulPeriodV;
+   }
+}
@@ -0,0 +1,269 @@
+//====================================================================================================================//
+// File:          canopen_master.h                                                                                    //
+// Description:   Host stand-in for the CANopen master library API                                                    //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    canopen_master.h
+** \brief   Host stand-in for the CANopen master library API
+**
+** The CANopen master library is only available for the µMIC.200 target. This header declares
+** the subset of its API which is used by the demo, so the master logic can be built, profiled
+** and benchmarked on a workstation. The implementation in co_host_master.cpp runs on a SocketCAN
+** interface, e.g. a virtual CAN interface driven by canopen-sim.
+**
+** The stand-in implements NMT, heartbeat producer / consumer, SYNC producer, EMCY consumer and
+** the SDO client transfers of ComNodeGetInfo() and ComNodeSetHbProdTime(). PDOs can't be
+** configured: TPDO1 of node n (predefined connection set) is reported as RPDO n, without data.
+** LSS is not supported. The header must not be used for the target build.
+*/
+#ifndef CANOPEN_MASTER_H_
+#define CANOPEN_MASTER_H_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  COM_NET_MAX                ((uint8_t)       4)        // number of supported networks
+#define  COM_NODE_ID_MAX            ((uint8_t)     127)        // highest node-ID
+
+
+typedef int32_t   ComStatus_tv;
+
+
+enum ComErr_e {
+   eCOM_ERR_OK = 0,
+   eCOM_ERR_NET,
+   eCOM_ERR_NODE_ID,
+   eCOM_ERR_CHANNEL,
+   eCOM_ERR_SDO_BUSY,
+   eCOM_ERR_NOT_SUPPORTED
+};
+
+enum ComNet_e {
+   eCOM_NET_1 = 1,
+   eCOM_NET_2,
+   eCOM_NET_3,
+   eCOM_NET_4
+};
+
+enum ComMode_e {
+   eCOM_MODE_NMT_SLAVE = 0,
+   eCOM_MODE_NMT_MASTER
+};
+
+enum ComVersion_e {
+   eCOM_VERSION_STACK = 0
+};
+
+//-------------------------------------------------------------------------------------------------------
+// NMT states, the values are equal to the state of the heartbeat protocol, the reset commands
+// are the NMT command specifier plus 128
+//
+enum ComNmtState_e {
+   eCOM_NMT_STATE_BOOTUP         = 0,
+   eCOM_NMT_STATE_STOPPED        = 4,
+   eCOM_NMT_STATE_OPERATIONAL    = 5,
+   eCOM_NMT_STATE_PREOPERATIONAL = 127,
+   eCOM_NMT_STATE_RESET_NODE     = 129,
+   eCOM_NMT_STATE_RESET_COM      = 130
+};
+
+enum ComNmtDetect_e {
+   eCOM_NMT_DETECT_TIMEOUT = 0,
+   eCOM_NMT_DETECT_ACTIVE_MASTER
+};
+
+enum ComSdoMarker_e {
+   eCOM_SDO_MARKER_NONE = 0,
+   eCOM_SDO_MARKER_NODE_GET_INFO,
+   eCOM_SDO_MARKER_NODE_SET_HEARTBEAT
+};
+
+enum CpChannel_e {
+   eCP_CHANNEL_1 = 1,
+   eCP_CHANNEL_2,
+   eCP_CHANNEL_3,
+   eCP_CHANNEL_4
+};
+
+enum CpBitrate_e {
+   eCP_BITRATE_10K = 0,
+   eCP_BITRATE_20K,
+   eCP_BITRATE_50K,
+   eCP_BITRATE_100K,
+   eCP_BITRATE_125K,
+   eCP_BITRATE_250K,
+   eCP_BITRATE_500K,
+   eCP_BITRATE_800K,
+   eCP_BITRATE_1M
+};
+
+enum CpState_e {
+   eCP_STATE_INIT = 0,
+   eCP_STATE_SLEEPING,
+   eCP_STATE_BUS_ACTIVE,
+   eCP_STATE_BUS_WARN,
+   eCP_STATE_BUS_PASSIVE,
+   eCP_STATE_BUS_OFF,
+   eCP_STATE_PHY_FAULT
+};
+
+
+//-------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CpState_s
+** \brief   State of the CAN controller
+*/
+typedef struct CpState_s {
+   uint8_t     ubCanErrState;
+   uint8_t     ubCanErrType;
+   uint8_t     ubCanRcvErrCnt;
+   uint8_t     ubCanTrmErrCnt;
+} CpState_ts;
+
+
+//-------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoObject_s
+** \brief   Object of an SDO transfer, reported by the signal QCoEvent::comSdoEventObjectReady()
+*/
+typedef struct CoObject_s {
+   uint16_t    uwIndex;
+   uint8_t     ubSubIndex;
+   uint8_t     ubMarker;
+} CoObject_ts;
+
+
+//-------------------------------------------------------------------------------------------------------
+/*!
+** \struct  ComNode_s
+** \brief   Identification of a node, filled by ComNodeGetInfo()
+*/
+typedef struct ComNode_s {
+   uint32_t    ulIdx1000_DT;
+   uint8_t     ubIdx1001_ER;
+   uint8_t     aubIdx1008_DN[32];
+   uint32_t    ulIdx1018_VI;
+   uint32_t    ulIdx1018_PC;
+   uint32_t    ulIdx1018_RN;
+   uint32_t    ulIdx1018_SN;
+} ComNode_ts;
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Function prototypes                                                                                                **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------------------------------------------------------------------
+// Manager
+//
+ComStatus_tv   ComMgrInit(uint8_t ubCanIfV, uint8_t ubNetV, uint8_t ubBitrateV, uint8_t ubNodeIdV, uint8_t ubModeV);
+
+ComStatus_tv   ComMgrNodeAdd(uint8_t ubNetV, uint8_t ubNodeIdV, ComNode_ts * ptsNodeV);
+
+ComStatus_tv   ComMgrNetTimerEvent(uint8_t ubNetV);
+
+ComStatus_tv   ComMgrProcess(uint8_t ubNetV);
+
+ComStatus_tv   ComMgrRelease(uint8_t ubNetV);
+
+ComStatus_tv   ComMgrStart(uint8_t ubNetV);
+
+const char *   ComMgrGetVersionString(uint8_t ubVersionV);
+
+//-------------------------------------------------------------------------------------------------------
+// callback, implemented by the application, called by ComMgrInit()
+//
+ComStatus_tv   ComMgrUserInit(uint8_t ubNetV);
+
+//-------------------------------------------------------------------------------------------------------
+// EMCY consumer
+//
+ComStatus_tv   ComEmcyConsGetData(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t * pubDataV);
+
+//-------------------------------------------------------------------------------------------------------
+// NMT
+//
+ComStatus_tv   ComNmtMasterDetection(uint8_t ubNetV, uint8_t ubPriorityV);
+
+ComStatus_tv   ComNmtSetHbConsTime(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV);
+
+ComStatus_tv   ComNmtSetHbProdTime(uint8_t ubNetV, uint16_t uwTimeV);
+
+ComStatus_tv   ComNmtSetNodeState(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubStateV);
+
+//-------------------------------------------------------------------------------------------------------
+// Node, the SDO transfers are reported by QCoEvent::comSdoEventObjectReady()
+//
+ComStatus_tv   ComNodeGetInfo(uint8_t ubNetV, uint8_t ubNodeIdV);
+
+void           ComNodeSetDefault(ComNode_ts * ptsNodeV);
+
+ComStatus_tv   ComNodeSetHbProdTime(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV);
+
+//-------------------------------------------------------------------------------------------------------
+// SDO client
+//
+ComStatus_tv   ComSdoSetTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwTimeV);
+
+//-------------------------------------------------------------------------------------------------------
+// SYNC producer, the cycle time is given in micro-seconds
+//
+ComStatus_tv   ComSyncEnable(uint8_t ubNetV, uint8_t ubEnableV);
+
+ComStatus_tv   ComSyncSetCycleTime(uint8_t ubNetV, uint32_t ulCycleTimeV);
+
+//-------------------------------------------------------------------------------------------------------
+// Timer, the period of ComMgrNetTimerEvent() is given in micro-seconds
+//
+void           ComTmrSetPeriod(uint32_t ulPeriodV);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /*CANOPEN_MASTER_H_*/
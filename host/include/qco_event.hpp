@@ -0,0 +1,106 @@
+//====================================================================================================================//
+// File:          qco_event.hpp                                                                                       //
+// Description:   Host stand-in for the CANopen master event class                                                    //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    qco_event.hpp
+** \brief   Host stand-in for the CANopen master event class
+**
+** The signals are emitted by the host stand-in of the CANopen master library inside the thread
+** which calls ComMgrProcess() or ComMgrNetTimerEvent(), the same way the target library emits
+** them from its callback functions.
+*/
+#ifndef QCO_EVENT_HPP_
+#define QCO_EVENT_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QObject>
+
+#include "canopen_master.h"
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   QCoEvent
+** \brief   Signals of the CANopen master library
+**
+*/
+class QCoEvent : public QObject
+{
+   Q_OBJECT
+
+public:
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     pointer to the single instance of the class
+   */
+   static QCoEvent * instance(void);
+
+signals:
+   void  comEmcyConsEventReceive(uint8_t ubNetV, uint8_t ubNodeIdV);
+
+   void  comLssEventReceive(uint8_t ubNetV, uint8_t ubLssProtocolV);
+
+   void  comMgrEventBus(uint8_t ubNetV, CpState_ts * ptsBusStateV);
+
+   void  comNmtEventActiveMaster(uint8_t ubNetV, uint8_t ubPriorityV, uint8_t ubNodeIdV);
+
+   void  comNmtEventHeartbeat(uint8_t ubNetV, uint8_t ubNodeIdV);
+
+   void  comNmtEventIdCollision(uint8_t ubNetV);
+
+   void  comNmtEventMasterDetection(uint8_t ubNetV, uint8_t ubResultV);
+
+   void  comNmtEventStateChange(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV);
+
+   void  comPdoEventReceive(uint8_t ubNetV, uint16_t uwPdoV);
+
+   void  comPdoEventTimeout(uint8_t ubNetV, uint16_t uwPdoNumV);
+
+   void  comSdoEventObjectReady(uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, uint32_t * pulAbortV);
+
+   void  comSdoEventProgress(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV,
+                             uint32_t ulByteCntV);
+
+   void  comSdoEventTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV);
+
+private:
+   QCoEvent();
+};
+
+
+#endif /*QCO_EVENT_HPP_*/
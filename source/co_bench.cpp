@@ -0,0 +1,1003 @@
+//====================================================================================================================//
+// File:          co_bench.cpp                                                                                        //
+// Description:   Benchmark of the CANopen master                                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+
+#include "qco_event.hpp"
+#include "co_bench.hpp"
+
+#include <algorithm>
+
+#include <string.h>
+#include <unistd.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  BENCH_TIMER_PERIOD         ((uint32_t)     10)        // check of the measurement in milli-seconds
+#define  BENCH_SIM_PERIOD           ((uint32_t)      1)        // tick of the slaves in milli-seconds
+
+#define  BENCH_BRING_UP_TIMEOUT     ((uint64_t) 60000000000)   // maximum duration of a bring-up in [ns]
+#define  BENCH_SAMPLE_TIMEOUT       ((uint64_t)  2000000000)   // maximum duration of a sample in [ns]
+#define  BENCH_RECOVERY_TIMEOUT     ((uint64_t) 10000000000)   // maximum duration of a sample with a scan in [ns]
+
+#define  BENCH_NMT_RESET_NODE       ((uint8_t)    0x81)        // NMT command specifier
+
+#define  MS_TO_NS(ms)               ((uint64_t) (ms) * 1000000)
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    parseValue(QCommandLineParser & clCmdParserR, const QCommandLineOption & clOptionR,
+                          uint32_t ulMinV, uint32_t ulMaxV, uint32_t & ulValueR);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+   QCoreApplication clAppT(argc, argv);
+   QCoreApplication::setApplicationName("canopen-bench");
+   QCoreApplication::setApplicationVersion("1.0");
+
+   //---------------------------------------------------------------------------------------------------
+   // create the main class, the exit code of the benchmark is the exit code of the program
+   //
+   CoBench clMainT;
+
+   QObject::connect(&clMainT, &CoBench::finished, &clAppT, [](int32_t slExitCodeV) {
+      QCoreApplication::exit(slExitCodeV);
+   });
+
+   QTimer::singleShot(10, &clMainT, SLOT(runCmdParser()));
+
+   return (clAppT.exec());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// parseValue()                                                                                                       //
+// evaluate an integer option                                                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+static void parseValue(QCommandLineParser & clCmdParserR, const QCommandLineOption & clOptionR,
+                       uint32_t ulMinV, uint32_t ulMaxV, uint32_t & ulValueR)
+{
+   bool     btOkT;
+   uint32_t ulValueT;
+
+   if (clCmdParserR.isSet(clOptionR))
+   {
+      ulValueT = clCmdParserR.value(clOptionR).toUInt(&btOkT, 10);
+      if ((btOkT == false) || (ulValueT < ulMinV) || (ulValueT > ulMaxV))
+      {
+         fprintf(stderr, "Error: value of option --%s out of range \n\n", qPrintable(clOptionR.names().at(0)));
+         clCmdParserR.showHelp(0);
+      }
+      ulValueR = ulValueT;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::CoBench()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoBench::CoBench()
+{
+   ulSamplesP        = 100;
+   ubScanParallelP   = 8;
+   btEventDrivenP    = false;
+   slResultFdP       = -1;
+
+   pclMasterP        = nullptr;
+   ubNodeCntP        = 0;
+   pclSimRxP         = nullptr;
+   pclMonitorRxP     = nullptr;
+
+   ubPhaseP          = eCO_BENCH_PHASE_IDLE;
+   ulSampleP         = 0;
+   ubNodeIdP         = 0;
+   btSampleP         = false;
+   btSilentP         = false;
+   uqStartP          = 0;
+   uqDeadlineP       = 0;
+   uqEndP            = 0;
+   ubOperationalCntP = 0;
+   ulFailedCntP      = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // The slaves boot immediately and transmit TPDO1 on request of the benchmark. The heartbeat
+   // is started by the master during the device scan.
+   //
+   memset(&tsSimConfigP, 0, sizeof(tsSimConfigP));
+   tsSimConfigP.ulDeviceType  = 0x00000191;
+   strcpy(tsSimConfigP.aszDeviceName, "CANopen Bench");
+   tsSimConfigP.ulVendorId    = 0x0000000E;
+   tsSimConfigP.ulProductCode = 0x00001000;
+   tsSimConfigP.ulRevision    = 0x00010000;
+   tsSimConfigP.ulSerialBase  = 0x00100000;
+   tsSimConfigP.btPdoEnable   = true;
+
+   connect(&clTimerP,    &QTimer::timeout, this, &CoBench::onTimerEvent);
+   connect(&clSimTimerP, &QTimer::timeout, this, &CoBench::onSimTimerEvent);
+
+   //---------------------------------------------------------------------------------------------------
+   // the signals are also connected to the master, the master runs without stack thread, so
+   // all slots are called in the thread of the event loop
+   //
+   QCoEvent * pclCoEventT = QCoEvent::instance();
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventHeartbeat,    this, &CoBench::onNmtEventHeartbeat);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventStateChange,  this, &CoBench::onNmtEventStateChange);
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventReceive,      this, &CoBench::onPdoEventReceive);
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventObjectReady,  this, &CoBench::onSdoEventObjectReady);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::~CoBench()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoBench::~CoBench()
+{
+   stopMaster();
+
+   if (slResultFdP >= 0)
+   {
+      ::close(slResultFdP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::canFrameReceived()                                                                                        //
+// frames received by the monitor: pass requests of the master to the slaves, record the time of SDO transfers       //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   uint32_t ulCanIdT;
+   uint8_t  ubNodeIdT;
+
+   Q_UNUSED(btLocalV);
+
+   if ((tsFrameR.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0)
+   {
+      return;
+   }
+   ulCanIdT  = tsFrameR.can_id;
+   ubNodeIdT = (uint8_t) (ulCanIdT & 0x7F);
+
+   //---------------------------------------------------------------------------------------------------
+   // NMT command: node-ID 0 addresses all slaves
+   //
+   if ((ulCanIdT == 0x000) && (tsFrameR.can_dlc == 2))
+   {
+      for (uint8_t ubSlaveT = 1; ubSlaveT <= ubNodeCntP; ubSlaveT++)
+      {
+         if ((tsFrameR.data[1] == 0) || (tsFrameR.data[1] == ubSlaveT))
+         {
+            aclSlaveP[ubSlaveT - 1].receiveNmt(tsFrameR.data[0], uqTimeStampV);
+         }
+      }
+      return;
+   }
+
+   if ((ubNodeIdT == 0) || (ubNodeIdT > ubNodeCntP))
+   {
+      return;
+   }
+
+   switch (ulCanIdT & 0x780)
+   {
+      //-------------------------------------------------------------------------------------------
+      // SDO request: the first request after the boot-up starts the identification of the
+      // node, an expedited download and the upload of 1008h start the measurement of a transfer
+      //
+      case 0x600:
+         if (abtBootedP[ubNodeIdT - 1])
+         {
+            abtBootedP[ubNodeIdT - 1]   = false;
+            auqNodeInfoP[ubNodeIdT - 1] = uqTimeStampV;
+         }
+         if ((tsFrameR.data[0] & 0xE3) == 0x23)
+         {
+            auqExpeditedP[ubNodeIdT - 1] = uqTimeStampV;
+         }
+         else if ((tsFrameR.data[0] == 0x40) && (tsFrameR.data[1] == 0x08) && (tsFrameR.data[2] == 0x10))
+         {
+            auqSegmentP[ubNodeIdT - 1] = uqTimeStampV;
+         }
+         aclSlaveP[ubNodeIdT - 1].receiveSdo(tsFrameR, uqTimeStampV);
+         aclSlaveP[ubNodeIdT - 1].tick(uqTimeStampV);
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // SDO response: the download response or the last segment ends the measurement, an
+      // abort discards it
+      //
+      case 0x580:
+         if (auqExpeditedP[ubNodeIdT - 1] != 0)
+         {
+            if (tsFrameR.data[0] == 0x60)
+            {
+               clSdoExpeditedP.append(uqTimeStampV - auqExpeditedP[ubNodeIdT - 1]);
+            }
+            auqExpeditedP[ubNodeIdT - 1] = 0;
+         }
+         else if (auqSegmentP[ubNodeIdT - 1] != 0)
+         {
+            if ((tsFrameR.data[0] & 0xE1) == 0x01)
+            {
+               clSdoSegmentedP.append(uqTimeStampV - auqSegmentP[ubNodeIdT - 1]);
+               auqSegmentP[ubNodeIdT - 1] = 0;
+            }
+            else if (tsFrameR.data[0] == 0x80)
+            {
+               auqSegmentP[ubNodeIdT - 1] = 0;
+            }
+         }
+         break;
+
+      case 0x700:
+         if (tsFrameR.data[0] == 0x00)
+         {
+            abtBootedP[ubNodeIdT - 1]   = true;
+            auqNodeInfoP[ubNodeIdT - 1] = 0;
+         }
+         else
+         {
+            auqHeartbeatP[ubNodeIdT - 1] = uqTimeStampV;
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::finish()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::finish(void)
+{
+   FILE *   ptsFileT;
+   int32_t  slExitCodeT = 0;
+
+   clTimerP.stop();
+   clSimTimerP.stop();
+   stopMaster();
+   ubPhaseP = eCO_BENCH_PHASE_DONE;
+
+   //---------------------------------------------------------------------------------------------------
+   // the benchmark fails if a network could not be brought up or if a sample did not complete
+   //
+   for (const CoBenchBringUp_ts & tsBringUpR : clBringUpP)
+   {
+      if (tsBringUpR.ubOperationalCnt != tsBringUpR.ubNodeCnt)
+      {
+         slExitCodeT = CO_BENCH_EXIT_FAILED;
+      }
+   }
+   if (ulFailedCntP > 0)
+   {
+      slExitCodeT = CO_BENCH_EXIT_FAILED;
+   }
+
+   if (clOutputFileP.isEmpty())
+   {
+      ptsFileT    = fdopen(slResultFdP, "w");
+      slResultFdP = -1;
+   }
+   else
+   {
+      ptsFileT = fopen(qPrintable(clOutputFileP), "w");
+   }
+
+   if (ptsFileT == nullptr)
+   {
+      fprintf(stderr, "Failed to open %s.\n", clOutputFileP.isEmpty() ? "stdout" : qPrintable(clOutputFileP));
+      emit finished(CO_BENCH_EXIT_FAILED);
+      return;
+   }
+
+   writeResult(ptsFileT);
+   fclose(ptsFileT);
+
+   emit finished(slExitCodeT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::nextSample()                                                                                              //
+// start the next sample of the running measurement                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::nextSample(void)
+{
+   if (ulSampleP >= ulSamplesP)
+   {
+      startPhase(ubPhaseP + 1);
+      return;
+   }
+
+   ubNodeIdP   = (uint8_t) (1 + (ulSampleP % ubNodeCntP));
+   ulSampleP++;
+
+   //---------------------------------------------------------------------------------------------------
+   // the master has not recovered the node of a failed sample
+   //
+   if (abtOperationalP[ubNodeIdP - 1] == false)
+   {
+      ulFailedCntP++;
+      return;
+   }
+
+   btSampleP   = true;
+   btSilentP   = false;
+   uqStartP    = CoCanTap::timeStamp();
+   uqDeadlineP = uqStartP + BENCH_SAMPLE_TIMEOUT;
+
+   switch (ubPhaseP)
+   {
+      case eCO_BENCH_PHASE_RESCAN:
+         uqDeadlineP = uqStartP + BENCH_RECOVERY_TIMEOUT;
+         aclSlaveP[ubNodeIdP - 1].receiveNmt(BENCH_NMT_RESET_NODE, uqStartP);
+         break;
+
+      case eCO_BENCH_PHASE_PDO_DISPATCH:
+         aclSlaveP[ubNodeIdP - 1].receiveSync();
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // stop the heartbeat of the node, the consumer of the master must detect the loss
+      //
+      case eCO_BENCH_PHASE_HEARTBEAT_LOSS:
+         uqDeadlineP = uqStartP + BENCH_RECOVERY_TIMEOUT;
+         btSilentP   = true;
+         aclSlaveP[ubNodeIdP - 1].setHeartbeat(0, uqStartP);
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onCanRxEvent()                                                                                            //
+// the socket of the slaves is only drained, its frames are received by the monitor                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onCanRxEvent(void)
+{
+   clSimTapP.process();
+   clMonitorP.process();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onMasterFinished()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onMasterFinished(void)
+{
+   //---------------------------------------------------------------------------------------------------
+   // the signal is emitted by the master itself, so the object is deleted later
+   //
+   fprintf(stderr, "CANopen master stopped during the benchmark.\n");
+   disconnect(pclMasterP, nullptr, this, nullptr);
+   pclMasterP->deleteLater();
+   pclMasterP = nullptr;
+
+   ulFailedCntP++;
+   finish();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onNmtEventHeartbeat()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onNmtEventHeartbeat(uint8_t ubNetV, uint8_t ubNodeIdV)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   Q_UNUSED(ubNetV);
+
+   if ((ubPhaseP != eCO_BENCH_PHASE_HEARTBEAT_LOSS) || !btSampleP || !btSilentP || (ubNodeIdV != ubNodeIdP))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the master resets the node, the sample ends when the node is operational again
+   //
+   clHeartbeatLossP.append(uqTimeT - auqHeartbeatP[ubNodeIdV - 1]);
+   btSilentP = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onNmtEventStateChange()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onNmtEventStateChange(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   Q_UNUSED(ubNetV);
+
+   if ((ubNodeIdV < 1) || (ubNodeIdV > ubNodeCntP))
+   {
+      return;
+   }
+
+   switch (ubNmtEventV)
+   {
+      case eCOM_NMT_STATE_BOOTUP:
+         if (abtOperationalP[ubNodeIdV - 1])
+         {
+            abtOperationalP[ubNodeIdV - 1] = false;
+            ubOperationalCntP--;
+         }
+         break;
+
+      case eCOM_NMT_STATE_OPERATIONAL:
+         if (abtOperationalP[ubNodeIdV - 1])
+         {
+            break;
+         }
+         abtOperationalP[ubNodeIdV - 1] = true;
+         ubOperationalCntP++;
+
+         if ((ubPhaseP == eCO_BENCH_PHASE_BRING_UP) && (ubOperationalCntP == ubNodeCntP))
+         {
+            uqEndP = uqTimeT;
+         }
+
+         if (btSampleP && (ubNodeIdV == ubNodeIdP))
+         {
+            if (ubPhaseP == eCO_BENCH_PHASE_RESCAN)
+            {
+               sampleDone(clRescanP, uqTimeT - uqStartP);
+            }
+            else if ((ubPhaseP == eCO_BENCH_PHASE_HEARTBEAT_LOSS) && !btSilentP)
+            {
+               btSampleP = false;
+            }
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onPdoEventReceive()                                                                                       //
+// the host stand-in of the library reports TPDO1 of node n as PDO n                                                  //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onPdoEventReceive(uint8_t ubNetV, uint16_t uwPdoV)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   Q_UNUSED(ubNetV);
+
+   if ((ubPhaseP == eCO_BENCH_PHASE_PDO_DISPATCH) && btSampleP && (uwPdoV == ubNodeIdP))
+   {
+      sampleDone(clPdoDispatchP, uqTimeT - uqStartP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onSdoEventObjectReady()                                                                                   //
+// the identification of a node by the device scan of the master is finished                                          //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onSdoEventObjectReady(uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, uint32_t * pulAbortV)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   Q_UNUSED(ubNetV);
+
+   if ((ubNodeIdV < 1) || (ubNodeIdV > ubNodeCntP) || (ptsCoObjV->ubMarker != eCOM_SDO_MARKER_NODE_GET_INFO))
+   {
+      return;
+   }
+
+   if ((auqNodeInfoP[ubNodeIdV - 1] != 0) && ((pulAbortV == nullptr) || (*pulAbortV == 0)))
+   {
+      clSdoNodeInfoP.append(uqTimeT - auqNodeInfoP[ubNodeIdV - 1]);
+   }
+   auqNodeInfoP[ubNodeIdV - 1] = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onSimTimerEvent()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onSimTimerEvent(void)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= ubNodeCntP; ubNodeIdT++)
+   {
+      aclSlaveP[ubNodeIdT - 1].tick(uqTimeT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::onTimerEvent()                                                                                            //
+// the master is processed by its own timer, this timer only checks the measurement                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::onTimerEvent(void)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   switch (ubPhaseP)
+   {
+      //-------------------------------------------------------------------------------------------
+      // the network of the last bring-up is used for the following measurements
+      //
+      case eCO_BENCH_PHASE_BRING_UP:
+      {
+         if ((ubOperationalCntP < ubNodeCntP) && (uqTimeT < uqDeadlineP))
+         {
+            break;
+         }
+
+         CoBenchBringUp_ts tsBringUpT;
+         tsBringUpT.ubNodeCnt        = ubNodeCntP;
+         tsBringUpT.ubOperationalCnt = ubOperationalCntP;
+         tsBringUpT.uqDuration       = ((ubOperationalCntP == ubNodeCntP) ? uqEndP : uqTimeT) - uqStartP;
+         clBringUpP.append(tsBringUpT);
+
+         fprintf(stderr, "Bring-up of %3d nodes: %d operational after %.1f ms\n", tsBringUpT.ubNodeCnt,
+                 tsBringUpT.ubOperationalCnt, (double) tsBringUpT.uqDuration / 1.0e6);
+
+         if (ubOperationalCntP < ubNodeCntP)
+         {
+            finish();
+         }
+         else if (clNodeCountP.isEmpty())
+         {
+            startPhase(eCO_BENCH_PHASE_RESCAN);
+         }
+         else
+         {
+            stopMaster();
+            startBringUp();
+         }
+         break;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // a slave whose heartbeat loss was not detected is reset, so the master can scan it again
+      //
+      case eCO_BENCH_PHASE_RESCAN:
+      case eCO_BENCH_PHASE_PDO_DISPATCH:
+      case eCO_BENCH_PHASE_HEARTBEAT_LOSS:
+         if (btSampleP && (uqTimeT > uqDeadlineP))
+         {
+            ulFailedCntP++;
+            btSampleP = false;
+            if (btSilentP)
+            {
+               aclSlaveP[ubNodeIdP - 1].receiveNmt(BENCH_NMT_RESET_NODE, uqTimeT);
+            }
+         }
+
+         if (!btSampleP)
+         {
+            nextSample();
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::runCmdParser()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::runCmdParser(void)
+{
+   QCommandLineParser   clCmdParserT;
+   uint32_t             ulValueT;
+
+   //---------------------------------------------------------------------------------------------------
+   // setup command line parser, options are added in alphabetical order
+   //
+   clCmdParserT.setApplicationDescription(tr("CANopen master benchmark"));
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -h, --help
+   //
+   clCmdParserT.addHelpOption();
+
+   //---------------------------------------------------------------------------------------------------
+   // argument <interface> is required
+   //
+   clCmdParserT.addPositionalArgument("interface",
+                                      tr("CAN interface, e.g. can1"));
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --event-driven
+   //
+   QCommandLineOption clOptEventDrivenT("event-driven",
+         tr("Run the master with event-driven processing of received CAN frames"));
+   clCmdParserT.addOption(clOptEventDrivenT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --nodes <list>
+   //
+   QCommandLineOption clOptNodesT("nodes",
+         tr("Numbers of nodes for the bring-up, default 1,2,4,8,16,32,64,127"),
+         tr("list"));
+   clCmdParserT.addOption(clOptNodesT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --output <file>
+   //
+   QCommandLineOption clOptOutputT("output",
+         tr("Write the results as JSON to <file>, default stdout"),
+         tr("file"));
+   clCmdParserT.addOption(clOptOutputT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --samples <n>
+   //
+   QCommandLineOption clOptSamplesT("samples",
+         tr("Number of samples of each latency measurement, default 100"),
+         tr("n"));
+   clCmdParserT.addOption(clOptSamplesT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --scan-parallel <n>
+   //
+   QCommandLineOption clOptScanParallelT("scan-parallel",
+         tr("Number of devices scanned by the master at the same time, default 8"),
+         tr("n"));
+   clCmdParserT.addOption(clOptScanParallelT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --sdo-latency <ms>
+   //
+   QCommandLineOption clOptSdoLatencyT("sdo-latency",
+         tr("Delay of SDO responses of the slaves in [ms]"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptSdoLatencyT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -v, --version
+   //
+   clCmdParserT.addVersionOption();
+
+   //---------------------------------------------------------------------------------------------------
+   // Process the actual command line arguments given by the user
+   //
+   clCmdParserT.process(*QCoreApplication::instance());
+   const QStringList clArgsT = clCmdParserT.positionalArguments();
+   if (clArgsT.size() != 1)
+   {
+      fprintf(stdout, "%s\n", qPrintable(tr("Error: Must specify CAN interface.\n")));
+      clCmdParserT.showHelp(0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the interface is checked like inside canopen-demo, the master would end the process
+   //
+   clInterfaceP = clArgsT.at(0);
+   if (!clInterfaceP.startsWith("can"))
+   {
+      fprintf(stderr, "%s %s\n", qPrintable(tr("Error: Unknown CAN interface ")), qPrintable(clInterfaceP));
+      clCmdParserT.showHelp(0);
+   }
+
+   bool    btConversionSuccessT;
+   int32_t slChannelT = clInterfaceP.mid(3).toInt(&btConversionSuccessT, 10);
+   if ((btConversionSuccessT == false) || (slChannelT < eCP_CHANNEL_1) || (slChannelT > eCP_CHANNEL_2))
+   {
+      fprintf(stderr, "%s \n\n", qPrintable(tr("Error: CAN interface out of range")));
+      clCmdParserT.showHelp(0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate the numbers of nodes, the bring-ups run in ascending order
+   //
+   QString clNodesT = "1,2,4,8,16,32,64,127";
+   if (clCmdParserT.isSet(clOptNodesT))
+   {
+      clNodesT = clCmdParserT.value(clOptNodesT);
+   }
+   for (const QString & clItemR : clNodesT.split(","))
+   {
+      uint32_t ulCountT = clItemR.toUInt(&btConversionSuccessT, 10);
+      if ((btConversionSuccessT == false) || (ulCountT < 1) || (ulCountT > CO_BENCH_NODE_MAX))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: number of nodes out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      if (!clNodeCountP.contains((uint8_t) ulCountT))
+      {
+         clNodeCountP.append((uint8_t) ulCountT);
+      }
+   }
+   std::sort(clNodeCountP.begin(), clNodeCountP.end());
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate timing and number of samples
+   //
+   ulValueT = ubScanParallelP;
+   parseValue(clCmdParserT, clOptScanParallelT, 1,   CO_BENCH_NODE_MAX, ulValueT);
+   ubScanParallelP = (uint8_t) ulValueT;
+
+   parseValue(clCmdParserT, clOptSamplesT,      1,   100000,  ulSamplesP);
+   parseValue(clCmdParserT, clOptSdoLatencyT,   0,   1000,    tsSimConfigP.ulSdoLatency);
+
+   btEventDrivenP = clCmdParserT.isSet(clOptEventDrivenT);
+   clOutputFileP  = clCmdParserT.value(clOptOutputT);
+
+   //---------------------------------------------------------------------------------------------------
+   // the benchmark is skipped if the interface is not available, e.g. no vcan module
+   //
+   if ((clMonitorP.open(qPrintable(clInterfaceP)) == false) || (clSimTapP.open(qPrintable(clInterfaceP)) == false))
+   {
+      fprintf(stderr, "CAN interface %s not available, benchmark skipped.\n", qPrintable(clInterfaceP));
+      emit finished(CO_BENCH_EXIT_SKIPPED);
+      return;
+   }
+   clMonitorP.addListener(this);
+
+   pclMonitorRxP = new QSocketNotifier(clMonitorP.handle(), QSocketNotifier::Read, this);
+   connect(pclMonitorRxP, &QSocketNotifier::activated, this, &CoBench::onCanRxEvent);
+
+   pclSimRxP = new QSocketNotifier(clSimTapP.handle(), QSocketNotifier::Read, this);
+   connect(pclSimRxP, &QSocketNotifier::activated, this, &CoBench::onCanRxEvent);
+
+   fprintf(stderr, "Using library: %s\n", ComMgrGetVersionString(eCOM_VERSION_STACK));
+
+   //---------------------------------------------------------------------------------------------------
+   // The results are written to the original stdout, the console output of the master goes to
+   // stderr like the progress messages of the benchmark.
+   //
+   fflush(stdout);
+   slResultFdP = ::dup(STDOUT_FILENO);
+   if ((slResultFdP < 0) || (::dup2(STDERR_FILENO, STDOUT_FILENO) < 0))
+   {
+      fprintf(stderr, "Failed to redirect the console output of the master.\n");
+      emit finished(CO_BENCH_EXIT_FAILED);
+      return;
+   }
+
+   clTimerP.setTimerType(Qt::PreciseTimer);
+   clTimerP.start(BENCH_TIMER_PERIOD);
+   clSimTimerP.setTimerType(Qt::PreciseTimer);
+   clSimTimerP.start(BENCH_SIM_PERIOD);
+
+   startBringUp();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::sampleDone()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::sampleDone(QVector<uint64_t> & clSamplesR, uint64_t uqDurationV)
+{
+   clSamplesR.append(uqDurationV);
+   btSampleP = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::startBringUp()                                                                                            //
+// start a new master and power-on the slaves for the next number of nodes                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::startBringUp(void)
+{
+   QStringList clArgsT;
+   uint8_t     ubNodeCntT = clNodeCountP.takeFirst();
+
+   memset(&abtOperationalP[0], 0, sizeof(abtOperationalP));
+   memset(&abtBootedP[0],      0, sizeof(abtBootedP));
+   memset(&auqHeartbeatP[0],   0, sizeof(auqHeartbeatP));
+   memset(&auqNodeInfoP[0],    0, sizeof(auqNodeInfoP));
+   memset(&auqExpeditedP[0],   0, sizeof(auqExpeditedP));
+   memset(&auqSegmentP[0],     0, sizeof(auqSegmentP));
+   ubOperationalCntP = 0;
+   ubNodeCntP        = ubNodeCntT;
+
+   //---------------------------------------------------------------------------------------------------
+   // the master is configured like canopen-demo by its command line
+   //
+   clArgsT << "canopen-demo" << "--scan-parallel" << QString::number(ubScanParallelP);
+   if (btEventDrivenP)
+   {
+      clArgsT << "--event-driven";
+   }
+   clArgsT << clInterfaceP;
+
+   pclMasterP = new CoMasterDemo();
+   pclMasterP->setArguments(clArgsT);
+   connect(pclMasterP, &CoMasterDemo::finished, this, &CoBench::onMasterFinished);
+
+   //---------------------------------------------------------------------------------------------------
+   // the measurement starts with the master, which calls ComMgrStart(), the slaves boot at the
+   // same time
+   //
+   ubPhaseP    = eCO_BENCH_PHASE_BRING_UP;
+   uqStartP    = CoCanTap::timeStamp();
+   uqDeadlineP = uqStartP + BENCH_BRING_UP_TIMEOUT;
+   pclMasterP->runCmdParser();
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= ubNodeCntT; ubNodeIdT++)
+   {
+      aclSlaveP[ubNodeIdT - 1].init(ubNodeIdT, &tsSimConfigP, &clSimTapP, uqStartP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::startPhase()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::startPhase(uint8_t ubPhaseV)
+{
+   ubPhaseP  = ubPhaseV;
+   ulSampleP = 0;
+   btSampleP = false;
+   btSilentP = false;
+
+   if (ubPhaseP >= eCO_BENCH_PHASE_DONE)
+   {
+      finish();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::stopMaster()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::stopMaster(void)
+{
+   //---------------------------------------------------------------------------------------------------
+   // The master is deleted at once: the next master uses the same network and recreates the
+   // socket pairs of the signal handlers, which are closed by the destructor.
+   //
+   if (pclMasterP != nullptr)
+   {
+      disconnect(pclMasterP, nullptr, this, nullptr);
+      pclMasterP->stop();
+      delete pclMasterP;
+      pclMasterP = nullptr;
+   }
+   ubNodeCntP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::writeResult()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::writeResult(FILE * ptsFileV)
+{
+   fprintf(ptsFileV, "{\n");
+   fprintf(ptsFileV, "  \"benchmark\": \"canopen-bench\",\n");
+   fprintf(ptsFileV, "  \"library\": \"%s\",\n", ComMgrGetVersionString(eCOM_VERSION_STACK));
+   fprintf(ptsFileV, "  \"interface\": \"%s\",\n", qPrintable(clInterfaceP));
+   fprintf(ptsFileV, "  \"event_driven\": %s,\n", btEventDrivenP ? "true" : "false");
+   fprintf(ptsFileV, "  \"scan_parallel\": %u,\n", ubScanParallelP);
+   fprintf(ptsFileV, "  \"sdo_latency_ms\": %u,\n", tsSimConfigP.ulSdoLatency);
+   fprintf(ptsFileV, "  \"failed_samples\": %u,\n", ulFailedCntP);
+
+   //---------------------------------------------------------------------------------------------------
+   // bring-up time for each number of nodes
+   //
+   fprintf(ptsFileV, "  \"bring_up\": [");
+   for (int32_t slIdxT = 0; slIdxT < clBringUpP.count(); slIdxT++)
+   {
+      const CoBenchBringUp_ts & tsBringUpR = clBringUpP.at(slIdxT);
+
+      fprintf(ptsFileV, "%s\n    { \"nodes\": %u, \"operational\": %u, \"duration_ms\": %.3f }",
+              (slIdxT > 0) ? "," : "", tsBringUpR.ubNodeCnt, tsBringUpR.ubOperationalCnt,
+              (double) tsBringUpR.uqDuration / 1.0e6);
+   }
+   fprintf(ptsFileV, "\n  ],\n");
+
+   //---------------------------------------------------------------------------------------------------
+   // latencies
+   //
+   writeSamples(ptsFileV, "sdo_expedited",   clSdoExpeditedP,  false);
+   writeSamples(ptsFileV, "sdo_node_info",   clSdoNodeInfoP,   false);
+   writeSamples(ptsFileV, "sdo_segmented",   clSdoSegmentedP,  false);
+   writeSamples(ptsFileV, "rescan",          clRescanP,        false);
+   writeSamples(ptsFileV, "pdo_dispatch",    clPdoDispatchP,   false);
+   writeSamples(ptsFileV, "heartbeat_loss",  clHeartbeatLossP, true);
+
+   fprintf(ptsFileV, "}\n");
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBench::writeSamples()                                                                                            //
+// write statistics of a latency measurement in micro-seconds                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBench::writeSamples(FILE * ptsFileV, const char * szNameV, const QVector<uint64_t> & clSamplesR, bool btLastV)
+{
+   QVector<uint64_t> clSortedT = clSamplesR;
+   uint64_t          uqSumT    = 0;
+   int32_t           slCountT  = clSortedT.count();
+
+   fprintf(ptsFileV, "  \"%s\": { \"samples\": %d", szNameV, slCountT);
+
+   if (slCountT > 0)
+   {
+      std::sort(clSortedT.begin(), clSortedT.end());
+      for (uint64_t uqSampleT : clSortedT)
+      {
+         uqSumT += uqSampleT;
+      }
+
+      fprintf(ptsFileV, ", \"min_us\": %.1f, \"mean_us\": %.1f, \"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f",
+              (double) clSortedT.at(0) / 1.0e3,
+              (double) uqSumT / (1.0e3 * slCountT),
+              (double) clSortedT.at(((slCountT - 1) * 50) / 100) / 1.0e3,
+              (double) clSortedT.at(((slCountT - 1) * 99) / 100) / 1.0e3,
+              (double) clSortedT.at(slCountT - 1) / 1.0e3);
+   }
+
+   fprintf(ptsFileV, " }%s\n", btLastV ? "" : ",");
+}
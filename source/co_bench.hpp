@@ -0,0 +1,258 @@
+//====================================================================================================================//
+// File:          co_bench.hpp                                                                                        //
+// Description:   Benchmark of the CANopen master                                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_bench.hpp
+** \brief   Benchmark of the CANopen master
+**
+** The benchmark runs the CANopen master of canopen-demo (CoMasterDemo) and simulated slaves
+** (CoSimSlave) in one process on a CAN interface, usually a virtual CAN interface. It measures
+** the bring-up time of a network, SDO round-trip times, the heartbeat loss detection and the
+** dispatch of PDOs through QCoEvent. The results are written as JSON.
+*/
+#ifndef CO_BENCH_HPP_
+#define CO_BENCH_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include <stdio.h>
+
+#include "canopen_master.h"
+
+#include "co_can_tap.hpp"
+#include "co_master_demo.hpp"
+#include "co_sim_slave.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_BENCH_NODE_MAX          ((uint8_t)     127)
+
+#define  CO_BENCH_EXIT_FAILED       ((int32_t)       1)        // a measurement did not complete
+#define  CO_BENCH_EXIT_SKIPPED      ((int32_t)      77)        // CAN interface not available, see CTest
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoBenchPhase_e
+** \brief   Measurement which is running
+**
+*/
+enum CoBenchPhase_e {
+   eCO_BENCH_PHASE_IDLE = 0,
+
+   //---------------------------------------------------------------------------------------------------
+   // start of the master until all nodes reported the operational state by their heartbeat
+   //
+   eCO_BENCH_PHASE_BRING_UP,
+
+   //---------------------------------------------------------------------------------------------------
+   // reset of one slave until the master has scanned it again and the node reported the
+   // operational state
+   //
+   eCO_BENCH_PHASE_RESCAN,
+
+   //---------------------------------------------------------------------------------------------------
+   // transmission of a TPDO by a slave until QCoEvent::comPdoEventReceive()
+   //
+   eCO_BENCH_PHASE_PDO_DISPATCH,
+
+   //---------------------------------------------------------------------------------------------------
+   // last heartbeat of a slave until QCoEvent::comNmtEventHeartbeat(), the sample ends when the
+   // master has recovered the node
+   //
+   eCO_BENCH_PHASE_HEARTBEAT_LOSS,
+
+   eCO_BENCH_PHASE_DONE
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoBenchBringUp_s
+** \brief   Result of one bring-up measurement
+**
+*/
+typedef struct CoBenchBringUp_s {
+   uint8_t     ubNodeCnt;
+   uint8_t     ubOperationalCnt;
+   uint64_t    uqDuration;          // duration in nano-seconds
+} CoBenchBringUp_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoBench
+** \brief   Benchmark of the CANopen master
+**
+** The master is a CoMasterDemo object, configured by a command line like canopen-demo. It runs
+** the device scan, the configuration and the recovery of lost devices, a new master is created
+** for each bring-up. The benchmark only drives the slaves and observes the master: through the
+** signals of QCoEvent, which are received by the master and the benchmark, and on the bus.
+**
+** The slaves transmit through their own raw socket. A second raw socket (the monitor) receives
+** all frames of the master and of the slaves: frames of the master are passed to the slaves,
+** the reception time of the frames is used for measurements on the bus. The SDO round-trip
+** times are taken from the transfers of all device scans.
+**
+** The console output of the master is written to stderr, stdout only carries the results.
+*/
+class CoBench : public QObject, public CoCanListener {
+
+   Q_OBJECT
+
+public:
+
+   //--------------------------------------------------------------------------------------------------------
+   CoBench();
+
+   ~CoBench();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+public slots:
+   void           onCanRxEvent(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** The master has stopped by itself, e.g. because another master is active on the bus.
+   */
+   void           onMasterFinished(void);
+
+   void           onNmtEventHeartbeat(uint8_t ubNetV, uint8_t ubNodeIdV);
+
+   void           onNmtEventStateChange(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV);
+
+   void           onPdoEventReceive(uint8_t ubNetV, uint16_t uwPdoV);
+
+   void           onSdoEventObjectReady(uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV,
+                                         uint32_t * pulAbortV);
+
+   void           onSimTimerEvent(void);
+
+   void           onTimerEvent(void);
+
+   void           runCmdParser(void);
+
+signals:
+   void           finished(int32_t slExitCodeV);
+
+private:
+   void           finish(void);
+
+   void           nextSample(void);
+
+   void           sampleDone(QVector<uint64_t> & clSamplesR, uint64_t uqDurationV);
+
+   void           startBringUp(void);
+
+   void           startPhase(uint8_t ubPhaseV);
+
+   void           stopMaster(void);
+
+   void           writeResult(FILE * ptsFileV);
+
+   static void    writeSamples(FILE * ptsFileV, const char * szNameV, const QVector<uint64_t> & clSamplesR,
+                               bool btLastV);
+
+   //-----------------------------------------------------------------------------------------
+   // configuration
+   //
+   QString              clInterfaceP;
+   QString              clOutputFileP;
+   QList<uint8_t>       clNodeCountP;
+   uint32_t             ulSamplesP;
+   uint8_t              ubScanParallelP;
+   bool                 btEventDrivenP;
+   CoSimConfig_ts       tsSimConfigP;
+   int32_t              slResultFdP;         // stdout of the process for the results
+
+   //-----------------------------------------------------------------------------------------
+   // CANopen master and slaves
+   //
+   CoMasterDemo *       pclMasterP;
+   uint8_t              ubNodeCntP;          // number of slaves
+   CoSimSlave           aclSlaveP[CO_BENCH_NODE_MAX];
+   CoCanTap             clSimTapP;
+   CoCanTap             clMonitorP;
+   QSocketNotifier *    pclSimRxP;
+   QSocketNotifier *    pclMonitorRxP;
+   QTimer               clTimerP;            // state of the measurement
+   QTimer               clSimTimerP;         // tick of the slaves
+
+   //-----------------------------------------------------------------------------------------
+   // state of the measurement, times are monotonic times in nano-seconds
+   //
+   uint8_t              ubPhaseP;
+   uint32_t             ulSampleP;           // number of the running sample
+   uint8_t              ubNodeIdP;           // node of the running sample
+   bool                 btSampleP;           // sample is running
+   bool                 btSilentP;           // heartbeat of the node is stopped, loss not detected yet
+   uint64_t             uqStartP;            // start of the running sample or bring-up
+   uint64_t             uqDeadlineP;         // end of the running sample or bring-up
+   uint64_t             uqEndP;              // all nodes of the bring-up are operational
+   uint8_t              ubOperationalCntP;
+   uint32_t             ulFailedCntP;        // samples which did not complete
+   bool                 abtOperationalP[CO_BENCH_NODE_MAX];
+   bool                 abtBootedP[CO_BENCH_NODE_MAX];      // boot-up seen, the scan has not started
+   uint64_t             auqHeartbeatP[CO_BENCH_NODE_MAX];   // reception of the last heartbeat
+   uint64_t             auqNodeInfoP[CO_BENCH_NODE_MAX];    // first SDO request of the scan
+   uint64_t             auqExpeditedP[CO_BENCH_NODE_MAX];   // start of an expedited download
+   uint64_t             auqSegmentP[CO_BENCH_NODE_MAX];     // start of the segmented upload
+
+   //-----------------------------------------------------------------------------------------
+   // results, samples are durations in nano-seconds
+   //
+   QList<CoBenchBringUp_ts>   clBringUpP;
+   QVector<uint64_t>          clSdoExpeditedP;
+   QVector<uint64_t>          clSdoNodeInfoP;
+   QVector<uint64_t>          clSdoSegmentedP;
+   QVector<uint64_t>          clRescanP;
+   QVector<uint64_t>          clPdoDispatchP;
+   QVector<uint64_t>          clHeartbeatLossP;
+};
+
+
+#endif /*CO_BENCH_HPP_*/
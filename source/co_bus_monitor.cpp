@@ -0,0 +1,627 @@
+//====================================================================================================================//
+// File:          co_bus_monitor.cpp                                                                                  //
+// Description:   Bus load and error counter monitor                                                                  //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_bus_monitor.hpp"
+
+#include <string.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  SECOND_NS                  ((uint64_t) 1000000000)    // one second in nano-seconds
+#define  CRC15_POLYNOMIAL           ((uint16_t)     0x4599)    // CRC polynomial of CAN frames
+#define  FRAME_TRAILER_BITS         ((uint32_t)     13)        // CRC delimiter, ACK, EOF and interframe space
+#define  FRAME_STUFFED_MAX          ((uint32_t)    120)        // bits of the stuffed part of a frame
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void       addSample(CoMonitorSample_ts & tsSumR, const CoMonitorSample_ts & tsSampleR);
+
+static uint32_t   frameBits(const struct can_frame & tsFrameR);
+
+static uint8_t    frameClass(canid_t tvCanIdV);
+
+static void       putBits(uint8_t * pubBitV, uint32_t & ulPosR, uint32_t ulValueV, uint32_t ulWidthV);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Static variables                                                                                                   **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * aszClassNameS[] = {
+   "nmt",
+   "sync",
+   "emcy",
+   "pdo",
+   "sdo",
+   "heartbeat",
+   "other"
+};
+
+static const char * aszStateFormatS[] = {
+   "can%d: CAN controller initialised, REC %d, TEC %d\n",
+   "can%d: CAN controller sleeping, REC %d, TEC %d\n",
+   "can%d: CAN controller error active, REC %d, TEC %d\n",
+   "can%d: CAN controller warning level reached, REC %d, TEC %d\n",
+   "can%d: CAN controller error passive, REC %d, TEC %d\n",
+   "can%d: CAN controller bus-off, REC %d, TEC %d\n",
+   "can%d: CAN physical layer fault, REC %d, TEC %d\n"
+};
+
+static const char * aszStateNameS[] = {
+   "initialised",
+   "sleeping",
+   "error active",
+   "warning level",
+   "error passive",
+   "bus-off",
+   "physical layer fault"
+};
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::CoBusMonitor()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoBusMonitor::CoBusMonitor()
+{
+   pclLoggerP       = nullptr;
+   ubNetworkP       = 0;
+   ulBitrateP       = 500000;
+   ubLoadLimitP     = 0;
+   btOverLimitP     = false;
+
+   for (uint8_t ubClassT = 0; ubClassT < CO_MONITOR_CLASS_MAX; ubClassT++)
+   {
+      aulFrameCntP[ubClassT].store(0);
+      aulFrameBaseP[ubClassT] = 0;
+   }
+   uqBitCntP.store(0);
+   uqBitBaseP       = 0;
+   uqSecondStartP   = 0;
+
+   memset(&tsStateP, 0, sizeof(tsStateP));
+   tsStateP.ubCanErrState = eCP_STATE_INIT;
+   ubRcvErrMaxP     = 0;
+   ubTrmErrMaxP     = 0;
+
+   memset(atsSecondP,    0, sizeof(atsSecondP));
+   memset(&tsMinuteSumP, 0, sizeof(tsMinuteSumP));
+   memset(atsMinuteP,    0, sizeof(atsMinuteP));
+   memset(atsErrorP,     0, sizeof(atsErrorP));
+   ulSecondCntP     = 0;
+   ulMinuteSecondsP = 0;
+   ulMinuteCntP     = 0;
+   ulErrorCntP      = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::canFrameReceived()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   Q_UNUSED(uqTimeStampV);
+   Q_UNUSED(btLocalV);
+
+   //---------------------------------------------------------------------------------------------------
+   // frames transmitted by this host are on the bus as well, only error frames are skipped
+   //
+   if ((tsFrameR.can_id & CAN_ERR_FLAG) != 0)
+   {
+      return;
+   }
+
+   aulFrameCntP[frameClass(tsFrameR.can_id)].fetch_add(1, std::memory_order_relaxed);
+   uqBitCntP.fetch_add(frameBits(tsFrameR), std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::className()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+const char * CoBusMonitor::className(uint8_t ubClassV)
+{
+   if (ubClassV >= CO_MONITOR_CLASS_MAX)
+   {
+      return ("unknown");
+   }
+
+   return (aszClassNameS[ubClassV]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::closeMinute()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::closeMinute(void)
+{
+   atsMinuteP[ulMinuteCntP % CO_MONITOR_MINUTE_MAX] = tsMinuteSumP;
+   ulMinuteCntP++;
+
+   memset(&tsMinuteSumP, 0, sizeof(tsMinuteSumP));
+   ulMinuteSecondsP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::closeSecond()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::closeSecond(uint64_t uqTimeV)
+{
+   uint32_t ulCountT;
+   uint64_t uqBitsT;
+   uint32_t ulLoadT;
+
+   CoMonitorSample_ts & tsSampleR = atsSecondP[ulSecondCntP % CO_MONITOR_SECOND_MAX];
+
+   //---------------------------------------------------------------------------------------------------
+   // the sample is the difference of the counters to the start of the second
+   //
+   tsSampleR.ulDuration = (uint32_t) ((uqTimeV - uqSecondStartP) / 1000000);
+   tsSampleR.ulFrames   = 0;
+   for (uint8_t ubClassT = 0; ubClassT < CO_MONITOR_CLASS_MAX; ubClassT++)
+   {
+      ulCountT = aulFrameCntP[ubClassT].load(std::memory_order_relaxed);
+      tsSampleR.aulClassFrames[ubClassT] = ulCountT - aulFrameBaseP[ubClassT];
+      tsSampleR.ulFrames += tsSampleR.aulClassFrames[ubClassT];
+      aulFrameBaseP[ubClassT] = ulCountT;
+   }
+
+   uqBitsT = uqBitCntP.load(std::memory_order_relaxed);
+   tsSampleR.uqBits = uqBitsT - uqBitBaseP;
+   uqBitBaseP       = uqBitsT;
+
+   //---------------------------------------------------------------------------------------------------
+   // the highest error counters of the next second start with the current values
+   //
+   tsSampleR.ubRcvErrMax = ubRcvErrMaxP;
+   tsSampleR.ubTrmErrMax = ubTrmErrMaxP;
+   ubRcvErrMaxP          = tsStateP.ubCanRcvErrCnt;
+   ubTrmErrMaxP          = tsStateP.ubCanTrmErrCnt;
+
+   ulSecondCntP++;
+   uqSecondStartP = uqTimeV;
+
+   //---------------------------------------------------------------------------------------------------
+   // check the load limit
+   //
+   if ((ubLoadLimitP > 0) && (pclLoggerP != nullptr))
+   {
+      ulLoadT = load(tsSampleR);
+      if ((ulLoadT > ubLoadLimitP * 10u) && (btOverLimitP == false))
+      {
+         pclLoggerP->print("can%d: bus load %d.%d %% above limit of %d %%\n", ubNetworkP,
+                           ulLoadT / 10, ulLoadT % 10, ubLoadLimitP);
+         btOverLimitP = true;
+      }
+      else if ((ulLoadT <= ubLoadLimitP * 10u) && btOverLimitP)
+      {
+         pclLoggerP->print("can%d: bus load %d.%d %% below limit of %d %% again\n", ubNetworkP,
+                           ulLoadT / 10, ulLoadT % 10, ubLoadLimitP);
+         btOverLimitP = false;
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // sum up the minute
+   //
+   addSample(tsMinuteSumP, tsSampleR);
+   ulMinuteSecondsP++;
+   if (ulMinuteSecondsP >= 60)
+   {
+      closeMinute();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::error()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoBusMonitor::error(uint32_t ulIndexV, CoMonitorError_ts & tsErrorR) const
+{
+   if ((ulIndexV >= ulErrorCntP) || (ulIndexV >= CO_MONITOR_ERROR_MAX))
+   {
+      return (false);
+   }
+
+   tsErrorR = atsErrorP[(ulErrorCntP - 1 - ulIndexV) % CO_MONITOR_ERROR_MAX];
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::load()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoBusMonitor::load(const CoMonitorSample_ts & tsSampleR) const
+{
+   if ((tsSampleR.ulDuration == 0) || (ulBitrateP == 0))
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // bits / (duration [ms] / 1000 * bitrate) in 1/10 percent
+   //
+   return ((uint32_t) ((tsSampleR.uqBits * 1000000) / ((uint64_t) tsSampleR.ulDuration * ulBitrateP)));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::minute()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoBusMonitor::minute(uint32_t ulIndexV, CoMonitorSample_ts & tsSampleR) const
+{
+   if ((ulIndexV >= ulMinuteCntP) || (ulIndexV >= CO_MONITOR_MINUTE_MAX))
+   {
+      return (false);
+   }
+
+   tsSampleR = atsMinuteP[(ulMinuteCntP - 1 - ulIndexV) % CO_MONITOR_MINUTE_MAX];
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::rollingMinute()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoBusMonitor::rollingMinute(CoMonitorSample_ts & tsSampleR, uint32_t * pulPeakV) const
+{
+   uint32_t ulCountT;
+   uint32_t ulLoadT;
+   uint32_t ulPeakT = 0;
+
+   memset(&tsSampleR, 0, sizeof(tsSampleR));
+
+   ulCountT = (ulSecondCntP < CO_MONITOR_SECOND_MAX) ? ulSecondCntP : CO_MONITOR_SECOND_MAX;
+   for (uint32_t ulIdxT = 0; ulIdxT < ulCountT; ulIdxT++)
+   {
+      addSample(tsSampleR, atsSecondP[ulIdxT]);
+
+      ulLoadT = load(atsSecondP[ulIdxT]);
+      if (ulLoadT > ulPeakT)
+      {
+         ulPeakT = ulLoadT;
+      }
+   }
+
+   if (pulPeakV != nullptr)
+   {
+      *pulPeakV = ulPeakT;
+   }
+
+   return (ulCountT > 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::second()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoBusMonitor::second(uint32_t ulIndexV, CoMonitorSample_ts & tsSampleR) const
+{
+   if ((ulIndexV >= ulSecondCntP) || (ulIndexV >= CO_MONITOR_SECOND_MAX))
+   {
+      return (false);
+   }
+
+   tsSampleR = atsSecondP[(ulSecondCntP - 1 - ulIndexV) % CO_MONITOR_SECOND_MAX];
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::setBusState()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::setBusState(const CpState_ts & tsStateR, uint64_t uqTimeV)
+{
+   if (tsStateR.ubCanRcvErrCnt > ubRcvErrMaxP)
+   {
+      ubRcvErrMaxP = tsStateR.ubCanRcvErrCnt;
+   }
+   if (tsStateR.ubCanTrmErrCnt > ubTrmErrMaxP)
+   {
+      ubTrmErrMaxP = tsStateR.ubCanTrmErrCnt;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // store and log a change of the state
+   //
+   if (tsStateR.ubCanErrState != tsStateP.ubCanErrState)
+   {
+      CoMonitorError_ts & tsErrorR = atsErrorP[ulErrorCntP % CO_MONITOR_ERROR_MAX];
+
+      tsErrorR.uqTime      = uqTimeV;
+      tsErrorR.ubState     = tsStateR.ubCanErrState;
+      tsErrorR.ubRcvErrCnt = tsStateR.ubCanRcvErrCnt;
+      tsErrorR.ubTrmErrCnt = tsStateR.ubCanTrmErrCnt;
+      ulErrorCntP++;
+
+      if ((pclLoggerP != nullptr) && (tsStateR.ubCanErrState <= eCP_STATE_PHY_FAULT))
+      {
+         pclLoggerP->print(aszStateFormatS[tsStateR.ubCanErrState], ubNetworkP,
+                           tsStateR.ubCanRcvErrCnt, tsStateR.ubCanTrmErrCnt);
+      }
+   }
+
+   tsStateP = tsStateR;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::setLogger()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::setLogger(CoLogger * pclLoggerV, uint8_t ubNetV)
+{
+   pclLoggerP = pclLoggerV;
+   ubNetworkP = ubNetV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::stateName()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+const char * CoBusMonitor::stateName(uint8_t ubStateV)
+{
+   if (ubStateV > eCP_STATE_PHY_FAULT)
+   {
+      return ("unknown");
+   }
+
+   return (aszStateNameS[ubStateV]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusMonitor::tick()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusMonitor::tick(uint64_t uqTimeV)
+{
+   //---------------------------------------------------------------------------------------------------
+   // the first second starts with the first tick, frames counted before are dropped
+   //
+   if (uqSecondStartP == 0)
+   {
+      for (uint8_t ubClassT = 0; ubClassT < CO_MONITOR_CLASS_MAX; ubClassT++)
+      {
+         aulFrameBaseP[ubClassT] = aulFrameCntP[ubClassT].load(std::memory_order_relaxed);
+      }
+      uqBitBaseP     = uqBitCntP.load(std::memory_order_relaxed);
+      uqSecondStartP = uqTimeV;
+      return;
+   }
+
+   if ((uqTimeV - uqSecondStartP) >= SECOND_NS)
+   {
+      closeSecond(uqTimeV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// addSample()                                                                                                        //
+// add a sample to a sum of samples                                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+static void addSample(CoMonitorSample_ts & tsSumR, const CoMonitorSample_ts & tsSampleR)
+{
+   tsSumR.ulDuration += tsSampleR.ulDuration;
+   tsSumR.ulFrames   += tsSampleR.ulFrames;
+   tsSumR.uqBits     += tsSampleR.uqBits;
+   for (uint8_t ubClassT = 0; ubClassT < CO_MONITOR_CLASS_MAX; ubClassT++)
+   {
+      tsSumR.aulClassFrames[ubClassT] += tsSampleR.aulClassFrames[ubClassT];
+   }
+
+   if (tsSampleR.ubRcvErrMax > tsSumR.ubRcvErrMax)
+   {
+      tsSumR.ubRcvErrMax = tsSampleR.ubRcvErrMax;
+   }
+   if (tsSampleR.ubTrmErrMax > tsSumR.ubTrmErrMax)
+   {
+      tsSumR.ubTrmErrMax = tsSampleR.ubTrmErrMax;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// frameBits()                                                                                                        //
+// number of bits of a classic CAN frame on the bus, including stuff bits and interframe space                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static uint32_t frameBits(const struct can_frame & tsFrameR)
+{
+   uint8_t  aubBitT[FRAME_STUFFED_MAX];
+   uint32_t ulPosT = 0;
+   uint32_t ulDataT;
+   uint16_t uwCrcT = 0;
+   uint32_t ulStuffT = 0;
+   uint32_t ulRunT = 0;
+   uint8_t  ubLastT = 2;
+   uint8_t  ubDlcT;
+   bool     btRemoteT;
+
+   ubDlcT    = tsFrameR.can_dlc & 0x0F;
+   btRemoteT = ((tsFrameR.can_id & CAN_RTR_FLAG) != 0);
+
+   //---------------------------------------------------------------------------------------------------
+   // arbitration and control field, starting with the SOF bit
+   //
+   putBits(aubBitT, ulPosT, 0, 1);
+   if ((tsFrameR.can_id & CAN_EFF_FLAG) != 0)
+   {
+      putBits(aubBitT, ulPosT, (tsFrameR.can_id & CAN_EFF_MASK) >> 18, 11);
+      putBits(aubBitT, ulPosT, 3, 2);                                         // SRR, IDE
+      putBits(aubBitT, ulPosT, tsFrameR.can_id & 0x3FFFF, 18);
+      putBits(aubBitT, ulPosT, btRemoteT ? 1 : 0, 1);                         // RTR
+      putBits(aubBitT, ulPosT, 0, 2);                                         // r1, r0
+   }
+   else
+   {
+      putBits(aubBitT, ulPosT, tsFrameR.can_id & CAN_SFF_MASK, 11);
+      putBits(aubBitT, ulPosT, btRemoteT ? 1 : 0, 1);                         // RTR
+      putBits(aubBitT, ulPosT, 0, 2);                                         // IDE, r0
+   }
+   putBits(aubBitT, ulPosT, ubDlcT, 4);
+
+   //---------------------------------------------------------------------------------------------------
+   // data field, a remote frame has none
+   //
+   if (btRemoteT == false)
+   {
+      ulDataT = (ubDlcT > CAN_MAX_DLEN) ? CAN_MAX_DLEN : ubDlcT;
+      for (uint32_t ulByteT = 0; ulByteT < ulDataT; ulByteT++)
+      {
+         putBits(aubBitT, ulPosT, tsFrameR.data[ulByteT], 8);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // CRC field
+   //
+   for (uint32_t ulBitT = 0; ulBitT < ulPosT; ulBitT++)
+   {
+      bool btFeedbackT = (((uwCrcT >> 14) & 1) != aubBitT[ulBitT]);
+
+      uwCrcT = (uwCrcT << 1) & 0x7FFF;
+      if (btFeedbackT)
+      {
+         uwCrcT ^= CRC15_POLYNOMIAL;
+      }
+   }
+   putBits(aubBitT, ulPosT, uwCrcT, 15);
+
+   //---------------------------------------------------------------------------------------------------
+   // A stuff bit is inserted after 5 equal bits, the stuff bit starts the next sequence.
+   //
+   for (uint32_t ulBitT = 0; ulBitT < ulPosT; ulBitT++)
+   {
+      if (aubBitT[ulBitT] == ubLastT)
+      {
+         ulRunT++;
+      }
+      else
+      {
+         ubLastT = aubBitT[ulBitT];
+         ulRunT  = 1;
+      }
+
+      if (ulRunT == 5)
+      {
+         ulStuffT++;
+         ubLastT = (ubLastT == 0) ? 1 : 0;
+         ulRunT  = 1;
+      }
+   }
+
+   return (ulPosT + ulStuffT + FRAME_TRAILER_BITS);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// frameClass()                                                                                                       //
+// CANopen service of a frame                                                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+static uint8_t frameClass(canid_t tvCanIdV)
+{
+   uint32_t ulCobIdT;
+
+   if ((tvCanIdV & CAN_EFF_FLAG) != 0)
+   {
+      return (eCO_MONITOR_OTHER);
+   }
+
+   ulCobIdT = tvCanIdV & CAN_SFF_MASK;
+   if (ulCobIdT == 0x000)
+   {
+      return (eCO_MONITOR_NMT);
+   }
+   if (ulCobIdT == 0x080)
+   {
+      return (eCO_MONITOR_SYNC);
+   }
+   if (ulCobIdT < 0x100)
+   {
+      return (eCO_MONITOR_EMCY);
+   }
+   if ((ulCobIdT >= 0x180) && (ulCobIdT < 0x580))
+   {
+      return (eCO_MONITOR_PDO);
+   }
+   if ((ulCobIdT >= 0x580) && (ulCobIdT < 0x680))
+   {
+      return (eCO_MONITOR_SDO);
+   }
+   if ((ulCobIdT > 0x700) && (ulCobIdT < 0x780))
+   {
+      return (eCO_MONITOR_HEARTBEAT);
+   }
+
+   return (eCO_MONITOR_OTHER);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// putBits()                                                                                                          //
+// append a value MSB first to a bit array                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+static void putBits(uint8_t * pubBitV, uint32_t & ulPosR, uint32_t ulValueV, uint32_t ulWidthV)
+{
+   while (ulWidthV > 0)
+   {
+      ulWidthV--;
+      pubBitV[ulPosR] = (uint8_t) ((ulValueV >> ulWidthV) & 1);
+      ulPosR++;
+   }
+}
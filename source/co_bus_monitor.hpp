@@ -0,0 +1,310 @@
+//====================================================================================================================//
+// File:          co_bus_monitor.hpp                                                                                  //
+// Description:   Bus load and error counter monitor                                                                  //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_bus_monitor.hpp
+** \brief   Bus load and error counter monitor
+**
+** The monitor counts all frames seen by the CAN tap, including the frames transmitted by this
+** host. For each frame the exact number of bits on the bus is calculated, stuff bits and the
+** interframe space included, so the bus load is measured and not estimated from the frame
+** rate. Frames are counted per CANopen service, derived from the COB-ID.
+**
+** Every second tick() closes one sample with the number of frames and bits of this second and
+** the highest error counters of the CAN controller. The last 60 samples form the rolling
+** minute, every 60 seconds one minute sample is stored as well, the last 60 minute samples are
+** kept. Changes of the CAN controller state (error active, error passive, bus-off, ..) are
+** stored in a history with the error counters at the time of the change.
+*/
+#ifndef CO_BUS_MONITOR_HPP_
+#define CO_BUS_MONITOR_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "canopen_master.h"
+
+#include "co_can_tap.hpp"
+#include "co_logger.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_MONITOR_CLASS_MAX       ((uint8_t)       7)        // number of frame classes
+#define  CO_MONITOR_SECOND_MAX      ((uint32_t)     60)        // number of stored second samples
+#define  CO_MONITOR_MINUTE_MAX      ((uint32_t)     60)        // number of stored minute samples
+#define  CO_MONITOR_ERROR_MAX       ((uint32_t)     32)        // number of stored state changes
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoMonitorClass_e
+** \brief   Frame classes of the bus monitor
+**
+*/
+enum CoMonitorClass_e {
+   eCO_MONITOR_NMT = 0,                      // COB-ID 000h
+   eCO_MONITOR_SYNC,                         // COB-ID 080h
+   eCO_MONITOR_EMCY,                         // COB-ID 081h .. 0FFh
+   eCO_MONITOR_PDO,                          // COB-ID 180h .. 57Fh
+   eCO_MONITOR_SDO,                          // COB-ID 580h .. 67Fh
+   eCO_MONITOR_HEARTBEAT,                    // COB-ID 701h .. 77Fh
+   eCO_MONITOR_OTHER                         // TIME, LSS, extended frames, ..
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoMonitorSample_s
+** \brief   Bus traffic of one second or one minute
+**
+*/
+typedef struct CoMonitorSample_s {
+   uint32_t    ulDuration;                           // length of the sample in milli-seconds
+   uint32_t    ulFrames;                             // number of frames
+   uint64_t    uqBits;                               // number of bits on the bus
+   uint32_t    aulClassFrames[CO_MONITOR_CLASS_MAX]; // number of frames of each class
+   uint8_t     ubRcvErrMax;                          // highest receive error counter
+   uint8_t     ubTrmErrMax;                          // highest transmit error counter
+} CoMonitorSample_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoMonitorError_s
+** \brief   Change of the CAN controller state
+**
+*/
+typedef struct CoMonitorError_s {
+   uint64_t    uqTime;           // monotonic time in nano-seconds
+   uint8_t     ubState;          // new state, see CpState_e
+   uint8_t     ubRcvErrCnt;      // receive error counter
+   uint8_t     ubTrmErrCnt;      // transmit error counter
+} CoMonitorError_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoBusMonitor
+** \brief   Bus load and error counter monitor
+**
+** The function canFrameReceived() is called in the thread which processes the CAN tap, it only
+** updates atomic counters. These totals can be read by bits() and frames() from any thread, all
+** other functions must be called by one other thread.
+*/
+class CoBusMonitor : public CoCanListener {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoBusMonitor();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of bits on the bus since the start, including stuff bits
+   */
+   uint64_t       bits(void) const   { return (uqBitCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     current state and error counters of the CAN controller
+   */
+   const CpState_ts &   busState(void) const   { return (tsStateP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubClassV      - frame class, see CoMonitorClass_e
+   ** \return     name of the frame class
+   */
+   static const char *  className(uint8_t ubClassV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulIndexV      - index of the state change, 0 for the latest one
+   ** \param[out] tsErrorR      - state change
+   ** \return     false if the state change is not stored
+   */
+   bool           error(uint32_t ulIndexV, CoMonitorError_ts & tsErrorR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of state changes since the start, the last CO_MONITOR_ERROR_MAX are stored
+   */
+   uint32_t       errorCount(void) const        { return (ulErrorCntP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubClassV      - frame class, see CoMonitorClass_e
+   ** \return     number of frames of the class since the start
+   */
+   uint32_t       frames(uint8_t ubClassV) const
+                  { return (aulFrameCntP[ubClassV].load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsSampleR     - sample
+   ** \return     bus load of the sample in 1/10 percent
+   */
+   uint32_t       load(const CoMonitorSample_ts & tsSampleR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulIndexV      - index of the minute, 0 for the last complete minute
+   ** \param[out] tsSampleR     - sample of the minute
+   ** \return     false if the sample is not stored
+   */
+   bool           minute(uint32_t ulIndexV, CoMonitorSample_ts & tsSampleR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[out] tsSampleR     - sum of the stored second samples
+   ** \param[out] pulPeakV      - highest bus load of a single second in 1/10 percent, may be
+   **                             nullptr
+   ** \return     false if no second sample is stored
+   **
+   ** The function returns the traffic of the rolling minute, i.e. the last 60 seconds.
+   */
+   bool           rollingMinute(CoMonitorSample_ts & tsSampleR, uint32_t * pulPeakV = nullptr) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulIndexV      - index of the second, 0 for the last complete second
+   ** \param[out] tsSampleR     - sample of the second
+   ** \return     false if the sample is not stored
+   */
+   bool           second(uint32_t ulIndexV, CoMonitorSample_ts & tsSampleR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulBitrateV    - bitrate in bit/s
+   */
+   void           setBitrate(uint32_t ulBitrateV)  { ulBitrateP = ulBitrateV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsStateR      - state of the CAN controller
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** The function is called with each bus event of the CANopen master library. A change of
+   ** the state is stored and logged.
+   */
+   void           setBusState(const CpState_ts & tsStateR, uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubPercentV    - bus load limit in percent, 0 disables the limit
+   **
+   ** A second with a bus load above the limit is logged, the next message is written when the
+   ** bus load has dropped below the limit again.
+   */
+   void           setLoadLimit(uint8_t ubPercentV)  { ubLoadLimitP = ubPercentV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclLoggerV    - logger for state changes and load limit violations
+   ** \param[in]  ubNetV        - CANopen network, used for the output
+   */
+   void           setLogger(CoLogger * pclLoggerV, uint8_t ubNetV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubStateV      - state of the CAN controller, see CpState_e
+   ** \return     name of the state
+   */
+   static const char *  stateName(uint8_t ubStateV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** Close the current second sample after one second, the function is called with each timer
+   ** tick.
+   */
+   void           tick(uint64_t uqTimeV);
+
+private:
+
+   void           closeMinute(void);
+
+   void           closeSecond(uint64_t uqTimeV);
+
+   CoLogger *        pclLoggerP;
+   uint8_t           ubNetworkP;
+   uint32_t          ulBitrateP;
+   uint8_t           ubLoadLimitP;
+   bool              btOverLimitP;
+
+   //-----------------------------------------------------------------------------------------
+   // Counters written by the tap thread. tick() keeps the counter values at the start of the
+   // current second, a sample is the difference to the values at its end.
+   //
+   std::atomic<uint32_t>   aulFrameCntP[CO_MONITOR_CLASS_MAX];
+   std::atomic<uint64_t>   uqBitCntP;
+
+   uint32_t          aulFrameBaseP[CO_MONITOR_CLASS_MAX];
+   uint64_t          uqBitBaseP;
+   uint64_t          uqSecondStartP;
+
+   //-----------------------------------------------------------------------------------------
+   // state and highest error counters of the current second
+   //
+   CpState_ts        tsStateP;
+   uint8_t           ubRcvErrMaxP;
+   uint8_t           ubTrmErrMaxP;
+
+   //-----------------------------------------------------------------------------------------
+   // ring buffers of the samples, the minute sample is summed up from the second samples
+   //
+   CoMonitorSample_ts   atsSecondP[CO_MONITOR_SECOND_MAX];
+   uint32_t             ulSecondCntP;
+   CoMonitorSample_ts   tsMinuteSumP;
+   uint32_t             ulMinuteSecondsP;
+   CoMonitorSample_ts   atsMinuteP[CO_MONITOR_MINUTE_MAX];
+   uint32_t             ulMinuteCntP;
+
+   CoMonitorError_ts    atsErrorP[CO_MONITOR_ERROR_MAX];
+   uint32_t             ulErrorCntP;
+};
+
+
+#endif /*CO_BUS_MONITOR_HPP_*/
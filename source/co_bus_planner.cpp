@@ -0,0 +1,259 @@
+//====================================================================================================================//
+// File:          co_bus_planner.cpp                                                                                  //
+// Description:   Planning of heartbeat and PDO inhibit times                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_bus_planner.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t   reverseBits7(uint32_t ulValueV);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::CoBusPlanner()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoBusPlanner::CoBusPlanner()
+{
+   ulBitrateP   = 500000;
+   ubBudgetP    = 0;
+   ubPdoLoadP   = 0;
+   uwFixedTimeP = 500;
+
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::addNode()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoBusPlanner::addNode(uint8_t ubNodeIdV)
+{
+   uint8_t ubPlanCntT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_PLAN_NODE_MAX))
+   {
+      return (false);
+   }
+
+   if ((aulNodeMaskP[ubNodeIdV >> 5] & ((uint32_t) 1 << (ubNodeIdV & 0x1F))) != 0)
+   {
+      return (false);
+   }
+
+   aulNodeMaskP[ubNodeIdV >> 5] |= ((uint32_t) 1 << (ubNodeIdV & 0x1F));
+   ubNodeCntP++;
+
+   //---------------------------------------------------------------------------------------------------
+   // the plan is only changed if the number of devices exceeds the planned number
+   //
+   if (ubNodeCntP <= ubPlanCntP)
+   {
+      return (false);
+   }
+
+   ubPlanCntT = ubPlanCntP;
+   while (ubPlanCntT < ubNodeCntP)
+   {
+      ubPlanCntT = ubPlanCntT * 2;
+   }
+   if (ubPlanCntT > CO_PLAN_NODE_MAX)
+   {
+      ubPlanCntT = CO_PLAN_NODE_MAX;
+   }
+   ubPlanCntP = ubPlanCntT;
+   plan();
+
+   return (isEnabled());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::phaseDelay()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoBusPlanner::phaseDelay(uint8_t ubNodeIdV, uint64_t uqTimeV) const
+{
+   uint64_t uqPeriodT = (uint64_t) uwHeartbeatTimeP * 1000;
+   uint64_t uqPhaseT;
+
+   if ((isEnabled() == false) || (ubNodeIdV == 0) || (ubNodeIdV > CO_PLAN_NODE_MAX))
+   {
+      return (0);
+   }
+
+   uqPhaseT = (reverseBits7(ubNodeIdV) * uqPeriodT) / 128;
+
+   return ((uint32_t) ((uqPhaseT + uqPeriodT - (uqTimeV % uqPeriodT)) % uqPeriodT));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::plan()                                                                                               //
+// calculate heartbeat, consumer and inhibit time for the planned number of devices                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusPlanner::plan(void)
+{
+   uint64_t uqBitsT;
+   uint64_t uqAvailableT;
+   uint64_t uqTimeT;
+
+   btOverBudgetP  = false;
+   uwInhibitTimeP = 0;
+
+   if (isEnabled() == false)
+   {
+      uwHeartbeatTimeP = uwFixedTimeP;
+      uwConsumerTimeP  = uwFixedTimeP * 3;
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat: the budget which is not used by PDOs in bit/s, the producer time in [ms] is
+   // rounded up to the next multiple of the timer tick
+   //
+   uqBitsT      = (uint64_t) ubPlanCntP * CO_PLAN_HEARTBEAT_BITS * 1000;
+   uqAvailableT = 0;
+   if (ubBudgetP > ubPdoLoadP)
+   {
+      uqAvailableT = ((uint64_t) ulBitrateP * (ubBudgetP - ubPdoLoadP)) / 100;
+   }
+
+   if (uqAvailableT == 0)
+   {
+      uqTimeT = CO_PLAN_HEARTBEAT_MAX + 1;
+   }
+   else
+   {
+      uqTimeT = (uqBitsT + uqAvailableT - 1) / uqAvailableT;
+   }
+
+   if (uqTimeT > CO_PLAN_HEARTBEAT_MAX)
+   {
+      btOverBudgetP = true;
+      uqTimeT       = CO_PLAN_HEARTBEAT_MAX;
+   }
+   if (uqTimeT < CO_PLAN_HEARTBEAT_MIN)
+   {
+      uqTimeT = CO_PLAN_HEARTBEAT_MIN;
+   }
+   uqTimeT = ((uqTimeT + CO_PLAN_TIME_STEP - 1) / CO_PLAN_TIME_STEP) * CO_PLAN_TIME_STEP;
+
+   uwHeartbeatTimeP = (uint16_t) uqTimeT;
+   uwConsumerTimeP  = (uint16_t) (((uqTimeT * 3) / 2) + CO_PLAN_CONSUMER_MARGIN);
+
+   //---------------------------------------------------------------------------------------------------
+   // PDO: shortest distance of two PDOs of one device in multiples of 100 us
+   //
+   if (ubPdoLoadP > 0)
+   {
+      uqBitsT      = (uint64_t) ubPlanCntP * CO_PLAN_PDO_MAX * CO_PLAN_PDO_BITS * 10000;
+      uqAvailableT = ((uint64_t) ulBitrateP * ubPdoLoadP) / 100;
+      uqTimeT      = (uqBitsT + uqAvailableT - 1) / uqAvailableT;
+      if (uqTimeT > UINT16_MAX)
+      {
+         uqTimeT = UINT16_MAX;
+      }
+      uwInhibitTimeP = (uint16_t) uqTimeT;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::reset()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusPlanner::reset(void)
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < 4; ubIdxT++)
+   {
+      aulNodeMaskP[ubIdxT] = 0;
+   }
+   ubNodeCntP = 0;
+   ubPlanCntP = CO_PLAN_NODE_MIN;
+
+   plan();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::setBudget()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusPlanner::setBudget(uint32_t ulBitrateV, uint8_t ubBudgetV, uint8_t ubPdoLoadV)
+{
+   if (ulBitrateV > 0)
+   {
+      ulBitrateP = ulBitrateV;
+   }
+   ubBudgetP  = (ubBudgetV  > 100) ? 100 : ubBudgetV;
+   ubPdoLoadP = (ubPdoLoadV > 100) ? 100 : ubPdoLoadV;
+
+   plan();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoBusPlanner::setHeartbeatTime()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoBusPlanner::setHeartbeatTime(uint16_t uwTimeV)
+{
+   uwFixedTimeP = uwTimeV;
+
+   plan();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// reverseBits7()                                                                                                     //
+// reverse the order of the lower 7 bits                                                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+static uint32_t reverseBits7(uint32_t ulValueV)
+{
+   uint32_t ulResultT = 0;
+
+   for (uint32_t ulBitT = 0; ulBitT < 7; ulBitT++)
+   {
+      ulResultT = (ulResultT << 1) | ((ulValueV >> ulBitT) & 1);
+   }
+
+   return (ulResultT);
+}
@@ -0,0 +1,195 @@
+//====================================================================================================================//
+// File:          co_bus_planner.hpp                                                                                  //
+// Description:   Planning of heartbeat and PDO inhibit times                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_bus_planner.hpp
+** \brief   Planning of heartbeat and PDO inhibit times
+**
+** The planner derives the heartbeat producer time, the heartbeat consumer time and the PDO
+** inhibit time of the devices from the bitrate, the number of devices and a bus load budget:
+**
+** - The PDOs may use the configured PDO load. The inhibit time is chosen so that the
+**   transmit PDOs 1 to 4 of all devices stay within this load, even if they are sent as fast
+**   as the inhibit time allows.
+** - The heartbeats may use the rest of the budget. The producer time is the shortest multiple
+**   of 10 ms within this load, limited to 100 ms .. 10 s.
+** - The consumer time is 1.5 times the producer time plus two timer ticks.
+**
+** The number of devices is rounded up to a power of two (at least 8, at most 127), so the plan
+** only changes a few times while the devices boot.
+**
+** The producer phases are staggered: the heartbeat timer of a device starts when its producer
+** time is written, so the write is delayed until the phase of the device. The phase is the
+** bit-reversed node-ID times 1/128 of the producer time, which spreads any set of node-IDs
+** evenly over the period.
+*/
+#ifndef CO_BUS_PLANNER_HPP_
+#define CO_BUS_PLANNER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_PLAN_NODE_MAX           ((uint8_t)     127)        // highest node-ID
+#define  CO_PLAN_NODE_MIN           ((uint8_t)       8)        // smallest planned number of devices
+#define  CO_PLAN_PDO_MAX            ((uint32_t)      4)        // transmit PDOs of a device
+
+//-------------------------------------------------------------------------------------------------------
+// Number of bits of a heartbeat (1 data byte) and of a PDO (8 data bytes) with 11-bit identifier,
+// including worst case bit stuffing and interframe space
+//
+#define  CO_PLAN_HEARTBEAT_BITS     ((uint32_t)     65)
+#define  CO_PLAN_PDO_BITS           ((uint32_t)    135)
+
+#define  CO_PLAN_HEARTBEAT_MIN      ((uint16_t)    100)        // shortest producer time in [ms]
+#define  CO_PLAN_HEARTBEAT_MAX      ((uint16_t)  10000)        // longest producer time in [ms]
+#define  CO_PLAN_TIME_STEP          ((uint16_t)     10)        // producer time is a multiple of the timer tick
+#define  CO_PLAN_CONSUMER_MARGIN    ((uint16_t)     20)        // added to the consumer time in [ms]
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoBusPlanner
+** \brief   Planning of heartbeat and PDO inhibit times
+**
+** Without a bus load budget the planner returns the fixed heartbeat producer time given by
+** setHeartbeatTime(), the consumer time is three times this value and no inhibit time is
+** planned.
+*/
+class CoBusPlanner {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoBusPlanner();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID of a device which sent a boot-up message
+   ** \return     true if the plan has changed
+   */
+   bool           addNode(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     heartbeat consumer time in [ms]
+   */
+   uint16_t       consumerTime(void) const      { return (uwConsumerTimeP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     heartbeat producer time in [ms]
+   */
+   uint16_t       heartbeatTime(void) const     { return (uwHeartbeatTimeP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     PDO inhibit time in multiples of 100 us, 0 if no inhibit time is planned
+   */
+   uint16_t       inhibitTime(void) const       { return (uwInhibitTimeP); }
+
+   bool           isEnabled(void) const         { return (ubBudgetP > 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     true if the heartbeats exceed the budget even with the longest producer time
+   */
+   bool           isOverBudget(void) const      { return (btOverBudgetP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of devices the plan is made for
+   */
+   uint8_t        nodeCount(void) const         { return (ubPlanCntP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uqTimeV       - current time in micro-seconds
+   ** \return     time until the heartbeat phase of the node starts in micro-seconds
+   **
+   ** The function returns 0 if no bus load budget is set.
+   */
+   uint32_t       phaseDelay(uint8_t ubNodeIdV, uint64_t uqTimeV) const;
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulBitrateV    - bitrate in bit/s
+   ** \param[in]  ubBudgetV     - bus load budget in percent, 0 disables the planning
+   ** \param[in]  ubPdoLoadV    - bus load of the PDOs in percent, 0 disables the inhibit time
+   */
+   void           setBudget(uint32_t ulBitrateV, uint8_t ubBudgetV, uint8_t ubPdoLoadV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uwTimeV       - heartbeat producer time in [ms] without bus load budget
+   */
+   void           setHeartbeatTime(uint16_t uwTimeV);
+
+private:
+
+   void           plan(void);
+
+   uint32_t          ulBitrateP;
+   uint8_t           ubBudgetP;
+   uint8_t           ubPdoLoadP;
+   uint16_t          uwFixedTimeP;
+
+   //-----------------------------------------------------------------------------------------
+   // devices which sent a boot-up message, one bit per node-ID
+   //
+   uint32_t          aulNodeMaskP[4];
+   uint8_t           ubNodeCntP;
+
+   //-----------------------------------------------------------------------------------------
+   // current plan
+   //
+   uint8_t           ubPlanCntP;
+   bool              btOverBudgetP;
+   uint16_t          uwHeartbeatTimeP;
+   uint16_t          uwConsumerTimeP;
+   uint16_t          uwInhibitTimeP;
+};
+
+
+#endif /*CO_BUS_PLANNER_HPP_*/
@@ -0,0 +1,239 @@
+//====================================================================================================================//
+// File:          co_can_tap.cpp                                                                                      //
+// Description:   Raw SocketCAN tap on the CANopen interface                                                          //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_can_tap.hpp"
+
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/can/raw.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::CoCanTap()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoCanTap::CoCanTap()
+{
+   slSocketP      = -1;
+   ulListenerCntP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::~CoCanTap()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoCanTap::~CoCanTap()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::addListener()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoCanTap::addListener(CoCanListener * pclListenerV)
+{
+   if ((pclListenerV == nullptr) || (ulListenerCntP >= CO_CAN_TAP_LISTENER_MAX))
+   {
+      return (false);
+   }
+
+   apclListenerP[ulListenerCntP] = pclListenerV;
+   ulListenerCntP++;
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::close()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCanTap::close(void)
+{
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::open()                                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoCanTap::open(const char * szInterfaceV, bool btReceiveV)
+{
+   struct ifreq         tsIfReqT;
+   struct sockaddr_can  tsAddrT;
+
+   close();
+
+   if ((szInterfaceV == nullptr) || (strlen(szInterfaceV) >= IFNAMSIZ))
+   {
+      return (false);
+   }
+
+   slSocketP = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // get the interface index
+   //
+   memset(&tsIfReqT, 0, sizeof(tsIfReqT));
+   strncpy(tsIfReqT.ifr_name, szInterfaceV, IFNAMSIZ - 1);
+   if (::ioctl(slSocketP, SIOCGIFINDEX, &tsIfReqT) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // error frames are not needed here, the bus state is reported by the CANopen master library
+   //
+   can_err_mask_t tvErrMaskT = 0;
+   setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &tvErrMaskT, sizeof(tvErrMaskT));
+
+   //---------------------------------------------------------------------------------------------------
+   // an empty filter list disables the reception of frames
+   //
+   if (btReceiveV == false)
+   {
+      setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0);
+   }
+
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.can_family  = AF_CAN;
+   tsAddrT.can_ifindex = tsIfReqT.ifr_ifindex;
+   if (::bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::process()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoCanTap::process(void)
+{
+   struct can_frame  tsFrameT;
+   struct iovec      tsIoVecT;
+   struct msghdr     tsMsgT;
+   uint64_t          uqTimeStampT;
+   uint32_t          ulCountT = 0;
+
+   if (slSocketP < 0)
+   {
+      return (0);
+   }
+
+   tsIoVecT.iov_base = &tsFrameT;
+   tsIoVecT.iov_len  = sizeof(tsFrameT);
+
+   memset(&tsMsgT, 0, sizeof(tsMsgT));
+   tsMsgT.msg_iov    = &tsIoVecT;
+   tsMsgT.msg_iovlen = 1;
+
+   //---------------------------------------------------------------------------------------------------
+   // All frames pending at this point are stamped with the same time, this saves one system
+   // call per frame.
+   //
+   uqTimeStampT = timeStamp();
+
+   //---------------------------------------------------------------------------------------------------
+   // drain the socket, otherwise the notifier fires again immediately
+   //
+   while (::recvmsg(slSocketP, &tsMsgT, 0) == (ssize_t) sizeof(tsFrameT))
+   {
+      ulCountT++;
+
+      //-------------------------------------------------------------------------------------------
+      // SocketCAN marks frames sent by other sockets of this host with MSG_DONTROUTE
+      //
+      for (uint32_t ulIdxT = 0; ulIdxT < ulListenerCntP; ulIdxT++)
+      {
+         apclListenerP[ulIdxT]->canFrameReceived(tsFrameT, uqTimeStampT, (tsMsgT.msg_flags & MSG_DONTROUTE) != 0);
+      }
+      tsMsgT.msg_flags = 0;
+   }
+
+   return (ulCountT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::timeStamp()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoCanTap::timeStamp(void)
+{
+   struct timespec tsTimeT;
+
+   clock_gettime(CLOCK_MONOTONIC, &tsTimeT);
+   return (((uint64_t) tsTimeT.tv_sec * 1000000000) + (uint64_t) tsTimeT.tv_nsec);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCanTap::write()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoCanTap::write(const struct can_frame & tsFrameR)
+{
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   return (::write(slSocketP, &tsFrameR, sizeof(tsFrameR)) == (ssize_t) sizeof(tsFrameR));
+}
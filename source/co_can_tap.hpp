@@ -0,0 +1,171 @@
+//====================================================================================================================//
+// File:          co_can_tap.hpp                                                                                      //
+// Description:   Raw SocketCAN tap on the CANopen interface                                                          //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_can_tap.hpp
+** \brief   Raw SocketCAN tap
+**
+** The CANopen master library owns the CAN interface and does not export its file descriptor.
+** The tap opens an additional raw SocketCAN socket on the same interface: the kernel delivers
+** every frame to all sockets bound to the interface, so the tap becomes readable at the same
+** moment the stack has new data to process.
+**
+** Received frames are passed to the registered CoCanListener objects. Frames transmitted by
+** other sockets of this host, e.g. by the CANopen master library, are also received and are
+** marked as local frames.
+*/
+#ifndef CO_CAN_TAP_HPP_
+#define CO_CAN_TAP_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <linux/can.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_CAN_TAP_LISTENER_MAX    ((uint32_t)      8)        // maximum number of listeners
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoCanListener
+** \brief   Receiver of frames from the CAN tap
+**
+*/
+class CoCanListener {
+
+public:
+   virtual ~CoCanListener()   { }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsFrameR      - received CAN frame
+   ** \param[in]  uqTimeStampV  - monotonic reception time in nano-seconds
+   ** \param[in]  btLocalV      - frame has been transmitted by this host
+   **
+   ** The function is called in the thread which processes the tap, i.e. the stack thread if it
+   ** is running. It must not block.
+   */
+   virtual void   canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) = 0;
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoCanTap
+** \brief   Raw SocketCAN tap
+**
+*/
+class CoCanTap {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoCanTap();
+
+   ~CoCanTap();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclListenerV  - listener for received frames
+   ** \return     false if the maximum number of listeners is reached
+   **
+   ** Listeners must be added before the tap is processed.
+   */
+   bool           addListener(CoCanListener * pclListenerV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szInterfaceV   - name of the CAN interface, e.g. "can1"
+   ** \param[in]  btReceiveV     - false for a socket which is only used for transmission
+   ** \return     true if the socket has been opened
+   **
+   ** Open a non-blocking raw socket on the interface \c szInterfaceV. A socket opened for
+   ** transmission only does not receive any frame, so it never has to be drained.
+   */
+   bool           open(const char * szInterfaceV, bool btReceiveV = true);
+
+   void           close(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     file descriptor of the socket, -1 if the tap is closed
+   **
+   ** The file descriptor can be used with QSocketNotifier, poll() or epoll().
+   */
+   int32_t        handle(void) const   { return (slSocketP); }
+
+   bool           isOpen(void) const   { return (slSocketP >= 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of frames read from the socket
+   **
+   ** Read all pending frames from the socket and pass them to the listeners. The function does
+   ** not block.
+   */
+   uint32_t       process(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     monotonic time in nano-seconds
+   */
+   static uint64_t   timeStamp(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsFrameR      - CAN frame
+   ** \return     false if the frame could not be transmitted, e.g. the transmit queue is full
+   **
+   ** Transmit a frame on the interface, the function does not block.
+   */
+   bool           write(const struct can_frame & tsFrameR);
+
+private:
+
+   int32_t           slSocketP;
+
+   uint32_t          ulListenerCntP;
+   CoCanListener *   apclListenerP[CO_CAN_TAP_LISTENER_MAX];
+};
+
+
+#endif /*CO_CAN_TAP_HPP_*/
@@ -0,0 +1,343 @@
+//====================================================================================================================//
+// File:          co_collision_detector.cpp                                                                           //
+// Description:   Detection of node-ID collisions                                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QtGlobal>
+
+#include "co_collision_detector.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  COB_ID_SDO_RESPONSE        ((canid_t)  0x580)
+#define  COB_ID_SDO_REQUEST         ((canid_t)  0x600)
+#define  COB_ID_HEARTBEAT           ((canid_t)  0x700)
+
+#define  HEARTBEAT_BOOT_UP          ((uint8_t)   0x00)
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::CoCollisionDetector()                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoCollisionDetector::CoCollisionDetector()
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_COLLISION_NODE_MAX; ubIdxT++)
+   {
+      auwHeartbeatTimeP[ubIdxT].store(0, std::memory_order_relaxed);
+      abtCollisionP[ubIdxT].store(false, std::memory_order_relaxed);
+   }
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::canFrameReceived()                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   canid_t  tvFuncT;
+   uint8_t  ubNodeIdT;
+
+   Q_UNUSED(btLocalV);
+
+   //---------------------------------------------------------------------------------------------------
+   // The simulator may run on this host, so local frames are evaluated as well. Only standard
+   // data frames are relevant.
+   //
+   if ((tsFrameR.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0)
+   {
+      return;
+   }
+
+   tvFuncT   = tsFrameR.can_id & 0x780;
+   ubNodeIdT = (uint8_t) (tsFrameR.can_id & 0x07F);
+   if (ubNodeIdT == 0)
+   {
+      return;
+   }
+
+   TapNode_s & tsNodeR = atsTapNodeP[ubNodeIdT - 1];
+
+   switch (tvFuncT)
+   {
+      //-------------------------------------------------------------------------------------------
+      // Each SDO request is answered by exactly one response. A second response to the same
+      // request has been sent by a second device.
+      //
+      case COB_ID_SDO_REQUEST:
+         tsNodeR.btRequest = true;
+         break;
+
+      case COB_ID_SDO_RESPONSE:
+         if (tsNodeR.btRequest == false)
+         {
+            strike(ubNodeIdT, uqTimeStampV);
+         }
+         tsNodeR.btRequest = false;
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // Two producers with the same period interleave their heartbeats, one of two intervals
+      // is at most half of the period then.
+      //
+      case COB_ID_HEARTBEAT:
+         if ((tsFrameR.can_dlc == 1) && (tsFrameR.data[0] != HEARTBEAT_BOOT_UP))
+         {
+            uint64_t uqLimitT = (uint64_t) auwHeartbeatTimeP[ubNodeIdT - 1].load(std::memory_order_relaxed);
+
+            uqLimitT = uqLimitT * 500000;
+            if ((uqLimitT > 0) && (tsNodeR.uqHeartbeat > 0) &&
+                ((uqTimeStampV - tsNodeR.uqHeartbeat) < uqLimitT))
+            {
+               strike(ubNodeIdT, uqTimeStampV);
+            }
+            tsNodeR.uqHeartbeat = uqTimeStampV;
+         }
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::identityRead()                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::identityRead(uint8_t ubNodeIdV, uint32_t ulSerialV)
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX) || (ulSerialV == 0))
+   {
+      return;
+   }
+
+   Node_s & tsNodeR = atsNodeP[ubNodeIdV - 1];
+
+   if (tsNodeR.aulSerial[0] == 0)
+   {
+      tsNodeR.aulSerial[0] = ulSerialV;
+   }
+   else if ((tsNodeR.aulSerial[0] != ulSerialV) && (tsNodeR.btQuarantined == false))
+   {
+      //-------------------------------------------------------------------------------------------
+      // no boot-up message in between, so a second device has answered
+      //
+      tsNodeR.aulSerial[1] = ulSerialV;
+      tsNodeR.btConflict   = true;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::isQuarantined()                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoCollisionDetector::isQuarantined(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX))
+   {
+      return (false);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].btQuarantined);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::nextCollision()                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoCollisionDetector::nextCollision(void)
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_COLLISION_NODE_MAX; ubIdxT++)
+   {
+      Node_s & tsNodeR = atsNodeP[ubIdxT];
+      bool     btCollisionT;
+
+      btCollisionT = abtCollisionP[ubIdxT].exchange(false, std::memory_order_relaxed);
+      if (tsNodeR.btConflict)
+      {
+         tsNodeR.btConflict = false;
+         btCollisionT       = true;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // a quarantined node is reported once
+      //
+      if (btCollisionT && (tsNodeR.btQuarantined == false))
+      {
+         tsNodeR.btQuarantined = true;
+         tsNodeR.btUnresolved  = true;
+         return (ubIdxT + 1);
+      }
+   }
+
+   return (0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::nextUnresolved()                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoCollisionDetector::nextUnresolved(void)
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_COLLISION_NODE_MAX; ubIdxT++)
+   {
+      if (atsNodeP[ubIdxT].btUnresolved)
+      {
+         atsNodeP[ubIdxT].btUnresolved = false;
+         return (ubIdxT + 1);
+      }
+   }
+
+   return (0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::nodeBooted()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::nodeBooted(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX))
+   {
+      return;
+   }
+
+   auwHeartbeatTimeP[ubNodeIdV - 1].store(0, std::memory_order_relaxed);
+
+   //---------------------------------------------------------------------------------------------------
+   // the serial numbers of a quarantined node are kept for the resolution
+   //
+   if (atsNodeP[ubNodeIdV - 1].btQuarantined == false)
+   {
+      atsNodeP[ubNodeIdV - 1].aulSerial[0] = 0;
+      atsNodeP[ubNodeIdV - 1].aulSerial[1] = 0;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::release()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::release(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX))
+   {
+      return;
+   }
+
+   atsNodeP[ubNodeIdV - 1] = { { 0, 0 }, false, false, false };
+   abtCollisionP[ubNodeIdV - 1].store(false, std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::reset()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::reset(void)
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_COLLISION_NODE_MAX; ubIdxT++)
+   {
+      atsTapNodeP[ubIdxT] = { false, 0, 0, 0 };
+      atsNodeP[ubIdxT]    = { { 0, 0 }, false, false, false };
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::serial()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoCollisionDetector::serial(uint8_t ubNodeIdV, uint8_t ubIdxV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX) || (ubIdxV > 1))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].aulSerial[ubIdxV]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::setHeartbeatTime()                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::setHeartbeatTime(uint8_t ubNodeIdV, uint16_t uwTimeV)
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_COLLISION_NODE_MAX))
+   {
+      return;
+   }
+
+   auwHeartbeatTimeP[ubNodeIdV - 1].store(uwTimeV, std::memory_order_relaxed);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoCollisionDetector::strike()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoCollisionDetector::strike(uint8_t ubNodeIdV, uint64_t uqTimeStampV)
+{
+   TapNode_s & tsNodeR = atsTapNodeP[ubNodeIdV - 1];
+
+   //---------------------------------------------------------------------------------------------------
+   // start a new window if the last one has expired
+   //
+   if ((tsNodeR.ubStrikeCnt == 0) || ((uqTimeStampV - tsNodeR.uqStrikeStart) > CO_COLLISION_WINDOW))
+   {
+      tsNodeR.ubStrikeCnt   = 0;
+      tsNodeR.uqStrikeStart = uqTimeStampV;
+   }
+
+   tsNodeR.ubStrikeCnt++;
+   if (tsNodeR.ubStrikeCnt >= CO_COLLISION_STRIKE_MIN)
+   {
+      tsNodeR.ubStrikeCnt = 0;
+      abtCollisionP[ubNodeIdV - 1].store(true, std::memory_order_relaxed);
+   }
+}
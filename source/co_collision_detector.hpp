@@ -0,0 +1,191 @@
+//====================================================================================================================//
+// File:          co_collision_detector.hpp                                                                           //
+// Description:   Detection of node-ID collisions                                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_collision_detector.hpp
+** \brief   Detection of node-ID collisions
+**
+*/
+#ifndef CO_COLLISION_DETECTOR_HPP_
+#define CO_COLLISION_DETECTOR_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <atomic>
+
+#include <stdint.h>
+
+#include "co_can_tap.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_COLLISION_NODE_MAX      ((uint8_t)     127)        // highest node-ID
+#define  CO_COLLISION_STRIKE_MIN    ((uint8_t)       3)        // strikes within the window for a collision
+#define  CO_COLLISION_WINDOW        ((uint64_t) 10000000000)   // window for the strikes in nano-seconds
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoCollisionDetector
+** \brief   Detection of node-ID collisions
+**
+** Two devices with the same node-ID answer the same SDO request and both produce heartbeats
+** with the same COB-ID. The detector watches the frames of the CAN tap and counts a strike for
+**
+** - an SDO response of a node without a preceding SDO request,
+** - two heartbeats of a node within less than half of its configured producer time.
+**
+** CO_COLLISION_STRIKE_MIN strikes within CO_COLLISION_WINDOW report a collision. Lost or late
+** frames cause single strikes only. The heartbeat check needs the producer time of the node,
+** it is set by setHeartbeatTime() when the heartbeat of the node has been configured.
+**
+** Independent of the CAN tap the identity reads of the scan are correlated: two different
+** serial numbers read for a node between two boot-up messages report a collision as well.
+**
+** SDO block uploads answer several segments per request, they are taken as collision.
+**
+** canFrameReceived() is called in the thread which processes the tap and only exchanges atomic
+** values with the other functions, which must be called by one other thread.
+*/
+class CoCollisionDetector : public CoCanListener {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoCollisionDetector();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  ulSerialV     - serial number read from the node (1018h:04h)
+   */
+   void           identityRead(uint8_t ubNodeIdV, uint32_t ulSerialV);
+
+   bool           isQuarantined(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     node-ID of a newly detected collision, 0 if there is none
+   **
+   ** The returned node-ID is quarantined until release() is called.
+   */
+   uint8_t        nextCollision(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     node-ID of a quarantined node which waits for its resolution, 0 if there is none
+   **
+   ** Each quarantined node-ID is returned once.
+   */
+   uint8_t        nextUnresolved(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** A boot-up message of the node has been received, its heartbeat is not configured yet and
+   ** a different device may answer now.
+   */
+   void           nodeBooted(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The collision has been resolved, e.g. one device has got a new node-ID.
+   */
+   void           release(uint8_t ubNodeIdV);
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  ubIdxV        - 0 for the serial number read first, 1 for the conflicting one
+   ** \return     serial number, 0 if it is not known
+   */
+   uint32_t       serial(uint8_t ubNodeIdV, uint8_t ubIdxV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uwTimeV       - heartbeat producer time of the node in milli-seconds, 0 to stop
+   **                             the heartbeat check
+   */
+   void           setHeartbeatTime(uint8_t ubNodeIdV, uint16_t uwTimeV);
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // data of the tap thread
+   //
+   struct TapNode_s {
+      bool        btRequest;     // SDO request seen, the response is pending
+      uint8_t     ubStrikeCnt;
+      uint64_t    uqStrikeStart; // time of the first strike in the window
+      uint64_t    uqHeartbeat;   // time of the last heartbeat
+   };
+
+   void           strike(uint8_t ubNodeIdV, uint64_t uqTimeStampV);
+
+   //-----------------------------------------------------------------------------------------
+   // data of the main thread
+   //
+   struct Node_s {
+      uint32_t    aulSerial[2];
+      bool        btConflict;    // conflicting serial numbers
+      bool        btQuarantined;
+      bool        btUnresolved;
+   };
+
+   TapNode_s               atsTapNodeP[CO_COLLISION_NODE_MAX];
+   Node_s                  atsNodeP[CO_COLLISION_NODE_MAX];
+
+   //-----------------------------------------------------------------------------------------
+   // exchanged between the threads: the producer time is written by the main thread, the
+   // collision flag is set by the tap thread and cleared by nextCollision()
+   //
+   std::atomic<uint16_t>   auwHeartbeatTimeP[CO_COLLISION_NODE_MAX];
+   std::atomic<bool>       abtCollisionP[CO_COLLISION_NODE_MAX];
+};
+
+
+#endif /*CO_COLLISION_DETECTOR_HPP_*/
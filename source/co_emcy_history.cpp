@@ -0,0 +1,260 @@
+//====================================================================================================================//
+// File:          co_emcy_history.cpp                                                                                 //
+// Description:   EMCY history of the devices                                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_emcy_history.hpp"
+
+#include <string.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  NANO_SECONDS               ((uint64_t) 1000000000)    // nano-seconds per second
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::CoEmcyHistory()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoEmcyHistory::CoEmcyHistory()
+{
+   setRate(CO_EMCY_RATE_DEFAULT);
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::count()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoEmcyHistory::count(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_EMCY_NODE_MAX))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ulCount);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::entry()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoEmcyHistory::entry(uint8_t ubNodeIdV, uint32_t ulIndexV, CoEmcyEntry_ts & tsEntryR) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_EMCY_NODE_MAX))
+   {
+      return (false);
+   }
+
+   const Node_s & tsNodeR = atsNodeP[ubNodeIdV - 1];
+
+   if (ulIndexV >= tsNodeR.ulUsed)
+   {
+      return (false);
+   }
+
+   tsEntryR = tsNodeR.atsEntry[(tsNodeR.ulHead + CO_EMCY_HISTORY_DEPTH - ulIndexV) % CO_EMCY_HISTORY_DEPTH];
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::record()                                                                                            //
+// store an EMCY and check the notification rate                                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoEmcyHistory::record(uint8_t ubNodeIdV, const uint8_t * pubDataV, uint64_t uqTimeV, uint32_t & ulSuppressedR)
+{
+   CoEmcyEntry_ts *  ptsEntryT = nullptr;
+   CoEmcyEntry_ts    tsMatchT;
+   uint32_t          ulNextT;
+   uint16_t          uwCodeT;
+
+   ulSuppressedR = 0;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_EMCY_NODE_MAX) || (pubDataV == nullptr))
+   {
+      return (false);
+   }
+
+   Node_s & tsNodeR = atsNodeP[ubNodeIdV - 1];
+
+   tsNodeR.ulCount++;
+   uwCodeT = (uint16_t) (pubDataV[0] | (pubDataV[1] << 8));
+
+   //---------------------------------------------------------------------------------------------------
+   // Coalesce the EMCY with a stored entry of the same error. The entry becomes the latest one,
+   // the newer entries move one position towards the tail. The ring has a fixed size, so the
+   // search and the move cost the same for each EMCY.
+   //
+   for (uint32_t ulIdxT = 0; ulIdxT < tsNodeR.ulUsed; ulIdxT++)
+   {
+      if ((tsNodeR.atsEntry[ulIdxT].uwCode == uwCodeT) && (tsNodeR.atsEntry[ulIdxT].ubRegister == pubDataV[2]))
+      {
+         tsMatchT = tsNodeR.atsEntry[ulIdxT];
+         while (ulIdxT != tsNodeR.ulHead)
+         {
+            ulNextT = (ulIdxT + 1) % CO_EMCY_HISTORY_DEPTH;
+            tsNodeR.atsEntry[ulIdxT] = tsNodeR.atsEntry[ulNextT];
+            ulIdxT  = ulNextT;
+         }
+         tsNodeR.atsEntry[tsNodeR.ulHead] = tsMatchT;
+         ptsEntryT = &tsNodeR.atsEntry[tsNodeR.ulHead];
+         break;
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a new error overwrites the least recently seen entry
+   //
+   if (ptsEntryT == nullptr)
+   {
+      tsNodeR.ulHead = (tsNodeR.ulHead + 1) % CO_EMCY_HISTORY_DEPTH;
+      if (tsNodeR.ulUsed < CO_EMCY_HISTORY_DEPTH)
+      {
+         tsNodeR.ulUsed++;
+      }
+
+      ptsEntryT = &tsNodeR.atsEntry[tsNodeR.ulHead];
+      ptsEntryT->uqFirst    = uqTimeV;
+      ptsEntryT->ulCount    = 0;
+      ptsEntryT->uwCode     = uwCodeT;
+      ptsEntryT->ubRegister = pubDataV[2];
+   }
+
+   ptsEntryT->uqLast = uqTimeV;
+   ptsEntryT->ulCount++;
+   memcpy(&ptsEntryT->aubManufacturer[0], &pubDataV[3], sizeof(ptsEntryT->aubManufacturer));
+
+   //---------------------------------------------------------------------------------------------------
+   // check the notification rate
+   //
+   if (takeToken(tsNodeR, uqTimeV) == false)
+   {
+      tsNodeR.ulSuppressed++;
+      return (false);
+   }
+
+   ulSuppressedR         = tsNodeR.ulSuppressed;
+   tsNodeR.ulSuppressed  = 0;
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::reset()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoEmcyHistory::reset(void)
+{
+   memset(&atsNodeP[0], 0, sizeof(atsNodeP));
+
+   for (uint8_t ubNodeIdT = 0; ubNodeIdT < CO_EMCY_NODE_MAX; ubNodeIdT++)
+   {
+      atsNodeP[ubNodeIdT].ulHead   = CO_EMCY_HISTORY_DEPTH - 1;
+      atsNodeP[ubNodeIdT].ulTokens = ulBurstP;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::setRate()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoEmcyHistory::setRate(uint32_t ulRateV)
+{
+   ulBurstP  = ulRateV;
+   uqPeriodP = (ulRateV > 0) ? (NANO_SECONDS / ulRateV) : 0;
+
+   for (uint8_t ubNodeIdT = 0; ubNodeIdT < CO_EMCY_NODE_MAX; ubNodeIdT++)
+   {
+      atsNodeP[ubNodeIdT].ulTokens = ulBurstP;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoEmcyHistory::takeToken()                                                                                         //
+// token bucket of the notification rate                                                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoEmcyHistory::takeToken(Node_s & tsNodeR, uint64_t uqTimeV)
+{
+   uint64_t uqStepsT;
+
+   if (ulBurstP == 0)
+   {
+      return (true);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // one token is added for each elapsed period, the bucket holds at most ulBurstP tokens
+   //
+   if (tsNodeR.ulTokens < ulBurstP)
+   {
+      uqStepsT = (uqTimeV - tsNodeR.uqRefill) / uqPeriodP;
+      if (uqStepsT >= (uint64_t) (ulBurstP - tsNodeR.ulTokens))
+      {
+         tsNodeR.ulTokens = ulBurstP;
+      }
+      else
+      {
+         tsNodeR.ulTokens += (uint32_t) uqStepsT;
+         tsNodeR.uqRefill += uqStepsT * uqPeriodP;
+      }
+   }
+
+   if (tsNodeR.ulTokens == 0)
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the refill period starts when the first token is taken from a full bucket
+   //
+   if (tsNodeR.ulTokens == ulBurstP)
+   {
+      tsNodeR.uqRefill = uqTimeV;
+   }
+   tsNodeR.ulTokens--;
+
+   return (true);
+}
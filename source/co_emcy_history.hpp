@@ -0,0 +1,162 @@
+//====================================================================================================================//
+// File:          co_emcy_history.hpp                                                                                 //
+// Description:   EMCY history of the devices                                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_emcy_history.hpp
+** \brief   EMCY history of the devices
+**
+** Each device has a ring of the last CO_EMCY_HISTORY_DEPTH emergency messages. An EMCY with the
+** same error code and error register as a stored entry is coalesced into this entry: its counter
+** and the time of the latest EMCY are updated and the entry becomes the latest one. A device which
+** repeats the same error does not push the other errors out of the ring, a new error replaces the
+** least recently seen entry.
+**
+** The notification of the application is rate limited for each device by a token bucket. EMCY
+** messages above the limit are stored, but not reported; the number of suppressed messages is
+** passed with the next notification.
+**
+** The memory is allocated with the object and the cost of record() does not depend on the EMCY
+** rate, so an EMCY storm of all devices does not slow down the CANopen stack.
+*/
+#ifndef CO_EMCY_HISTORY_HPP_
+#define CO_EMCY_HISTORY_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_EMCY_NODE_MAX           ((uint8_t)     127)        // highest node-ID
+#define  CO_EMCY_HISTORY_DEPTH      ((uint32_t)      8)        // number of entries per device
+#define  CO_EMCY_RATE_DEFAULT       ((uint32_t)      5)        // notifications per second and device
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoEmcyEntry_s
+** \brief   Entry of the EMCY history
+**
+*/
+typedef struct CoEmcyEntry_s {
+   uint64_t    uqFirst;             // reception time of the first EMCY in nano-seconds
+   uint64_t    uqLast;              // reception time of the latest EMCY in nano-seconds
+   uint32_t    ulCount;             // number of coalesced EMCY messages
+   uint16_t    uwCode;              // emergency error code
+   uint8_t     ubRegister;          // error register, object 1001h
+   uint8_t     aubManufacturer[5];  // manufacturer specific error field of the latest EMCY
+} CoEmcyEntry_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoEmcyHistory
+** \brief   EMCY history and notification rate limit of all devices
+**
+** The class is not thread-safe: record() is called by the EMCY callback of the CANopen master
+** library, the other functions must be called in the same thread or with the stack lock held.
+*/
+class CoEmcyHistory {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoEmcyHistory();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     number of EMCY messages received from the device
+   */
+   uint32_t       count(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  ulIndexV      - index of the entry, 0 for the latest one
+   ** \param[out] tsEntryR      - entry
+   ** \return     false if the entry is not stored
+   */
+   bool           entry(uint8_t ubNodeIdV, uint32_t ulIndexV, CoEmcyEntry_ts & tsEntryR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  pubDataV      - EMCY data, 8 bytes
+   ** \param[in]  uqTimeV       - monotonic reception time in nano-seconds
+   ** \param[out] ulSuppressedR - number of EMCY messages suppressed since the last notification
+   ** \return     true if the application shall be notified
+   **
+   ** Store the EMCY in the history of the device and check the notification rate.
+   */
+   bool           record(uint8_t ubNodeIdV, const uint8_t * pubDataV, uint64_t uqTimeV, uint32_t & ulSuppressedR);
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulRateV       - notifications per second and device, 0 for no limit
+   **
+   ** Up to \a ulRateV notifications are passed at once, afterwards one notification every
+   ** 1 / \a ulRateV seconds.
+   */
+   void           setRate(uint32_t ulRateV);
+
+private:
+
+   struct Node_s {
+      CoEmcyEntry_ts atsEntry[CO_EMCY_HISTORY_DEPTH];
+      uint32_t       ulHead;           // index of the latest entry
+      uint32_t       ulUsed;           // number of stored entries
+      uint32_t       ulCount;          // number of received EMCY messages
+      uint32_t       ulSuppressed;     // EMCY messages suppressed since the last notification
+      uint32_t       ulTokens;         // remaining notifications
+      uint64_t       uqRefill;         // time of the last token refill in nano-seconds
+   };
+
+   bool           takeToken(Node_s & tsNodeR, uint64_t uqTimeV);
+
+   uint32_t       ulBurstP;
+   uint64_t       uqPeriodP;           // token refill period in nano-seconds
+
+   Node_s         atsNodeP[CO_EMCY_NODE_MAX];
+};
+
+
+#endif /*CO_EMCY_HISTORY_HPP_*/
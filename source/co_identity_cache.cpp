@@ -0,0 +1,220 @@
+//====================================================================================================================//
+// File:          co_identity_cache.cpp                                                                               //
+// Description:   Persistent cache of device identity data                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_identity_cache.hpp"
+
+#include <string.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::CoIdentityCache()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoIdentityCache::CoIdentityCache()
+{
+   pclSettingsP = nullptr;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::~CoIdentityCache()                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoIdentityCache::~CoIdentityCache()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::close()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoIdentityCache::close(void)
+{
+   if (pclSettingsP != nullptr)
+   {
+      pclSettingsP->sync();
+      delete pclSettingsP;
+      pclSettingsP = nullptr;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::group()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+QString CoIdentityCache::group(const QString & clNetworkR, uint8_t ubNodeIdV) const
+{
+   return (QString("%1/node%2").arg(clNetworkR).arg(ubNodeIdV, 3, 10, QLatin1Char('0')));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::load()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoIdentityCache::load(const QString & clNetworkR, uint8_t ubNodeIdV, ComNode_ts * ptsNodeV) const
+{
+   QByteArray  clNameT;
+   size_t      tvSizeT;
+
+   if ((pclSettingsP == nullptr) || (ptsNodeV == nullptr))
+   {
+      return (false);
+   }
+
+   pclSettingsP->beginGroup(group(clNetworkR, ubNodeIdV));
+   if (pclSettingsP->contains("serial-number") == false)
+   {
+      pclSettingsP->endGroup();
+      return (false);
+   }
+
+   ptsNodeV->ulIdx1000_DT = pclSettingsP->value("device-type").toUInt();
+   ptsNodeV->ulIdx1018_VI = pclSettingsP->value("vendor-id").toUInt();
+   ptsNodeV->ulIdx1018_PC = pclSettingsP->value("product-code").toUInt();
+   ptsNodeV->ulIdx1018_RN = pclSettingsP->value("revision-number").toUInt();
+   ptsNodeV->ulIdx1018_SN = pclSettingsP->value("serial-number").toUInt();
+
+   //---------------------------------------------------------------------------------------------------
+   // the device name is truncated to the size of the buffer and always terminated
+   //
+   clNameT = pclSettingsP->value("device-name").toString().toLatin1();
+   tvSizeT = sizeof(ptsNodeV->aubIdx1008_DN) - 1;
+   if ((size_t) clNameT.size() < tvSizeT)
+   {
+      tvSizeT = (size_t) clNameT.size();
+   }
+   memcpy(&ptsNodeV->aubIdx1008_DN[0], clNameT.constData(), tvSizeT);
+   ptsNodeV->aubIdx1008_DN[tvSizeT] = 0;
+
+   pclSettingsP->endGroup();
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::lookup()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoIdentityCache::lookup(const QString & clNetworkR, uint8_t ubNodeIdV, uint32_t * pulSerialV) const
+{
+   QVariant clValueT;
+
+   if (pclSettingsP == nullptr)
+   {
+      return (false);
+   }
+
+   clValueT = pclSettingsP->value(group(clNetworkR, ubNodeIdV) + "/serial-number");
+   if (clValueT.isValid() == false)
+   {
+      return (false);
+   }
+
+   if (pulSerialV != nullptr)
+   {
+      *pulSerialV = clValueT.toUInt();
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::open()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoIdentityCache::open(const QString & clFileNameR)
+{
+   close();
+
+   pclSettingsP = new QSettings(clFileNameR, QSettings::IniFormat);
+   if (pclSettingsP->status() != QSettings::NoError)
+   {
+      close();
+      return (false);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::remove()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoIdentityCache::remove(const QString & clNetworkR, uint8_t ubNodeIdV)
+{
+   if (pclSettingsP != nullptr)
+   {
+      pclSettingsP->remove(group(clNetworkR, ubNodeIdV));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoIdentityCache::store()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoIdentityCache::store(const QString & clNetworkR, uint8_t ubNodeIdV, const ComNode_ts * ptsNodeV)
+{
+   if ((pclSettingsP == nullptr) || (ptsNodeV == nullptr))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a device without serial number can't be verified after boot-up
+   //
+   if (ptsNodeV->ulIdx1018_SN == 0)
+   {
+      remove(clNetworkR, ubNodeIdV);
+      return;
+   }
+
+   pclSettingsP->beginGroup(group(clNetworkR, ubNodeIdV));
+   pclSettingsP->setValue("device-type",     ptsNodeV->ulIdx1000_DT);
+   pclSettingsP->setValue("device-name",     QString::fromLatin1((const char *) &ptsNodeV->aubIdx1008_DN[0]));
+   pclSettingsP->setValue("vendor-id",       ptsNodeV->ulIdx1018_VI);
+   pclSettingsP->setValue("product-code",    ptsNodeV->ulIdx1018_PC);
+   pclSettingsP->setValue("revision-number", ptsNodeV->ulIdx1018_RN);
+   pclSettingsP->setValue("serial-number",   ptsNodeV->ulIdx1018_SN);
+   pclSettingsP->endGroup();
+}
@@ -0,0 +1,116 @@
+//====================================================================================================================//
+// File:          co_identity_cache.hpp                                                                               //
+// Description:   Persistent cache of device identity data                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_identity_cache.hpp
+** \brief   Persistent cache of device identity data
+**
+*/
+#ifndef CO_IDENTITY_CACHE_HPP_
+#define CO_IDENTITY_CACHE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QSettings>
+#include <QtCore/QString>
+
+#include "canopen_master.h"
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoIdentityCache
+** \brief   Persistent cache of device identity data
+**
+** The cache stores the identity data of a device read by ComNodeGetInfo() in an INI file:
+** device type (1000h), device name (1008h) and the identity object (1018h). Entries are keyed
+** by the CAN interface and the node-ID, e.g. group \c can1/node005. The error register (1001h)
+** changes during operation and is not stored. Devices without serial number (1018h:04h is 0)
+** are not stored, since they can't be verified.
+*/
+class CoIdentityCache {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoIdentityCache();
+
+   ~CoIdentityCache();
+
+   void           close(void);
+
+   bool           isOpen(void) const      { return (pclSettingsP != nullptr); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  clNetworkR    - name of the CAN interface
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[out] ptsNodeV      - device information
+   ** \return     true if an entry has been found
+   **
+   ** Copy the cached identity data into \c ptsNodeV, other members of the structure are not
+   ** changed.
+   */
+   bool           load(const QString & clNetworkR, uint8_t ubNodeIdV, ComNode_ts * ptsNodeV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  clNetworkR    - name of the CAN interface
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[out] pulSerialV    - cached serial number (1018h:04h)
+   ** \return     true if an entry has been found
+   */
+   bool           lookup(const QString & clNetworkR, uint8_t ubNodeIdV, uint32_t * pulSerialV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  clFileNameR   - name of the cache file
+   ** \return     true if the file can be used
+   */
+   bool           open(const QString & clFileNameR);
+
+   void           remove(const QString & clNetworkR, uint8_t ubNodeIdV);
+
+   void           store(const QString & clNetworkR, uint8_t ubNodeIdV, const ComNode_ts * ptsNodeV);
+
+private:
+
+   QString        group(const QString & clNetworkR, uint8_t ubNodeIdV) const;
+
+   QSettings *    pclSettingsP;
+};
+
+
+#endif /*CO_IDENTITY_CACHE_HPP_*/
@@ -0,0 +1,352 @@
+//====================================================================================================================//
+// File:          co_latency.cpp                                                                                      //
+// Description:   Latency histograms of the master event handlers                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_latency.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  SUB_BUCKET_COUNT           ((uint32_t) (1 << CO_LATENCY_SUB_BITS))
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Static variables                                                                                                   **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static const char * aszPathNameS[eCO_LATENCY_PATH_MAX] = {
+   "EmcyConsEventReceive",
+   "LssEventReceive",
+   "MgrEventBus",
+   "NmtEventHeartbeat",
+   "NmtEventMasterDetection",
+   "NmtEventStateChange",
+   "PdoEventReceive",
+   "PdoEventTimeout",
+   "SdoEventObjectReady",
+   "SdoEventTimeout",
+   "ComMgrProcess",
+   "ComMgrNetTimerEvent",
+   "DeviceScan",
+   "EventQueue",
+   "TimerTick",
+   "TickLateness"
+};
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::CoLatencyHistogram()                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLatencyHistogram::CoLatencyHistogram()
+{
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::bucket()                                                                                       //
+// the upper 5 significant bits of the value select the bucket                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoLatencyHistogram::bucket(uint64_t uqValueV)
+{
+   uint32_t ulShiftT;
+
+   if (uqValueV < (2 * SUB_BUCKET_COUNT))
+   {
+      return ((uint32_t) uqValueV);
+   }
+
+   ulShiftT = (uint32_t) (63 - __builtin_clzll(uqValueV)) - CO_LATENCY_SUB_BITS;
+   if (ulShiftT > CO_LATENCY_SHIFT_MAX)
+   {
+      return (CO_LATENCY_BUCKET_MAX - 1);
+   }
+
+   return ((ulShiftT * SUB_BUCKET_COUNT) + (uint32_t) (uqValueV >> ulShiftT));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::bucketLimit()                                                                                  //
+// largest value stored in a bucket                                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoLatencyHistogram::bucketLimit(uint32_t ulBucketV)
+{
+   uint32_t ulShiftT;
+   uint64_t uqMantissaT;
+
+   if (ulBucketV < (2 * SUB_BUCKET_COUNT))
+   {
+      return (ulBucketV);
+   }
+
+   ulShiftT    = (ulBucketV / SUB_BUCKET_COUNT) - 1;
+   uqMantissaT = ulBucketV - (ulShiftT * SUB_BUCKET_COUNT);
+
+   return (((uqMantissaT + 1) << ulShiftT) - 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::mean()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoLatencyHistogram::mean(void) const
+{
+   uint64_t uqCountT = count();
+
+   if (uqCountT == 0)
+   {
+      return (0);
+   }
+
+   return (uqSumP.load(std::memory_order_relaxed) / uqCountT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::percentile()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoLatencyHistogram::percentile(uint32_t ulPerMilleV) const
+{
+   uint64_t uqTotalT = 0;
+   uint64_t uqRankT;
+   uint64_t uqSumT   = 0;
+   uint64_t uqLimitT;
+
+   //---------------------------------------------------------------------------------------------------
+   // the buckets are summed up instead of using count(), record() may run at the same time
+   //
+   for (uint32_t ulBucketT = 0; ulBucketT < CO_LATENCY_BUCKET_MAX; ulBucketT++)
+   {
+      uqTotalT += auqBucketP[ulBucketT].load(std::memory_order_relaxed);
+   }
+
+   if (uqTotalT == 0)
+   {
+      return (0);
+   }
+
+   uqRankT = ((uqTotalT * ulPerMilleV) + 999) / 1000;
+   if (uqRankT == 0)
+   {
+      uqRankT = 1;
+   }
+
+   for (uint32_t ulBucketT = 0; ulBucketT < CO_LATENCY_BUCKET_MAX; ulBucketT++)
+   {
+      uqSumT += auqBucketP[ulBucketT].load(std::memory_order_relaxed);
+      if (uqSumT >= uqRankT)
+      {
+         //-------------------------------------------------------------------------------------
+         // the last bucket also holds all values which are too large to be resolved
+         //
+         uqLimitT = bucketLimit(ulBucketT);
+         if ((uqLimitT > maximum()) || (ulBucketT == (CO_LATENCY_BUCKET_MAX - 1)))
+         {
+            uqLimitT = maximum();
+         }
+         return (uqLimitT);
+      }
+   }
+
+   return (maximum());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::record()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLatencyHistogram::record(uint64_t uqValueV)
+{
+   uint64_t uqMaxT = uqMaxP.load(std::memory_order_relaxed);
+
+   auqBucketP[bucket(uqValueV)].fetch_add(1, std::memory_order_relaxed);
+   uqCountP.fetch_add(1, std::memory_order_relaxed);
+   uqSumP.fetch_add(uqValueV, std::memory_order_relaxed);
+
+   while ((uqValueV > uqMaxT) && !uqMaxP.compare_exchange_weak(uqMaxT, uqValueV, std::memory_order_relaxed))
+   {
+      // uqMaxT holds the current maximum after a failed exchange
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatencyHistogram::reset()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLatencyHistogram::reset(void)
+{
+   uqCountP.store(0, std::memory_order_relaxed);
+   uqSumP.store(0, std::memory_order_relaxed);
+   uqMaxP.store(0, std::memory_order_relaxed);
+
+   for (uint32_t ulBucketT = 0; ulBucketT < CO_LATENCY_BUCKET_MAX; ulBucketT++)
+   {
+      auqBucketP[ulBucketT].store(0, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::CoLatency()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLatency::CoLatency(uint32_t ulTickPeriodV)
+{
+   uqTickPeriodP = (uint64_t) ulTickPeriodV * 1000;
+   uqArrivalP    = 0;
+
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::beginTick()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLatency::beginTick(uint64_t uqTimeV)
+{
+   uint64_t uqLatenessT;
+   uint64_t uqProcessT;
+   uint64_t uqSlotSumT = 0;
+   bool     btOverrunT = false;
+
+   if (uqTickStartP != 0)
+   {
+      uqLatenessT = uqTimeV - uqTickStartP;
+      uqLatenessT = (uqLatenessT > uqTickPeriodP) ? (uqLatenessT - uqTickPeriodP) : 0;
+      record(eCO_LATENCY_TICK_LATENESS, uqLatenessT);
+
+      //-------------------------------------------------------------------------------------------
+      // The slots run inside ComMgrProcess() unless the stack thread is used, so the time of the
+      // slots is taken from ComMgrProcess() before the paths are compared.
+      //
+      if (uqLatenessT > uqTickPeriodP)
+      {
+         ulOverrunCntP++;
+         btOverrunT = true;
+
+         for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_MGR_PROCESS; ubPathT++)
+         {
+            uqSlotSumT += auqTickSumP[ubPathT];
+         }
+         uqProcessT = auqTickSumP[eCO_LATENCY_MGR_PROCESS];
+         auqTickSumP[eCO_LATENCY_MGR_PROCESS] = (uqProcessT > uqSlotSumT) ? (uqProcessT - uqSlotSumT) : 0;
+
+         ubOverrunPathP     = eCO_LATENCY_MGR_PROCESS;
+         uqOverrunPathTimeP = 0;
+         for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_EVENT_QUEUE; ubPathT++)
+         {
+            if (auqTickSumP[ubPathT] > uqOverrunPathTimeP)
+            {
+               ubOverrunPathP     = ubPathT;
+               uqOverrunPathTimeP = auqTickSumP[ubPathT];
+            }
+         }
+      }
+   }
+
+   uqTickStartP = uqTimeV;
+   for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_PATH_MAX; ubPathT++)
+   {
+      auqTickSumP[ubPathT] = 0;
+   }
+
+   return (btOverrunT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::endTick()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLatency::endTick(uint64_t uqTimeV)
+{
+   record(eCO_LATENCY_TIMER_TICK, uqTimeV - uqTickStartP);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::pathName()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+const char * CoLatency::pathName(uint8_t ubPathV)
+{
+   if (ubPathV >= eCO_LATENCY_PATH_MAX)
+   {
+      return ("unknown");
+   }
+
+   return (aszPathNameS[ubPathV]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::recordLocal()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLatency::recordLocal(uint8_t ubPathV, uint64_t uqValueV)
+{
+   aclHistogramP[ubPathV].record(uqValueV);
+   auqTickSumP[ubPathV] += uqValueV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLatency::reset()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLatency::reset(void)
+{
+   uqTickStartP       = 0;
+   ulOverrunCntP      = 0;
+   ubOverrunPathP     = eCO_LATENCY_MGR_PROCESS;
+   uqOverrunPathTimeP = 0;
+
+   for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_PATH_MAX; ubPathT++)
+   {
+      auqTickSumP[ubPathT] = 0;
+      aclHistogramP[ubPathT].reset();
+   }
+}
@@ -0,0 +1,297 @@
+//====================================================================================================================//
+// File:          co_latency.hpp                                                                                      //
+// Description:   Latency histograms of the master event handlers                                                     //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_latency.hpp
+** \brief   Latency histograms of the master event handlers
+**
+** Execution times of the CANopen stack functions, of the event handlers and the delay between
+** frame reception and event handler are recorded in log-linear histograms: each power of two
+** is divided into 16 linear sub-buckets, so a value is stored with a relative error below
+** 6.25 %. Recording a value needs no lock and no allocation, the histograms are always on.
+*/
+#ifndef CO_LATENCY_HPP_
+#define CO_LATENCY_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "co_can_tap.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_LATENCY_SUB_BITS        ((uint32_t)      4)        // 16 sub-buckets per power of two
+#define  CO_LATENCY_SHIFT_MAX       ((uint32_t)     32)        // values up to 2^37 ns (137 s) are resolved
+#define  CO_LATENCY_BUCKET_MAX      ((uint32_t)    544)        // (CO_LATENCY_SHIFT_MAX + 1) * 16 + 16
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoLatencyPath_e
+** \brief   Measured paths
+**
+** The slot paths have the same order as the event types of the stack thread (CoStackEvent_e),
+** the event type can be used as path.
+*/
+enum CoLatencyPath_e {
+   eCO_LATENCY_SLOT_EMCY_RECEIVE = 0,        // slots of the QCoEvent signals
+   eCO_LATENCY_SLOT_LSS_RECEIVE,
+   eCO_LATENCY_SLOT_MGR_BUS,
+   eCO_LATENCY_SLOT_NMT_HEARTBEAT,
+   eCO_LATENCY_SLOT_NMT_MASTER_DETECTION,
+   eCO_LATENCY_SLOT_NMT_STATE_CHANGE,
+   eCO_LATENCY_SLOT_PDO_RECEIVE,
+   eCO_LATENCY_SLOT_PDO_TIMEOUT,
+   eCO_LATENCY_SLOT_SDO_OBJECT_READY,
+   eCO_LATENCY_SLOT_SDO_TIMEOUT,
+   eCO_LATENCY_MGR_PROCESS,                  // ComMgrProcess()
+   eCO_LATENCY_NET_TIMER_EVENT,              // ComMgrNetTimerEvent()
+   eCO_LATENCY_DEVICE_SCAN,                  // scan scheduler and start of device scans
+   eCO_LATENCY_EVENT_QUEUE,                  // frame reception or event post until slot
+   eCO_LATENCY_TIMER_TICK,                   // execution time of the timer handler
+   eCO_LATENCY_TICK_LATENESS,                // delay of the timer tick against its period
+
+   eCO_LATENCY_PATH_MAX
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLatencyHistogram
+** \brief   Log-linear histogram of time values in nano-seconds
+**
+** The function record() can be called from any thread at the same time. Readers get a
+** consistent value for each counter, but not a consistent snapshot of the whole histogram.
+*/
+class CoLatencyHistogram {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoLatencyHistogram();
+
+   uint64_t       count(void) const             { return (uqCountP.load(std::memory_order_relaxed)); }
+
+   uint64_t       maximum(void) const           { return (uqMaxP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     mean value in nano-seconds, 0 if no value is recorded
+   */
+   uint64_t       mean(void) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulPerMilleV   - percentile in 1/1000, e.g. 999 for p99.9
+   ** \return     upper bound of the bucket holding the percentile in nano-seconds
+   **
+   ** The value is limited to the maximum recorded value.
+   */
+   uint64_t       percentile(uint32_t ulPerMilleV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqValueV      - time in nano-seconds
+   */
+   void           record(uint64_t uqValueV);
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     sum of all recorded values in nano-seconds
+   */
+   uint64_t       sum(void) const               { return (uqSumP.load(std::memory_order_relaxed)); }
+
+private:
+
+   static uint32_t   bucket(uint64_t uqValueV);
+
+   static uint64_t   bucketLimit(uint32_t ulBucketV);
+
+   std::atomic<uint64_t>   uqCountP;
+   std::atomic<uint64_t>   uqSumP;
+   std::atomic<uint64_t>   uqMaxP;
+   std::atomic<uint64_t>   auqBucketP[CO_LATENCY_BUCKET_MAX];
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLatency
+** \brief   Latency histograms of all measured paths
+**
+** Besides the histograms the class checks each timer tick against its period. All time spent
+** in the application thread between two ticks is summed up per path. If a tick is delayed by
+** more than one period the tick is counted as overrun and the path with the largest share is
+** stored, so a slow event handler can be identified.
+**
+** The functions record() and path names can be used from any thread. All other functions
+** must only be called by the application thread.
+*/
+class CoLatency {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTickPeriodV - period of the timer tick in micro-seconds
+   */
+   CoLatency(uint32_t ulTickPeriodV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     reception time of the frames processed by the stack, 0 if no frames are processed
+   */
+   uint64_t       arrival(void) const           { return (uqArrivalP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqArrivalV    - reception time of the frames, 0 after the frames are processed
+   **
+   ** Event handlers called while an arrival time is set record their delay against this time.
+   */
+   void           setArrival(uint64_t uqArrivalV)  { uqArrivalP = uqArrivalV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTimeV       - start time of the tick
+   ** \return     true if the tick is an overrun, the cause is available by overrunPath()
+   **
+   ** Start of a timer tick: records the tick lateness and checks for an overrun. The path sums
+   ** of the application thread are cleared.
+   */
+   bool           beginTick(uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTimeV       - end time of the tick
+   */
+   void           endTick(uint64_t uqTimeV);
+
+   const CoLatencyHistogram & histogram(uint8_t ubPathV) const   { return (aclHistogramP[ubPathV]); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     path with the largest share of the last overrun
+   */
+   uint8_t        overrunPath(void) const       { return (ubOverrunPathP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     time of the path with the largest share of the last overrun in nano-seconds
+   */
+   uint64_t       overrunPathTime(void) const   { return (uqOverrunPathTimeP); }
+
+   uint32_t       overruns(void) const          { return (ulOverrunCntP); }
+
+   static const char *  pathName(uint8_t ubPathV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubPathV       - measured path, CoLatencyPath_e
+   ** \param[in]  uqValueV      - time in nano-seconds
+   **
+   ** Record a value, the function can be called from any thread.
+   */
+   void           record(uint8_t ubPathV, uint64_t uqValueV)   { aclHistogramP[ubPathV].record(uqValueV); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubPathV       - measured path, CoLatencyPath_e
+   ** \param[in]  uqValueV      - time in nano-seconds
+   **
+   ** Record a value measured in the application thread, the value is added to the path sum
+   ** of the current tick.
+   */
+   void           recordLocal(uint8_t ubPathV, uint64_t uqValueV);
+
+   void           reset(void);
+
+private:
+
+   uint64_t             uqTickPeriodP;
+   uint64_t             uqTickStartP;
+   uint64_t             uqArrivalP;
+
+   uint32_t             ulOverrunCntP;
+   uint8_t              ubOverrunPathP;
+   uint64_t             uqOverrunPathTimeP;
+
+   uint64_t             auqTickSumP[eCO_LATENCY_PATH_MAX];
+
+   CoLatencyHistogram   aclHistogramP[eCO_LATENCY_PATH_MAX];
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLatencyScope
+** \brief   Measurement of a code block in the application thread
+**
+** The execution time from construction to destruction of the object is recorded. If frames are
+** processed by the stack at construction, the delay since their reception is recorded as well.
+*/
+class CoLatencyScope {
+
+public:
+   CoLatencyScope(CoLatency & clLatencyR, uint8_t ubPathV) : clLatencyP(clLatencyR), ubPathP(ubPathV)
+   {
+      uqStartP = CoCanTap::timeStamp();
+      if ((ubPathV < eCO_LATENCY_MGR_PROCESS) && (clLatencyR.arrival() != 0))
+      {
+         clLatencyR.record(eCO_LATENCY_EVENT_QUEUE, uqStartP - clLatencyR.arrival());
+      }
+   }
+
+   ~CoLatencyScope()
+   {
+      clLatencyP.recordLocal(ubPathP, CoCanTap::timeStamp() - uqStartP);
+   }
+
+private:
+   CoLatency &    clLatencyP;
+   uint8_t        ubPathP;
+   uint64_t       uqStartP;
+};
+
+
+#endif /*CO_LATENCY_HPP_*/
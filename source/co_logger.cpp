@@ -0,0 +1,267 @@
+//====================================================================================================================//
+// File:          co_logger.cpp                                                                                       //
+// Description:   Asynchronous console output                                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_logger.hpp"
+
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::CoLogger()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLogger::CoLogger(FILE * ptsStreamV, QObject * pclParentV)
+   : QThread(pclParentV)
+{
+   ptsStreamP    = ptsStreamV;
+   btNotifiedP   = false;
+   btRunP        = true;
+   ulDropCntP    = 0;
+   ulDropReportP = 0;
+
+   slEventFdP = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (slEventFdP < 0)
+   {
+      qFatal("Couldn't create eventfd for logger thread");
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::~CoLogger()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLogger::~CoLogger()
+{
+   stop();
+
+   ::close(slEventFdP);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::post()                                                                                                   //
+// store record, drop the oldest one if the queue is full                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::post(CoLogRecord_ts & tsRecordR)
+{
+   CoLogRecord_ts tsOldestT;
+   uint64_t       uqCounterT = 1;
+
+   //---------------------------------------------------------------------------------------------------
+   // The caller must never wait for the console: if the queue is full the oldest record is
+   // removed. Another producer may take the free cell, so this is repeated.
+   //
+   while (clQueueP.push(tsRecordR) == false)
+   {
+      if (clQueueP.pop(tsOldestT))
+      {
+         ulDropCntP.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // only the first record after a wake-up requires a system call
+   //
+   if (btNotifiedP.exchange(true, std::memory_order_acq_rel) == false)
+   {
+      if (::write(slEventFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+      {
+         // counter overflow is not possible here, avoid compiler warning
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::print()                                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::print(const char * szFormatV,
+                     uint32_t ulArg0V, uint32_t ulArg1V, uint32_t ulArg2V,
+                     uint32_t ulArg3V, uint32_t ulArg4V, uint32_t ulArg5V)
+{
+   CoLogRecord_ts tsRecordT;
+
+   tsRecordT.szFormat  = szFormatV;
+   tsRecordT.aulArg[0] = ulArg0V;
+   tsRecordT.aulArg[1] = ulArg1V;
+   tsRecordT.aulArg[2] = ulArg2V;
+   tsRecordT.aulArg[3] = ulArg3V;
+   tsRecordT.aulArg[4] = ulArg4V;
+   tsRecordT.aulArg[5] = ulArg5V;
+   tsRecordT.btText    = false;
+
+   post(tsRecordT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::printText()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::printText(const char * szFormatV, const char * szTextV,
+                         uint32_t ulArg0V, uint32_t ulArg1V, uint32_t ulArg2V,
+                         uint32_t ulArg3V, uint32_t ulArg4V, uint32_t ulArg5V)
+{
+   CoLogRecord_ts tsRecordT;
+
+   tsRecordT.szFormat  = szFormatV;
+   tsRecordT.aulArg[0] = ulArg0V;
+   tsRecordT.aulArg[1] = ulArg1V;
+   tsRecordT.aulArg[2] = ulArg2V;
+   tsRecordT.aulArg[3] = ulArg3V;
+   tsRecordT.aulArg[4] = ulArg4V;
+   tsRecordT.aulArg[5] = ulArg5V;
+   tsRecordT.btText    = true;
+   strncpy(tsRecordT.aszText, (szTextV != nullptr) ? szTextV : "", CO_LOG_TEXT_SIZE - 1);
+   tsRecordT.aszText[CO_LOG_TEXT_SIZE - 1] = 0;
+
+   post(tsRecordT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::run()                                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::run()
+{
+   struct pollfd  tsPollT;
+   CoLogRecord_ts tsRecordT;
+   uint64_t       uqCounterT;
+   bool           btRunT = true;
+
+   tsPollT.fd     = slEventFdP;
+   tsPollT.events = POLLIN;
+
+   while (btRunT)
+   {
+      //-------------------------------------------------------------------------------------------
+      // The eventfd is read before the flag is cleared, a record posted in between finds the
+      // flag still set and is written by the following drain. Clearing the flag first would let
+      // the read consume the wake-up of such a record and leave the flag set for good.
+      //
+      if (::read(slEventFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+      {
+         // nothing pending, avoid compiler warning
+      }
+      btNotifiedP.exchange(false, std::memory_order_acq_rel);
+
+      //-------------------------------------------------------------------------------------------
+      // The run flag is read after the eventfd and before the queue is drained, so the wake-up
+      // of stop() is not lost and all records posted before stop() are written.
+      //
+      btRunT = btRunP.load(std::memory_order_acquire);
+
+      while (clQueueP.pop(tsRecordT))
+      {
+         write(tsRecordT);
+      }
+      fflush(ptsStreamP);
+
+      if (btRunT)
+      {
+         ::poll(&tsPollT, 1, -1);
+      }
+   }
+
+   if (ulDropCntP.load(std::memory_order_relaxed) != ulDropReportP)
+   {
+      fprintf(ptsStreamP, "... %u log messages dropped\n", ulDropCntP.load(std::memory_order_relaxed) - ulDropReportP);
+      fflush(ptsStreamP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::stop()                                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::stop(void)
+{
+   uint64_t uqCounterT = 1;
+
+   if (isRunning())
+   {
+      btRunP.store(false, std::memory_order_release);
+      if (::write(slEventFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+      {
+         // counter overflow is not possible here, avoid compiler warning
+      }
+      wait();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLogger::write()                                                                                                  //
+// format a record, runs inside the logger thread                                                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLogger::write(const CoLogRecord_ts & tsRecordR)
+{
+   uint32_t ulDropCntT;
+
+   //---------------------------------------------------------------------------------------------------
+   // report dropped records before the next record which made it through the queue
+   //
+   ulDropCntT = ulDropCntP.load(std::memory_order_relaxed);
+   if (ulDropCntT != ulDropReportP)
+   {
+      fprintf(ptsStreamP, "... %u log messages dropped\n", ulDropCntT - ulDropReportP);
+      ulDropReportP = ulDropCntT;
+   }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+   if (tsRecordR.btText)
+   {
+      fprintf(ptsStreamP, tsRecordR.szFormat, tsRecordR.aszText,
+              tsRecordR.aulArg[0], tsRecordR.aulArg[1], tsRecordR.aulArg[2],
+              tsRecordR.aulArg[3], tsRecordR.aulArg[4], tsRecordR.aulArg[5]);
+   }
+   else
+   {
+      fprintf(ptsStreamP, tsRecordR.szFormat,
+              tsRecordR.aulArg[0], tsRecordR.aulArg[1], tsRecordR.aulArg[2],
+              tsRecordR.aulArg[3], tsRecordR.aulArg[4], tsRecordR.aulArg[5]);
+   }
+#pragma GCC diagnostic pop
+}
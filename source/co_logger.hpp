@@ -0,0 +1,161 @@
+//====================================================================================================================//
+// File:          co_logger.hpp                                                                                       //
+// Description:   Asynchronous console output                                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_logger.hpp
+** \brief   Asynchronous console output
+**
+*/
+#ifndef CO_LOGGER_HPP_
+#define CO_LOGGER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+
+#include <QtCore/QThread>
+
+#include "co_mpmc_queue.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_LOG_QUEUE_SIZE          ((uint32_t)   1024)
+#define  CO_LOG_ARG_MAX             ((uint32_t)      6)
+#define  CO_LOG_TEXT_SIZE           ((uint32_t)     48)        // holds a device name of 32 characters
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoLogRecord_s
+** \brief   Binary log record
+**
+** The record holds the format string and the arguments, the text is formatted by the logger
+** thread. The format string must be a string literal.
+*/
+typedef struct CoLogRecord_s {
+   const char *   szFormat;                        // printf() format string
+   uint32_t       aulArg[CO_LOG_ARG_MAX];          // integer arguments
+   char           aszText[CO_LOG_TEXT_SIZE];       // string argument, first conversion of szFormat
+   bool           btText;                          // aszText is valid
+} CoLogRecord_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLogger
+** \brief   Asynchronous console output
+**
+** Log records are stored in a lock-free queue and written to the output stream by a
+** background thread, so a slow console never delays the caller. If the queue is full the
+** oldest record is dropped; the number of dropped records is counted and reported in the
+** output. The functions print() and printText() can be called from any thread and never
+** block.
+*/
+class CoLogger : public QThread {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoLogger(FILE * ptsStreamV = stdout, QObject * pclParentV = nullptr);
+
+   ~CoLogger();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of records dropped because the queue was full
+   */
+   uint32_t       droppedRecords(void) const    { return (ulDropCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szFormatV  - printf() format string with integer conversions only
+   **
+   ** Queue a log record, all arguments are passed as unsigned 32-bit values.
+   */
+   void           print(const char * szFormatV,
+                        uint32_t ulArg0V = 0, uint32_t ulArg1V = 0, uint32_t ulArg2V = 0,
+                        uint32_t ulArg3V = 0, uint32_t ulArg4V = 0, uint32_t ulArg5V = 0);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szFormatV  - printf() format string, the first conversion must be %s
+   ** \param[in]  szTextV    - string for the first conversion, truncated to 47 characters
+   **
+   ** Queue a log record with a string argument, the remaining arguments are passed as unsigned
+   ** 32-bit values.
+   */
+   void           printText(const char * szFormatV, const char * szTextV,
+                            uint32_t ulArg0V = 0, uint32_t ulArg1V = 0, uint32_t ulArg2V = 0,
+                            uint32_t ulArg3V = 0, uint32_t ulArg4V = 0, uint32_t ulArg5V = 0);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Write all pending records and terminate the logger thread.
+   */
+   void           stop(void);
+
+protected:
+
+   void           run() override;
+
+private:
+
+   void           post(CoLogRecord_ts & tsRecordR);
+
+   void           write(const CoLogRecord_ts & tsRecordR);
+
+   FILE *                  ptsStreamP;
+
+   int32_t                 slEventFdP;          // wake-up of logger thread
+   std::atomic<bool>       btNotifiedP;
+   std::atomic<bool>       btRunP;
+
+   std::atomic<uint32_t>   ulDropCntP;
+   uint32_t                ulDropReportP;       // drop counter of last report, logger thread only
+
+   CoMpmcQueue<CoLogRecord_ts, CO_LOG_QUEUE_SIZE> clQueueP;
+};
+
+
+#endif /*CO_LOGGER_HPP_*/
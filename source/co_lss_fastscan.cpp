@@ -0,0 +1,132 @@
+//====================================================================================================================//
+// File:          co_lss_fastscan.cpp                                                                                 //
+// Description:   Bit-wise identity search of the LSS Fastscan                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_lss_fastscan.hpp"
+
+#include <string.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssFastscan::CoLssFastscan()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLssFastscan::CoLssFastscan()
+{
+   start();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssFastscan::checked()                                                                                           //
+// a response shows a device with the checked bit cleared, otherwise the bit is set                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssFastscan::checked(bool btResponseV)
+{
+   if (btVerifyP)
+   {
+      return;
+   }
+
+   if (btResponseV == false)
+   {
+      ulIdNumberP |= ((uint32_t) 1 << ubBitP);
+   }
+
+   if (ubBitP > 0)
+   {
+      ubBitP--;
+   }
+   else
+   {
+      btVerifyP = true;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssFastscan::identity()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoLssFastscan::identity(uint8_t ubSubV) const
+{
+   if (ubSubV >= CO_LSS_FASTSCAN_SUB_MAX)
+   {
+      return (0);
+   }
+
+   return (aulIdentityP[ubSubV]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssFastscan::start()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssFastscan::start(void)
+{
+   ubSubP      = 0;
+   ubBitP      = 31;
+   btVerifyP   = false;
+   ulIdNumberP = 0;
+
+   memset(&aulIdentityP[0], 0, sizeof(aulIdentityP));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssFastscan::verified()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssFastscan::verified(void)
+{
+   if (btVerifyP == false)
+   {
+      return (false);
+   }
+
+   aulIdentityP[ubSubP] = ulIdNumberP;
+   if (ubSubP == (CO_LSS_FASTSCAN_SUB_MAX - 1))
+   {
+      return (true);
+   }
+
+   ubSubP++;
+   ubBitP      = 31;
+   btVerifyP   = false;
+   ulIdNumberP = 0;
+
+   return (false);
+}
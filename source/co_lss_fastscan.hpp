@@ -0,0 +1,128 @@
+//====================================================================================================================//
+// File:          co_lss_fastscan.hpp                                                                                 //
+// Description:   Bit-wise identity search of the LSS Fastscan                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_lss_fastscan.hpp
+** \brief   Bit-wise identity search of the LSS Fastscan
+**
+*/
+#ifndef CO_LSS_FASTSCAN_HPP_
+#define CO_LSS_FASTSCAN_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_LSS_FASTSCAN_SUB_MAX    ((uint8_t)       4)        // identity values 1018h:01h .. 1018h:04h
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLssFastscan
+** \brief   Bit-wise identity search of the LSS Fastscan
+**
+** The search runs over the four identity values, from the highest to the lowest bit. Each
+** request asks if a device matches the bits found so far with the checked bit cleared, a
+** missing response sets the bit. A complete value is verified with all bits, the device then
+** moves to the next value. Thus the device with the lowest identity is found.
+**
+** The class holds the state of the search only, the requests are transmitted by CoLssMaster:
+** idNumber(), bitChecked(), sub() and next() are the parameters of the next Fastscan request.
+*/
+class CoLssFastscan {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoLssFastscan();
+
+   uint8_t        bitChecked(void) const        { return (btVerifyP ? 0 : ubBitP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  btResponseV   - a device has answered the request
+   **
+   ** Evaluate the response of a request with a checked bit. After the lowest bit the value is
+   ** complete and must be verified.
+   */
+   void           checked(bool btResponseV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubSubV        - identity value, 0 = vendor-ID .. 3 = serial number
+   ** \return     value found by the search
+   */
+   uint32_t       identity(uint8_t ubSubV) const;
+
+   uint32_t       idNumber(void) const          { return (ulIdNumberP); }
+
+   bool           isVerify(void) const          { return (btVerifyP); }
+
+   uint8_t        next(void) const              { return (btVerifyP ? ((ubSubP + 1) & 0x03) : ubSubP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Start the search with the highest bit of the vendor-ID.
+   */
+   void           start(void);
+
+   uint8_t        sub(void) const               { return (ubSubP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     true if all four values are found
+   **
+   ** The verification of the current value has been answered, the search continues with the
+   ** next value.
+   */
+   bool           verified(void);
+
+private:
+
+   uint8_t           ubSubP;
+   uint8_t           ubBitP;
+   bool              btVerifyP;
+   uint32_t          ulIdNumberP;
+   uint32_t          aulIdentityP[CO_LSS_FASTSCAN_SUB_MAX];
+};
+
+
+#endif /*CO_LSS_FASTSCAN_HPP_*/
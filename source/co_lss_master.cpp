@@ -0,0 +1,606 @@
+//====================================================================================================================//
+// File:          co_lss_master.cpp                                                                                   //
+// Description:   LSS master with Fastscan on a raw CAN socket                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_lss_master.hpp"
+
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  LSS_COB_ID_MASTER          ((uint32_t)  0x7E5)
+#define  LSS_COB_ID_SLAVE           ((uint32_t)  0x7E4)
+
+#define  LSS_CS_SWITCH_GLOBAL       ((uint8_t)    0x04)        // switch state global
+#define  LSS_CS_CONFIGURE_NODE_ID   ((uint8_t)    0x11)        // configure node-ID
+#define  LSS_CS_STORE               ((uint8_t)    0x17)        // store configuration
+#define  LSS_CS_SWITCH_SEL_VENDOR   ((uint8_t)    0x40)        // switch state selective: vendor-ID
+#define  LSS_CS_SWITCH_SEL_PRODUCT  ((uint8_t)    0x41)        // switch state selective: product code
+#define  LSS_CS_SWITCH_SEL_REVISION ((uint8_t)    0x42)        // switch state selective: revision number
+#define  LSS_CS_SWITCH_SEL_SERIAL   ((uint8_t)    0x43)        // switch state selective: serial number
+#define  LSS_CS_SWITCH_SEL_RESPONSE ((uint8_t)    0x44)        // response to switch state selective
+#define  LSS_CS_IDENTIFY_SLAVE      ((uint8_t)    0x4F)        // response to Fastscan
+#define  LSS_CS_FASTSCAN            ((uint8_t)    0x51)        // Fastscan request
+
+#define  LSS_STATE_WAITING          ((uint8_t)    0x00)
+#define  LSS_FASTSCAN_CONFIRM       ((uint8_t)    0x80)        // bit checked: reset the Fastscan of all devices
+#define  LSS_STORE_NOT_SUPPORTED    ((uint8_t)    0x01)        // error code of the store response
+
+
+//-------------------------------------------------------------------------------------------------------
+// steps of the Fastscan and the reassignment
+//
+enum LssStep_e {
+   eLSS_STEP_IDLE = 0,
+   eLSS_STEP_CONFIRM,            // is there any unconfigured device?
+   eLSS_STEP_SCAN,               // bit-wise search of one identity value
+   eLSS_STEP_VERIFY,             // check the complete value, the device moves to the next value
+   eLSS_STEP_CONFIGURE,          // configure the node-ID
+   eLSS_STEP_STORE,              // store the node-ID
+   eLSS_STEP_SELECT              // switch state selective of a configured device
+};
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::CoLssMaster()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLssMaster::CoLssMaster(QObject * pclParentV)
+   : QObject(pclParentV)
+{
+   slSocketP      = -1;
+   ulTimeoutP     = 10;
+   ubFirstIdP     = 1;
+   pclNotifierP   = nullptr;
+
+   ubStepP        = eLSS_STEP_IDLE;
+   ubRetryCntP    = 0;
+   ubAssignedCntP = 0;
+   ubNodeIdP      = 0;
+   btReassignP    = false;
+
+   memset(&aulIdentityP[0], 0, sizeof(aulIdentityP));
+   memset(&abtUsedP[0], 0, sizeof(abtUsedP));
+
+   connect(&clTimerP, &QTimer::timeout, this, &CoLssMaster::onTimerEvent);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::~CoLssMaster()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoLssMaster::~CoLssMaster()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::close()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::close(void)
+{
+   clTimerP.stop();
+
+   if (pclNotifierP != nullptr)
+   {
+      pclNotifierP->setEnabled(false);
+      delete pclNotifierP;
+      pclNotifierP = nullptr;
+   }
+
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+   }
+
+   ubStepP     = eLSS_STEP_IDLE;
+   btReassignP = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::fail()                                                                                                //
+// stop the Fastscan or reassignment and report the error                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::fail(uint8_t ubErrorV)
+{
+   clTimerP.stop();
+   ubStepP = eLSS_STEP_IDLE;
+
+   if (btReassignP)
+   {
+      btReassignP = false;
+      emit reassignFailed(ubErrorV);
+   }
+   else
+   {
+      emit fastscanFailed(ubErrorV, ubAssignedCntP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::fastscan()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssMaster::fastscan(void)
+{
+   if ((slSocketP < 0) || (ubStepP != eLSS_STEP_IDLE))
+   {
+      return (false);
+   }
+
+   ubAssignedCntP = 0;
+   ubRetryCntP    = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // all unconfigured devices restart their Fastscan and answer if they are present
+   //
+   ubStepP = eLSS_STEP_CONFIRM;
+   if (send(LSS_CS_FASTSCAN, 0, LSS_FASTSCAN_CONFIRM, 0, 0) == false)
+   {
+      ubStepP = eLSS_STEP_IDLE;
+      return (false);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::freeNodeId()                                                                                          //
+// lowest node-ID of the range which is not used                                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoLssMaster::freeNodeId(void) const
+{
+   for (uint8_t ubNodeIdT = ubFirstIdP; ubNodeIdT <= CO_LSS_NODE_MAX; ubNodeIdT++)
+   {
+      if (abtUsedP[ubNodeIdT - 1] == false)
+      {
+         return (ubNodeIdT);
+      }
+   }
+
+   return (0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::onSocketEvent()                                                                                       //
+// evaluate LSS responses                                                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::onSocketEvent(void)
+{
+   struct can_frame  tsFrameT;
+   uint8_t           ubExpectedT;
+
+   while (::read(slSocketP, &tsFrameT, sizeof(tsFrameT)) == (ssize_t) sizeof(tsFrameT))
+   {
+      if ((ubStepP == eLSS_STEP_IDLE) || (tsFrameT.can_dlc != 8))
+      {
+         continue;
+      }
+
+      switch (ubStepP)
+      {
+         case eLSS_STEP_CONFIGURE:
+            ubExpectedT = LSS_CS_CONFIGURE_NODE_ID;
+            break;
+
+         case eLSS_STEP_STORE:
+            ubExpectedT = LSS_CS_STORE;
+            break;
+
+         case eLSS_STEP_SELECT:
+            ubExpectedT = LSS_CS_SWITCH_SEL_RESPONSE;
+            break;
+
+         default:
+            ubExpectedT = LSS_CS_IDENTIFY_SLAVE;
+            break;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // Several devices may answer the same Fastscan request. Identical frames are usually
+      // merged on the bus, further responses are discarded by send() before the next request.
+      //
+      if (tsFrameT.data[0] == ubExpectedT)
+      {
+         clTimerP.stop();
+         step(true, tsFrameT.data[1]);
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::onTimerEvent()                                                                                        //
+// no response within the timeout                                                                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::onTimerEvent(void)
+{
+   clTimerP.stop();
+
+   if (ubStepP != eLSS_STEP_IDLE)
+   {
+      step(false, 0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::open()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssMaster::open(const char * szInterfaceV)
+{
+   struct ifreq         tsIfReqT;
+   struct sockaddr_can  tsAddrT;
+   struct can_filter    tsFilterT;
+
+   close();
+
+   if ((szInterfaceV == nullptr) || (strlen(szInterfaceV) >= IFNAMSIZ))
+   {
+      return (false);
+   }
+
+   slSocketP = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   memset(&tsIfReqT, 0, sizeof(tsIfReqT));
+   strncpy(tsIfReqT.ifr_name, szInterfaceV, IFNAMSIZ - 1);
+   if (::ioctl(slSocketP, SIOCGIFINDEX, &tsIfReqT) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // receive LSS responses 7E4h only
+   //
+   tsFilterT.can_id   = LSS_COB_ID_SLAVE;
+   tsFilterT.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK;
+   setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_FILTER, &tsFilterT, sizeof(tsFilterT));
+
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.can_family  = AF_CAN;
+   tsAddrT.can_ifindex = tsIfReqT.ifr_ifindex;
+   if (::bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   pclNotifierP = new QSocketNotifier(slSocketP, QSocketNotifier::Read, this);
+   connect(pclNotifierP, &QSocketNotifier::activated, this, &CoLssMaster::onSocketEvent);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::reassign()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssMaster::reassign(uint32_t ulVendorIdV, uint32_t ulProductCodeV, uint32_t ulRevisionV, uint32_t ulSerialV)
+{
+   if ((slSocketP < 0) || (ubStepP != eLSS_STEP_IDLE))
+   {
+      return (false);
+   }
+
+   aulIdentityP[0] = ulVendorIdV;
+   aulIdentityP[1] = ulProductCodeV;
+   aulIdentityP[2] = ulRevisionV;
+   aulIdentityP[3] = ulSerialV;
+
+   //---------------------------------------------------------------------------------------------------
+   // only the device matching all four values enters the configuration state and answers
+   //
+   ubStepP     = eLSS_STEP_SELECT;
+   btReassignP = true;
+   if ((send(LSS_CS_SWITCH_SEL_VENDOR,   ulVendorIdV,    0, 0, 0) == false) ||
+       (send(LSS_CS_SWITCH_SEL_PRODUCT,  ulProductCodeV, 0, 0, 0) == false) ||
+       (send(LSS_CS_SWITCH_SEL_REVISION, ulRevisionV,    0, 0, 0) == false) ||
+       (send(LSS_CS_SWITCH_SEL_SERIAL,   ulSerialV,      0, 0, 0) == false))
+   {
+      clTimerP.stop();
+      ubStepP     = eLSS_STEP_IDLE;
+      btReassignP = false;
+      return (false);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::send()                                                                                                //
+// transmit an LSS request and start the response timeout                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssMaster::send(uint8_t ubCommandV, uint32_t ulValueV, uint8_t ubBitV, uint8_t ubSubV, uint8_t ubNextV)
+{
+   struct can_frame  tsFrameT;
+
+   //---------------------------------------------------------------------------------------------------
+   // late responses to the previous request must not be taken as response to this one
+   //
+   while (::read(slSocketP, &tsFrameT, sizeof(tsFrameT)) == (ssize_t) sizeof(tsFrameT))
+   {
+   }
+
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_id  = LSS_COB_ID_MASTER;
+   tsFrameT.can_dlc = 8;
+   tsFrameT.data[0] = ubCommandV;
+   tsFrameT.data[1] = (uint8_t) (ulValueV);
+   tsFrameT.data[2] = (uint8_t) (ulValueV >>  8);
+   tsFrameT.data[3] = (uint8_t) (ulValueV >> 16);
+   tsFrameT.data[4] = (uint8_t) (ulValueV >> 24);
+   tsFrameT.data[5] = ubBitV;
+   tsFrameT.data[6] = ubSubV;
+   tsFrameT.data[7] = ubNextV;
+
+   if (::write(slSocketP, &tsFrameT, sizeof(tsFrameT)) != (ssize_t) sizeof(tsFrameT))
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // switch state global and the first three requests of switch state selective are not
+   // answered
+   //
+   if ((ubCommandV != LSS_CS_SWITCH_GLOBAL) &&
+       ((ubCommandV < LSS_CS_SWITCH_SEL_VENDOR) || (ubCommandV > LSS_CS_SWITCH_SEL_REVISION)))
+   {
+      clTimerP.start(ulTimeoutP);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::sendFastscan()                                                                                        //
+// transmit the next request of the bit-wise search                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoLssMaster::sendFastscan(void)
+{
+   return (send(LSS_CS_FASTSCAN, clFastscanP.idNumber(), clFastscanP.bitChecked(),
+                clFastscanP.sub(), clFastscanP.next()));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::setFirstNodeId()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::setFirstNodeId(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_LSS_NODE_MAX))
+   {
+      ubFirstIdP = ubNodeIdV;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::setNodeUsed()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::setNodeUsed(uint8_t ubNodeIdV, bool btUsedV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_LSS_NODE_MAX))
+   {
+      abtUsedP[ubNodeIdV - 1] = btUsedV;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoLssMaster::step()                                                                                                //
+// evaluate the response of a request, or its timeout, and send the next request                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoLssMaster::step(bool btResponseV, uint8_t ubErrorV)
+{
+   bool  btSentT = true;
+
+   switch (ubStepP)
+   {
+      //-------------------------------------------------------------------------------------------
+      // no response: all devices are commissioned
+      //
+      case eLSS_STEP_CONFIRM:
+         if (btResponseV == false)
+         {
+            ubStepP = eLSS_STEP_IDLE;
+            emit fastscanFinished(ubAssignedCntP);
+            return;
+         }
+         clFastscanP.start();
+         ubStepP = eLSS_STEP_SCAN;
+         btSentT = sendFastscan();
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // after the lowest bit the complete value is verified
+      //
+      case eLSS_STEP_SCAN:
+         clFastscanP.checked(btResponseV);
+         if (clFastscanP.isVerify())
+         {
+            ubStepP = eLSS_STEP_VERIFY;
+         }
+         btSentT = sendFastscan();
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // After verification of the serial number (sub 3) the device enters the configuration
+      // state. A failed verification, e.g. after a lost response, restarts the Fastscan.
+      //
+      case eLSS_STEP_VERIFY:
+         if (btResponseV == false)
+         {
+            ubRetryCntP++;
+            if (ubRetryCntP >= CO_LSS_RETRY_MAX)
+            {
+               fail(eCO_LSS_ERROR_VERIFY);
+               return;
+            }
+            ubStepP = eLSS_STEP_CONFIRM;
+            btSentT = send(LSS_CS_FASTSCAN, 0, LSS_FASTSCAN_CONFIRM, 0, 0);
+            break;
+         }
+
+         if (clFastscanP.verified() == false)
+         {
+            ubStepP = eLSS_STEP_SCAN;
+            btSentT = sendFastscan();
+            break;
+         }
+
+         for (uint8_t ubSubT = 0; ubSubT < CO_LSS_FASTSCAN_SUB_MAX; ubSubT++)
+         {
+            aulIdentityP[ubSubT] = clFastscanP.identity(ubSubT);
+         }
+
+         ubNodeIdP = freeNodeId();
+         if (ubNodeIdP == 0)
+         {
+            send(LSS_CS_SWITCH_GLOBAL, LSS_STATE_WAITING, 0, 0, 0);
+            fail(eCO_LSS_ERROR_NODE_ID);
+            return;
+         }
+         ubStepP = eLSS_STEP_CONFIGURE;
+         btSentT = send(LSS_CS_CONFIGURE_NODE_ID, ubNodeIdP, 0, 0, 0);
+         break;
+
+      case eLSS_STEP_CONFIGURE:
+         if ((btResponseV == false) || (ubErrorV != 0))
+         {
+            send(LSS_CS_SWITCH_GLOBAL, LSS_STATE_WAITING, 0, 0, 0);
+            fail(eCO_LSS_ERROR_CONFIGURE);
+            return;
+         }
+         ubStepP = eLSS_STEP_STORE;
+         btSentT = send(LSS_CS_STORE, 0, 0, 0, 0);
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // A device which doesn't support storing keeps the node-ID until the next power cycle.
+      // Back in waiting state the device boots with the new node-ID, the next device is searched.
+      // A missing response or a failed storage stops the Fastscan: the node-ID is active but
+      // the device would be unconfigured again after a power cycle.
+      //
+      case eLSS_STEP_STORE:
+         abtUsedP[ubNodeIdP - 1] = true;
+         if ((btResponseV == false) || ((ubErrorV != 0) && (ubErrorV != LSS_STORE_NOT_SUPPORTED)))
+         {
+            send(LSS_CS_SWITCH_GLOBAL, LSS_STATE_WAITING, 0, 0, 0);
+            fail(eCO_LSS_ERROR_STORE);
+            return;
+         }
+         btSentT = send(LSS_CS_SWITCH_GLOBAL, LSS_STATE_WAITING, 0, 0, 0);
+
+         if (btReassignP)
+         {
+            if (btSentT == false)
+            {
+               break;
+            }
+            ubStepP     = eLSS_STEP_IDLE;
+            btReassignP = false;
+            emit nodeAssigned(ubNodeIdP, aulIdentityP[0], aulIdentityP[1], aulIdentityP[2], aulIdentityP[3]);
+            return;
+         }
+
+         ubAssignedCntP++;
+         ubRetryCntP = 0;
+
+         emit nodeAssigned(ubNodeIdP, aulIdentityP[0], aulIdentityP[1], aulIdentityP[2], aulIdentityP[3]);
+
+         ubStepP = eLSS_STEP_CONFIRM;
+         btSentT = btSentT && send(LSS_CS_FASTSCAN, 0, LSS_FASTSCAN_CONFIRM, 0, 0);
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // the selected device is in configuration state
+      //
+      case eLSS_STEP_SELECT:
+         if (btResponseV == false)
+         {
+            fail(eCO_LSS_ERROR_SELECT);
+            return;
+         }
+
+         ubNodeIdP = freeNodeId();
+         if (ubNodeIdP == 0)
+         {
+            send(LSS_CS_SWITCH_GLOBAL, LSS_STATE_WAITING, 0, 0, 0);
+            fail(eCO_LSS_ERROR_NODE_ID);
+            return;
+         }
+         ubStepP = eLSS_STEP_CONFIGURE;
+         btSentT = send(LSS_CS_CONFIGURE_NODE_ID, ubNodeIdP, 0, 0, 0);
+         break;
+
+      default:
+         break;
+   }
+
+   if (btSentT == false)
+   {
+      fail(eCO_LSS_ERROR_TRANSMIT);
+   }
+}
@@ -0,0 +1,255 @@
+//====================================================================================================================//
+// File:          co_lss_master.hpp                                                                                   //
+// Description:   LSS master with Fastscan on a raw CAN socket                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_lss_master.hpp
+** \brief   LSS master with Fastscan on a raw CAN socket
+**
+*/
+#ifndef CO_LSS_MASTER_HPP_
+#define CO_LSS_MASTER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+
+#include <stdint.h>
+
+#include <linux/can.h>
+
+#include "co_lss_fastscan.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_LSS_NODE_MAX            ((uint8_t)     127)        // highest node-ID
+#define  CO_LSS_RETRY_MAX           ((uint8_t)       3)        // failed verifications of one Fastscan
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoLssError_e
+** \brief   Reason of a failed Fastscan or reassignment
+**
+*/
+enum CoLssError_e {
+   //---------------------------------------------------------------------------------------------------
+   // a request could not be transmitted
+   //
+   eCO_LSS_ERROR_TRANSMIT = 1,
+
+   //---------------------------------------------------------------------------------------------------
+   // the identity found by the bit-wise search is not confirmed by a device
+   //
+   eCO_LSS_ERROR_VERIFY,
+
+   //---------------------------------------------------------------------------------------------------
+   // all node-IDs of the range are used
+   //
+   eCO_LSS_ERROR_NODE_ID,
+
+   //---------------------------------------------------------------------------------------------------
+   // the device has rejected the node-ID or has not answered
+   //
+   eCO_LSS_ERROR_CONFIGURE,
+
+   //---------------------------------------------------------------------------------------------------
+   // no device with the given identity has answered the switch state selective
+   //
+   eCO_LSS_ERROR_SELECT,
+
+   //---------------------------------------------------------------------------------------------------
+   // the device could not store the node-ID or has not answered, the node-ID is active until
+   // the next power cycle
+   //
+   eCO_LSS_ERROR_STORE
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoLssMaster
+** \brief   LSS master with Fastscan on a raw CAN socket
+**
+** The LSS master commissions devices without a valid node-ID (255). It uses its own raw socket
+** on the CAN interface, which only receives LSS responses (7E4h), and does not depend on the
+** LSS support of the CANopen master library.
+**
+** fastscan() identifies one unconfigured device by a bit-wise binary search over its identity
+** (1018h:01h .. 1018h:04h): each request asks if a device matches the bits found so far with
+** the next bit cleared, a missing response within the timeout sets the bit. The found device
+** is in LSS configuration state, it gets the lowest free node-ID and stores it. After switching
+** back to waiting state the device boots with the new node-ID. The search is repeated until no
+** unconfigured device answers.
+**
+** A Fastscan of one device needs 133 requests, on average half of them run into the timeout.
+** Node-IDs of devices which are present must be marked with setNodeUsed() before.
+**
+** reassign() moves a configured device to the lowest free node-ID, e.g. to resolve a node-ID
+** used by two devices. The device is selected by its complete identity (switch state
+** selective), the new node-ID is activated by the next NMT reset communication of the device.
+*/
+class CoLssMaster : public QObject {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoLssMaster(QObject * pclParentV = nullptr);
+
+   ~CoLssMaster();
+
+   void           close(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     true if the Fastscan has been started
+   **
+   ** Commission all unconfigured devices. Each device is reported by nodeAssigned(), the end of
+   ** the Fastscan is reported by fastscanFinished() or fastscanFailed().
+   */
+   bool           fastscan(void);
+
+   bool           isBusy(void) const   { return (ubStepP != 0); }
+
+   bool           isOpen(void) const   { return (slSocketP >= 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulVendorIdV    - vendor-ID of the device (1018h:01h)
+   ** \param[in]  ulProductCodeV - product code of the device (1018h:02h)
+   ** \param[in]  ulRevisionV    - revision number of the device (1018h:03h)
+   ** \param[in]  ulSerialV      - serial number of the device (1018h:04h)
+   ** \return     true if the reassignment has been started
+   **
+   ** Assign the lowest free node-ID to the device with the given identity. The new node-ID is
+   ** reported by nodeAssigned(), an error by reassignFailed().
+   */
+   bool           reassign(uint32_t ulVendorIdV, uint32_t ulProductCodeV, uint32_t ulRevisionV, uint32_t ulSerialV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szInterfaceV  - name of the CAN interface, e.g. "can1"
+   ** \return     true if the socket has been opened
+   */
+   bool           open(const char * szInterfaceV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - lowest node-ID which is assigned, default 1
+   */
+   void           setFirstNodeId(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  btUsedV       - node-ID is used by a device
+   **
+   ** A used node-ID is not assigned to an unconfigured device.
+   */
+   void           setNodeUsed(uint8_t ubNodeIdV, bool btUsedV = true);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTimeoutV    - response timeout in milli-seconds
+   */
+   void           setTimeout(uint32_t ulTimeoutV)   { ulTimeoutP = ulTimeoutV; }
+
+signals:
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubErrorV      - reason, CoLssError_e
+   ** \param[in]  ubCountV      - number of devices commissioned before the error
+   */
+   void           fastscanFailed(uint8_t ubErrorV, uint8_t ubCountV);
+
+   void           fastscanFinished(uint8_t ubCountV);
+
+   void           nodeAssigned(uint8_t ubNodeIdV, uint32_t ulVendorIdV, uint32_t ulProductCodeV,
+                               uint32_t ulRevisionV, uint32_t ulSerialV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubErrorV      - reason, CoLssError_e
+   */
+   void           reassignFailed(uint8_t ubErrorV);
+
+private slots:
+
+   void           onSocketEvent(void);
+
+   void           onTimerEvent(void);
+
+private:
+
+   void           fail(uint8_t ubErrorV);
+
+   uint8_t        freeNodeId(void) const;
+
+   bool           send(uint8_t ubCommandV, uint32_t ulValueV, uint8_t ubBitV, uint8_t ubSubV, uint8_t ubNextV);
+
+   bool           sendFastscan(void);
+
+   void           step(bool btResponseV, uint8_t ubErrorV);
+
+   int32_t           slSocketP;
+   uint32_t          ulTimeoutP;
+   uint8_t           ubFirstIdP;
+
+   QSocketNotifier * pclNotifierP;
+   QTimer            clTimerP;
+
+   //-----------------------------------------------------------------------------------------
+   // state of the Fastscan, the bit-wise search is done by clFastscanP
+   //
+   uint8_t           ubStepP;
+   CoLssFastscan     clFastscanP;
+   uint8_t           ubRetryCntP;
+   uint8_t           ubAssignedCntP;
+   uint8_t           ubNodeIdP;        // node-ID of the found device
+   bool              btReassignP;      // a configured device is moved by reassign()
+   uint32_t          aulIdentityP[4];
+
+   bool              abtUsedP[CO_LSS_NODE_MAX];
+};
+
+
+#endif /*CO_LSS_MASTER_HPP_*/
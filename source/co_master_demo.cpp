@@ -45,6 +45,8 @@
 #include "co_master_demo.hpp"
 
 #include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -56,6 +58,24 @@
 
 #define  TIMER_CYCLE_PERIOD         ((uint32_t)     10)        // timer period in milli-seconds
 
+#define  DEVICE_HEARTBEAT_PERIOD    ((uint16_t)    500)        // heartbeat producer time of devices in [ms]
+
+#define  PDO_COB_ID_INVALID         ((uint32_t) 0x80000000)    // PDO is not valid, bit 31 of the COB-ID
+
+#define  LSS_START_DELAY            ((uint32_t)   2000)        // first Fastscan after master detection in [ms]
+#define  LSS_CHECK_PERIOD           ((uint32_t)  10000)        // Fastscan for new unconfigured devices in [ms]
+
+//-------------------------------------------------------------------------------------------------------------
+// Steps of the PDO inhibit time configuration: the inhibit time (sub-index 3) can only be written
+// while the PDO is disabled, so a valid PDO is disabled first and enabled again afterwards.
+//
+enum PdoConfigStep_e {
+   eCO_PDO_STEP_COB_ID = 0,
+   eCO_PDO_STEP_DISABLE,
+   eCO_PDO_STEP_INHIBIT,
+   eCO_PDO_STEP_ENABLE
+};
+
 
 
 #ifndef  VERSION_MAJOR
@@ -76,7 +96,9 @@
 **                                                                                                                    **
 \*--------------------------------------------------------------------------------------------------------------------*/
 
+#ifndef  CO_DEMO_NO_MAIN
 static int   setup_signal_handler(void);
+#endif
 
 
 /*--------------------------------------------------------------------------------------------------------------------*\
@@ -86,6 +108,7 @@ static int   setup_signal_handler(void);
 int32_t  CoMasterDemo::aslSigHupFdP[]  = {0, 0};
 int32_t  CoMasterDemo::aslSigIntFdP[]  = {0, 0};
 int32_t  CoMasterDemo::aslSigTermFdP[] = {0, 0};
+int32_t  CoMasterDemo::aslSigUsr1FdP[] = {0, 0};
 
 //--------------------------------------------------------------------------------------------------------------------//
 // ComMgrUserInit()                                                                                                   //
@@ -101,6 +124,11 @@ ComStatus_tv ComMgrUserInit(uint8_t ubNetV)
 
 
 
+//---------------------------------------------------------------------------------------------------
+// canopen-bench runs the master inside its own main(), it is built with CO_DEMO_NO_MAIN
+//
+#ifndef  CO_DEMO_NO_MAIN
+
 //--------------------------------------------------------------------------------------------------------------------//
 // main()                                                                                                             //
 //                                                                                                                    //
@@ -127,6 +155,11 @@ int main(int argc, char *argv[])
    //
    CoMasterDemo clMainT;
 
+   if (setup_signal_handler() != 0)
+   {
+      qWarning("Couldn't install signal handlers");
+   }
+
    
    //---------------------------------------------------------------------------------------------------
    // connect the signal between application and main class for quit
@@ -143,57 +176,127 @@ int main(int argc, char *argv[])
    clAppT.exec();
 }
 
+#endif
+
 
 //--------------------------------------------------------------------------------------------------------------------//
 // CoMasterDemo::CoMasterDemo()                                                                                       //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-CoMasterDemo::CoMasterDemo()
+CoMasterDemo::CoMasterDemo(uint8_t ubIndexV)
+   : clLatencyP(TIMER_CYCLE_PERIOD * 1000)
 {
+   ubIndexP        = ubIndexV;
    ubCanChannelP   = eCP_CHANNEL_1;
-   ubNetworkP      = eCOM_NET_1;
+   ubNetworkP      = eCOM_NET_1 + ubIndexV;
+
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_DEMO_NETWORK_MAX; ubIdxT++)
+   {
+      apclNetworkP[ubIdxT] = nullptr;
+   }
+   apclNetworkP[0] = this;
    ubMasterNodeIdP = 125;
 
    uwHeartbeatTimeP = 0;
 
+   ulBitrateP       = 500000;
+   ubBusLoadP       = 0;
+   ubPdoLoadP       = 0;
+   ubScanParallelP  = 8;
+   ubScanBusLoadP   = 0;
+   ubScanRetriesP   = CO_SCAN_RETRY_MAX;
+   ubNmtGroupP      = 0;
+   ubRecoveryBatchP = 0;
+   ubLssFirstIdP    = 0;
+   uqLssDueP        = 0;
+   ubReassignNodeP  = 0;
 
-   //---------------------------------------------------------------------------------------------------
-   // connect events of CANopen master library to server
-   //
-   connectComEvents();
+   btEventDrivenP   = false;
+   pclCanRxP        = nullptr;
+
+   flReplaySpeedP   = 1.0;
+
+   btSuperviseP     = false;
+   btBusMonitorP    = false;
+   btCollisionP     = false;
+   ulPdoTimeoutP    = 0;
+
+   uwMetricsPortP   = 0;
+
+   ulEmcyRateP      = CO_EMCY_RATE_DEFAULT;
+
+   btStackThreadP   = false;
+   btStackLockNetP  = false;
+   slStackCpuP      = -1;
+   slStackPriorityP = 0;
+   pclStackThreadP  = nullptr;
+   pclStackEventP   = nullptr;
+
+   ulStackDropCntP    = 0;
+   ulStackOverrunCntP = 0;
+
+   ulSyncTimeP      = 0;
+   btSyncThreadP    = false;
+   slSyncPriorityP  = 0;
 
    //---------------------------------------------------------------------------------------------------
    // connect the cyclic timer to the event handler
    //
    connect(&clTimerP, &QTimer::timeout, this, &CoMasterDemo::onTimerEvent);
 
+   //---------------------------------------------------------------------------------------------------
+   // print statistics at the end of a replay
+   //
+   connect(&clReplayP, &QThread::finished, this, [this]() {
+              clLoggerP.print("Replay finished: %u frames in %u ms, %u frames failed\n",
+                              clReplayP.transmittedFrames(),
+                              (uint32_t) (clReplayP.duration() / 1000000),
+                              clReplayP.failedFrames());
+           });
+
 
    //---------------------------------------------------------------------------------------------------
-   // Initialisation of socket handler for Linux
+   // Initialisation of socket handler for Linux, the signals are handled by the first network
    //
-   if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigHupFdP) > 0)
-   {
-      qFatal("Couldn't create HUP socketpair");
-   }
+   pclSigHupP  = nullptr;
+   pclSigIntP  = nullptr;
+   pclSigTermP = nullptr;
+   pclSigUsr1P = nullptr;
 
-   if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigIntFdP) > 0)
+   if (ubIndexP == 0)
    {
-      qFatal("Couldn't create INT socketpair");
-   }
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigHupFdP) > 0)
+      {
+         qFatal("Couldn't create HUP socketpair");
+      }
 
-   if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigTermFdP) > 0)
-   {
-      qFatal("Couldn't create TERM socketpair");
-   }
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigIntFdP) > 0)
+      {
+         qFatal("Couldn't create INT socketpair");
+      }
+
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigTermFdP) > 0)
+      {
+         qFatal("Couldn't create TERM socketpair");
+      }
+
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, aslSigUsr1FdP) > 0)
+      {
+         qFatal("Couldn't create USR1 socketpair");
+      }
+
+      pclSigHupP = new QSocketNotifier(aslSigHupFdP[1], QSocketNotifier::Read, this);
+      connect(pclSigHupP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigHup);
 
-   pclSigHupP = new QSocketNotifier(aslSigHupFdP[1], QSocketNotifier::Read, this);
-   connect(pclSigHupP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigHup);
+      pclSigIntP = new QSocketNotifier(aslSigIntFdP[1], QSocketNotifier::Read, this);
+      connect(pclSigIntP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigInt);
 
-   pclSigIntP = new QSocketNotifier(aslSigIntFdP[1], QSocketNotifier::Read, this);
-   connect(pclSigIntP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigInt);
+      pclSigTermP = new QSocketNotifier(aslSigTermFdP[1], QSocketNotifier::Read, this);
+      connect(pclSigTermP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigTerm);
 
-   pclSigTermP = new QSocketNotifier(aslSigTermFdP[1], QSocketNotifier::Read, this);
-   connect(pclSigTermP, &QSocketNotifier::activated, this, &CoMasterDemo::onSigTerm);
+      pclSigUsr1P = new QSocketNotifier(aslSigUsr1FdP[1], QSocketNotifier::Read, this);
+      connect(pclSigUsr1P, &QSocketNotifier::activated, this, &CoMasterDemo::onSigUsr1);
+   }
 
 }
 
@@ -204,525 +307,2942 @@ CoMasterDemo::CoMasterDemo()
 //--------------------------------------------------------------------------------------------------------------------//
 CoMasterDemo::~CoMasterDemo()
 {
+   //---------------------------------------------------------------------------------------------------
+   // the socket pairs of the signal handlers are created again by the next first network, e.g.
+   // by each bring-up of canopen-bench
+   //
+   if (ubIndexP == 0)
+   {
+      delete pclSigHupP;
+      delete pclSigIntP;
+      delete pclSigTermP;
+      delete pclSigUsr1P;
 
-
+      for (uint8_t ubFdT = 0; ubFdT < 2; ubFdT++)
+      {
+         ::close(aslSigHupFdP[ubFdT]);
+         ::close(aslSigIntFdP[ubFdT]);
+         ::close(aslSigTermFdP[ubFdT]);
+         ::close(aslSigUsr1FdP[ubFdT]);
+      }
+   }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::connectComEvents()                                                                                   //
-// connect events generated by the CANopen Master library to this class                                               //
+// CoMasterDemo::applyPlan()                                                                                          //
+// the bus plan has changed after a boot-up message                                                                   //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::connectComEvents(void)
+void  CoMasterDemo::applyPlan(void)
 {
+   clLoggerP.print("can%d: bus plan for %d devices - heartbeat %d ms, consumer %d ms, inhibit time %d x 100 us\n",
+                   ubNetworkP, clPlannerP.nodeCount(), clPlannerP.heartbeatTime(), clPlannerP.consumerTime(),
+                   clPlannerP.inhibitTime());
 
-   QCoEvent *  pclCoEventT = QCoEvent::instance();
-
-   connect(pclCoEventT, &QCoEvent::comEmcyConsEventReceive,     this, &CoMasterDemo::onEmcyConsEventReceive);
-
-   connect(pclCoEventT, &QCoEvent::comLssEventReceive,          this, &CoMasterDemo::onLssEventReceive);
-
-   connect(pclCoEventT, &QCoEvent::comMgrEventBus,              this, &CoMasterDemo::onMgrEventBus);
-
-   connect(pclCoEventT, &QCoEvent::comNmtEventHeartbeat,        this, &CoMasterDemo::onNmtEventHeartbeat);
-
-   connect(pclCoEventT, &QCoEvent::comNmtEventMasterDetection,  this, &CoMasterDemo::onNmtEventMasterDetection);
-
-   connect(pclCoEventT, &QCoEvent::comNmtEventStateChange,      this, &CoMasterDemo::onNmtEventStateChange);
-
-   connect(pclCoEventT, &QCoEvent::comPdoEventReceive,          this, &CoMasterDemo::onPdoEventReceive);
-
-   connect(pclCoEventT, &QCoEvent::comPdoEventTimeout,          this, &CoMasterDemo::onPdoEventTimeout);
+   if (clPlannerP.isOverBudget())
+   {
+      clLoggerP.print("can%d: heartbeats exceed the bus load budget of %d %%\n", ubNetworkP, ubBusLoadP);
+   }
 
-   connect(pclCoEventT, &QCoEvent::comSdoEventObjectReady,      this, &CoMasterDemo::onSdoEventObjectReady);
+   if (btSuperviseP)
+   {
+      clSupervisorP.setHeartbeatTimeout(clPlannerP.heartbeatTime() * 1500);
+   }
 
-   connect(pclCoEventT, &QCoEvent::comSdoEventTimeout,          this, &CoMasterDemo::onSdoEventTimeout);
+   //---------------------------------------------------------------------------------------------------
+   // devices which are configured already get the new plan, devices inside the scan pick it up
+   // with their next configuration step
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_SCAN_NODE_MAX; ubNodeIdT++)
+   {
+      clScanSchedulerP.reconfigureNode(ubNodeIdT);
+   }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onEmcyConsEventReceive()                                                                             //
-//                                                                                                                    //
+// CoMasterDemo::configureHeartbeat()                                                                                 //
+// write the heartbeat producer time in the phase of the device                                                       //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onEmcyConsEventReceive(uint8_t ubNetV, uint8_t ubNodeIdV)
+void  CoMasterDemo::configureHeartbeat(uint8_t ubNodeIdV)
 {
-   uint8_t  aubDataT[8];
-   uint16_t uwEmcyCodeT;
+   ComStatus_tv tvResultT;
+   uint32_t     ulDelayT;
+   uint32_t     ulPeriodT;
 
-   ComEmcyConsGetData(ubNetV,ubNodeIdV,&aubDataT[0]);
-   uwEmcyCodeT = aubDataT[1];
-   uwEmcyCodeT = uwEmcyCodeT << 8;
-   uwEmcyCodeT = uwEmcyCodeT | aubDataT[0];
+   //---------------------------------------------------------------------------------------------------
+   // The device starts its heartbeat timer when object 1017h is written. The write is deferred
+   // to the phase of the device unless the phase is reached within one timer cycle.
+   //
+   ulDelayT  = clPlannerP.phaseDelay(ubNodeIdV, clScanSchedulerP.time());
+   ulPeriodT = clPlannerP.heartbeatTime() * 1000;
+   if ((ulDelayT > TIMER_CYCLE_PERIOD * 1000) && (ulDelayT + (TIMER_CYCLE_PERIOD * 1000) < ulPeriodT))
+   {
+      clScanSchedulerP.deferNode(ubNodeIdV, ulDelayT);
+      return;
+   }
 
-   fprintf(stdout, "can%d: NID %03d - EMCY code %04X, error register value %d\n",
-           ubNetV, ubNodeIdV, uwEmcyCodeT, aubDataT[2]);
+   //---------------------------------------------------------------------------------------------------
+   // The collision detector checks the heartbeat intervals again when the new time is written.
+   // A refused request raises no SDO event, it is repeated like a request which timed out.
+   //
+   clCollisionP.setHeartbeatTime(ubNodeIdV, 0);
+   tvResultT = ComNodeSetHbProdTime(ubNetworkP, ubNodeIdV, clPlannerP.heartbeatTime());
+   if (tvResultT != eCOM_ERR_OK)
+   {
+      clLoggerP.print("can%d: NID %03d - heartbeat request refused, error %d\n", ubNetworkP, ubNodeIdV, tvResultT);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+   }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onLssEventReceive()                                                                                  //
-//                                                                                                                    //
+// CoMasterDemo::connectComEvents()                                                                                   //
+// connect events generated by the CANopen Master library to this class                                               //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onLssEventReceive(uint8_t ubNetV, uint8_t ubLssProtocolV)
+void  CoMasterDemo::connectComEvents(void)
 {
-   Q_UNUSED(ubLssProtocolV);
 
+   QCoEvent *  pclCoEventT = QCoEvent::instance();
 
+   //---------------------------------------------------------------------------------------------------
+   // QCoEvent emits the events of all networks, each instance handles only its own network
+   //
+   connect(pclCoEventT, &QCoEvent::comEmcyConsEventReceive, this,
+           [this](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onEmcyConsEventReceive(ubNetV, ubNodeIdV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comLssEventReceive, this,
+           [this](uint8_t ubNetV, uint8_t ubLssProtocolV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onLssEventReceive(ubNetV, ubLssProtocolV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comMgrEventBus, this,
+           [this](uint8_t ubNetV, CpState_ts * ptsBusStateV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onMgrEventBus(ubNetV, ptsBusStateV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventHeartbeat, this,
+           [this](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onNmtEventHeartbeat(ubNetV, ubNodeIdV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventIdCollision, this,
+           [this](uint8_t ubNetV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onNmtEventIdCollision(ubNetV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventMasterDetection, this,
+           [this](uint8_t ubNetV, uint8_t ubResultV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onNmtEventMasterDetection(ubNetV, ubResultV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventStateChange, this,
+           [this](uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onNmtEventStateChange(ubNetV, ubNodeIdV, ubNmtEventV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventReceive, this,
+           [this](uint8_t ubNetV, uint16_t uwPdoV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onPdoEventReceive(ubNetV, uwPdoV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventTimeout, this,
+           [this](uint8_t ubNetV, uint16_t uwPdoNumV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onPdoEventTimeout(ubNetV, uwPdoNumV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventObjectReady, this,
+           [this](uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, uint32_t * pulAbortV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onSdoEventObjectReady(ubNetV, ubNodeIdV, ptsCoObjV, pulAbortV);
+              }
+           });
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventTimeout, this,
+           [this](uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV) {
+              if (ubNetV == ubNetworkP)
+              {
+                 onSdoEventTimeout(ubNetV, ubNodeIdV, uwIndexV, ubSubIndexV);
+              }
+           });
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onMgrEventBus()                                                                                      //
-//                                                                                                                    //
+// CoMasterDemo::connectStackEvents()                                                                                 //
+// connect events generated by the CANopen Master library to the event queue of the stack thread                      //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onMgrEventBus(uint8_t ubNetV, CpState_ts * ptsBusStateV)
+void  CoMasterDemo::connectStackEvents(void)
 {
-   Q_UNUSED(ptsBusStateV);
-
+   QCoEvent *        pclCoEventT = QCoEvent::instance();
+   CoStackThread *   pclThreadT  = pclStackThreadP;
+   CoEmcyHistory *   pclEmcyT    = &clEmcyHistoryP;
+   CoMetrics *       pclMetricsT = &clMetricsP;
+   uint8_t           ubNetT      = ubNetworkP;
 
+   //---------------------------------------------------------------------------------------------------
+   // The signals are emitted inside the stack thread. A direct connection copies the signal
+   // parameters into an event record, the record is dispatched inside onStackEvent(). Events of
+   // other networks are handled by the stack thread of the other network.
+   //
+   // EMCY messages are stored in the history on the stack thread, only the EMCY within the
+   // notification rate are passed to the queue. An EMCY storm can't fill the event queue.
+   //
+   connect(pclCoEventT, &QCoEvent::comEmcyConsEventReceive, pclThreadT,
+           [pclThreadT, pclEmcyT, pclMetricsT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_EMCY_RECEIVE;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubNodeId = ubNodeIdV;
+              ComEmcyConsGetData(ubNetV, ubNodeIdV, &tsEventT.aubData[0]);
+              pclMetricsT->countEmcy(ubNodeIdV);
+              if (pclEmcyT->record(ubNodeIdV, &tsEventT.aubData[0], CoCanTap::timeStamp(), tsEventT.ulCount))
+              {
+                 pclThreadT->postEvent(tsEventT);
+              }
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comLssEventReceive, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubLssProtocolV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_LSS_RECEIVE;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubValue  = ubLssProtocolV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comMgrEventBus, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, CpState_ts * ptsBusStateV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType     = eCO_STACK_EVENT_MGR_BUS;
+              tsEventT.ubNet      = ubNetV;
+              tsEventT.tsBusState = *ptsBusStateV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventHeartbeat, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_NMT_HEARTBEAT;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubNodeId = ubNodeIdV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventIdCollision, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_NMT_ID_COLLISION;
+              tsEventT.ubNet    = ubNetV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventMasterDetection, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubResultV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_NMT_MASTER_DETECTION;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubValue  = ubResultV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventStateChange, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_NMT_STATE_CHANGE;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubNodeId = ubNodeIdV;
+              tsEventT.ubValue  = ubNmtEventV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventReceive, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint16_t uwPdoV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_PDO_RECEIVE;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.uwIndex  = uwPdoV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventTimeout, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint16_t uwPdoNumV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_PDO_TIMEOUT;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.uwIndex  = uwPdoNumV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventObjectReady, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, uint32_t * pulAbortV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              Q_UNUSED(pulAbortV);
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType   = eCO_STACK_EVENT_SDO_OBJECT_READY;
+              tsEventT.ubNet    = ubNetV;
+              tsEventT.ubNodeId = ubNodeIdV;
+              tsEventT.tsCoObj  = *ptsCoObjV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventTimeout, pclThreadT,
+           [pclThreadT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              CoStackEvent_ts tsEventT;
+              tsEventT.ubType     = eCO_STACK_EVENT_SDO_TIMEOUT;
+              tsEventT.ubNet      = ubNetV;
+              tsEventT.ubNodeId   = ubNodeIdV;
+              tsEventT.uwIndex    = uwIndexV;
+              tsEventT.ubSubIndex = ubSubIndexV;
+              pclThreadT->postEvent(tsEventT);
+           }, Qt::DirectConnection);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onNmtEventActiveMaster()                                                                             //
-//                                                                                                                    //
+// CoMasterDemo::connectTraceEvents()                                                                                 //
+// connect events generated by the CANopen Master library to the trace recorder                                       //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onNmtEventActiveMaster( uint8_t ubNetV, uint8_t ubPriorityV, uint8_t ubNodeIdV)
+void  CoMasterDemo::connectTraceEvents(void)
 {
-   Q_UNUSED(ubPriorityV);
-   Q_UNUSED(ubNodeIdV);
-
+   QCoEvent *        pclCoEventT = QCoEvent::instance();
+   CoTraceRecorder * pclTraceT   = &clTraceP;
+   uint8_t           ubNetT      = ubNetworkP;
 
+   //---------------------------------------------------------------------------------------------------
+   // The records are written inside the thread which emits the signal, before the event is
+   // handled by the application. EMCY data is not read here, the EMCY frame itself is stored
+   // by the CAN tap. Each network has its own trace.
+   //
+   connect(pclCoEventT, &QCoEvent::comEmcyConsEventReceive, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_EMCY_RECEIVE, ubNetV, ubNodeIdV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comLssEventReceive, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubLssProtocolV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_LSS_RECEIVE, ubNetV, 0, ubLssProtocolV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comMgrEventBus, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, CpState_ts * ptsBusStateV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_MGR_BUS, ubNetV, 0, ptsBusStateV->ubCanErrState, 0, 0,
+                                ((uint32_t) ptsBusStateV->ubCanErrType   << 16) |
+                                ((uint32_t) ptsBusStateV->ubCanRcvErrCnt <<  8) |
+                                ((uint32_t) ptsBusStateV->ubCanTrmErrCnt));
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventHeartbeat, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_NMT_HEARTBEAT, ubNetV, ubNodeIdV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventMasterDetection, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubResultV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_NMT_MASTER_DETECTION, ubNetV, 0, ubResultV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comNmtEventStateChange, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_NMT_STATE_CHANGE, ubNetV, ubNodeIdV, ubNmtEventV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventReceive, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint16_t uwPdoV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_PDO_RECEIVE, ubNetV, 0, 0, uwPdoV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comPdoEventTimeout, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint16_t uwPdoNumV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_PDO_TIMEOUT, ubNetV, 0, 0, uwPdoNumV);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventObjectReady, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, uint32_t * pulAbortV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_SDO_OBJECT_READY, ubNetV, ubNodeIdV, ptsCoObjV->ubMarker, 0, 0,
+                                (pulAbortV != nullptr) ? *pulAbortV : 0);
+           }, Qt::DirectConnection);
+
+   connect(pclCoEventT, &QCoEvent::comSdoEventTimeout, this,
+           [pclTraceT, ubNetT](uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV) {
+              if (ubNetV != ubNetT)
+              {
+                 return;
+              }
+              pclTraceT->record(eCO_TRACE_SDO_TIMEOUT, ubNetV, ubNodeIdV, 0, uwIndexV, ubSubIndexV);
+           }, Qt::DirectConnection);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onNmtEventHeartbeat()                                                                                //
-//                                                                                                                    //
+// CoMasterDemo::onCanRxEvent()                                                                                       //
+// CAN frames are pending on the interface                                                                            //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onNmtEventHeartbeat(uint8_t ubNetV, uint8_t ubNodeIdV)
+void  CoMasterDemo::onCanRxEvent(void)
 {
-   //-----------------------------------------------------------------------------------------
-   // show infomratiin the heartbeat consumer got an issue
+   //---------------------------------------------------------------------------------------------------
+   // The tap only signals that frames are pending, the CANopen stack reads them from its own
+   // CAN interface. The socket is always drained, the listeners of the tap are called here.
    //
-   fprintf(stdout, "can%d: NID %03d - missing heartbeat, try to reset node .. \n\n", ubNetV, ubNodeIdV);
+   uint64_t uqArrivalT = CoCanTap::timeStamp();
 
+   if ((clCanTapP.process() > 0) && btEventDrivenP)
+   {
+      //-------------------------------------------------------------------------------------------
+      // slots called by ComMgrProcess() record their delay against the reception time
+      //
+      clLatencyP.setArrival(uqArrivalT);
+      {
+         CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_MGR_PROCESS);
+         ComMgrProcess(ubNetworkP);
+      }
+      clLatencyP.setArrival(0);
 
-   //-----------------------------------------------------------------------------------------
-   // If the node is still there: send a NMT reset node command and try to get it again
-   //
-   ComNmtSetNodeState(ubNetV, ubNodeIdV, eCOM_NMT_STATE_RESET_NODE);
-
+      //-------------------------------------------------------------------------------------------
+      // a finished device scan can be followed by the next one without waiting for the timer
+      //
+      CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_DEVICE_SCAN);
+      processDeviceScan();
+   }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onNmtEventIdCollision()                                                                              //
+// CoMasterDemo::onEmcyConsEventReceive()                                                                             //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onNmtEventIdCollision(uint8_t ubNetV)
+void  CoMasterDemo::onEmcyConsEventReceive(uint8_t ubNetV, uint8_t ubNodeIdV)
 {
+   uint8_t  aubDataT[8];
+   uint32_t ulSuppressedT;
+
+   ComEmcyConsGetData(ubNetV,ubNodeIdV,&aubDataT[0]);
+   clMetricsP.countEmcy(ubNodeIdV);
+
+   if (clEmcyHistoryP.record(ubNodeIdV, &aubDataT[0], CoCanTap::timeStamp(), ulSuppressedT))
+   {
+      handleEmcy(ubNetV, ubNodeIdV, &aubDataT[0], ulSuppressedT);
+   }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onNmtEventMasterDetection()                                                                          //
-//                                                                                                                    //
+// CoMasterDemo::handleEmcy()                                                                                         //
+// handle EMCY data read by ComEmcyConsGetData()                                                                      //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onNmtEventMasterDetection(uint8_t ubNetV, uint8_t ubResultV)
+void  CoMasterDemo::handleEmcy(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t * pubDataV, uint32_t ulSuppressedV)
 {
+   uint16_t uwEmcyCodeT;
 
-   //----------------------------------------------------------------------------------------------
-   // In case of timeout: we are the active CANopen master
+   //---------------------------------------------------------------------------------------------------
+   // the EMCY slot and the dispatcher of the stack thread both end here
    //
-   if (ubResultV == eCOM_NMT_DETECT_TIMEOUT)
-   {
-      fprintf(stdout, "I am the active Master.\n");
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_EMCY_RECEIVE);
 
-      //--------------------------------------------------------------------------------------
-      // reset all nodes
-      //
-      ComNmtSetNodeState(ubNetV, 0, eCOM_NMT_STATE_RESET_COM);
+   uwEmcyCodeT = pubDataV[1];
+   uwEmcyCodeT = uwEmcyCodeT << 8;
+   uwEmcyCodeT = uwEmcyCodeT | pubDataV[0];
 
-      //--------------------------------------------------------------------------------------
-      // set the SYNC cycle time
-      //
-      ComSyncSetCycleTime(ubNetV, ulSyncTimeP);
-      ComSyncEnable(ubNetV, 1);
+   if (ulSuppressedV > 0)
+   {
+      clLoggerP.print("can%d: NID %03d - EMCY code %04X, error register value %d, %u EMCY suppressed\n",
+                      ubNetV, ubNodeIdV, uwEmcyCodeT, pubDataV[2], ulSuppressedV);
    }
    else
    {
-      fprintf(stdout, "Another CANopen Master is active on the bus, e.g. the Comet daemon.\n");
-      fprintf(stdout, "Disable the other CANopen Master first, for Comet daemon:\n");
-      fprintf(stdout, "   sudo systemctrl stop umic-comet\n");
-      emit finished();
+      clLoggerP.print("can%d: NID %03d - EMCY code %04X, error register value %d\n",
+                      ubNetV, ubNodeIdV, uwEmcyCodeT, pubDataV[2]);
    }
-   
-
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onNmtEventStateChange()                                                                              //
-//                                                                                                                    //
+// CoMasterDemo::printLatency()                                                                                       //
+// print the latency histograms of all paths which have been executed                                                 //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onNmtEventStateChange( uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV)
+void  CoMasterDemo::printLatency(void)
 {
-   switch(ubNmtEventV)
-   {
-      case eCOM_NMT_STATE_BOOTUP:
-         fprintf(stdout, "can%d: NID %03d - received boot-up message\n",            ubNetV, ubNodeIdV);
-         
-         //-----------------------------------------------------------------------------------
-         // store node.ID of device in FIFO for later processing
-         //
-         clDeviceFifoP.enqueue(ubNodeIdV);
-         break;
+   clLoggerP.printText("Latency of %s in [us] since start, %u tick overruns\n",
+                       qPrintable(clInterfaceP), tickOverruns());
 
-      case eCOM_NMT_STATE_PREOPERATIONAL:
-         fprintf(stdout, "can%d: NID %03d - switched to pre-operational state\n",   ubNetV, ubNodeIdV);
-         break;
-
-      case eCOM_NMT_STATE_OPERATIONAL:
-         fprintf(stdout, "can%d: NID %03d - switched to operational state\n",       ubNetV, ubNodeIdV);
-         break;
+   for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_PATH_MAX; ubPathT++)
+   {
+      const CoLatencyHistogram & clHistogramR = clLatencyP.histogram(ubPathT);
 
-      case eCOM_NMT_STATE_STOPPED:
-         fprintf(stdout, "can%d: NID %03d - switched to stopped state\n",           ubNetV, ubNodeIdV);
-         break;
+      if (clHistogramR.count() == 0)
+      {
+         continue;
+      }
 
-      default:
+      clLoggerP.printText("   %-24s count %10u  p50 %7u  p99 %7u  p999 %7u  max %7u\n",
+                          CoLatency::pathName(ubPathT),
+                          (uint32_t) clHistogramR.count(),
+                          (uint32_t) (clHistogramR.percentile(500) / 1000),
+                          (uint32_t) (clHistogramR.percentile(990) / 1000),
+                          (uint32_t) (clHistogramR.percentile(999) / 1000),
+                          (uint32_t) (clHistogramR.maximum() / 1000));
+   }
 
-         break;
+   //---------------------------------------------------------------------------------------------------
+   // the SYNC producer is measured in nano-seconds, its jitter is far below the tick period
+   //
+   if (clSyncP.cycles() > 0)
+   {
+      const CoLatencyHistogram & clErrorR = clSyncP.error();
+
+      clLoggerP.printText("SYNC producer of %s: %u cycles, %u missed, %u failed, wake-up compensation %u ns\n",
+                          qPrintable(clInterfaceP),
+                          clSyncP.cycles(), clSyncP.missedCycles(), clSyncP.failedFrames(),
+                          (uint32_t) clSyncP.compensation());
+      clLoggerP.print("   transmission after deadline [ns]: p50 %u  p99 %u  p999 %u  max %u\n",
+                      (uint32_t) clErrorR.percentile(500), (uint32_t) clErrorR.percentile(990),
+                      (uint32_t) clErrorR.percentile(999), (uint32_t) clErrorR.maximum());
+      clLoggerP.print("   interval [ns]: min %u  max %u\n",
+                      (uint32_t) clSyncP.intervalMin(), (uint32_t) clSyncP.intervalMax());
    }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onPdoEventReceive()                                                                                  //
-//                                                                                                                    //
+// CoMasterDemo::printNodeInfo()                                                                                      //
+// print identity data of a device                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onPdoEventReceive(uint8_t ubNetV, uint16_t uwPdoV)
+void  CoMasterDemo::printNodeInfo(uint8_t ubNetV, uint8_t ubNodeIdV, bool btCachedV)
 {
+   char     aszNameT[sizeof(atsComNodeP[0].aubIdx1008_DN) + 1];
+   uint32_t ulProfileT = atsComNodeP[ubNodeIdV - 1].ulIdx1000_DT;
+   ulProfileT = ulProfileT & 0x0000FFFF;  // mask the profile
+   clLoggerP.print("can%d: NID %03d - Device profile  : %03d\n", ubNetV, ubNodeIdV, ulProfileT);
+   if (btCachedV)
+   {
+      clLoggerP.print("                Error code      : -- (identity from cache)\n");
+   }
+   else
+   {
+      clLoggerP.print("                Error code      : %02d\n", atsComNodeP[ubNodeIdV - 1].ubIdx1001_ER);
+   }
+   clLoggerP.print("                Vendor ID       : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_VI);
+   clLoggerP.print("                Product code    : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_PC);
+   clLoggerP.print("                Revision number : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_RN);
+   clLoggerP.print("                Serial number   : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_SN);
+
+   //---------------------------------------------------------------------------------------------------
+   // the device name uses all bytes of the object if it has the maximum length
+   //
+   memcpy(&aszNameT[0], &atsComNodeP[ubNodeIdV - 1].aubIdx1008_DN[0], sizeof(aszNameT) - 1);
+   aszNameT[sizeof(aszNameT) - 1] = 0;
+   clLoggerP.printText("                Device name     : %s  \n", &aszNameT[0]);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onPdoEventTimeout()                                                                                  //
+// CoMasterDemo::onLssEventReceive()                                                                                  //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onPdoEventTimeout(uint8_t ubNetV, uint16_t uwPdoNumV)
+void  CoMasterDemo::onLssEventReceive(uint8_t ubNetV, uint8_t ubLssProtocolV)
 {
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_LSS_RECEIVE);
+
+   Q_UNUSED(ubLssProtocolV);
+
 
 }
 
+
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSdoEventObjectReady()                                                                              //
+// CoMasterDemo::onLssFastscanFailed()                                                                                //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onSdoEventObjectReady(uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, 
-                                          uint32_t * pulAbortV)
+void  CoMasterDemo::onLssFastscanFailed(uint8_t ubErrorV, uint8_t ubCountV)
 {
-   uint16_t uwDeviceHeartbeatT = 500;
-
-   switch (ptsCoObjV->ubMarker)
+   switch (ubErrorV)
    {
-      //-------------------------------------------------------------------------------------------
-      // device has been scanned, print some infomation
-      //
-      case eCOM_SDO_MARKER_NODE_GET_INFO:
-      {
-         uint32_t ulProfileT = atsComNodeP[ubNodeIdV - 1].ulIdx1000_DT;
-         ulProfileT = ulProfileT & 0x0000FFFF;  // mask the profile
-         fprintf(stdout, "can%d: NID %03d - Device profile  : %03d\n", ubNetV, ubNodeIdV, ulProfileT);
-         fprintf(stdout, "                Error code      : %02d\n", atsComNodeP[ubNodeIdV - 1].ubIdx1001_ER);
-         fprintf(stdout, "                Vendor ID       : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_VI);
-         fprintf(stdout, "                Product code    : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_PC);
-         fprintf(stdout, "                Revision number : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_RN);
-         fprintf(stdout, "                Serial number   : %d  \n", atsComNodeP[ubNodeIdV - 1].ulIdx1018_SN);
-         fprintf(stdout, "                Device name     : %s  \n", atsComNodeP[ubNodeIdV - 1].aubIdx1008_DN);
-         ComNodeSetHbProdTime(ubNetV,  ubNodeIdV, uwDeviceHeartbeatT);
-
+      case eCO_LSS_ERROR_NODE_ID:
+         clLoggerP.print("can%d: LSS - no free node-ID for unconfigured device\n", ubNetworkP);
          break;
-      }
-
-      //-------------------------------------------------------------------------------------------
-      // heartbeat has been configured, now setup the consumer heartbeat time inside the master
-      // and remove the device from the scan queue.
-      //
-      case eCOM_SDO_MARKER_NODE_SET_HEARTBEAT:
-      {
-         ComNmtSetHbConsTime(ubNetV, ubNodeIdV, uwDeviceHeartbeatT * 3);
 
-         clDeviceFifoP.dequeue();
-         btSdoActiveP = false;
+      case eCO_LSS_ERROR_CONFIGURE:
+         clLoggerP.print("can%d: LSS - device rejected node-ID\n", ubNetworkP);
+         break;
 
-         //-----------------------------------------------------------------------------------
-         // set node to operational
-         //
-         ComNmtSetNodeState(ubNetV, ubNodeIdV, eCOM_NMT_STATE_OPERATIONAL);
+      case eCO_LSS_ERROR_STORE:
+         clLoggerP.print("can%d: LSS - device could not store node-ID\n", ubNetworkP);
          break;
-      }
 
       default:
-      {
+         clLoggerP.print("can%d: LSS - Fastscan failed, error %d\n", ubNetworkP, ubErrorV);
          break;
-      }
    }
 
+   if (ubCountV > 0)
+   {
+      clLoggerP.print("can%d: LSS - %d devices commissioned\n", ubNetworkP, ubCountV);
+   }
+
+   uqLssDueP = clScanSchedulerP.time() + ((uint64_t) LSS_CHECK_PERIOD * 1000);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSdoEventProgress()                                                                                 //
+// CoMasterDemo::onLssFastscanFinished()                                                                              //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onSdoEventProgress(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV,
-                                       uint32_t ulByteCntV)
+void  CoMasterDemo::onLssFastscanFinished(uint8_t ubCountV)
 {
+   if (ubCountV > 0)
+   {
+      clLoggerP.print("can%d: LSS - %d devices commissioned\n", ubNetworkP, ubCountV);
+   }
 
+   //---------------------------------------------------------------------------------------------------
+   // devices which are connected later are found by the next Fastscan
+   //
+   uqLssDueP = clScanSchedulerP.time() + ((uint64_t) LSS_CHECK_PERIOD * 1000);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSdoEventTimeout()                                                                                  //
+// CoMasterDemo::onLssNodeAssigned()                                                                                  //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::onSdoEventTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV)
+void  CoMasterDemo::onLssNodeAssigned(uint8_t ubNodeIdV, uint32_t ulVendorIdV, uint32_t ulProductCodeV,
+                                      uint32_t ulRevisionV, uint32_t ulSerialV)
 {
-   fprintf(stdout, "can%d: NID %03d - SDO timeout condition, object %04Xh:%02Xh\n", ubNetV, ubNodeIdV,  
-           uwIndexV,ubSubIndexV);
+   uint8_t  ubOldIdT = ubReassignNodeP;
 
-   btSdoActiveP = false;
+   if (ubOldIdT == 0)
+   {
+      clLoggerP.print("can%d: NID %03d - assigned by LSS to %08X:%08X:%08X:%08X\n", ubNetworkP, ubNodeIdV,
+                      ulVendorIdV, ulProductCodeV, ulRevisionV, ulSerialV);
+      return;
+   }
 
+   //---------------------------------------------------------------------------------------------------
+   // The moved device activates its new node-ID with the reset, the other device boots with
+   // the old node-ID. Both are scanned like any other device.
+   //
+   ubReassignNodeP = 0;
+   clLoggerP.print("can%d: NID %03d - device with serial number %08X moved to NID %03d by LSS\n", ubNetworkP,
+                   ubOldIdT, ulSerialV, ubNodeIdV);
+   clScanSchedulerP.releaseNode(ubOldIdT);
+   clCollisionP.release(ubOldIdT);
+
+   CoStackLocker clLockT(pclStackThreadP);
+   ComNmtSetNodeState(ubNetworkP, ubOldIdT, eCOM_NMT_STATE_RESET_COM);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSigHup()                                                                                           //
-// handle the SIGHUP signal                                                                                           //
+// CoMasterDemo::onLssReassignFailed()                                                                                //
+//                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void CoMasterDemo::onSigHup(void)
+void  CoMasterDemo::onLssReassignFailed(uint8_t ubErrorV)
 {
-   if (pclSigHupP != nullptr)
+   switch (ubErrorV)
    {
-      pclSigHupP->setEnabled(false);
-
-      char chValuesT;
-      ssize_t tvSizeT = ::read(aslSigHupFdP[1], &chValuesT, sizeof(chValuesT));
+      case eCO_LSS_ERROR_SELECT:
+         clLoggerP.print("can%d: NID %03d - LSS - device not found by its identity\n", ubNetworkP, ubReassignNodeP);
+         break;
 
-      if (tvSizeT > 0)
-      {
+      case eCO_LSS_ERROR_NODE_ID:
+         clLoggerP.print("can%d: NID %03d - LSS - no free node-ID\n", ubNetworkP, ubReassignNodeP);
+         break;
 
-         //-------------------------------------------------------------------------------------------
-         // stop the demo
-         //
-         stop();
+      default:
+         clLoggerP.print("can%d: NID %03d - LSS - reassignment failed, error %d\n", ubNetworkP, ubReassignNodeP,
+                         ubErrorV);
+         break;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the node-ID stays quarantined
+   //
+   clLoggerP.print("can%d: NID %03d - assign a new node-ID to one of the devices by hand\n", ubNetworkP,
+                   ubReassignNodeP);
+   ubReassignNodeP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onMgrEventBus()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onMgrEventBus(uint8_t ubNetV, CpState_ts * ptsBusStateV)
+{
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_MGR_BUS);
+
+   if (btBusMonitorP)
+   {
+      clBusMonitorP.setBusState(*ptsBusStateV, CoCanTap::timeStamp());
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onNmtEventActiveMaster()                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onNmtEventActiveMaster( uint8_t ubNetV, uint8_t ubPriorityV, uint8_t ubNodeIdV)
+{
+   Q_UNUSED(ubPriorityV);
+   Q_UNUSED(ubNodeIdV);
 
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onNmtEventHeartbeat()                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onNmtEventHeartbeat(uint8_t ubNetV, uint8_t ubNodeIdV)
+{
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_NMT_HEARTBEAT);
+
+   clMetricsP.countHeartbeatLost(ubNodeIdV);
+   clNmtBatchP.removeNode(ubNodeIdV);
+
+   //-----------------------------------------------------------------------------------------
+   // The recovery scheduler debounces the loss and sends the reset later, together with the
+   // resets of other devices which are lost at the same time.
+   //
+   if (clRecoveryP.isEnabled())
+   {
+      clLoggerP.print("can%d: NID %03d - missing heartbeat, node queued for recovery\n", ubNetV, ubNodeIdV);
+      if (clRecoveryP.lostNode(ubNodeIdV))
+      {
+         clLoggerP.print("can%d: %d devices lost within %d ms, segment failure suspected\n", ubNetV,
+                         CO_RECOVERY_SEGMENT_MIN, CO_RECOVERY_DEBOUNCE / 1000);
       }
+      return;
+   }
 
-      pclSigHupP->setEnabled(true);
+   //-----------------------------------------------------------------------------------------
+   // show infomratiin the heartbeat consumer got an issue
+   //
+   clLoggerP.print("can%d: NID %03d - missing heartbeat, try to reset node .. \n\n", ubNetV, ubNodeIdV);
+
+
+   //-----------------------------------------------------------------------------------------
+   // If the node is still there: send a NMT reset node command and try to get it again
+   //
+   CoStackLocker clLockT(pclStackThreadP);
+   ComNmtSetNodeState(ubNetV, ubNodeIdV, eCOM_NMT_STATE_RESET_NODE);
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onNmtEventIdCollision()                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onNmtEventIdCollision(uint8_t ubNetV)
+{
+   //---------------------------------------------------------------------------------------------------
+   // the library does not report the node-ID, it is found by the collision detector
+   //
+   if (btCollisionP)
+   {
+      clLoggerP.print("can%d: node-ID collision reported by the CANopen master library\n", ubNetV);
+   }
+   else
+   {
+      clLoggerP.print("can%d: node-ID collision reported by the CANopen master library, "
+                      "use --collision to find the node-ID\n", ubNetV);
    }
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSigInt()                                                                                           //
-// handle the SIGINT signal                                                                                           //
+// CoMasterDemo::onNmtEventMasterDetection()                                                                          //
+//                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void CoMasterDemo::onSigInt(void)
+void  CoMasterDemo::onNmtEventMasterDetection(uint8_t ubNetV, uint8_t ubResultV)
 {
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_NMT_MASTER_DETECTION);
 
-   if (pclSigIntP != nullptr)
+   //----------------------------------------------------------------------------------------------
+   // In case of timeout: we are the active CANopen master
+   //
+   if (ubResultV == eCOM_NMT_DETECT_TIMEOUT)
    {
-      pclSigIntP->setEnabled(false);
+      clLoggerP.print("I am the active Master.\n");
 
-      char chValuesT;
-      ssize_t tvSizeT = ::read(aslSigIntFdP[1], &chValuesT, sizeof(chValuesT));
+      CoStackLocker clLockT(pclStackThreadP);
 
-      if (tvSizeT > 0)
+      //--------------------------------------------------------------------------------------
+      // reset all nodes
+      //
+      ComNmtSetNodeState(ubNetV, 0, eCOM_NMT_STATE_RESET_COM);
+      clNmtBatchP.reset();
+      clRecoveryP.reset();
+
+      //--------------------------------------------------------------------------------------
+      // the configured devices boot first, then the unconfigured devices are commissioned
+      //
+      if (clLssMasterP.isOpen())
       {
-         //-------------------------------------------------------------------------------------------
-         // stop the demo
-         //
-         stop();
+         uqLssDueP = clScanSchedulerP.time() + ((uint64_t) LSS_START_DELAY * 1000);
       }
 
-      pclSigIntP->setEnabled(true);
-   }
+      //--------------------------------------------------------------------------------------
+      // set the SYNC cycle time, the SYNC producer thread replaces the SYNC service of the
+      // library
+      //
+      if (btSyncThreadP)
+      {
+         clSyncP.start();
+         clLoggerP.print("SYNC producer thread started, cycle time %u us\n", ulSyncTimeP);
+      }
+      else
+      {
+         ComSyncSetCycleTime(ubNetV, ulSyncTimeP);
+         ComSyncEnable(ubNetV, 1);
+      }
 
+      //--------------------------------------------------------------------------------------
+      // the recorded devices boot after the master has reset the network
+      //
+      if (clReplayFileP.isEmpty() == false)
+      {
+         startReplay();
+      }
+   }
+   else
+   {
+      clLoggerP.print("Another CANopen Master is active on the bus, e.g. the Comet daemon.\n");
+      clLoggerP.print("Disable the other CANopen Master first, for Comet daemon:\n");
+      clLoggerP.print("   sudo systemctrl stop umic-comet\n");
+      emit finished();
+   }
+   
 
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onSigTerm()                                                                                          //
-// handle the SIGTERM signal                                                                                          //
+// CoMasterDemo::onNmtEventStateChange()                                                                              //
+//                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void CoMasterDemo::onSigTerm(void)
+void  CoMasterDemo::onNmtEventStateChange( uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubNmtEventV)
 {
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_NMT_STATE_CHANGE);
 
-   if (pclSigTermP != nullptr)
+   clMetricsP.setNodeState(ubNodeIdV, ubNmtEventV);
+   clLssMasterP.setNodeUsed(ubNodeIdV);
+
+   switch(ubNmtEventV)
    {
-      pclSigTermP->setEnabled(false);
+      case eCOM_NMT_STATE_BOOTUP:
+         clLoggerP.print("can%d: NID %03d - received boot-up message\n",            ubNetV, ubNodeIdV);
+         clMetricsP.scanStarted(ubNodeIdV, CoCanTap::timeStamp());
+         clNmtBatchP.removeNode(ubNodeIdV);
+         clCollisionP.nodeBooted(ubNodeIdV);
 
-      #if defined(Q_OS_UNIX)
-      char chValuesT;
-      ssize_t tvSizeT = ::read(aslSigTermFdP[1], &chValuesT, sizeof(chValuesT));
+         //-----------------------------------------------------------------------------------
+         // a new device may change the bus plan
+         //
+         if (clPlannerP.addNode(ubNodeIdV))
+         {
+            applyPlan();
+         }
 
-      if (tvSizeT > 0)
-      {
-         //-------------------------------------------------------------------------------------------
-         // stop the demo
+         //-----------------------------------------------------------------------------------
+         // store node-ID of device in scan scheduler for later processing, a device in
+         // recovery is passed to the scan scheduler by processRecovery()
          //
-         stop();
-      }
-      #endif
+         if (clRecoveryP.nodeBooted(ubNodeIdV) == false)
+         {
+            clScanSchedulerP.addNode(ubNodeIdV, clSdoProbeP.isOpen() &&
+                                     clIdentityCacheP.lookup(clInterfaceP, ubNodeIdV, nullptr));
+         }
+         break;
 
-      pclSigTermP->setEnabled(true);
+      case eCOM_NMT_STATE_PREOPERATIONAL:
+         clLoggerP.print("can%d: NID %03d - switched to pre-operational state\n",   ubNetV, ubNodeIdV);
+         clRecoveryP.nodeAlive(ubNodeIdV);
+         break;
+
+      case eCOM_NMT_STATE_OPERATIONAL:
+         clLoggerP.print("can%d: NID %03d - switched to operational state\n",       ubNetV, ubNodeIdV);
+         clRecoveryP.nodeAlive(ubNodeIdV);
+         break;
+
+      case eCOM_NMT_STATE_STOPPED:
+         clLoggerP.print("can%d: NID %03d - switched to stopped state\n",           ubNetV, ubNodeIdV);
+         clRecoveryP.nodeAlive(ubNodeIdV);
+         break;
+
+      default:
+
+         break;
    }
+}
 
 
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onPdoEventReceive()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onPdoEventReceive(uint8_t ubNetV, uint16_t uwPdoV)
+{
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_PDO_RECEIVE);
 }
 
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::onTimerEvent()                                                                                       //
+// CoMasterDemo::onPdoEventTimeout()                                                                                  //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void CoMasterDemo::onTimerEvent(void)
+void  CoMasterDemo::onPdoEventTimeout(uint8_t ubNetV, uint16_t uwPdoNumV)
 {
-   //---------------------------------------------------------------------------------------------------
-   // Process CAN message handling by the CANopen stack
-   //
-   ComMgrProcess(ubNetworkP);
-   ComMgrNetTimerEvent(ubNetworkP);
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_PDO_TIMEOUT);
+}
 
-   
-   //---------------------------------------------------------------------------------------------------
-   // check for devices which have not been scanned yet after boot-up message
-   //
-   if (btSdoActiveP == false)
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoEventObjectReady()                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoEventObjectReady(uint8_t ubNetV, uint8_t ubNodeIdV, CoObject_ts * ptsCoObjV, 
+                                          uint32_t * pulAbortV)
+{
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_SDO_OBJECT_READY);
+
+   switch (ptsCoObjV->ubMarker)
    {
-      if (clDeviceFifoP.isEmpty() == false)
+      //-------------------------------------------------------------------------------------------
+      // device has been scanned, print some infomation
+      //
+      case eCOM_SDO_MARKER_NODE_GET_INFO:
+      {
+         //-----------------------------------------------------------------------------------
+         // the object data is written by the stack thread, the identity of a quarantined
+         // node-ID may belong to either device
+         //
+         CoStackLocker clLockT(pclStackThreadP);
+         clCollisionP.identityRead(ubNodeIdV, atsComNodeP[ubNodeIdV - 1].ulIdx1018_SN);
+         if (clScanSchedulerP.state(ubNodeIdV) == eCO_SCAN_STATE_QUARANTINED)
+         {
+            break;
+         }
+
+         printNodeInfo(ubNetV, ubNodeIdV, false);
+         clIdentityCacheP.store(clInterfaceP, ubNodeIdV, &atsComNodeP[ubNodeIdV - 1]);
+
+         clScanSchedulerP.nodeIdentified(ubNodeIdV);
+         configureHeartbeat(ubNodeIdV);
+
+         break;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // heartbeat has been configured, continue with the PDO inhibit times if they are planned,
+      // otherwise the configuration of the device is finished
+      //
+      case eCOM_SDO_MARKER_NODE_SET_HEARTBEAT:
+      {
+         if (clScanSchedulerP.state(ubNodeIdV) == eCO_SCAN_STATE_QUARANTINED)
+         {
+            break;
+         }
+         clCollisionP.setHeartbeatTime(ubNodeIdV, clPlannerP.heartbeatTime());
+
+         CoStackLocker clLockT(pclStackThreadP);
+         if ((clPlannerP.inhibitTime() > 0) && clSdoProbeP.isOpen())
+         {
+            atsPdoConfigP[ubNodeIdV - 1].ubPdo      = 0;
+            atsPdoConfigP[ubNodeIdV - 1].ubStep     = eCO_PDO_STEP_COB_ID;
+            atsPdoConfigP[ubNodeIdV - 1].btEnable   = false;
+            atsPdoConfigP[ubNodeIdV - 1].ubRetryCnt = 0;
+            atsPdoConfigP[ubNodeIdV - 1].ulCobId    = 0;
+            clScanSchedulerP.nodeConfigPdo(ubNodeIdV);
+            if (requestPdoStep(ubNodeIdV))
+            {
+               break;
+            }
+         }
+         finishNodeConfig(ubNodeIdV);
+         break;
+      }
+
+      default:
       {
-         ComSdoSetTimeout(ubNetworkP, 0, 200);
-         ComNodeGetInfo(ubNetworkP, clDeviceFifoP.head());
-         btSdoActiveP = true;
+         break;
       }
    }
+
 }
 
 
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoEventProgress()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoEventProgress(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV,
+                                       uint32_t ulByteCntV)
+{
+
+}
+
 
 //--------------------------------------------------------------------------------------------------------------------//
-// CoMasterDemo::runCmdParser()                                                                                       //
+// CoMasterDemo::onSdoEventTimeout()                                                                                  //
 //                                                                                                                    //
 //--------------------------------------------------------------------------------------------------------------------//
-void  CoMasterDemo::runCmdParser(void)
+void  CoMasterDemo::onSdoEventTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV)
 {
-   QCommandLineParser   clCmdParserT;
+   CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_SLOT_SDO_TIMEOUT);
+
+   clLoggerP.print("can%d: NID %03d - SDO timeout condition, object %04Xh:%02Xh\n", ubNetV, ubNodeIdV,  
+                   uwIndexV,ubSubIndexV);
+
+   handleScanTimeout(ubNetV, ubNodeIdV);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::handleScanTimeout()                                                                                  //
+// a device did not respond during the scan                                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::handleScanTimeout(uint8_t ubNetV, uint8_t ubNodeIdV)
+{
+   bool  btPdoDisabledT;
+
+   clMetricsP.countSdoTimeout(ubNodeIdV);
 
    //---------------------------------------------------------------------------------------------------
-   // setup command line parser, options are added in alphabetical order
+   // a TPDO disabled for the inhibit time stays disabled if the device is parked
    //
-   clCmdParserT.setApplicationDescription(tr("CANopen Master demo"));
-
+   btPdoDisabledT = (clScanSchedulerP.state(ubNodeIdV) == eCO_SCAN_STATE_CONFIG_PDO) &&
+                    atsPdoConfigP[ubNodeIdV - 1].btEnable &&
+                    ((atsPdoConfigP[ubNodeIdV - 1].ubStep == eCO_PDO_STEP_INHIBIT) ||
+                     (atsPdoConfigP[ubNodeIdV - 1].ubStep == eCO_PDO_STEP_ENABLE));
 
    //---------------------------------------------------------------------------------------------------
-   // command line option: -h, --help
+   // free the scan slot, the failed step is repeated after a backoff time or the device is
+   // parked after the last retry
    //
-   clCmdParserT.addHelpOption();
+   if (clScanSchedulerP.isActive(ubNodeIdV))
+   {
+      if (clScanSchedulerP.nodeTimeout(ubNodeIdV))
+      {
+         clLoggerP.print("can%d: NID %03d - retry %d scheduled\n", ubNetV, ubNodeIdV,
+                         clScanSchedulerP.retryCount(ubNodeIdV));
+      }
+      else
+      {
+         clLoggerP.print("can%d: NID %03d - no response after %d retries, device is parked\n", ubNetV, ubNodeIdV,
+                         clScanSchedulerP.retryCount(ubNodeIdV));
+         if (btPdoDisabledT)
+         {
+            clLoggerP.print("can%d: NID %03d - TPDO%d is left disabled\n", ubNetV, ubNodeIdV,
+                            atsPdoConfigP[ubNodeIdV - 1].ubPdo + 1);
+         }
+         clMetricsP.countScanFailure(ubNodeIdV);
+      }
+   }
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::finishNodeConfig()                                                                                   //
+// the device is configured, start the heartbeat consumer                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::finishNodeConfig(uint8_t ubNodeIdV)
+{
+   ComStatus_tv tvResultT;
 
-   
    //---------------------------------------------------------------------------------------------------
-   // argument <interface> is required
+   // a device without heartbeat consumer can't be supervised, the configuration is repeated
    //
-   clCmdParserT.addPositionalArgument("interface", 
-                                      tr("CAN interface, e.g. can1"));
+   tvResultT = ComNmtSetHbConsTime(ubNetworkP, ubNodeIdV, clPlannerP.consumerTime());
+   if (tvResultT != eCOM_ERR_OK)
+   {
+      clLoggerP.print("can%d: NID %03d - heartbeat consumer refused, error %d\n", ubNetworkP, ubNodeIdV, tvResultT);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+      return;
+   }
+
+   clScanSchedulerP.nodeOperational(ubNodeIdV);
+   clMetricsP.scanFinished(ubNodeIdV, CoCanTap::timeStamp());
 
    //---------------------------------------------------------------------------------------------------
-   // command line option: --heartbeat-cycle <time>
+   // set node to operational, with batching the device waits for the common start
    //
-   QCommandLineOption clOptHeartbeatCycleT("heartbeat-cycle",
+   if (clNmtBatchP.isEnabled())
+   {
+      clNmtBatchP.addNode(ubNodeIdV, clScanSchedulerP.time());
+   }
+   else
+   {
+      ComNmtSetNodeState(ubNetworkP, ubNodeIdV, eCOM_NMT_STATE_OPERATIONAL);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoProbeDownloadFailed()                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoProbeDownloadFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV,
+                                             uint32_t ulAbortV)
+{
+   if (clScanSchedulerP.state(ubNodeIdV) != eCO_SCAN_STATE_CONFIG_PDO)
+   {
+      return;
+   }
+
+   if (ulAbortV == CO_SDO_ABORT_TIMEOUT)
+   {
+      clLoggerP.print("can%d: NID %03d - SDO timeout condition, object %04Xh:%02Xh\n", ubNetworkP, ubNodeIdV,
+                      uwIndexV, ubSubIndexV);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+   }
+   else
+   {
+      clLoggerP.print("can%d: NID %03d - write of object %04Xh:%02Xh aborted, code %08Xh\n", ubNetworkP,
+                      ubNodeIdV, uwIndexV, ubSubIndexV, ulAbortV);
+      processPdoConfig(ubNodeIdV, false, 0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoProbeDownloadFinished()                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoProbeDownloadFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV)
+{
+   Q_UNUSED(uwIndexV);
+   Q_UNUSED(ubSubIndexV);
+
+   if (clScanSchedulerP.state(ubNodeIdV) == eCO_SCAN_STATE_CONFIG_PDO)
+   {
+      processPdoConfig(ubNodeIdV, true, 0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoProbeFailed()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoProbeFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV)
+{
+   uint8_t ubStateT = clScanSchedulerP.state(ubNodeIdV);
+
+   if ((ubStateT != eCO_SCAN_STATE_VERIFYING) && (ubStateT != eCO_SCAN_STATE_CONFIG_PDO))
+   {
+      return;
+   }
+
+   if (ulAbortV == CO_SDO_ABORT_TIMEOUT)
+   {
+      clLoggerP.print("can%d: NID %03d - SDO timeout condition, object %04Xh:%02Xh\n", ubNetworkP, ubNodeIdV,
+                      uwIndexV, ubSubIndexV);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+   }
+   else if (ubStateT == eCO_SCAN_STATE_CONFIG_PDO)
+   {
+      processPdoConfig(ubNodeIdV, false, 0);
+   }
+   else
+   {
+      //-------------------------------------------------------------------------------------------
+      // the serial number can't be read, identify the device with the CANopen master library
+      //
+      clScanSchedulerP.nodeVerified(ubNodeIdV, false);
+
+      CoStackLocker clLockT(pclStackThreadP);
+      requestNodeInfo(ubNodeIdV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSdoProbeFinished()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::onSdoProbeFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV)
+{
+   uint32_t ulSerialT;
+
+   Q_UNUSED(uwIndexV);
+   Q_UNUSED(ubSubIndexV);
+
+   if (clScanSchedulerP.state(ubNodeIdV) == eCO_SCAN_STATE_CONFIG_PDO)
+   {
+      processPdoConfig(ubNodeIdV, true, ulValueV);
+      return;
+   }
+
+   if (clScanSchedulerP.state(ubNodeIdV) != eCO_SCAN_STATE_VERIFYING)
+   {
+      return;
+   }
+   clCollisionP.identityRead(ubNodeIdV, ulValueV);
+
+   if (clIdentityCacheP.lookup(clInterfaceP, ubNodeIdV, &ulSerialT) && (ulSerialT == ulValueV))
+   {
+      //-------------------------------------------------------------------------------------------
+      // same device as before: use the cached identity and continue with the heartbeat
+      //
+      CoStackLocker clLockT(pclStackThreadP);
+      clIdentityCacheP.load(clInterfaceP, ubNodeIdV, &atsComNodeP[ubNodeIdV - 1]);
+      printNodeInfo(ubNetworkP, ubNodeIdV, true);
+      clScanSchedulerP.nodeVerified(ubNodeIdV, true);
+      configureHeartbeat(ubNodeIdV);
+   }
+   else
+   {
+      clLoggerP.print("can%d: NID %03d - serial number changed, reading identity\n", ubNetworkP, ubNodeIdV);
+      clScanSchedulerP.nodeVerified(ubNodeIdV, false);
+
+      CoStackLocker clLockT(pclStackThreadP);
+      requestNodeInfo(ubNodeIdV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSigHup()                                                                                           //
+// handle the SIGHUP signal                                                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onSigHup(void)
+{
+   if (pclSigHupP != nullptr)
+   {
+      pclSigHupP->setEnabled(false);
+
+      char chValuesT;
+      ssize_t tvSizeT = ::read(aslSigHupFdP[1], &chValuesT, sizeof(chValuesT));
+
+      if (tvSizeT > 0)
+      {
+
+         //-------------------------------------------------------------------------------------------
+         // stop the demo
+         //
+         stop();
+
+      }
+
+      pclSigHupP->setEnabled(true);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSigInt()                                                                                           //
+// handle the SIGINT signal                                                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onSigInt(void)
+{
+
+   if (pclSigIntP != nullptr)
+   {
+      pclSigIntP->setEnabled(false);
+
+      char chValuesT;
+      ssize_t tvSizeT = ::read(aslSigIntFdP[1], &chValuesT, sizeof(chValuesT));
+
+      if (tvSizeT > 0)
+      {
+         //-------------------------------------------------------------------------------------------
+         // stop the demo
+         //
+         stop();
+      }
+
+      pclSigIntP->setEnabled(true);
+   }
+
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSigTerm()                                                                                          //
+// handle the SIGTERM signal                                                                                          //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onSigTerm(void)
+{
+
+   if (pclSigTermP != nullptr)
+   {
+      pclSigTermP->setEnabled(false);
+
+      #if defined(Q_OS_UNIX)
+      char chValuesT;
+      ssize_t tvSizeT = ::read(aslSigTermFdP[1], &chValuesT, sizeof(chValuesT));
+
+      if (tvSizeT > 0)
+      {
+         //-------------------------------------------------------------------------------------------
+         // stop the demo
+         //
+         stop();
+      }
+      #endif
+
+      pclSigTermP->setEnabled(true);
+   }
+
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onSigUsr1()                                                                                          //
+// handle the SIGUSR1 signal                                                                                          //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onSigUsr1(void)
+{
+   if (pclSigUsr1P != nullptr)
+   {
+      pclSigUsr1P->setEnabled(false);
+
+      char chValuesT;
+      ssize_t tvSizeT = ::read(aslSigUsr1FdP[1], &chValuesT, sizeof(chValuesT));
+
+      if (tvSizeT > 0)
+      {
+         //-------------------------------------------------------------------------------------------
+         // print the latency histograms, supervision statistics and bus monitor of all networks
+         //
+         for (uint8_t ubIdxT = 0; ubIdxT < CO_DEMO_NETWORK_MAX; ubIdxT++)
+         {
+            if (apclNetworkP[ubIdxT] != nullptr)
+            {
+               apclNetworkP[ubIdxT]->printLatency();
+               apclNetworkP[ubIdxT]->printSupervision();
+               apclNetworkP[ubIdxT]->printBusMonitor();
+               apclNetworkP[ubIdxT]->printEmcyHistory();
+            }
+         }
+      }
+
+      pclSigUsr1P->setEnabled(true);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onStackEvent()                                                                                       //
+// dispatch events from the stack thread                                                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onStackEvent(void)
+{
+   CoStackEvent_ts   tsEventT;
+   uint32_t          ulAbortT;
+
+   if (pclStackThreadP == nullptr)
+   {
+      return;
+   }
+
+   pclStackThreadP->clearNotification();
+
+   while (pclStackThreadP->fetchEvent(tsEventT))
+   {
+      clLatencyP.record(eCO_LATENCY_EVENT_QUEUE, CoCanTap::timeStamp() - tsEventT.uqTimeStamp);
+
+      switch (tsEventT.ubType)
+      {
+         case eCO_STACK_EVENT_EMCY_RECEIVE:
+            handleEmcy(tsEventT.ubNet, tsEventT.ubNodeId, &tsEventT.aubData[0], tsEventT.ulCount);
+            break;
+
+         case eCO_STACK_EVENT_LSS_RECEIVE:
+            onLssEventReceive(tsEventT.ubNet, tsEventT.ubValue);
+            break;
+
+         case eCO_STACK_EVENT_MGR_BUS:
+            onMgrEventBus(tsEventT.ubNet, &tsEventT.tsBusState);
+            break;
+
+         case eCO_STACK_EVENT_NMT_HEARTBEAT:
+            onNmtEventHeartbeat(tsEventT.ubNet, tsEventT.ubNodeId);
+            break;
+
+         case eCO_STACK_EVENT_NMT_ID_COLLISION:
+            onNmtEventIdCollision(tsEventT.ubNet);
+            break;
+
+         case eCO_STACK_EVENT_NMT_MASTER_DETECTION:
+            onNmtEventMasterDetection(tsEventT.ubNet, tsEventT.ubValue);
+            break;
+
+         case eCO_STACK_EVENT_NMT_STATE_CHANGE:
+            onNmtEventStateChange(tsEventT.ubNet, tsEventT.ubNodeId, tsEventT.ubValue);
+            break;
+
+         case eCO_STACK_EVENT_PDO_RECEIVE:
+            onPdoEventReceive(tsEventT.ubNet, tsEventT.uwIndex);
+            break;
+
+         case eCO_STACK_EVENT_PDO_TIMEOUT:
+            onPdoEventTimeout(tsEventT.ubNet, tsEventT.uwIndex);
+            break;
+
+         //-------------------------------------------------------------------------------------------
+         // the SDO transfer is already finished, an abort code can't be returned to the stack here
+         //
+         case eCO_STACK_EVENT_SDO_OBJECT_READY:
+            ulAbortT = 0;
+            onSdoEventObjectReady(tsEventT.ubNet, tsEventT.ubNodeId, &tsEventT.tsCoObj, &ulAbortT);
+            break;
+
+         case eCO_STACK_EVENT_SDO_TIMEOUT:
+            onSdoEventTimeout(tsEventT.ubNet, tsEventT.ubNodeId, tsEventT.uwIndex, tsEventT.ubSubIndex);
+            break;
+
+         default:
+            break;
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::onTimerEvent()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::onTimerEvent(void)
+{
+   uint32_t ulCountT;
+
+   //---------------------------------------------------------------------------------------------------
+   // A tick which is delayed by more than one period is reported together with the path which
+   // used most of the time since the previous tick. The stack thread reports its own ticks.
+   //
+   if (clLatencyP.beginTick(CoCanTap::timeStamp()) && (pclStackThreadP == nullptr))
+   {
+      clLoggerP.printText("Tick overrun: %s used %u us since the previous tick, %u overruns\n",
+                          CoLatency::pathName(clLatencyP.overrunPath()),
+                          (uint32_t) (clLatencyP.overrunPathTime() / 1000),
+                          clLatencyP.overruns());
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // Process CAN message handling by the CANopen stack, this is done by the stack thread if
+   // it is running
+   //
+   if (pclStackThreadP == nullptr)
+   {
+      {
+         CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_MGR_PROCESS);
+         ComMgrProcess(ubNetworkP);
+      }
+
+      CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_NET_TIMER_EVENT);
+      ComMgrNetTimerEvent(ubNetworkP);
+   }
+   else
+   {
+      //-------------------------------------------------------------------------------------------
+      // Events are dropped if the event queue is full, e.g. a dropped SDO event leaves the scan
+      // of the device without result. Dropped events and missed ticks of the stack thread are
+      // reported once per timer tick.
+      //
+      ulCountT = pclStackThreadP->droppedEvents();
+      if (ulCountT != ulStackDropCntP)
+      {
+         clLoggerP.print("can%d: %u events of the stack thread dropped, %u in total\n", ubNetworkP,
+                         ulCountT - ulStackDropCntP, ulCountT);
+         ulStackDropCntP = ulCountT;
+      }
+
+      ulCountT = pclStackThreadP->tickOverruns();
+      if (ulCountT != ulStackOverrunCntP)
+      {
+         clLoggerP.print("can%d: stack thread missed %u ticks, %u in total\n", ubNetworkP,
+                         ulCountT - ulStackOverrunCntP, ulCountT);
+         ulStackOverrunCntP = ulCountT;
+      }
+   }
+
+   {
+      CoLatencyScope clScopeT(clLatencyP, eCO_LATENCY_DEVICE_SCAN);
+      clScanSchedulerP.tick(TIMER_CYCLE_PERIOD * 1000);
+      clRecoveryP.tick(TIMER_CYCLE_PERIOD * 1000);
+      processRecovery();
+      processCollision();
+      processDeviceScan();
+      processLss();
+      processNmtStart();
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // check the heartbeat and PDO deadlines which expire with this tick
+   //
+   if (btSuperviseP)
+   {
+      clSupervisorP.tick(CoCanTap::timeStamp());
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // close the bus monitor sample after each second
+   //
+   if (btBusMonitorP)
+   {
+      clBusMonitorP.tick(CoCanTap::timeStamp());
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // prepare the next trace file outside of the stack thread
+   //
+   clTraceP.service();
+
+   clLatencyP.endTick(CoCanTap::timeStamp());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::printEmcyHistory()                                                                                   //
+// print the EMCY history of all devices which have sent an EMCY                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::printEmcyHistory(void)
+{
+   CoEmcyEntry_ts atsEntryT[CO_EMCY_HISTORY_DEPTH];
+   uint32_t       ulEntryCntT;
+   uint32_t       ulCountT;
+   uint64_t       uqTimeT;
+   bool           btHeaderT = false;
+
+   uqTimeT = CoCanTap::timeStamp();
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_EMCY_NODE_MAX; ubNodeIdT++)
+   {
+      //-------------------------------------------------------------------------------------------
+      // the history is written by the stack thread, copy the entries of one device at a time
+      //
+      {
+         CoStackLocker clLockT(pclStackThreadP);
+         ulCountT = clEmcyHistoryP.count(ubNodeIdT);
+         for (ulEntryCntT = 0; ulEntryCntT < CO_EMCY_HISTORY_DEPTH; ulEntryCntT++)
+         {
+            if (clEmcyHistoryP.entry(ubNodeIdT, ulEntryCntT, atsEntryT[ulEntryCntT]) == false)
+            {
+               break;
+            }
+         }
+      }
+
+      if (ulCountT == 0)
+      {
+         continue;
+      }
+
+      if (btHeaderT == false)
+      {
+         clLoggerP.printText("EMCY history of %s, latest error first\n", qPrintable(clInterfaceP));
+         btHeaderT = true;
+      }
+
+      clLoggerP.print("   NID %03d: %u EMCY\n", ubNodeIdT, ulCountT);
+      for (uint32_t ulIdxT = 0; ulIdxT < ulEntryCntT; ulIdxT++)
+      {
+         const CoEmcyEntry_ts & tsEntryR = atsEntryT[ulIdxT];
+
+         clLoggerP.print("      code %04Xh  register %02Xh  data %08X%02X  count %8u  last %u s ago\n",
+                         tsEntryR.uwCode, tsEntryR.ubRegister,
+                         ((uint32_t) tsEntryR.aubManufacturer[0] << 24) |
+                         ((uint32_t) tsEntryR.aubManufacturer[1] << 16) |
+                         ((uint32_t) tsEntryR.aubManufacturer[2] <<  8) |
+                         ((uint32_t) tsEntryR.aubManufacturer[3]),
+                         tsEntryR.aubManufacturer[4], tsEntryR.ulCount,
+                         (uint32_t) ((uqTimeT - tsEntryR.uqLast) / 1000000000));
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::printBusMonitor()                                                                                    //
+// print bus load, frame counts and error counter history                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::printBusMonitor(void)
+{
+   CoMonitorSample_ts   tsSampleT;
+   CoMonitorError_ts    tsErrorT;
+   uint32_t             ulLoadT;
+   uint32_t             ulPeakT;
+   uint64_t             uqNowT;
+
+   if (btBusMonitorP == false)
+   {
+      return;
+   }
+
+   clLoggerP.printText("Bus monitor of %s\n", qPrintable(clInterfaceP));
+   clLoggerP.printText("   CAN state     %s, REC %u, TEC %u\n",
+                       CoBusMonitor::stateName(clBusMonitorP.busState().ubCanErrState),
+                       clBusMonitorP.busState().ubCanRcvErrCnt, clBusMonitorP.busState().ubCanTrmErrCnt);
+
+   if (clBusMonitorP.second(0, tsSampleT))
+   {
+      ulLoadT = clBusMonitorP.load(tsSampleT);
+      clLoggerP.print("   last second   load %3u.%u %%  frames %8u\n", ulLoadT / 10, ulLoadT % 10,
+                      tsSampleT.ulFrames);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // rolling minute, the frame counts show which service loads the bus
+   //
+   if (clBusMonitorP.rollingMinute(tsSampleT, &ulPeakT))
+   {
+      ulLoadT = clBusMonitorP.load(tsSampleT);
+      clLoggerP.print("   last minute   load %3u.%u %%  frames %8u  peak second %u.%u %%\n",
+                      ulLoadT / 10, ulLoadT % 10, tsSampleT.ulFrames, ulPeakT / 10, ulPeakT % 10);
+      clLoggerP.print("                 NMT %u  SYNC %u  EMCY %u  PDO %u  SDO %u  heartbeat %u\n",
+                      tsSampleT.aulClassFrames[eCO_MONITOR_NMT],  tsSampleT.aulClassFrames[eCO_MONITOR_SYNC],
+                      tsSampleT.aulClassFrames[eCO_MONITOR_EMCY], tsSampleT.aulClassFrames[eCO_MONITOR_PDO],
+                      tsSampleT.aulClassFrames[eCO_MONITOR_SDO],  tsSampleT.aulClassFrames[eCO_MONITOR_HEARTBEAT]);
+      clLoggerP.print("                 other %u  highest REC %u  highest TEC %u\n",
+                      tsSampleT.aulClassFrames[eCO_MONITOR_OTHER], tsSampleT.ubRcvErrMax, tsSampleT.ubTrmErrMax);
+   }
+
+   for (uint32_t ulIdxT = 0; clBusMonitorP.minute(ulIdxT, tsSampleT); ulIdxT++)
+   {
+      ulLoadT = clBusMonitorP.load(tsSampleT);
+      clLoggerP.print("   minute -%-3u   load %3u.%u %%  frames %8u  highest REC %3u  TEC %3u\n",
+                      ulIdxT + 1, ulLoadT / 10, ulLoadT % 10, tsSampleT.ulFrames,
+                      tsSampleT.ubRcvErrMax, tsSampleT.ubTrmErrMax);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // changes of the CAN controller state, latest first
+   //
+   uqNowT = CoCanTap::timeStamp();
+   for (uint32_t ulIdxT = 0; clBusMonitorP.error(ulIdxT, tsErrorT); ulIdxT++)
+   {
+      clLoggerP.printText("   %-20s  REC %3u  TEC %3u  %u s ago\n", CoBusMonitor::stateName(tsErrorT.ubState),
+                          tsErrorT.ubRcvErrCnt, tsErrorT.ubTrmErrCnt,
+                          (uint32_t) ((uqNowT - tsErrorT.uqTime) / 1000000000));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::printSupervision()                                                                                   //
+// print the inter-arrival statistics of all supervised frames                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::printSupervision(void)
+{
+   CoSupervisorStats_ts tsStatsT;
+
+   if (btSuperviseP == false)
+   {
+      return;
+   }
+
+   clLoggerP.printText("Supervision of %s: %u deadline misses, %u near misses\n",
+                       qPrintable(clInterfaceP), clSupervisorP.misses(), clSupervisorP.nearMisses());
+
+   for (uint32_t ulEntryT = 0; ulEntryT < CO_SUPERVISOR_ENTRY_MAX; ulEntryT++)
+   {
+      if (clSupervisorP.statistics(ulEntryT, tsStatsT) == false)
+      {
+         continue;
+      }
+
+      clLoggerP.print("   COB-ID %03Xh  count %8u  interval [us] min %8u  mean %8u  max %8u\n",
+                      tsStatsT.ulCobId, tsStatsT.ulCount,
+                      tsStatsT.ulIntervalMin, tsStatsT.ulIntervalMean, tsStatsT.ulIntervalMax);
+      if ((tsStatsT.ulMissCount > 0) || (tsStatsT.ulNearMissCount > 0))
+      {
+         clLoggerP.print("                 deadline misses %u, near misses %u\n",
+                         tsStatsT.ulMissCount, tsStatsT.ulNearMissCount);
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::writeMetrics()                                                                                       //
+// add the metrics of this network for a scrape of the metrics server                                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::writeMetrics(CoMetricsText & clTextR)
+{
+   QByteArray           clNetLabelT;
+   QByteArray           clLabelT;
+   CoSupervisorStats_ts tsStatsT;
+   CoMonitorSample_ts   tsSampleT;
+
+   clNetLabelT = "interface=\"";
+   clNetLabelT.append(clInterfaceP.toUtf8());
+   clNetLabelT.append("\"");
+
+   //---------------------------------------------------------------------------------------------------
+   // NMT state and counters of each device that has been seen on the network
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_METRICS_NODE_MAX; ubNodeIdT++)
+   {
+      if (clMetricsP.isKnown(ubNodeIdT) == false)
+      {
+         continue;
+      }
+
+      clLabelT = clNetLabelT;
+      clLabelT.append(",node=\"");
+      clLabelT.append(QByteArray::number(ubNodeIdT));
+      clLabelT.append("\"");
+
+      if (clMetricsP.nodeState(ubNodeIdT) != CO_METRICS_STATE_UNKNOWN)
+      {
+         clTextR.addGauge("canopen_node_state",
+                          "NMT state of the device: 0 boot-up, 4 stopped, 5 operational, 127 pre-operational",
+                          clLabelT, clMetricsP.nodeState(ubNodeIdT));
+      }
+      clTextR.addCounter("canopen_node_emcy_total", "EMCY messages received from the device",
+                         clLabelT, clMetricsP.emcyCount(ubNodeIdT));
+      clTextR.addCounter("canopen_node_heartbeat_lost_total", "Heartbeat losses reported by the heartbeat consumer",
+                         clLabelT, clMetricsP.heartbeatLostCount(ubNodeIdT));
+      clTextR.addCounter("canopen_node_sdo_timeouts_total", "SDO transfers to the device which timed out",
+                         clLabelT, clMetricsP.sdoTimeoutCount(ubNodeIdT));
+   }
+
+   clTextR.addSummary("canopen_scan_duration_seconds", "Time from boot-up until the device is configured",
+                      clNetLabelT, clMetricsP.scanDuration());
+   clTextR.addCounter("canopen_scan_failures_total", "Devices parked after the last scan retry",
+                      clNetLabelT, clMetricsP.scanFailures());
+   clTextR.addSummary("canopen_sdo_latency_seconds", "Round-trip time of SDO transfers of the SDO probe",
+                      clNetLabelT, clSdoLatencyP);
+
+   //---------------------------------------------------------------------------------------------------
+   // deadline misses of the supervised heartbeats and TPDOs, the statistics are owned by the
+   // timer handler which runs in this thread
+   //
+   if (btSuperviseP)
+   {
+      clTextR.addCounter("canopen_deadline_misses_total", "Supervised frames received after their deadline",
+                         clNetLabelT, clSupervisorP.misses());
+      clTextR.addCounter("canopen_deadline_near_misses_total", "Supervised frames received close to their deadline",
+                         clNetLabelT, clSupervisorP.nearMisses());
+
+      for (uint32_t ulEntryT = 0; ulEntryT < CO_SUPERVISOR_ENTRY_MAX; ulEntryT++)
+      {
+         if (clSupervisorP.statistics(ulEntryT, tsStatsT) == false)
+         {
+            continue;
+         }
+
+         clLabelT = clNetLabelT;
+         clLabelT.append(",cob_id=\"0x");
+         clLabelT.append(QByteArray::number(tsStatsT.ulCobId, 16));
+         clLabelT.append("\"");
+         clTextR.addCounter("canopen_frame_deadline_misses_total", "Deadline misses of one supervised frame",
+                            clLabelT, tsStatsT.ulMissCount);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // bus load of the last complete second, frame and bit totals and the CAN controller state
+   //
+   if (btBusMonitorP)
+   {
+      if (clBusMonitorP.second(0, tsSampleT))
+      {
+         clTextR.addGauge("canopen_bus_load_ratio", "Bus load of the last complete second",
+                          clNetLabelT, clBusMonitorP.load(tsSampleT) / 1000.0);
+      }
+
+      for (uint8_t ubClassT = 0; ubClassT < CO_MONITOR_CLASS_MAX; ubClassT++)
+      {
+         clLabelT = clNetLabelT;
+         clLabelT.append(",class=\"");
+         clLabelT.append(CoBusMonitor::className(ubClassT));
+         clLabelT.append("\"");
+         clTextR.addCounter("canopen_bus_frames_total", "Frames on the bus", clLabelT, clBusMonitorP.frames(ubClassT));
+      }
+      clTextR.addCounter("canopen_bus_bits_total", "Bits on the bus including stuff bits and interframe space",
+                         clNetLabelT, clBusMonitorP.bits());
+
+      clTextR.addGauge("canopen_bus_state", "CAN controller state: 2 error active, 4 error passive, 5 bus-off",
+                       clNetLabelT, clBusMonitorP.busState().ubCanErrState);
+      clTextR.addGauge("canopen_bus_receive_errors", "Receive error counter of the CAN controller",
+                       clNetLabelT, clBusMonitorP.busState().ubCanRcvErrCnt);
+      clTextR.addGauge("canopen_bus_transmit_errors", "Transmit error counter of the CAN controller",
+                       clNetLabelT, clBusMonitorP.busState().ubCanTrmErrCnt);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // timer tick overruns of the thread running the stack and the latency of the stack functions
+   // and event handlers
+   //
+   clTextR.addCounter("canopen_tick_overruns_total", "Timer ticks which took longer than the tick period",
+                      clNetLabelT, tickOverruns());
+   if (pclStackThreadP != nullptr)
+   {
+      clTextR.addCounter("canopen_stack_events_dropped_total", "Events of the stack thread dropped by a full queue",
+                         clNetLabelT, pclStackThreadP->droppedEvents());
+   }
+
+   for (uint8_t ubPathT = 0; ubPathT < eCO_LATENCY_PATH_MAX; ubPathT++)
+   {
+      clLabelT = clNetLabelT;
+      clLabelT.append(",path=\"");
+      clLabelT.append(CoLatency::pathName(ubPathT));
+      clLabelT.append("\"");
+      clTextR.addSummary("canopen_latency_seconds", "Latency of the stack functions and event handlers",
+                         clLabelT, clLatencyP.histogram(ubPathT));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processDeviceScan()                                                                                  //
+// start scans of devices which have not been scanned yet after boot-up message                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMasterDemo::processDeviceScan(void)
+{
+   uint8_t ubNodeIdT;
+
+   while ((ubNodeIdT = clScanSchedulerP.nextNode()) != 0)
+   {
+      CoStackLocker clLockT(pclStackThreadP);
+      ComSdoSetTimeout(ubNetworkP, 0, 200);
+
+      //-------------------------------------------------------------------------------------------
+      // the state defines the step of the scan, a retry continues with the step that failed
+      //
+      switch (clScanSchedulerP.state(ubNodeIdT))
+      {
+         case eCO_SCAN_STATE_VERIFYING:
+            if (clSdoProbeP.upload(ubNodeIdT, 0x1018, 0x04))
+            {
+               break;
+            }
+            clScanSchedulerP.nodeVerified(ubNodeIdT, false);
+            requestNodeInfo(ubNodeIdT);
+            break;
+
+         case eCO_SCAN_STATE_CONFIG_HEARTBEAT:
+            configureHeartbeat(ubNodeIdT);
+            break;
+
+         case eCO_SCAN_STATE_CONFIG_PDO:
+            if (requestPdoStep(ubNodeIdT) == false)
+            {
+               finishNodeConfig(ubNodeIdT);
+            }
+            break;
+
+         default:
+            requestNodeInfo(ubNodeIdT);
+            break;
+      }
+   }
+}
+
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processCollision()                                                                                   //
+// quarantine node-IDs used by two devices and resolve the collision by LSS                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::processCollision(void)
+{
+   uint8_t  ubNodeIdT;
+   uint32_t ulSerialT;
+
+   if (btCollisionP == false)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The quarantined node-ID is neither scanned nor started, its heartbeat consumer is stopped
+   // because the heartbeats of two devices can't be supervised.
+   //
+   while ((ubNodeIdT = clCollisionP.nextCollision()) != 0)
+   {
+      clLoggerP.print("can%d: NID %03d - node-ID collision detected, node-ID quarantined\n", ubNetworkP, ubNodeIdT);
+      clScanSchedulerP.quarantineNode(ubNodeIdT);
+      clNmtBatchP.removeNode(ubNodeIdT);
+
+      if (clLssMasterP.isOpen() == false)
+      {
+         clLoggerP.print("can%d: NID %03d - assign a new node-ID to one of the devices by hand\n", ubNetworkP,
+                         ubNodeIdT);
+      }
+
+      CoStackLocker clLockT(pclStackThreadP);
+      if (ComNmtSetHbConsTime(ubNetworkP, ubNodeIdT, 0) != eCOM_ERR_OK)
+      {
+         clLoggerP.print("can%d: NID %03d - heartbeat consumer can't be stopped\n", ubNetworkP, ubNodeIdT);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // one collision is resolved at a time, the LSS master must not run a Fastscan
+   //
+   if ((clLssMasterP.isOpen() == false) || clLssMasterP.isBusy() || (ubReassignNodeP != 0))
+   {
+      return;
+   }
+
+   ubNodeIdT = clCollisionP.nextUnresolved();
+   if (ubNodeIdT == 0)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The device is selected by the identity read by the scan. If a second serial number has
+   // been read, it belongs to the device which is moved. Devices which differ in vendor-ID,
+   // product code or revision number are not found and must be resolved by hand.
+   //
+   const ComNode_ts & tsNodeR = atsComNodeP[ubNodeIdT - 1];
+
+   ulSerialT = clCollisionP.serial(ubNodeIdT, 1);
+   if (ulSerialT == 0)
+   {
+      ulSerialT = tsNodeR.ulIdx1018_SN;
+   }
+
+   if ((ulSerialT == 0) ||
+       (clLssMasterP.reassign(tsNodeR.ulIdx1018_VI, tsNodeR.ulIdx1018_PC, tsNodeR.ulIdx1018_RN, ulSerialT) == false))
+   {
+      clLoggerP.print("can%d: NID %03d - identity unknown, assign a new node-ID to one of the devices by hand\n",
+                      ubNetworkP, ubNodeIdT);
+      return;
+   }
+
+   ubReassignNodeP = ubNodeIdT;
+   clLoggerP.print("can%d: NID %03d - moving device with serial number %08X by LSS\n", ubNetworkP, ubNodeIdT,
+                   ulSerialT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processLss()                                                                                         //
+// start the LSS Fastscan which is due                                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::processLss(void)
+{
+   if ((uqLssDueP == 0) || (clScanSchedulerP.time() < uqLssDueP) || clLssMasterP.isBusy())
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // node-IDs are marked as used on boot-up, so the Fastscan waits for the scan of the
+   // configured devices
+   //
+   if (clScanSchedulerP.isIdle() == false)
+   {
+      return;
+   }
+
+   uqLssDueP = 0;
+   if (clLssMasterP.fastscan() == false)
+   {
+      uqLssDueP = clScanSchedulerP.time() + ((uint64_t) LSS_CHECK_PERIOD * 1000);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processNmtStart()                                                                                    //
+// start the configured devices which are due                                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::processNmtStart(void)
+{
+   uint8_t  aubNodeIdT[CO_NMT_BATCH_NODE_MAX];
+   uint8_t  ubCountT;
+   bool     btBroadcastT;
+
+   if (clNmtBatchP.isEnabled() == false)
+   {
+      return;
+   }
+
+   ubCountT = clNmtBatchP.release(clScanSchedulerP.isIdle(), clScanSchedulerP.time(), &aubNodeIdT[0]);
+   if (ubCountT == 0)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // A broadcast starts every device of the network. It is only used when the released group
+   // holds all waiting devices, no device is queued or scanned and no device is parked after a
+   // failed scan or quarantined.
+   //
+   btBroadcastT = (clNmtBatchP.count() == 0) && clScanSchedulerP.isIdle();
+   for (uint8_t ubNodeIdT = 1; btBroadcastT && (ubNodeIdT <= CO_SCAN_NODE_MAX); ubNodeIdT++)
+   {
+      if ((clScanSchedulerP.state(ubNodeIdT) == eCO_SCAN_STATE_FAILED) ||
+          (clScanSchedulerP.state(ubNodeIdT) == eCO_SCAN_STATE_QUARANTINED))
+      {
+         btBroadcastT = false;
+      }
+   }
+
+   CoStackLocker clLockT(pclStackThreadP);
+   if (btBroadcastT)
+   {
+      ComNmtSetNodeState(ubNetworkP, 0, eCOM_NMT_STATE_OPERATIONAL);
+      clLoggerP.print("can%d: %d devices started by one broadcast NMT command\n", ubNetworkP, ubCountT);
+   }
+   else
+   {
+      for (uint8_t ubIdxT = 0; ubIdxT < ubCountT; ubIdxT++)
+      {
+         ComNmtSetNodeState(ubNetworkP, aubNodeIdT[ubIdxT], eCOM_NMT_STATE_OPERATIONAL);
+      }
+      clLoggerP.print("can%d: %d devices started, NID %03d .. %03d\n", ubNetworkP, ubCountT,
+                      aubNodeIdT[0], aubNodeIdT[ubCountT - 1]);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processRecovery()                                                                                    //
+// reset and scan the devices with lost heartbeat which are due                                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::processRecovery(void)
+{
+   uint8_t  ubNodeIdT;
+
+   if (clRecoveryP.isEnabled() == false)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // If the node is still there: send a NMT reset node command and try to get it again
+   //
+   while ((ubNodeIdT = clRecoveryP.nextReset()) != 0)
+   {
+      clLoggerP.print("can%d: NID %03d - missing heartbeat, try to reset node .. \n", ubNetworkP, ubNodeIdT);
+
+      CoStackLocker clLockT(pclStackThreadP);
+      ComNmtSetNodeState(ubNetworkP, ubNodeIdT, eCOM_NMT_STATE_RESET_NODE);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the scan of rebooted devices is limited to the batch size per second
+   //
+   while ((ubNodeIdT = clRecoveryP.nextRescan()) != 0)
+   {
+      clScanSchedulerP.addNode(ubNodeIdT, clSdoProbeP.isOpen() &&
+                               clIdentityCacheP.lookup(clInterfaceP, ubNodeIdT, nullptr));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::processPdoConfig()                                                                                   //
+// one step of the PDO inhibit time configuration has finished                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::processPdoConfig(uint8_t ubNodeIdV, bool btSuccessV, uint32_t ulValueV)
+{
+   PdoConfig_s & tsConfigR  = atsPdoConfigP[ubNodeIdV - 1];
+   bool          btNextPdoT = false;
+
+   switch (tsConfigR.ubStep)
+   {
+      //-------------------------------------------------------------------------------------------
+      // a PDO which can't be read is not supported by the device, a valid PDO is disabled first
+      //
+      case eCO_PDO_STEP_COB_ID:
+         if (btSuccessV)
+         {
+            tsConfigR.ulCobId  = ulValueV;
+            tsConfigR.btEnable = ((ulValueV & PDO_COB_ID_INVALID) == 0);
+            tsConfigR.ubStep   = tsConfigR.btEnable ? eCO_PDO_STEP_DISABLE : eCO_PDO_STEP_INHIBIT;
+         }
+         else
+         {
+            btNextPdoT = true;
+         }
+         break;
+
+      case eCO_PDO_STEP_DISABLE:
+         if (btSuccessV)
+         {
+            tsConfigR.ubStep = eCO_PDO_STEP_INHIBIT;
+         }
+         else
+         {
+            btNextPdoT = true;
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // the PDO is enabled again even if the device does not support an inhibit time
+      //
+      case eCO_PDO_STEP_INHIBIT:
+         if (tsConfigR.btEnable)
+         {
+            tsConfigR.ubStep = eCO_PDO_STEP_ENABLE;
+         }
+         else
+         {
+            btNextPdoT = true;
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // A disabled PDO never transmits again, so a rejected write is repeated. If the device
+      // still rejects it, the device is parked instead of being reported as configured.
+      //
+      case eCO_PDO_STEP_ENABLE:
+         if (btSuccessV)
+         {
+            btNextPdoT = true;
+         }
+         else if (tsConfigR.ubRetryCnt < ubScanRetriesP)
+         {
+            tsConfigR.ubRetryCnt++;
+         }
+         else
+         {
+            clLoggerP.print("can%d: NID %03d - TPDO%d can't be enabled again, device is parked\n", ubNetworkP,
+                            ubNodeIdV, tsConfigR.ubPdo + 1);
+            clScanSchedulerP.nodeFailed(ubNodeIdV);
+            clMetricsP.countScanFailure(ubNodeIdV);
+            return;
+         }
+         break;
+
+      default:
+         btNextPdoT = true;
+         break;
+   }
+
+   if (btNextPdoT)
+   {
+      tsConfigR.ubPdo++;
+      tsConfigR.ubStep     = eCO_PDO_STEP_COB_ID;
+      tsConfigR.btEnable   = false;
+      tsConfigR.ubRetryCnt = 0;
+   }
+
+   if (requestPdoStep(ubNodeIdV) == false)
+   {
+      CoStackLocker clLockT(pclStackThreadP);
+      finishNodeConfig(ubNodeIdV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::requestNodeInfo()                                                                                    //
+// read the identity of a device during the scan                                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::requestNodeInfo(uint8_t ubNodeIdV)
+{
+   ComStatus_tv tvResultT;
+
+   //---------------------------------------------------------------------------------------------------
+   // A refused request raises no SDO event, the scan slot would never be freed. The request is
+   // repeated after the backoff time or the device is parked after the last retry.
+   //
+   tvResultT = ComNodeGetInfo(ubNetworkP, ubNodeIdV);
+   if (tvResultT != eCOM_ERR_OK)
+   {
+      clLoggerP.print("can%d: NID %03d - identity request refused, error %d\n", ubNetworkP, ubNodeIdV, tvResultT);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::requestPdoStep()                                                                                     //
+// start the SDO transfer of the current PDO configuration step                                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+bool  CoMasterDemo::requestPdoStep(uint8_t ubNodeIdV)
+{
+   PdoConfig_s & tsConfigR = atsPdoConfigP[ubNodeIdV - 1];
+   uint16_t      uwIndexT;
+   bool          btSentT;
+
+   if (tsConfigR.ubPdo >= CO_PLAN_PDO_MAX)
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // TPDO communication parameter: sub-index 1 is the COB-ID, sub-index 3 the inhibit time
+   //
+   uwIndexT = 0x1800 + tsConfigR.ubPdo;
+   switch (tsConfigR.ubStep)
+   {
+      case eCO_PDO_STEP_DISABLE:
+         btSentT = clSdoProbeP.download(ubNodeIdV, uwIndexT, 0x01, tsConfigR.ulCobId | PDO_COB_ID_INVALID, 4);
+         break;
+
+      case eCO_PDO_STEP_INHIBIT:
+         btSentT = clSdoProbeP.download(ubNodeIdV, uwIndexT, 0x03, clPlannerP.inhibitTime(), 2);
+         break;
+
+      case eCO_PDO_STEP_ENABLE:
+         btSentT = clSdoProbeP.download(ubNodeIdV, uwIndexT, 0x01, tsConfigR.ulCobId & ~PDO_COB_ID_INVALID, 4);
+         break;
+
+      default:
+         btSentT = clSdoProbeP.upload(ubNodeIdV, uwIndexT, 0x01);
+         break;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The configuration is not finished if the request can't be sent, a disabled PDO still has
+   // to be enabled. The step is repeated after the backoff time like after an SDO timeout.
+   //
+   if (btSentT == false)
+   {
+      clLoggerP.print("can%d: NID %03d - SDO request to object %04Xh not sent\n", ubNetworkP, ubNodeIdV, uwIndexT);
+      handleScanTimeout(ubNetworkP, ubNodeIdV);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::runCmdParser()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::runCmdParser(void)
+{
+   QCommandLineParser   clCmdParserT;
+
+   //---------------------------------------------------------------------------------------------------
+   // setup command line parser, options are added in alphabetical order
+   //
+   clCmdParserT.setApplicationDescription(tr("CANopen Master demo"));
+
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -h, --help
+   //
+   clCmdParserT.addHelpOption();
+
+   
+   //---------------------------------------------------------------------------------------------------
+   // argument <interface> is required
+   //
+   clCmdParserT.addPositionalArgument("interface", 
+                                      tr("CAN interface, e.g. can1, a second interface runs in the same process"),
+                                      "interface [interface]");
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --bitrate <kbit/s>
+   //
+   QCommandLineOption clOptBitrateT("bitrate",
+         tr("Bitrate of the CAN interface in [kbit/s], default 500"),
+         tr("kbit/s"));
+   clCmdParserT.addOption(clOptBitrateT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --bus-monitor
+   //
+   QCommandLineOption clOptBusMonitorT("bus-monitor",
+         tr("Measure bus load, frame counts and error counters of the CAN interface"));
+   clCmdParserT.addOption(clOptBusMonitorT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --busload <percent>
+   //
+   QCommandLineOption clOptBusLoadT("busload",
+         tr("Plan heartbeat and PDO inhibit times of the devices for a bus load of <percent>"),
+         tr("percent"));
+   clCmdParserT.addOption(clOptBusLoadT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --collision
+   //
+   QCommandLineOption clOptCollisionT("collision",
+         tr("Detect node-ID collisions, quarantine the node-ID and resolve it by LSS"));
+   clCmdParserT.addOption(clOptCollisionT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --emcy-rate <n>
+   //
+   QCommandLineOption clOptEmcyRateT("emcy-rate",
+         tr("Report at most <n> EMCY messages per second and device, 0 for no limit, default 5"),
+         tr("n"));
+   clCmdParserT.addOption(clOptEmcyRateT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --event-driven
+   //
+   QCommandLineOption clOptEventDrivenT("event-driven",
+         tr("Process received CAN frames immediately instead of every timer cycle"));
+   clCmdParserT.addOption(clOptEventDrivenT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --heartbeat-cycle <time>
+   //
+   QCommandLineOption clOptHeartbeatCycleT("heartbeat-cycle",
          tr("Cycle time for heartbeat service in [ms]"),
          tr("time"));
    clCmdParserT.addOption(clOptHeartbeatCycleT);
    
    //---------------------------------------------------------------------------------------------------
-   // command line option: --sync-cycle <time>
+   // command line option: --identity-cache <file>
+   //
+   QCommandLineOption clOptIdentityCacheT("identity-cache",
+         tr("Store device identities in <file>, verify only the serial number after boot-up"),
+         tr("file"));
+   clCmdParserT.addOption(clOptIdentityCacheT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --lss <id>
+   //
+   QCommandLineOption clOptLssT("lss",
+         tr("Assign node-IDs from <id> upward to unconfigured devices by LSS Fastscan"),
+         tr("id"));
+   clCmdParserT.addOption(clOptLssT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --metrics-port <port>
+   //
+   QCommandLineOption clOptMetricsPortT("metrics-port",
+         tr("Serve metrics in Prometheus text format on 127.0.0.1:<port>"),
+         tr("port"));
+   clCmdParserT.addOption(clOptMetricsPortT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --nmt-start <n>
+   //
+   QCommandLineOption clOptNmtStartT("nmt-start",
+         tr("Start configured devices together: 'all' with one broadcast after the scan, <n> in groups of n"),
+         tr("n"));
+   clCmdParserT.addOption(clOptNmtStartT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --pdo-load <percent>
+   //
+   QCommandLineOption clOptPdoLoadT("pdo-load",
+         tr("Share of the bus load budget reserved for PDOs in <percent>, sets the PDO inhibit times"),
+         tr("percent"));
+   clCmdParserT.addOption(clOptPdoLoadT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --pdo-timeout <time>
+   //
+   QCommandLineOption clOptPdoTimeoutT("pdo-timeout",
+         tr("Supervise the TPDOs of all devices with a deadline of <time> [ms]"),
+         tr("time"));
+   clCmdParserT.addOption(clOptPdoTimeoutT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --process-image <name>
+   //
+   QCommandLineOption clOptProcessImageT("process-image",
+         tr("Publish received PDOs in shared memory object <name>, e.g. /canopen-demo"),
+         tr("name"));
+   clCmdParserT.addOption(clOptProcessImageT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --recovery <n>
+   //
+   QCommandLineOption clOptRecoveryT("recovery",
+         tr("Reset and scan devices with lost heartbeat in batches of <n> devices per second"),
+         tr("n"));
+   clCmdParserT.addOption(clOptRecoveryT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --replay <file>
+   //
+   QCommandLineOption clOptReplayT("replay",
+         tr("Transmit the CAN frames recorded in trace <file> on the interface"),
+         tr("file"));
+   clCmdParserT.addOption(clOptReplayT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --replay-speed <factor>
+   //
+   QCommandLineOption clOptReplaySpeedT("replay-speed",
+         tr("Replay speed, 1 for recorded timing (default), 0 for maximum speed"),
+         tr("factor"));
+   clCmdParserT.addOption(clOptReplaySpeedT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --scan-busload <percent>
+   //
+   QCommandLineOption clOptScanBusLoadT("scan-busload",
+         tr("Limit the bus load of device scans to <percent>"),
+         tr("percent"));
+   clCmdParserT.addOption(clOptScanBusLoadT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --scan-parallel <n>
+   //
+   QCommandLineOption clOptScanParallelT("scan-parallel",
+         tr("Number of devices scanned at the same time, default 8"),
+         tr("n"));
+   clCmdParserT.addOption(clOptScanParallelT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --scan-retries <n>
+   //
+   QCommandLineOption clOptScanRetriesT("scan-retries",
+         tr("Number of retries after an SDO timeout, default 3"),
+         tr("n"));
+   clCmdParserT.addOption(clOptScanRetriesT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --stack-cpu <cpu>
+   //
+   QCommandLineOption clOptStackCpuT("stack-cpu",
+         tr("Bind the stack thread to CPU <cpu>"),
+         tr("cpu"));
+   clCmdParserT.addOption(clOptStackCpuT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --stack-lock-per-network
+   //
+   QCommandLineOption clOptStackLockNetT("stack-lock-per-network",
+         tr("Use one stack lock for each network, requires a re-entrant master library"));
+   clCmdParserT.addOption(clOptStackLockNetT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --stack-priority <prio>
+   //
+   QCommandLineOption clOptStackPriorityT("stack-priority",
+         tr("Run the stack thread with SCHED_FIFO priority <prio> and lock memory"),
+         tr("prio"));
+   clCmdParserT.addOption(clOptStackPriorityT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --stack-thread
+   //
+   QCommandLineOption clOptStackThreadT("stack-thread",
+         tr("Run the CANopen stack in a separate thread"));
+   clCmdParserT.addOption(clOptStackThreadT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --supervise
+   //
+   QCommandLineOption clOptSuperviseT("supervise",
+         tr("Supervise heartbeat and PDO deadlines of all devices"));
+   clCmdParserT.addOption(clOptSuperviseT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --sync-cycle <time>
+   //
+   QCommandLineOption clOptSyncCycleT("sync-cycle",
+         tr("Cycle time for SYNC service in [ms], e.g. 0.5"),
+         tr("time"));
+   clCmdParserT.addOption(clOptSyncCycleT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --sync-priority <prio>
+   //
+   QCommandLineOption clOptSyncPriorityT("sync-priority",
+         tr("Run the SYNC producer thread with SCHED_FIFO priority <prio>"),
+         tr("prio"));
+   clCmdParserT.addOption(clOptSyncPriorityT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --sync-thread
+   //
+   QCommandLineOption clOptSyncThreadT("sync-thread",
+         tr("Transmit SYNC from a high-resolution timer thread instead of the stack"));
+   clCmdParserT.addOption(clOptSyncThreadT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --trace <file>
+   //
+   QCommandLineOption clOptTraceT("trace",
+         tr("Record CAN frames and CANopen events in <file>.0 .. <file>.3"),
+         tr("file"));
+   clCmdParserT.addOption(clOptTraceT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -v, --version
+   //
+   clCmdParserT.addVersionOption();
+
+
+   //---------------------------------------------------------------------------------------------------
+   // get the instance of the main application
+   //
+   QCoreApplication * pclAppT = QCoreApplication::instance();
+
+
+   //---------------------------------------------------------------------------------------------------
+   // Process the actual command line arguments given by the user
+   //
+   if (clArgumentsP.isEmpty())
+   {
+      clCmdParserT.process(*pclAppT);
+   }
+   else
+   {
+      clCmdParserT.process(clArgumentsP);
+   }
+   const QStringList clArgsT = clCmdParserT.positionalArguments();
+   if ((clArgsT.size() < 1) || (clArgsT.size() > CO_DEMO_NETWORK_MAX))
+   {
+      fprintf(stdout, "%s\n", qPrintable(tr("Error: Must specify one or two CAN interfaces.\n")));
+      clCmdParserT.showHelp(0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // test format of argument <interface>
+   //
+   QString clInterfaceT = clArgsT.at(ubIndexP);
+   if (!clInterfaceT.startsWith("can"))
+   {
+      fprintf(stderr, "%s %s\n", qPrintable(tr("Error: Unknown CAN interface ")), qPrintable(clInterfaceT));
+      clCmdParserT.showHelp(0);
+   }
+   
+   //---------------------------------------------------------------------------------------------------
+   // convert CAN channel to uint8_t value
+   //
+   QString clIfNumT = clInterfaceT.right(clInterfaceT.size() - 3);
+   bool    btConversionSuccessT;
+   int32_t slChannelT = clIfNumT.toInt(&btConversionSuccessT, 10);
+   if ((btConversionSuccessT == false) || (slChannelT < 1) || (slChannelT > 2))
+   {
+      fprintf(stderr, "%s \n\n", qPrintable(tr("Error: CAN interface out of range")));
+      clCmdParserT.showHelp(0);
+   }
+   
+   //---------------------------------------------------------------------------------------------------
+   // evaluate heartbeat cycle time
+   //
+   uwHeartbeatTimeP = (uint16_t) clCmdParserT.value(clOptHeartbeatCycleT).toInt(Q_NULLPTR, 10);   
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate SYNC cycle time, the cycle time is given in [ms], convert it to [us] for the API
+   //
+   ulSyncTimeP = 0;
+   if (clCmdParserT.isSet(clOptSyncCycleT))
+   {
+      bool   btOkT = false;
+      double flSyncTimeT = clCmdParserT.value(clOptSyncCycleT).toDouble(&btOkT);
+      if ((btOkT == false) || (flSyncTimeT < 0) || (flSyncTimeT > 60000))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: SYNC cycle time out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ulSyncTimeP = (uint32_t) ((flSyncTimeT * 1000.0) + 0.5);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // store CAN interface channel (CAN_Channel_e)
+   //
+   ubCanChannelP = (uint8_t) (slChannelT);
+   clInterfaceP  = clInterfaceT;
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate event-driven processing of received frames
+   //
+   btEventDrivenP = clCmdParserT.isSet(clOptEventDrivenT);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate EMCY notification rate
+   //
+   if (clCmdParserT.isSet(clOptEmcyRateT))
+   {
+      int32_t slEmcyRateT = clCmdParserT.value(clOptEmcyRateT).toInt(Q_NULLPTR, 10);
+      if ((slEmcyRateT < 0) || (slEmcyRateT > 1000))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: EMCY rate out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ulEmcyRateP = (uint32_t) slEmcyRateT;
+   }
+   clEmcyHistoryP.setRate(ulEmcyRateP);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate bitrate, the value is given in [kbit/s]
+   //
+   if (clCmdParserT.isSet(clOptBitrateT))
+   {
+      ulBitrateP = clCmdParserT.value(clOptBitrateT).toUInt(Q_NULLPTR, 10) * 1000;
+      if ((ulBitrateP < 10000) || (ulBitrateP > 1000000))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: bitrate out of range")));
+         clCmdParserT.showHelp(0);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate bus load budget, the PDO load is part of the budget
+   //
+   if (clCmdParserT.isSet(clOptBusLoadT))
+   {
+      int32_t slBusLoadT = clCmdParserT.value(clOptBusLoadT).toInt(Q_NULLPTR, 10);
+      if ((slBusLoadT < 0) || (slBusLoadT > 100))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: bus load out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubBusLoadP = (uint8_t) slBusLoadT;
+   }
+   if (clCmdParserT.isSet(clOptPdoLoadT))
+   {
+      int32_t slPdoLoadT = clCmdParserT.value(clOptPdoLoadT).toInt(Q_NULLPTR, 10);
+      if ((slPdoLoadT < 0) || (slPdoLoadT >= ubBusLoadP))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: PDO load must be below the bus load")));
+         clCmdParserT.showHelp(0);
+      }
+      ubPdoLoadP = (uint8_t) slPdoLoadT;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate identity cache file
+   //
+   clIdentityFileP = clCmdParserT.value(clOptIdentityCacheT);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate first node-ID assigned by LSS
+   //
+   if (clCmdParserT.isSet(clOptLssT))
+   {
+      int32_t slNodeIdT = clCmdParserT.value(clOptLssT).toInt(Q_NULLPTR, 10);
+      if ((slNodeIdT < 1) || (slNodeIdT > CO_LSS_NODE_MAX))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: LSS node-ID out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubLssFirstIdP = (uint8_t) slNodeIdT;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate NMT start of configured devices
+   //
+   if (clCmdParserT.isSet(clOptNmtStartT))
+   {
+      if (clCmdParserT.value(clOptNmtStartT) == "all")
+      {
+         ubNmtGroupP = CO_NMT_BATCH_ALL;
+      }
+      else
+      {
+         int32_t slNmtGroupT = clCmdParserT.value(clOptNmtStartT).toInt(Q_NULLPTR, 10);
+         if ((slNmtGroupT < 1) || (slNmtGroupT > CO_NMT_BATCH_NODE_MAX))
+         {
+            fprintf(stderr, "%s \n\n", qPrintable(tr("Error: NMT start group size out of range")));
+            clCmdParserT.showHelp(0);
+         }
+         ubNmtGroupP = (uint8_t) slNmtGroupT;
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate recovery batch size
+   //
+   if (clCmdParserT.isSet(clOptRecoveryT))
+   {
+      int32_t slBatchT = clCmdParserT.value(clOptRecoveryT).toInt(Q_NULLPTR, 10);
+      if ((slBatchT < 1) || (slBatchT > CO_RECOVERY_NODE_MAX))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: recovery batch size out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubRecoveryBatchP = (uint8_t) slBatchT;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate metrics port
+   //
+   if (clCmdParserT.isSet(clOptMetricsPortT))
+   {
+      int32_t slPortT = clCmdParserT.value(clOptMetricsPortT).toInt(Q_NULLPTR, 10);
+      if ((slPortT < 1) || (slPortT > 65535))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: metrics port out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      uwMetricsPortP = (uint16_t) slPortT;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate trace file
+   //
+   clTraceFileP = clCmdParserT.value(clOptTraceT);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate replay options
+   //
+   clReplayFileP = clCmdParserT.value(clOptReplayT);
+   if (clCmdParserT.isSet(clOptReplaySpeedT))
+   {
+      bool btOkT = false;
+      flReplaySpeedP = clCmdParserT.value(clOptReplaySpeedT).toDouble(&btOkT);
+      if ((btOkT == false) || (flReplaySpeedP < 0))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: replay speed out of range")));
+         clCmdParserT.showHelp(0);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate name of process image, the name of a shared memory object starts with '/'
+   //
+   clProcessImageNameP = clCmdParserT.value(clOptProcessImageT);
+   if ((clProcessImageNameP.isEmpty() == false) && (clProcessImageNameP.startsWith("/") == false))
+   {
+      clProcessImageNameP.prepend("/");
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate supervision options, a PDO deadline enables the supervision
    //
-   QCommandLineOption clOptSyncCycleT("sync-cycle",
-         tr("Cycle time for SYNC service in [ms]"),
-         tr("time"));
-   clCmdParserT.addOption(clOptSyncCycleT);
+   btSuperviseP = clCmdParserT.isSet(clOptSuperviseT);
 
    //---------------------------------------------------------------------------------------------------
-   // command line option: -v, --version
+   // evaluate bus monitor
    //
-   clCmdParserT.addVersionOption();
-
+   btBusMonitorP = clCmdParserT.isSet(clOptBusMonitorT);
 
    //---------------------------------------------------------------------------------------------------
-   // get the instance of the main application
+   // evaluate node-ID collision detection
    //
-   QCoreApplication * pclAppT = QCoreApplication::instance();
+   btCollisionP = clCmdParserT.isSet(clOptCollisionT);
 
+   if (clCmdParserT.isSet(clOptPdoTimeoutT))
+   {
+      ulPdoTimeoutP = clCmdParserT.value(clOptPdoTimeoutT).toUInt(Q_NULLPTR, 10);
+      if ((ulPdoTimeoutP < 2 * TIMER_CYCLE_PERIOD) || (ulPdoTimeoutP > 65535))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: PDO deadline out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      btSuperviseP = true;
+   }
 
    //---------------------------------------------------------------------------------------------------
-   // Process the actual command line arguments given by the user
+   // evaluate scan options
    //
-   clCmdParserT.process(*pclAppT);
-   const QStringList clArgsT = clCmdParserT.positionalArguments();
-   if (clArgsT.size() != 1) 
+   if (clCmdParserT.isSet(clOptScanParallelT))
    {
-      fprintf(stdout, "%s\n", qPrintable(tr("Error: Must specify CAN interface.\n")));
-      clCmdParserT.showHelp(0);
+      int32_t slParallelT = clCmdParserT.value(clOptScanParallelT).toInt(Q_NULLPTR, 10);
+      if ((slParallelT < 1) || (slParallelT > CO_SCAN_NODE_MAX))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: number of parallel scans out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubScanParallelP = (uint8_t) slParallelT;
+   }
+   if (clCmdParserT.isSet(clOptScanBusLoadT))
+   {
+      int32_t slBusLoadT = clCmdParserT.value(clOptScanBusLoadT).toInt(Q_NULLPTR, 10);
+      if ((slBusLoadT < 0) || (slBusLoadT > 100))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: scan bus load out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubScanBusLoadP = (uint8_t) slBusLoadT;
+   }
+   if (clCmdParserT.isSet(clOptScanRetriesT))
+   {
+      int32_t slRetriesT = clCmdParserT.value(clOptScanRetriesT).toInt(Q_NULLPTR, 10);
+      if ((slRetriesT < 0) || (slRetriesT > 10))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: number of scan retries out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubScanRetriesP = (uint8_t) slRetriesT;
    }
 
    //---------------------------------------------------------------------------------------------------
-   // test format of argument <interface>
+   // evaluate stack thread options, priority and CPU are only used with the stack thread
    //
-   QString clInterfaceT = clArgsT.at(0);
-   if (!clInterfaceT.startsWith("can"))
+   btStackThreadP  = clCmdParserT.isSet(clOptStackThreadT);
+   btStackLockNetP = clCmdParserT.isSet(clOptStackLockNetT);
+   if (clCmdParserT.isSet(clOptStackCpuT))
    {
-      fprintf(stderr, "%s %s\n", qPrintable(tr("Error: Unknown CAN interface ")), qPrintable(clInterfaceT));
-      clCmdParserT.showHelp(0);
+      slStackCpuP = clCmdParserT.value(clOptStackCpuT).toInt(Q_NULLPTR, 10);
    }
-   
+   if (clCmdParserT.isSet(clOptStackPriorityT))
+   {
+      slStackPriorityP = clCmdParserT.value(clOptStackPriorityT).toInt(Q_NULLPTR, 10);
+      if ((slStackPriorityP < 0) || (slStackPriorityP > 99))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: stack priority out of range")));
+         clCmdParserT.showHelp(0);
+      }
+   }
+
+
    //---------------------------------------------------------------------------------------------------
-   // convert CAN channel to uint8_t value
+   // evaluate SYNC producer options, the thread is only used if a SYNC cycle time is given
    //
-   QString clIfNumT = clInterfaceT.right(clInterfaceT.size() - 3);
-   bool    btConversionSuccessT;
-   int32_t slChannelT = clIfNumT.toInt(&btConversionSuccessT, 10);
-   if ((btConversionSuccessT == false) || (slChannelT < 1) || (slChannelT > 2))
+   btSyncThreadP = clCmdParserT.isSet(clOptSyncThreadT) && (ulSyncTimeP > 0);
+   if (btSyncThreadP && (ulSyncTimeP < CO_SYNC_CYCLE_MIN))
    {
-      fprintf(stderr, "%s \n\n", qPrintable(tr("Error: CAN interface out of range")));
+      fprintf(stderr, "%s \n\n", qPrintable(tr("Error: SYNC cycle time of SYNC thread below 0.1 ms")));
       clCmdParserT.showHelp(0);
    }
-   
-   //---------------------------------------------------------------------------------------------------
-   // evaluate heartbeat cycle time
-   //
-   uwHeartbeatTimeP = (uint16_t) clCmdParserT.value(clOptHeartbeatCycleT).toInt(Q_NULLPTR, 10);   
+   if (clCmdParserT.isSet(clOptSyncPriorityT))
+   {
+      slSyncPriorityP = clCmdParserT.value(clOptSyncPriorityT).toInt(Q_NULLPTR, 10);
+      if ((slSyncPriorityP < 0) || (slSyncPriorityP > 99))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: SYNC priority out of range")));
+         clCmdParserT.showHelp(0);
+      }
+   }
 
-   //---------------------------------------------------------------------------------------------------
-   // evaluate SYNC cycle time, the cycle time is given in [ms], convert it to [us] fot he API
-   //
-   ulSyncTimeP = (uint16_t) clCmdParserT.value(clOptSyncCycleT).toInt(Q_NULLPTR, 10);   
-   ulSyncTimeP = ulSyncTimeP * 1000;
 
    //---------------------------------------------------------------------------------------------------
-   // store CAN interface channel (CAN_Channel_e)
+   // With more than one network the files and the shared memory object of each network get the
+   // name of the interface as suffix, e.g. /canopen-demo-can2
    //
-   ubCanChannelP = (uint8_t) (slChannelT);
+   if (clArgsT.size() > 1)
+   {
+      if ((ubIndexP == 0) && (clArgsT.at(0) == clArgsT.at(1)))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: CAN interface given twice")));
+         clCmdParserT.showHelp(0);
+      }
+
+      if (clTraceFileP.isEmpty() == false)
+      {
+         clTraceFileP += "-" + clInterfaceP;
+      }
+      if (clReplayFileP.isEmpty() == false)
+      {
+         clReplayFileP += "-" + clInterfaceP;
+      }
+      if (clProcessImageNameP.isEmpty() == false)
+      {
+         clProcessImageNameP += "-" + clInterfaceP;
+      }
+   }
 
 
    //---------------------------------------------------------------------------------------------------
    // start demo
    //
    start();
+
+   //---------------------------------------------------------------------------------------------------
+   // The first network creates the other networks, they evaluate the same command line. If one
+   // network finishes all networks are stopped.
+   //
+   if (ubIndexP == 0)
+   {
+      for (uint8_t ubIdxT = 1; ubIdxT < clArgsT.size(); ubIdxT++)
+      {
+         apclNetworkP[ubIdxT] = new CoMasterDemo(ubIdxT);
+         apclNetworkP[ubIdxT]->setArguments(clArgumentsP);
+         connect(apclNetworkP[ubIdxT], &CoMasterDemo::finished, this, &CoMasterDemo::stop, Qt::QueuedConnection);
+         apclNetworkP[ubIdxT]->runCmdParser();
+      }
+   }
 }
 
 
@@ -789,6 +3309,47 @@ void  CoMasterDemo::signalHandlerTerm(int32_t slUnusedV)
 }
 
 
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::signalHandlerUsr1()                                                                                  //
+// write a value to the socket for SIGUSR1                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::signalHandlerUsr1(int32_t slUnusedV)
+{
+   Q_UNUSED(slUnusedV);
+
+   char chValueT = 1;
+   ssize_t tvSizeT = ::write(aslSigUsr1FdP[0], &chValueT, sizeof(chValueT));
+   if (tvSizeT == 0)
+   {
+      // avoid compiler warning
+   }
+
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::startReplay()                                                                                        //
+// transmit the frames of a recorded trace                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void  CoMasterDemo::startReplay(void)
+{
+   if (clReplayP.isRunning())
+   {
+      return;
+   }
+
+   if (clReplayP.open(qPrintable(clReplayFileP), qPrintable(clInterfaceP)) == false)
+   {
+      clLoggerP.printText("Failed to open trace %s for replay.\n", qPrintable(clReplayFileP));
+      return;
+   }
+
+   clReplayP.setSpeed(flReplaySpeedP);
+   clReplayP.start();
+   clLoggerP.printText("Replay of trace %s started.\n", qPrintable(clReplayFileP));
+}
+
+
 //--------------------------------------------------------------------------------------------------------------------//
 // CoMasterDemo::start()                                                                                              //
 //                                                                                                                    //
@@ -806,6 +3367,9 @@ void  CoMasterDemo::start(void)
    fprintf(stdout, "Using library: %s\n", ComMgrGetVersionString(eCOM_VERSION_STACK));
    fprintf(stdout, "Use CTRL-C to quit this demo.\n");
    fprintf(stdout, "\n");
+   fflush(stdout);
+
+   clLoggerP.start();
 
    //---------------------------------------------------------------------------------------------------
    // The function ComMgrNetTimerEvent() is called every 10 ms inside onTimerEvent(). We tell the 
@@ -815,6 +3379,234 @@ void  CoMasterDemo::start(void)
    ComTmrSetPeriod(TIMER_CYCLE_PERIOD * 1000);
    clTimerP.start(TIMER_CYCLE_PERIOD);
 
+   //---------------------------------------------------------------------------------------------------
+   // The process image is fed directly by the CAN tap, PDO data does not pass the Qt event loop.
+   //
+   if (clProcessImageNameP.isEmpty() == false)
+   {
+      if (clProcessImageP.open(qPrintable(clProcessImageNameP)) == false)
+      {
+         fprintf(stderr, "Failed to create process image %s.\n", qPrintable(clProcessImageNameP));
+      }
+      else
+      {
+         clCanTapP.addListener(&clProcessImageP);
+         fprintf(stdout, "Process image published in %s.\n", qPrintable(clProcessImageNameP));
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The trace recorder stores the frames seen by the CAN tap and the events of the library.
+   //
+   if (clTraceFileP.isEmpty() == false)
+   {
+      if (clTraceP.open(qPrintable(clTraceFileP)) == false)
+      {
+         fprintf(stderr, "Failed to create trace file %s.\n", qPrintable(clTraceFileP));
+      }
+      else
+      {
+         clCanTapP.addListener(&clTraceP);
+         connectTraceEvents();
+         fprintf(stdout, "Recording trace in %s.\n", qPrintable(clTraceFileP));
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The bus planner starts with the plan for the smallest network, the plan grows with the
+   // number of devices which send a boot-up message.
+   //
+   clPlannerP.reset();
+   clPlannerP.setHeartbeatTime(DEVICE_HEARTBEAT_PERIOD);
+   clPlannerP.setBudget(ulBitrateP, ubBusLoadP, ubPdoLoadP);
+   if (clPlannerP.isEnabled())
+   {
+      fprintf(stdout, "Bus load budget %d %%, %d %% reserved for PDOs.\n", ubBusLoadP, ubPdoLoadP);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The supervisor checks the heartbeats and TPDOs seen by the CAN tap against their deadlines.
+   // The heartbeat deadline is 1.5 times the producer time configured by the device scan.
+   //
+   if (btSuperviseP)
+   {
+      clSupervisorP.setLogger(&clLoggerP, ubNetworkP);
+      clSupervisorP.setTickPeriod(TIMER_CYCLE_PERIOD * 1000);
+      clSupervisorP.setHeartbeatTimeout(clPlannerP.heartbeatTime() * 1500);
+      clSupervisorP.setPdoTimeout(ulPdoTimeoutP * 1000);
+      clCanTapP.addListener(&clSupervisorP);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The bus monitor measures the load caused by all frames seen by the CAN tap. A bus load
+   // budget given by --busload is used as limit for the console warning.
+   //
+   if (btBusMonitorP)
+   {
+      clBusMonitorP.setLogger(&clLoggerP, ubNetworkP);
+      clBusMonitorP.setBitrate(ulBitrateP);
+      clBusMonitorP.setLoadLimit(ubBusLoadP);
+      clCanTapP.addListener(&clBusMonitorP);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The collision detector checks the SDO responses and heartbeats seen by the CAN tap.
+   //
+   if (btCollisionP)
+   {
+      clCollisionP.reset();
+      clCanTapP.addListener(&clCollisionP);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // In event-driven mode a raw socket on the same CAN interface wakes up the event loop as soon
+   // as a frame is received. The timer keeps running for the stack timer tick. If the socket can't
+   // be opened the demo falls back to the cyclic processing. The same socket feeds the process
+   // image, the trace recorder, the supervisor, the bus monitor and the collision detector.
+   //
+   if (btEventDrivenP || clProcessImageP.isOpen() || clTraceP.isOpen() || btSuperviseP || btBusMonitorP ||
+       btCollisionP)
+   {
+      if (clCanTapP.open(qPrintable(clInterfaceP)) == false)
+      {
+         fprintf(stderr, "Failed to open %s, using timer only.\n", qPrintable(clInterfaceP));
+         clProcessImageP.close();
+         btSuperviseP  = false;
+         btBusMonitorP = false;
+         btCollisionP  = false;
+      }
+      else if (btStackThreadP == false)
+      {
+         pclCanRxP = new QSocketNotifier(clCanTapP.handle(), QSocketNotifier::Read, this);
+         connect(pclCanRxP, &QSocketNotifier::activated, this, &CoMasterDemo::onCanRxEvent);
+         if (btEventDrivenP)
+         {
+            fprintf(stdout, "Event-driven processing of CAN frames on %s.\n", qPrintable(clInterfaceP));
+         }
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // connect events of CANopen master library to this class or to the event queue of the
+   // stack thread
+   //
+   if (btStackThreadP)
+   {
+      //-------------------------------------------------------------------------------------------
+      // The stack threads of all networks share one lock unless the master library is known
+      // to be re-entrant across networks.
+      //
+      pclStackThreadP = new CoStackThread(ubNetworkP, TIMER_CYCLE_PERIOD * 1000, !btStackLockNetP, this);
+      pclStackThreadP->setCpu(slStackCpuP);
+      pclStackThreadP->setRtPriority(slStackPriorityP);
+      pclStackThreadP->setLatency(&clLatencyP);
+      if (clCanTapP.isOpen())
+      {
+         pclStackThreadP->setCanTap(&clCanTapP, btEventDrivenP);
+      }
+
+      pclStackEventP = new QSocketNotifier(pclStackThreadP->eventHandle(), QSocketNotifier::Read, this);
+      connect(pclStackEventP, &QSocketNotifier::activated, this, &CoMasterDemo::onStackEvent);
+
+      connectStackEvents();
+   }
+   else
+   {
+      connectComEvents();
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // setup the scan scheduler
+   //
+   clScanSchedulerP.reset();
+   clScanSchedulerP.setMaxParallel(ubScanParallelP);
+   clScanSchedulerP.setBusLoadLimit(ubScanBusLoadP, ulBitrateP);
+   clScanSchedulerP.setRetryMax(ubScanRetriesP);
+
+   clNmtBatchP.reset();
+   clNmtBatchP.setGroupSize(ubNmtGroupP);
+
+   clRecoveryP.setBatchSize(ubRecoveryBatchP);
+   clRecoveryP.reset();
+
+   //---------------------------------------------------------------------------------------------------
+   // The identity cache needs the SDO probe for verification of the serial number, without the
+   // probe devices are scanned completely and the cache is only updated. The SDO probe also
+   // writes the planned PDO inhibit times.
+   //
+   if (clIdentityFileP.isEmpty() == false)
+   {
+      if (clIdentityCacheP.open(clIdentityFileP) == false)
+      {
+         fprintf(stderr, "Failed to open identity cache %s.\n", qPrintable(clIdentityFileP));
+      }
+   }
+
+   if (clIdentityCacheP.isOpen() || (clPlannerP.isEnabled() && (ubPdoLoadP > 0)))
+   {
+      if (clSdoProbeP.open(qPrintable(clInterfaceP)) == false)
+      {
+         fprintf(stderr, "Failed to open %s for SDO probe, identity cache and inhibit times are not used.\n",
+                 qPrintable(clInterfaceP));
+      }
+      else
+      {
+         connect(&clSdoProbeP, &CoSdoProbe::uploadFinished,   this, &CoMasterDemo::onSdoProbeFinished);
+         connect(&clSdoProbeP, &CoSdoProbe::uploadFailed,     this, &CoMasterDemo::onSdoProbeFailed);
+         connect(&clSdoProbeP, &CoSdoProbe::downloadFinished, this, &CoMasterDemo::onSdoProbeDownloadFinished);
+         connect(&clSdoProbeP, &CoSdoProbe::downloadFailed,   this, &CoMasterDemo::onSdoProbeDownloadFailed);
+         clSdoProbeP.setLatency(&clSdoLatencyP);
+         if (clIdentityCacheP.isOpen())
+         {
+            fprintf(stdout, "Using identity cache %s.\n", qPrintable(clIdentityFileP));
+         }
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The LSS master uses its own socket, the node-ID of the master is never assigned.
+   //
+   if (ubLssFirstIdP > 0)
+   {
+      if (clLssMasterP.open(qPrintable(clInterfaceP)) == false)
+      {
+         fprintf(stderr, "Failed to open %s for LSS master, unconfigured devices are not commissioned.\n",
+                 qPrintable(clInterfaceP));
+      }
+      else
+      {
+         connect(&clLssMasterP, &CoLssMaster::nodeAssigned,     this, &CoMasterDemo::onLssNodeAssigned);
+         connect(&clLssMasterP, &CoLssMaster::fastscanFinished, this, &CoMasterDemo::onLssFastscanFinished);
+         connect(&clLssMasterP, &CoLssMaster::fastscanFailed,   this, &CoMasterDemo::onLssFastscanFailed);
+         connect(&clLssMasterP, &CoLssMaster::reassignFailed,   this, &CoMasterDemo::onLssReassignFailed);
+         clLssMasterP.setFirstNodeId(ubLssFirstIdP);
+         clLssMasterP.setNodeUsed(ubMasterNodeIdP);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The SYNC producer thread uses its own socket, it is started after the master detection. If
+   // the socket can't be opened the SYNC message is transmitted by the library.
+   //
+   if (btSyncThreadP)
+   {
+      if (clSyncP.open(qPrintable(clInterfaceP)) == false)
+      {
+         fprintf(stderr, "Failed to open %s for SYNC producer, using SYNC of the library.\n",
+                 qPrintable(clInterfaceP));
+         btSyncThreadP = false;
+      }
+      else
+      {
+         clSyncP.setCycle(ulSyncTimeP);
+         clSyncP.setRtPriority(slSyncPriorityP);
+         if ((slSyncPriorityP > 0) && (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0))
+         {
+            fprintf(stderr, "Failed to lock memory of the process.\n");
+         }
+      }
+   }
+
    //---------------------------------------------------------------------------------------------------
    // Initialise the CANopen master stack
    // The bitrate value is a dummy here, since the bitrate is set via the CANpie server configuration 
@@ -849,6 +3641,49 @@ void  CoMasterDemo::start(void)
    // CANopen master is heartbeat producer, use configured time value, 0 is default
    //
    ComNmtSetHbProdTime(ubNetworkP, uwHeartbeatTimeP);
+
+
+   //---------------------------------------------------------------------------------------------------
+   // From here on the stack is processed by the stack thread. With real-time priority all pages
+   // are locked in memory, so the stack thread is not delayed by page faults.
+   //
+   if (pclStackThreadP != nullptr)
+   {
+      if (slStackPriorityP > 0)
+      {
+         if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+         {
+            fprintf(stderr, "Failed to lock memory of the process.\n");
+         }
+      }
+      pclStackThreadP->start();
+      fprintf(stdout, "CANopen stack is running in a separate thread.\n");
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The first network serves the metrics of all networks. A scrape is handled in the Qt event
+   // loop and only reads counters, it never waits for the stack thread.
+   //
+   if ((ubIndexP == 0) && (uwMetricsPortP > 0))
+   {
+      if (clMetricsServerP.open(uwMetricsPortP) == false)
+      {
+         fprintf(stderr, "Failed to open metrics port %d.\n", uwMetricsPortP);
+      }
+      else
+      {
+         connect(&clMetricsServerP, &CoMetricsServer::requested, this, [this](CoMetricsText & clTextR) {
+                    for (uint8_t ubIdxT = 0; ubIdxT < CO_DEMO_NETWORK_MAX; ubIdxT++)
+                    {
+                       if (apclNetworkP[ubIdxT] != nullptr)
+                       {
+                          apclNetworkP[ubIdxT]->writeMetrics(clTextR);
+                       }
+                    }
+                 });
+         fprintf(stdout, "Metrics served on http://127.0.0.1:%d/metrics.\n", uwMetricsPortP);
+      }
+   }
 }
 
 
@@ -858,22 +3693,93 @@ void  CoMasterDemo::start(void)
 //--------------------------------------------------------------------------------------------------------------------//   
 void CoMasterDemo::stop(void)
 {
+   //---------------------------------------------------------------------------------------------------
+   // the first network stops the other networks of the process
+   //
+   for (uint8_t ubIdxT = 1; ubIdxT < CO_DEMO_NETWORK_MAX; ubIdxT++)
+   {
+      if (apclNetworkP[ubIdxT] != nullptr)
+      {
+         disconnect(apclNetworkP[ubIdxT], nullptr, this, nullptr);
+         apclNetworkP[ubIdxT]->stop();
+         apclNetworkP[ubIdxT]->deleteLater();
+         apclNetworkP[ubIdxT] = nullptr;
+      }
+   }
+
    clTimerP.stop();
+   clReplayP.stop();
+   clSyncP.stop();
+   clMetricsServerP.close();
+
+   if (pclStackThreadP != nullptr)
+   {
+      pclStackThreadP->stop();
+      ulStackOverrunCntP = pclStackThreadP->tickOverruns();
+      delete pclStackEventP;
+      pclStackEventP = nullptr;
+      delete pclStackThreadP;
+      pclStackThreadP = nullptr;
+   }
+
+   if (pclCanRxP != nullptr)
+   {
+      pclCanRxP->setEnabled(false);
+      delete pclCanRxP;
+      pclCanRxP = nullptr;
+   }
+   clCanTapP.close();
+   clProcessImageP.close();
+   clTraceP.close();
+
+   clSdoProbeP.close();
+   clLssMasterP.close();
+   clIdentityCacheP.close();
    
    ComMgrRelease(ubNetworkP);
 
+   printLatency();
+   printSupervision();
+   printBusMonitor();
+   printEmcyHistory();
+   clLoggerP.stop();
+
    emit finished();
 }
 
 
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMasterDemo::tickOverruns()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoMasterDemo::tickOverruns(void) const
+{
+   if (pclStackThreadP != nullptr)
+   {
+      return (pclStackThreadP->tickOverruns());
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the count of a stopped stack thread is kept by stop()
+   //
+   if (btStackThreadP)
+   {
+      return (ulStackOverrunCntP);
+   }
+   return (clLatencyP.overruns());
+}
+
+
+#ifndef  CO_DEMO_NO_MAIN
+
 //--------------------------------------------------------------------------------------------------------------------//
 // setup_signal_handler()                                                                                             //
-// setup handler for SIGHUP and SIGTERM                                                                               //
+// setup handler for SIGHUP, SIGINT, SIGTERM and SIGUSR1                                                              //
 //--------------------------------------------------------------------------------------------------------------------//
 static int setup_signal_handler(void)
 {
 
-   struct sigaction tsSigHupT, tsSigIntT, tsSigTermT;
+   struct sigaction tsSigHupT, tsSigIntT, tsSigTermT, tsSigUsr1T;
 
    //---------------------------------------------------------------------------------------------------
    // setup handler for HUP
@@ -893,6 +3799,7 @@ static int setup_signal_handler(void)
    //
    tsSigIntT.sa_handler = CoMasterDemo::signalHandlerInt;
    sigemptyset(&tsSigIntT.sa_mask);
+   tsSigIntT.sa_flags = 0;
    tsSigIntT.sa_flags |= SA_RESTART;
 
    if (sigaction(SIGINT, &tsSigIntT, 0))
@@ -905,6 +3812,7 @@ static int setup_signal_handler(void)
    //
    tsSigTermT.sa_handler = CoMasterDemo::signalHandlerTerm;
    sigemptyset(&tsSigTermT.sa_mask);
+   tsSigTermT.sa_flags = 0;
    tsSigTermT.sa_flags |= SA_RESTART;
 
    if (sigaction(SIGTERM, &tsSigTermT, 0))
@@ -912,6 +3820,21 @@ static int setup_signal_handler(void)
       return 3;
    }
 
+   //---------------------------------------------------------------------------------------------------
+   // setup handler for USR1, prints the latency histograms
+   //
+   tsSigUsr1T.sa_handler = CoMasterDemo::signalHandlerUsr1;
+   sigemptyset(&tsSigUsr1T.sa_mask);
+   tsSigUsr1T.sa_flags = 0;
+   tsSigUsr1T.sa_flags |= SA_RESTART;
+
+   if (sigaction(SIGUSR1, &tsSigUsr1T, 0))
+   {
+      return 4;
+   }
+
    return 0;
 
-}
\ No newline at end of file
+}
+
+#endif
@@ -47,15 +47,50 @@
 #include <QtCore/QObject>
 #include <QtCore/QQueue>
 #include <QtCore/QSocketNotifier>
+#include <QtCore/QStringList>
 #include <QtCore/QTimer>
 
 #include "canopen_master.h"
 
+#include "co_bus_monitor.hpp"
+#include "co_bus_planner.hpp"
+#include "co_can_tap.hpp"
+#include "co_collision_detector.hpp"
+#include "co_emcy_history.hpp"
+#include "co_identity_cache.hpp"
+#include "co_latency.hpp"
+#include "co_logger.hpp"
+#include "co_lss_master.hpp"
+#include "co_metrics_server.hpp"
+#include "co_nmt_batch.hpp"
+#include "co_process_image.hpp"
+#include "co_recovery_scheduler.hpp"
+#include "co_scan_scheduler.hpp"
+#include "co_sdo_probe.hpp"
+#include "co_stack_thread.hpp"
+#include "co_supervisor.hpp"
+#include "co_sync_producer.hpp"
+#include "co_trace_recorder.hpp"
+#include "co_trace_replay.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_DEMO_NETWORK_MAX        ((uint8_t)       2)        // number of CAN interfaces of the controller
+
+
 //-----------------------------------------------------------------------------------------------------------
 /*!
 ** \class   CoMasterDemo
 ** \brief   CANopen Master Demo
 **
+** One object of the class manages one CANopen network: its stack instance, node table, CAN tap
+** and optionally its own stack thread. The first object (index 0) is created by main(), it
+** handles the Unix signals and creates one more object for each further CAN interface given
+** on the command line. All objects share the Qt event loop of the process.
 */
 class CoMasterDemo : public QObject {
 
@@ -63,7 +98,12 @@ class CoMasterDemo : public QObject {
 
 public:
    //--------------------------------------------------------------------------------------------------------
-   CoMasterDemo();
+   /*!
+   ** \param[in]  ubIndexV    - index of the network, 0 for the first network
+   **
+   ** The network number of the CANopen master library is eCOM_NET_1 + \a ubIndexV.
+   */
+   CoMasterDemo(uint8_t ubIndexV = 0);
 
    ~CoMasterDemo();
 
@@ -73,6 +113,16 @@ public:
    static void    signalHandlerHup(int32_t slUnusedV);
    static void    signalHandlerInt(int32_t slUnusedV);
    static void    signalHandlerTerm(int32_t slUnusedV);
+   static void    signalHandlerUsr1(int32_t slUnusedV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  clArgumentsV  - command line, the first entry is the program name
+   **
+   ** The command line is evaluated by runCmdParser() instead of the arguments of the
+   ** application, e.g. if the master runs inside canopen-bench.
+   */
+   void           setArguments(const QStringList & clArgumentsV)    { clArgumentsP = clArgumentsV; }
 
    void           start();
 
@@ -96,12 +146,51 @@ public slots:
    //
    void  onSigTerm(void);
 
+   //----------------------------------------------------------------------------------------------
+   // handler for SIGUSR1, prints the latency histograms, the supervision statistics and the
+   // bus monitor
+   //
+   void  onSigUsr1(void);
+
+   //----------------------------------------------------------------------------------------------
+   // evaluate the command line and start the master, called by canopen-bench for its master
+   //
+   void  runCmdParser(void);
+
 private slots:
 
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** The slot is called by the CAN receive notifier in event-driven mode. It hands received
+   ** frames to the CANopen stack without waiting for the next timer tick.
+   */
+   void           onCanRxEvent(void);
+
    void           onEmcyConsEventReceive(uint8_t ubNetV, uint8_t ubNodeIdV);
 
    void           onLssEventReceive(uint8_t ubNetV, uint8_t ubLssProtocolV);
 
+   void           onLssFastscanFailed(uint8_t ubErrorV, uint8_t ubCountV);
+
+   void           onLssFastscanFinished(uint8_t ubCountV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV       - assigned node-ID
+   ** \param[in]  ulVendorIdV     - vendor ID of the device
+   ** \param[in]  ulProductCodeV  - product code of the device
+   ** \param[in]  ulRevisionV     - revision number of the device
+   ** \param[in]  ulSerialV       - serial number of the device
+   **
+   ** The LSS master has assigned a node-ID to an unconfigured device or has moved a device of
+   ** a quarantined node-ID. The device boots with the new node-ID and is scanned like any other
+   ** device.
+   */
+   void           onLssNodeAssigned(uint8_t ubNodeIdV, uint32_t ulVendorIdV, uint32_t ulProductCodeV,
+                                    uint32_t ulRevisionV, uint32_t ulSerialV);
+
+   void           onLssReassignFailed(uint8_t ubErrorV);
+
    void           onMgrEventBus(uint8_t ubNetV, CpState_ts * ptsBusStateV);
 
    void           onNmtEventActiveMaster( uint8_t ubNetV, uint8_t ubPriorityV, uint8_t ubNodeIdV);
@@ -134,55 +223,386 @@ private slots:
 
    void           onSdoEventTimeout(uint8_t ubNetV, uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV);
 
-   void           onTimerEvent(void);
+   void           onSdoProbeDownloadFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV);
+
+   void           onSdoProbeDownloadFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV);
 
-   void           runCmdParser(void);
+   void           onSdoProbeFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   ** \param[in]  uwIndexV    - Object index
+   ** \param[in]  ubSubIndexV - Object sub-index
+   ** \param[in]  ulValueV    - Object value
+   **
+   ** The slot compares the serial number read from a device with the identity cache or
+   ** continues the PDO configuration of a device.
+   */
+   void           onSdoProbeFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** The slot is called when the stack thread has stored events in its queue. The events are
+   ** dispatched to the event handlers of this class.
+   */
+   void           onStackEvent(void);
+
+   void           onTimerEvent(void);
 
 signals:
    void           finished();
 
 private:
 
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Log the bus plan after it has changed and reconfigure the operational devices.
+   */
+   void           applyPlan(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   **
+   ** Write the planned heartbeat producer time to the device. The write is deferred until the
+   ** heartbeat phase of the device is reached, a refused write is repeated like a write which
+   ** timed out. The caller must hold the stack lock.
+   */
+   void           configureHeartbeat(uint8_t ubNodeIdV);
+
    void           connectComEvents(void);
 
+   void           connectStackEvents(void);
+
+   void           connectTraceEvents(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNetV        - CANopen network
+   ** \param[in]  ubNodeIdV     - Node-ID value
+   ** \param[in]  pubDataV      - EMCY data
+   ** \param[in]  ulSuppressedV - EMCY messages of the device suppressed since the last call
+   **
+   ** The EMCY has already been stored in the EMCY history, the function is only called within
+   ** the notification rate.
+   */
+   void           handleEmcy(uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t * pubDataV, uint32_t ulSuppressedV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   **
+   ** Start the heartbeat consumer for the device and switch it to OPERATIONAL. If the consumer
+   ** can't be set, the configuration is repeated like after a timeout. The caller must hold the
+   ** stack lock.
+   */
+   void           finishNodeConfig(uint8_t ubNodeIdV);
+
+   void           handleScanTimeout(uint8_t ubNetV, uint8_t ubNodeIdV);
+
+   void           printBusMonitor(void);
+
+   void           printEmcyHistory(void);
+
+   void           printLatency(void);
+
+   void           printNodeInfo(uint8_t ubNetV, uint8_t ubNodeIdV, bool btCachedV);
+
+   void           printSupervision(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Quarantine the node-IDs with a detected collision and move one device of a quarantined
+   ** node-ID to a free node-ID by LSS.
+   */
+   void           processCollision(void);
+
+   void           processDeviceScan(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Start the LSS Fastscan when it is due and the scan of the configured devices has finished.
+   */
+   void           processLss(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Start the devices released by the NMT batch. A broadcast NMT command is used if the scan
+   ** has finished and no device has failed, otherwise one NMT command per device.
+   */
+   void           processNmtStart(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   ** \param[in]  btSuccessV  - SDO transfer has been successful
+   ** \param[in]  ulValueV    - uploaded value
+   **
+   ** Evaluate the result of one PDO configuration step and request the next step.
+   */
+   void           processPdoConfig(uint8_t ubNodeIdV, bool btSuccessV, uint32_t ulValueV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Send the NMT resets which are due for devices with lost heartbeat and pass the rebooted
+   ** devices to the scan scheduler, both paced by the recovery scheduler.
+   */
+   void           processRecovery(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   **
+   ** Read the identity of the device with the CANopen master library. A request which is refused,
+   ** e.g. because all SDO clients are busy, is repeated like a request which timed out. The
+   ** caller must hold the stack lock.
+   */
+   void           requestNodeInfo(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV   - Node-ID value
+   ** \return     false if the PDO configuration of the device is finished
+   **
+   ** Request the SDO transfer of the current PDO configuration step. A request which can't be
+   ** sent is repeated like a request which timed out.
+   */
+   bool           requestPdoStep(uint8_t ubNodeIdV);
+
+   void           startReplay(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of timer ticks which took longer than the tick period
+   **
+   ** The overruns are counted by the thread which runs the stack tick: the stack thread if it
+   ** is running, otherwise the timer of the application.
+   */
+   uint32_t       tickOverruns(void) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  clTextR       - metrics of all networks
+   **
+   ** Add the metrics of this network, the function only reads atomic counters and the data of
+   ** the timer handler. It does not take the stack lock.
+   */
+   void           writeMetrics(CoMetricsText & clTextR);
+
+
+   //-----------------------------------------------------------------------------------------
+   // Index of this network. The first network holds the pointers to all networks of the
+   // process, apclNetworkP[0] points to the object itself.
+   //
+   uint8_t           ubIndexP;
+   CoMasterDemo *    apclNetworkP[CO_DEMO_NETWORK_MAX];
 
    uint8_t           ubCanChannelP;
    uint8_t           ubNetworkP;
    uint8_t           ubMasterNodeIdP;
 
+   //-----------------------------------------------------------------------------------------
+   // name of the CAN interface, e.g. can1
+   //
+   QString           clInterfaceP;
+
+   //-----------------------------------------------------------------------------------------
+   // command line set by setArguments(), the arguments of the application are used if the
+   // list is empty
+   //
+   QStringList       clArgumentsP;
+
+   //-----------------------------------------------------------------------------------------
+   // In event-driven mode the CAN tap triggers ComMgrProcess() on frame reception, the
+   // cyclic timer is still used for the stack timer tick.
+   //
+   bool              btEventDrivenP;
+   CoCanTap          clCanTapP;
+   QSocketNotifier * pclCanRxP;
+
+   //-----------------------------------------------------------------------------------------
+   // Optional thread for the CANopen stack, the thread is running if the pointer is not
+   // nullptr. Calls of the CANopen master API must be protected by a CoStackLocker.
+   //
+   bool              btStackThreadP;
+   bool              btStackLockNetP;        // own stack lock for each network
+   int32_t           slStackCpuP;
+   int32_t           slStackPriorityP;
+   CoStackThread *   pclStackThreadP;
+   QSocketNotifier * pclStackEventP;
+   uint32_t          ulStackDropCntP;        // dropped events already reported
+   uint32_t          ulStackOverrunCntP;     // tick overruns of the stack thread already reported
+
    //-----------------------------------------------------------------------------------------
    // heartbeat producer time for CANopen Master
    //
    uint16_t          uwHeartbeatTimeP;
 
    //-----------------------------------------------------------------------------------------
-   // SYNC producer time for CANopen Master
+   // SYNC producer time for CANopen Master in micro-seconds. If btSyncThreadP is true the
+   // SYNC message is transmitted by clSyncP instead of the library.
    //
    uint32_t          ulSyncTimeP;
+   bool              btSyncThreadP;
+   int32_t           slSyncPriorityP;
+   CoSyncProducer    clSyncP;
+
+   //-----------------------------------------------------------------------------------------
+   // bitrate of the CAN interface in bit/s, the value is used for bus load calculations
+   //
+   uint32_t          ulBitrateP;
+
+   //-----------------------------------------------------------------------------------------
+   // The bus planner calculates the heartbeat producer time and the PDO inhibit time of the
+   // devices from the bus load budget (ubBusLoadP) and the share reserved for PDOs
+   // (ubPdoLoadP). Both values are given in percent, 0 disables the planning. The inhibit
+   // time is written by the SDO probe, atsPdoConfigP holds the progress for each device.
+   //
+   uint8_t           ubBusLoadP;
+   uint8_t           ubPdoLoadP;
+   CoBusPlanner      clPlannerP;
+
+   struct PdoConfig_s {
+      uint8_t     ubPdo;                                     // TPDO number 0 .. 3
+      uint8_t     ubStep;                                    // configuration step
+      bool        btEnable;                                  // PDO has to be enabled again
+      uint8_t     ubRetryCnt;                                // rejected writes of the enable step
+      uint32_t    ulCobId;                                   // COB-ID read from the device
+   };
+   PdoConfig_s       atsPdoConfigP[CO_SCAN_NODE_MAX];
+
+   //-----------------------------------------------------------------------------------------
+   // The scan scheduler stores the node-IDs of devices which send a boot-up message. The
+   // scheduler is checked inside the onTimerEvent() handler, up to ubScanParallelP devices
+   // are scanned at the same time. Devices which don't respond are retried ubScanRetriesP
+   // times before they are parked.
+   //
+   CoScanScheduler   clScanSchedulerP;
+   uint8_t           ubScanParallelP;
+   uint8_t           ubScanBusLoadP;
+   uint8_t           ubScanRetriesP;
+
+   //-----------------------------------------------------------------------------------------
+   // Configured devices wait in the NMT batch for a common start, ubNmtGroupP is the group
+   // size (CO_NMT_BATCH_ALL for one group after the scan), 0 starts each device at once.
+   //
+   uint8_t           ubNmtGroupP;
+   CoNmtBatch        clNmtBatchP;
+
+   //-----------------------------------------------------------------------------------------
+   // Devices with lost heartbeat are reset and scanned again in batches of ubRecoveryBatchP
+   // devices per second, 0 resets each device at once.
+   //
+   uint8_t              ubRecoveryBatchP;
+   CoRecoveryScheduler  clRecoveryP;
+
+   //-----------------------------------------------------------------------------------------
+   // The LSS master assigns node-IDs from ubLssFirstIdP upward to unconfigured devices, 0
+   // disables it. uqLssDueP is the scan scheduler time of the next Fastscan, 0 if none is due.
+   //
+   uint8_t           ubLssFirstIdP;
+   uint64_t          uqLssDueP;
+   CoLssMaster       clLssMasterP;
+
+   //-----------------------------------------------------------------------------------------
+   // Node-ID collisions are detected from the frames of the CAN tap and from the identity
+   // reads of the scan. A quarantined node-ID is neither scanned nor started. With the LSS
+   // master one device is moved to a free node-ID, ubReassignNodeP is its old node-ID while
+   // the LSS master is busy.
+   //
+   bool                 btCollisionP;
+   uint8_t              ubReassignNodeP;
+   CoCollisionDetector  clCollisionP;
+
+   //-----------------------------------------------------------------------------------------
+   // The identity cache stores the identity data of scanned devices. After boot-up of a
+   // cached device only the serial number is read by the SDO probe.
+   //
+   QString           clIdentityFileP;
+   CoIdentityCache   clIdentityCacheP;
+   CoSdoProbe        clSdoProbeP;
 
    //-----------------------------------------------------------------------------------------
-   // The device FIFO is used to store the node-IDs of devices which send a boot-up
-   // message. The FIFO is checked inside the onTimerEvent() handler and the scanDevice()
-   // method is called.
+   // PDO process image in shared memory, fed by the CAN tap
    //
-   QQueue<uint8_t>   clDeviceFifoP;
+   QString           clProcessImageNameP;
+   CoProcessImage    clProcessImageP;
 
-   bool              btSdoActiveP;
+   //-----------------------------------------------------------------------------------------
+   // Deadline supervision of heartbeats and TPDOs, fed by the CAN tap and checked inside the
+   // onTimerEvent() handler. The PDO deadline is given in milli-seconds, 0 if PDOs are not
+   // supervised.
+   //
+   bool              btSuperviseP;
+   uint32_t          ulPdoTimeoutP;
+   CoSupervisor      clSupervisorP;
+
+   //-----------------------------------------------------------------------------------------
+   // Bus load, frame counts and error counters, fed by the CAN tap and by the bus events of
+   // the CANopen master library
+   //
+   bool              btBusMonitorP;
+   CoBusMonitor      clBusMonitorP;
+
+   //-----------------------------------------------------------------------------------------
+   // EMCY history of the devices, written by the EMCY callback of the library while the stack
+   // lock is held. Repeated errors are coalesced, the event handlers are called at most
+   // ulEmcyRateP times per second and device.
+   //
+   uint32_t          ulEmcyRateP;
+   CoEmcyHistory     clEmcyHistoryP;
+
+   //-----------------------------------------------------------------------------------------
+   // Console output of the event handlers is written by the logger thread, a slow console
+   // must not delay the CANopen stack.
+   //
+   CoLogger          clLoggerP;
+
+   //-----------------------------------------------------------------------------------------
+   // Latency histograms of the stack functions and event handlers, printed on SIGUSR1 and
+   // when the demo stops
+   //
+   CoLatency         clLatencyP;
+
+   //-----------------------------------------------------------------------------------------
+   // Counters of the devices and the SDO round-trip time of the SDO probe. The first network
+   // serves the metrics of all networks on 127.0.0.1:uwMetricsPortP, 0 if disabled.
+   //
+   CoMetrics            clMetricsP;
+   CoLatencyHistogram   clSdoLatencyP;
+   uint16_t             uwMetricsPortP;
+   CoMetricsServer      clMetricsServerP;
+
+   //-----------------------------------------------------------------------------------------
+   // Binary trace of CAN frames and library events for post-mortem analysis
+   //
+   QString           clTraceFileP;
+   CoTraceRecorder   clTraceP;
+
+   //-----------------------------------------------------------------------------------------
+   // replay of a recorded trace, started after the master detection
+   //
+   QString           clReplayFileP;
+   double            flReplaySpeedP;
+   CoTraceReplay     clReplayP;
 
    ComNode_ts        atsComNodeP[127];
 
    QTimer            clTimerP;         // cyclic event timer
       
    //----------------------------------------------------------------------------------------------
-   // file descriptor and notifier for SIGHUP, SIGINT and SIGTERM
+   // file descriptor and notifier for SIGHUP, SIGINT, SIGTERM and SIGUSR1
    //
    static int32_t    aslSigHupFdP[2];
    static int32_t    aslSigIntFdP[2];
    static int32_t    aslSigTermFdP[2];
+   static int32_t    aslSigUsr1FdP[2];
 
    QSocketNotifier * pclSigHupP;
    QSocketNotifier * pclSigIntP;
    QSocketNotifier * pclSigTermP;
+   QSocketNotifier * pclSigUsr1P;
 };
 
 
@@ -0,0 +1,390 @@
+//====================================================================================================================//
+// File:          co_metrics.cpp                                                                                      //
+// Description:   Metrics of a CANopen network in Prometheus text format                                              //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_metrics.hpp"
+
+#include <string.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  NANO_SECONDS               ((double) 1.0e9)           // nano-seconds per second
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::CoMetrics()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoMetrics::CoMetrics()
+{
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::countEmcy()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::countEmcy(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].ulEmcyCount.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::countHeartbeatLost()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::countHeartbeatLost(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].ulHeartbeatLostCount.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::countScanFailure()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::countScanFailure(uint8_t ubNodeIdV)
+{
+   ulScanFailCntP.fetch_add(1, std::memory_order_relaxed);
+
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].uqScanStart.store(0, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::countSdoTimeout()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::countSdoTimeout(uint8_t ubNodeIdV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].ulSdoTimeoutCount.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::emcyCount()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoMetrics::emcyCount(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_METRICS_NODE_MAX))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ulEmcyCount.load(std::memory_order_relaxed));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::heartbeatLostCount()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoMetrics::heartbeatLostCount(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_METRICS_NODE_MAX))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ulHeartbeatLostCount.load(std::memory_order_relaxed));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::isKnown()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoMetrics::isKnown(uint8_t ubNodeIdV) const
+{
+   return ((nodeState(ubNodeIdV) != CO_METRICS_STATE_UNKNOWN) || (emcyCount(ubNodeIdV) > 0) ||
+           (heartbeatLostCount(ubNodeIdV) > 0) || (sdoTimeoutCount(ubNodeIdV) > 0));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::nodeState()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoMetrics::nodeState(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_METRICS_NODE_MAX))
+   {
+      return (CO_METRICS_STATE_UNKNOWN);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ubState.load(std::memory_order_relaxed));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::reset()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::reset(void)
+{
+   ulScanFailCntP.store(0);
+   clScanDurationP.reset();
+
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_METRICS_NODE_MAX; ubIdxT++)
+   {
+      atsNodeP[ubIdxT].ubState.store(CO_METRICS_STATE_UNKNOWN);
+      atsNodeP[ubIdxT].ulEmcyCount.store(0);
+      atsNodeP[ubIdxT].ulHeartbeatLostCount.store(0);
+      atsNodeP[ubIdxT].ulSdoTimeoutCount.store(0);
+      atsNodeP[ubIdxT].uqScanStart.store(0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::scanFinished()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::scanFinished(uint8_t ubNodeIdV, uint64_t uqTimeV)
+{
+   uint64_t uqStartT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_METRICS_NODE_MAX))
+   {
+      return;
+   }
+
+   uqStartT = atsNodeP[ubNodeIdV - 1].uqScanStart.exchange(0, std::memory_order_relaxed);
+   if ((uqStartT != 0) && (uqTimeV > uqStartT))
+   {
+      clScanDurationP.record(uqTimeV - uqStartT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::scanStarted()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::scanStarted(uint8_t ubNodeIdV, uint64_t uqTimeV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].uqScanStart.store(uqTimeV, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::sdoTimeoutCount()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoMetrics::sdoTimeoutCount(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_METRICS_NODE_MAX))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ulSdoTimeoutCount.load(std::memory_order_relaxed));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetrics::setNodeState()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetrics::setNodeState(uint8_t ubNodeIdV, uint8_t ubStateV)
+{
+   if ((ubNodeIdV > 0) && (ubNodeIdV <= CO_METRICS_NODE_MAX))
+   {
+      atsNodeP[ubNodeIdV - 1].ubState.store(ubStateV, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::CoMetricsText()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoMetricsText::CoMetricsText()
+{
+   clFamilyP.reserve(32);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::addCounter()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsText::addCounter(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                               uint64_t uqValueV)
+{
+   addSample(family(szNameV, szHelpV, "counter"), "", clLabelsR, QByteArray::number((qulonglong) uqValueV));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::addGauge()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsText::addGauge(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                             double flValueV)
+{
+   addSample(family(szNameV, szHelpV, "gauge"), "", clLabelsR, QByteArray::number(flValueV, 'g', 9));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::addSample()                                                                                         //
+// append one sample line                                                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsText::addSample(Family_s & tsFamilyR, const char * szSuffixV, const QByteArray & clLabelsR,
+                              const QByteArray & clValueR)
+{
+   tsFamilyR.clSamples.append(tsFamilyR.szName);
+   tsFamilyR.clSamples.append(szSuffixV);
+   if (clLabelsR.isEmpty() == false)
+   {
+      tsFamilyR.clSamples.append('{');
+      tsFamilyR.clSamples.append(clLabelsR);
+      tsFamilyR.clSamples.append('}');
+   }
+   tsFamilyR.clSamples.append(' ');
+   tsFamilyR.clSamples.append(clValueR);
+   tsFamilyR.clSamples.append('\n');
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::addSummary()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsText::addSummary(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                               const CoLatencyHistogram & clHistogramR)
+{
+   static const uint32_t   aulPerMilleS[]  = { 500, 990, 999 };
+   static const char *     aszQuantileS[]  = { "0.5", "0.99", "0.999" };
+
+   QByteArray  clLabelsT;
+   Family_s &  tsFamilyR = family(szNameV, szHelpV, "summary");
+   uint64_t    uqCountT  = clHistogramR.count();
+
+   //---------------------------------------------------------------------------------------------------
+   // The quantiles are calculated from the histogram buckets, a value has a relative error below
+   // 6.25 %. The histogram is updated while it is read, count and sum may differ by a few values.
+   //
+   for (uint32_t ulIdxT = 0; ulIdxT < 3; ulIdxT++)
+   {
+      clLabelsT = clLabelsR;
+      if (clLabelsT.isEmpty() == false)
+      {
+         clLabelsT.append(',');
+      }
+      clLabelsT.append("quantile=\"");
+      clLabelsT.append(aszQuantileS[ulIdxT]);
+      clLabelsT.append('"');
+
+      addSample(tsFamilyR, "", clLabelsT, (uqCountT == 0) ? QByteArray("NaN") :
+                QByteArray::number((double) clHistogramR.percentile(aulPerMilleS[ulIdxT]) / NANO_SECONDS, 'g', 9));
+   }
+
+   addSample(tsFamilyR, "_sum",   clLabelsR, QByteArray::number((double) clHistogramR.sum() / NANO_SECONDS, 'g', 9));
+   addSample(tsFamilyR, "_count", clLabelsR, QByteArray::number((qulonglong) uqCountT));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::family()                                                                                            //
+// find a metric by its name, a new metric is appended                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+CoMetricsText::Family_s & CoMetricsText::family(const char * szNameV, const char * szHelpV, const char * szTypeV)
+{
+   Family_s tsFamilyT;
+
+   for (int32_t slIdxT = 0; slIdxT < clFamilyP.size(); slIdxT++)
+   {
+      if (strcmp(clFamilyP[slIdxT].szName, szNameV) == 0)
+      {
+         return (clFamilyP[slIdxT]);
+      }
+   }
+
+   tsFamilyT.szName = szNameV;
+   tsFamilyT.clHeader.append("# HELP ");
+   tsFamilyT.clHeader.append(szNameV);
+   tsFamilyT.clHeader.append(' ');
+   tsFamilyT.clHeader.append(szHelpV);
+   tsFamilyT.clHeader.append("\n# TYPE ");
+   tsFamilyT.clHeader.append(szNameV);
+   tsFamilyT.clHeader.append(' ');
+   tsFamilyT.clHeader.append(szTypeV);
+   tsFamilyT.clHeader.append('\n');
+   clFamilyP.append(tsFamilyT);
+
+   return (clFamilyP.last());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsText::text()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+QByteArray CoMetricsText::text(void) const
+{
+   QByteArray clTextT;
+
+   for (int32_t slIdxT = 0; slIdxT < clFamilyP.size(); slIdxT++)
+   {
+      clTextT.append(clFamilyP[slIdxT].clHeader);
+      clTextT.append(clFamilyP[slIdxT].clSamples);
+   }
+
+   return (clTextT);
+}
@@ -0,0 +1,230 @@
+//====================================================================================================================//
+// File:          co_metrics.hpp                                                                                      //
+// Description:   Metrics of a CANopen network in Prometheus text format                                              //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_metrics.hpp
+** \brief   Metrics of a CANopen network
+**
+** CoMetrics holds the counters of one CANopen network which are not kept by other modules:
+** NMT state, emergency messages, lost heartbeats and SDO timeouts of each device, the scan
+** duration and the number of failed scans. All values are atomic, so they can be read while the
+** event handlers update them.
+**
+** CoMetricsText collects the samples of all networks and writes them in the text exposition
+** format of Prometheus, the samples of one metric are grouped even if they are added by
+** different networks.
+*/
+#ifndef CO_METRICS_HPP_
+#define CO_METRICS_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "co_latency.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_METRICS_NODE_MAX        ((uint8_t)     127)        // highest node-ID
+#define  CO_METRICS_STATE_UNKNOWN   ((uint8_t)     255)        // no NMT state received from the device
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoMetrics
+** \brief   Counters of one CANopen network
+**
+** The functions can be called from any thread.
+*/
+class CoMetrics {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoMetrics();
+
+   void           countEmcy(uint8_t ubNodeIdV);
+
+   void           countHeartbeatLost(uint8_t ubNodeIdV);
+
+   void           countSdoTimeout(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The scan of the device has been given up, a running scan time measurement is dropped.
+   */
+   void           countScanFailure(uint8_t ubNodeIdV);
+
+   uint32_t       emcyCount(uint8_t ubNodeIdV) const;
+
+   uint32_t       heartbeatLostCount(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     true if the device has reported an NMT state or has been counted
+   */
+   bool           isKnown(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     NMT state of the device, CO_METRICS_STATE_UNKNOWN if no state has been reported
+   */
+   uint8_t        nodeState(uint8_t ubNodeIdV) const;
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     duration of the device scans from boot-up to operational state
+   */
+   const CoLatencyHistogram & scanDuration(void) const   { return (clScanDurationP); }
+
+   uint32_t       scanFailures(void) const      { return (ulScanFailCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** The device has finished its configuration, the time since scanStarted() is recorded. The
+   ** function does nothing if no scan of the device is running.
+   */
+   void           scanFinished(uint8_t ubNodeIdV, uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** The device has sent a boot-up message, the scan time measurement starts.
+   */
+   void           scanStarted(uint8_t ubNodeIdV, uint64_t uqTimeV);
+
+   uint32_t       sdoTimeoutCount(uint8_t ubNodeIdV) const;
+
+   void           setNodeState(uint8_t ubNodeIdV, uint8_t ubStateV);
+
+private:
+
+   struct Node_s {
+      std::atomic<uint8_t>    ubState;
+      std::atomic<uint32_t>   ulEmcyCount;
+      std::atomic<uint32_t>   ulHeartbeatLostCount;
+      std::atomic<uint32_t>   ulSdoTimeoutCount;
+      std::atomic<uint64_t>   uqScanStart;      // boot-up time, 0 if no scan is running
+   };
+
+   std::atomic<uint32_t>   ulScanFailCntP;
+   CoLatencyHistogram      clScanDurationP;
+
+   Node_s                  atsNodeP[CO_METRICS_NODE_MAX];
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoMetricsText
+** \brief   Prometheus text exposition format
+**
+** Label sets are passed as text without braces, e.g. \c interface="can1",node="5".
+*/
+class CoMetricsText {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoMetricsText();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szNameV       - metric name
+   ** \param[in]  szHelpV       - help text, written once for the metric
+   ** \param[in]  clLabelsR     - label set of the sample
+   ** \param[in]  uqValueV      - value of the sample
+   */
+   void           addCounter(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                             uint64_t uqValueV);
+
+   void           addGauge(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                           double flValueV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szNameV       - metric name, the unit is seconds
+   ** \param[in]  szHelpV       - help text, written once for the metric
+   ** \param[in]  clLabelsR     - label set of the sample
+   ** \param[in]  clHistogramR  - histogram with values in nano-seconds
+   **
+   ** The histogram is written as summary with the quantiles 0.5, 0.99 and 0.999.
+   */
+   void           addSummary(const char * szNameV, const char * szHelpV, const QByteArray & clLabelsR,
+                             const CoLatencyHistogram & clHistogramR);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     all metrics in text exposition format
+   */
+   QByteArray     text(void) const;
+
+private:
+
+   struct Family_s {
+      const char *   szName;
+      QByteArray     clHeader;       // HELP and TYPE line
+      QByteArray     clSamples;
+   };
+
+   Family_s &     family(const char * szNameV, const char * szHelpV, const char * szTypeV);
+
+   void           addSample(Family_s & tsFamilyR, const char * szSuffixV, const QByteArray & clLabelsR,
+                            const QByteArray & clValueR);
+
+   QVector<Family_s>    clFamilyP;
+};
+
+
+#endif /*CO_METRICS_HPP_*/
@@ -0,0 +1,356 @@
+//====================================================================================================================//
+// File:          co_metrics_server.cpp                                                                               //
+// Description:   HTTP endpoint for metrics on the loopback interface                                                 //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CONTENT_TYPE_METRICS       "text/plain; version=0.0.4; charset=utf-8"
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::CoMetricsServer()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoMetricsServer::CoMetricsServer(QObject * pclParentV)
+   : QObject(pclParentV)
+{
+   slSocketP    = -1;
+   pclNotifierP = nullptr;
+   uqSerialP    = 0;
+
+   for (uint32_t ulClientT = 0; ulClientT < CO_METRICS_CLIENT_MAX; ulClientT++)
+   {
+      atsClientP[ulClientT].slSocket = -1;
+      atsClientP[ulClientT].uqSerial = 0;
+      atsClientP[ulClientT].pclRead  = nullptr;
+      atsClientP[ulClientT].pclWrite = nullptr;
+      atsClientP[ulClientT].slSent   = 0;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::~CoMetricsServer()                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoMetricsServer::~CoMetricsServer()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::close()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::close(void)
+{
+   for (uint32_t ulClientT = 0; ulClientT < CO_METRICS_CLIENT_MAX; ulClientT++)
+   {
+      closeClient(ulClientT);
+   }
+
+   if (pclNotifierP != nullptr)
+   {
+      pclNotifierP->setEnabled(false);
+      delete pclNotifierP;
+      pclNotifierP = nullptr;
+   }
+
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::closeClient()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::closeClient(uint32_t ulClientV)
+{
+   Client_s & tsClientR = atsClientP[ulClientV];
+
+   //---------------------------------------------------------------------------------------------------
+   // the function may be called by a slot of the notifier, so the notifier is deleted later
+   //
+   if (tsClientR.pclRead != nullptr)
+   {
+      tsClientR.pclRead->setEnabled(false);
+      tsClientR.pclRead->deleteLater();
+      tsClientR.pclRead = nullptr;
+   }
+
+   if (tsClientR.pclWrite != nullptr)
+   {
+      tsClientR.pclWrite->setEnabled(false);
+      tsClientR.pclWrite->deleteLater();
+      tsClientR.pclWrite = nullptr;
+   }
+
+   if (tsClientR.slSocket >= 0)
+   {
+      ::close(tsClientR.slSocket);
+      tsClientR.slSocket = -1;
+   }
+
+   tsClientR.clRequest.clear();
+   tsClientR.clResponse.clear();
+   tsClientR.slSent = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::onAcceptEvent()                                                                                   //
+// accept a new connection                                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::onAcceptEvent(void)
+{
+   int32_t  slSocketT;
+   uint32_t ulClientT;
+
+   while ((slSocketT = ::accept4(slSocketP, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+   {
+      //-------------------------------------------------------------------------------------------
+      // use a free connection or the oldest one
+      //
+      ulClientT = 0;
+      for (uint32_t ulIdxT = 0; ulIdxT < CO_METRICS_CLIENT_MAX; ulIdxT++)
+      {
+         if (atsClientP[ulIdxT].slSocket < 0)
+         {
+            ulClientT = ulIdxT;
+            break;
+         }
+         if (atsClientP[ulIdxT].uqSerial < atsClientP[ulClientT].uqSerial)
+         {
+            ulClientT = ulIdxT;
+         }
+      }
+      closeClient(ulClientT);
+
+      Client_s & tsClientR = atsClientP[ulClientT];
+
+      uqSerialP++;
+      tsClientR.slSocket = slSocketT;
+      tsClientR.uqSerial = uqSerialP;
+      tsClientR.pclRead  = new QSocketNotifier(slSocketT, QSocketNotifier::Read, this);
+      connect(tsClientR.pclRead, &QSocketNotifier::activated, this,
+              [this, ulClientT]() { onClientRead(ulClientT); });
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::onClientRead()                                                                                    //
+// read the request header                                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::onClientRead(uint32_t ulClientV)
+{
+   char           aszBufferT[1024];
+   ssize_t        tvSizeT;
+   int32_t        slLineEndT;
+   QByteArray     clLineT;
+   CoMetricsText  clTextT;
+
+   Client_s & tsClientR = atsClientP[ulClientV];
+
+   while ((tvSizeT = ::read(tsClientR.slSocket, aszBufferT, sizeof(aszBufferT))) > 0)
+   {
+      tsClientR.clRequest.append(aszBufferT, (int) tvSizeT);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the client has closed the connection or an error occurred
+   //
+   if ((tvSizeT == 0) || ((tvSizeT < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)))
+   {
+      closeClient(ulClientV);
+      return;
+   }
+
+   if (tsClientR.clRequest.size() > CO_METRICS_REQUEST_MAX)
+   {
+      respond(ulClientV, "431 Request Header Fields Too Large", QByteArray());
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // wait for the complete header, the request line is the first line
+   //
+   if (tsClientR.clRequest.indexOf("\r\n\r\n") < 0)
+   {
+      return;
+   }
+
+   slLineEndT = tsClientR.clRequest.indexOf("\r\n");
+   clLineT    = tsClientR.clRequest.left(slLineEndT);
+
+   if (clLineT.startsWith("GET ") == false)
+   {
+      respond(ulClientV, "405 Method Not Allowed", QByteArray());
+   }
+   else if (clLineT.startsWith("GET / ") || clLineT.startsWith("GET /metrics ") ||
+            clLineT.startsWith("GET /metrics?"))
+   {
+      emit requested(clTextT);
+      respond(ulClientV, "200 OK", clTextT.text());
+   }
+   else
+   {
+      respond(ulClientV, "404 Not Found", QByteArray());
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::onClientWrite()                                                                                   //
+// send the response, the connection is closed afterwards                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::onClientWrite(uint32_t ulClientV)
+{
+   ssize_t tvSizeT;
+
+   Client_s & tsClientR = atsClientP[ulClientV];
+
+   while (tsClientR.slSent < tsClientR.clResponse.size())
+   {
+      tvSizeT = ::send(tsClientR.slSocket, tsClientR.clResponse.constData() + tsClientR.slSent,
+                       (size_t) (tsClientR.clResponse.size() - tsClientR.slSent), MSG_NOSIGNAL);
+      if (tvSizeT > 0)
+      {
+         tsClientR.slSent += (int32_t) tvSizeT;
+      }
+      else if ((tvSizeT < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+      {
+         //-----------------------------------------------------------------------------------
+         // the socket buffer is full, continue when the socket is writable again
+         //
+         if (tsClientR.pclWrite == nullptr)
+         {
+            tsClientR.pclWrite = new QSocketNotifier(tsClientR.slSocket, QSocketNotifier::Write, this);
+            connect(tsClientR.pclWrite, &QSocketNotifier::activated, this,
+                    [this, ulClientV]() { onClientWrite(ulClientV); });
+         }
+         return;
+      }
+      else
+      {
+         break;
+      }
+   }
+
+   closeClient(ulClientV);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::open()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoMetricsServer::open(uint16_t uwPortV)
+{
+   struct sockaddr_in   tsAddrT;
+   int32_t              slReuseT = 1;
+
+   close();
+
+   slSocketP = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   setsockopt(slSocketP, SOL_SOCKET, SO_REUSEADDR, &slReuseT, sizeof(slReuseT));
+
+   //---------------------------------------------------------------------------------------------------
+   // the metrics are only served on the loopback interface
+   //
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.sin_family      = AF_INET;
+   tsAddrT.sin_port        = htons(uwPortV);
+   tsAddrT.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   if ((::bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0) || (::listen(slSocketP, 8) < 0))
+   {
+      close();
+      return (false);
+   }
+
+   pclNotifierP = new QSocketNotifier(slSocketP, QSocketNotifier::Read, this);
+   connect(pclNotifierP, &QSocketNotifier::activated, this, &CoMetricsServer::onAcceptEvent);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoMetricsServer::respond()                                                                                         //
+// start the transmission of the response                                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoMetricsServer::respond(uint32_t ulClientV, const char * szStatusV, const QByteArray & clBodyR)
+{
+   Client_s & tsClientR = atsClientP[ulClientV];
+
+   //---------------------------------------------------------------------------------------------------
+   // further data of the client is not read, the connection is closed after the response
+   //
+   tsClientR.pclRead->setEnabled(false);
+
+   tsClientR.clResponse.clear();
+   tsClientR.clResponse.append("HTTP/1.1 ");
+   tsClientR.clResponse.append(szStatusV);
+   tsClientR.clResponse.append("\r\nContent-Type: " CONTENT_TYPE_METRICS "\r\nContent-Length: ");
+   tsClientR.clResponse.append(QByteArray::number(clBodyR.size()));
+   tsClientR.clResponse.append("\r\nConnection: close\r\n\r\n");
+   tsClientR.clResponse.append(clBodyR);
+   tsClientR.slSent = 0;
+
+   onClientWrite(ulClientV);
+}
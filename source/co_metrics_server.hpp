@@ -0,0 +1,140 @@
+//====================================================================================================================//
+// File:          co_metrics_server.hpp                                                                               //
+// Description:   HTTP endpoint for metrics on the loopback interface                                                 //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_metrics_server.hpp
+** \brief   HTTP endpoint for metrics
+**
+** The server listens on a TCP port of the loopback interface and answers each HTTP GET request
+** of the path / or /metrics with the metrics in Prometheus text format. It runs in the Qt event
+** loop with non-blocking sockets; the metrics are read from atomic counters and statistics of
+** the application thread, a scrape never waits for the stack thread.
+*/
+#ifndef CO_METRICS_SERVER_HPP_
+#define CO_METRICS_SERVER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+
+#include <stdint.h>
+
+#include "co_metrics.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_METRICS_CLIENT_MAX      ((uint32_t)      4)        // number of concurrent connections
+#define  CO_METRICS_REQUEST_MAX     ((int32_t)    4096)        // maximum size of a request header
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoMetricsServer
+** \brief   HTTP endpoint for metrics
+**
+** Each connection handles one request and is closed after the response. If all connections
+** are in use, the oldest one is closed for a new client.
+*/
+class CoMetricsServer : public QObject {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoMetricsServer(QObject * pclParentV = nullptr);
+
+   ~CoMetricsServer();
+
+   void           close(void);
+
+   bool           isOpen(void) const   { return (slSocketP >= 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uwPortV       - TCP port on 127.0.0.1
+   ** \return     true if the server is listening
+   */
+   bool           open(uint16_t uwPortV);
+
+signals:
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[out] clTextR       - metrics of the application
+   **
+   ** The signal is emitted for each request, the receiver adds its metrics to \a clTextR. The
+   ** receiver must live in the thread of the server.
+   */
+   void           requested(CoMetricsText & clTextR);
+
+private slots:
+
+   void           onAcceptEvent(void);
+
+private:
+
+   struct Client_s {
+      int32_t           slSocket;
+      uint64_t          uqSerial;         // number of the connection, the oldest has the lowest
+      QSocketNotifier * pclRead;
+      QSocketNotifier * pclWrite;
+      QByteArray        clRequest;
+      QByteArray        clResponse;
+      int32_t           slSent;           // number of bytes of clResponse sent
+   };
+
+   void           closeClient(uint32_t ulClientV);
+
+   void           onClientRead(uint32_t ulClientV);
+
+   void           onClientWrite(uint32_t ulClientV);
+
+   void           respond(uint32_t ulClientV, const char * szStatusV, const QByteArray & clBodyR);
+
+   int32_t           slSocketP;
+   QSocketNotifier * pclNotifierP;
+   uint64_t          uqSerialP;
+
+   Client_s          atsClientP[CO_METRICS_CLIENT_MAX];
+};
+
+
+#endif /*CO_METRICS_SERVER_HPP_*/
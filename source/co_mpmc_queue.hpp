@@ -0,0 +1,171 @@
+//====================================================================================================================//
+// File:          co_mpmc_queue.hpp                                                                                   //
+// Description:   Bounded lock-free queue for multiple producers and consumers                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_mpmc_queue.hpp
+** \brief   Lock-free multiple producer / multiple consumer queue
+**
+*/
+#ifndef CO_MPMC_QUEUE_HPP_
+#define CO_MPMC_QUEUE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoMpmcQueue
+** \brief   Bounded lock-free queue for multiple producers and consumers
+**
+** The queue holds up to \c SIZE elements, \c SIZE must be a power of two. Each cell carries a
+** sequence number which tells producers and consumers whether the cell is free or occupied
+** (D. Vyukov, bounded MPMC queue). Producers and consumers only compete for the tail and
+** head index respectively, no thread ever waits for another one. Elements are copied, the
+** queue never allocates memory after construction.
+*/
+template <typename T, uint32_t SIZE>
+class CoMpmcQueue {
+
+   static_assert((SIZE >= 2) && ((SIZE & (SIZE - 1)) == 0), "SIZE must be a power of two");
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoMpmcQueue() : ulHeadP(0), ulTailP(0)
+   {
+      for (uint32_t ulCellT = 0; ulCellT < SIZE; ulCellT++)
+      {
+         atsCellP[ulCellT].ulSequence.store(ulCellT, std::memory_order_relaxed);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsElementR  - element to store
+   ** \return     false if the queue is full
+   */
+   bool push(const T & tsElementR)
+   {
+      Cell_s * ptsCellT;
+      uint32_t ulTailT = ulTailP.load(std::memory_order_relaxed);
+      int32_t  slDiffT;
+
+      for (;;)
+      {
+         ptsCellT = &atsCellP[ulTailT & (SIZE - 1)];
+         slDiffT  = (int32_t) (ptsCellT->ulSequence.load(std::memory_order_acquire) - ulTailT);
+         if (slDiffT == 0)
+         {
+            if (ulTailP.compare_exchange_weak(ulTailT, ulTailT + 1, std::memory_order_relaxed))
+            {
+               break;
+            }
+         }
+         else if (slDiffT < 0)
+         {
+            return (false);
+         }
+         else
+         {
+            ulTailT = ulTailP.load(std::memory_order_relaxed);
+         }
+      }
+
+      ptsCellT->tsElement = tsElementR;
+      ptsCellT->ulSequence.store(ulTailT + 1, std::memory_order_release);
+      return (true);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[out] tsElementR  - element read from the queue
+   ** \return     false if the queue is empty
+   */
+   bool pop(T & tsElementR)
+   {
+      Cell_s * ptsCellT;
+      uint32_t ulHeadT = ulHeadP.load(std::memory_order_relaxed);
+      int32_t  slDiffT;
+
+      for (;;)
+      {
+         ptsCellT = &atsCellP[ulHeadT & (SIZE - 1)];
+         slDiffT  = (int32_t) (ptsCellT->ulSequence.load(std::memory_order_acquire) - (ulHeadT + 1));
+         if (slDiffT == 0)
+         {
+            if (ulHeadP.compare_exchange_weak(ulHeadT, ulHeadT + 1, std::memory_order_relaxed))
+            {
+               break;
+            }
+         }
+         else if (slDiffT < 0)
+         {
+            return (false);
+         }
+         else
+         {
+            ulHeadT = ulHeadP.load(std::memory_order_relaxed);
+         }
+      }
+
+      tsElementR = ptsCellT->tsElement;
+      ptsCellT->ulSequence.store(ulHeadT + SIZE, std::memory_order_release);
+      return (true);
+   }
+
+private:
+
+   struct Cell_s {
+      std::atomic<uint32_t>   ulSequence;
+      T                       tsElement;
+   };
+
+   //-----------------------------------------------------------------------------------------
+   // head and tail are padded to separate cache lines to avoid false sharing between
+   // producers and consumers
+   //
+   std::atomic<uint32_t>   ulHeadP;
+   uint8_t                 aubPadHeadP[64 - sizeof(std::atomic<uint32_t>)];
+   std::atomic<uint32_t>   ulTailP;
+   uint8_t                 aubPadTailP[64 - sizeof(std::atomic<uint32_t>)];
+   Cell_s                  atsCellP[SIZE];
+};
+
+
+#endif /*CO_MPMC_QUEUE_HPP_*/
@@ -0,0 +1,164 @@
+//====================================================================================================================//
+// File:          co_nmt_batch.cpp                                                                                    //
+// Description:   Batched NMT start of configured devices                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_nmt_batch.hpp"
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::CoNmtBatch()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoNmtBatch::CoNmtBatch()
+{
+   ubGroupSizeP = 0;
+   ulSettleP    = CO_NMT_BATCH_SETTLE;
+
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::addNode()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoNmtBatch::addNode(uint8_t ubNodeIdV, uint64_t uqTimeV)
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_NMT_BATCH_NODE_MAX))
+   {
+      return;
+   }
+
+   if (abtWaitingP[ubNodeIdV - 1] == false)
+   {
+      abtWaitingP[ubNodeIdV - 1] = true;
+      ubCountP++;
+   }
+   uqLastAddP = uqTimeV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::isWaiting()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoNmtBatch::isWaiting(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_NMT_BATCH_NODE_MAX))
+   {
+      return (false);
+   }
+
+   return (abtWaitingP[ubNodeIdV - 1]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::release()                                                                                              //
+// take the devices which are due for the NMT start                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoNmtBatch::release(bool btScanIdleV, uint64_t uqTimeV, uint8_t * pubNodeIdV)
+{
+   uint8_t  ubLimitT;
+   uint8_t  ubReleaseT = 0;
+
+   if ((ubCountP == 0) || (pubNodeIdV == nullptr))
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a full group is started at once, the rest waits until the scan has settled
+   //
+   if ((ubGroupSizeP != CO_NMT_BATCH_ALL) && (ubCountP >= ubGroupSizeP))
+   {
+      ubLimitT = ubGroupSizeP;
+   }
+   else if (btScanIdleV && ((uqTimeV - uqLastAddP) >= ulSettleP))
+   {
+      ubLimitT = ubCountP;
+   }
+   else
+   {
+      return (0);
+   }
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_NMT_BATCH_NODE_MAX; ubNodeIdT++)
+   {
+      if (ubReleaseT == ubLimitT)
+      {
+         break;
+      }
+
+      if (abtWaitingP[ubNodeIdT - 1])
+      {
+         abtWaitingP[ubNodeIdT - 1] = false;
+         pubNodeIdV[ubReleaseT]     = ubNodeIdT;
+         ubReleaseT++;
+      }
+   }
+   ubCountP = ubCountP - ubReleaseT;
+
+   return (ubReleaseT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::removeNode()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoNmtBatch::removeNode(uint8_t ubNodeIdV)
+{
+   if (isWaiting(ubNodeIdV))
+   {
+      abtWaitingP[ubNodeIdV - 1] = false;
+      ubCountP--;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoNmtBatch::reset()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoNmtBatch::reset(void)
+{
+   for (uint8_t ubNodeIdT = 0; ubNodeIdT < CO_NMT_BATCH_NODE_MAX; ubNodeIdT++)
+   {
+      abtWaitingP[ubNodeIdT] = false;
+   }
+   ubCountP   = 0;
+   uqLastAddP = 0;
+}
@@ -0,0 +1,147 @@
+//====================================================================================================================//
+// File:          co_nmt_batch.hpp                                                                                    //
+// Description:   Batched NMT start of configured devices                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_nmt_batch.hpp
+** \brief   Batched NMT start of configured devices
+**
+** Without batching each device is switched to OPERATIONAL by its own NMT command as soon as
+** its configuration is finished, so the devices start their PDOs at different times and the NMT
+** commands are interleaved with the SDO transfers of the scan.
+**
+** CoNmtBatch collects the configured devices instead. The devices are released together when
+** the scan has finished and no device has been added for the settle time, or in groups of a
+** fixed size while the scan is still running. The application decides how a released group is
+** started: one broadcast NMT command if it may start all devices of the network, otherwise one
+** NMT command per device, transmitted back to back.
+*/
+#ifndef CO_NMT_BATCH_HPP_
+#define CO_NMT_BATCH_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_NMT_BATCH_NODE_MAX      ((uint8_t)     127)        // highest node-ID
+#define  CO_NMT_BATCH_ALL           ((uint8_t)     255)        // release all devices after the scan
+#define  CO_NMT_BATCH_SETTLE        ((uint32_t) 500000)        // default settle time in micro-seconds
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoNmtBatch
+** \brief   Collection of configured devices waiting for the NMT start
+**
+*/
+class CoNmtBatch {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoNmtBatch();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uqTimeV       - time in micro-seconds
+   **
+   ** The configuration of the device is finished, it waits for the NMT start.
+   */
+   void           addNode(uint8_t ubNodeIdV, uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of devices waiting for the NMT start
+   */
+   uint8_t        count(void) const             { return (ubCountP); }
+
+   bool           isEnabled(void) const         { return (ubGroupSizeP > 0); }
+
+   bool           isWaiting(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  btScanIdleV   - no device is queued or scanned
+   ** \param[in]  uqTimeV       - time in micro-seconds
+   ** \param[out] pubNodeIdV    - node-IDs of the released devices, CO_NMT_BATCH_NODE_MAX entries
+   ** \return     number of released devices, 0 if no device is due
+   **
+   ** A full group is released at once. The remaining devices are released when the scan is
+   ** idle and no device has been added for the settle time. Released devices are removed from
+   ** the batch.
+   */
+   uint8_t        release(bool btScanIdleV, uint64_t uqTimeV, uint8_t * pubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** Remove a waiting device, e.g. after a new boot-up message or a lost heartbeat.
+   */
+   void           removeNode(uint8_t ubNodeIdV);
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubGroupSizeV  - devices per group, CO_NMT_BATCH_ALL for one group after the
+   **                             scan, 0 disables batching
+   */
+   void           setGroupSize(uint8_t ubGroupSizeV)   { ubGroupSizeP = ubGroupSizeV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulSettleV     - settle time in micro-seconds
+   */
+   void           setSettleTime(uint32_t ulSettleV)    { ulSettleP = ulSettleV; }
+
+private:
+
+   uint8_t           ubGroupSizeP;
+   uint32_t          ulSettleP;
+
+   uint8_t           ubCountP;
+   uint64_t          uqLastAddP;       // time of the last addNode() in micro-seconds
+   bool              abtWaitingP[CO_NMT_BATCH_NODE_MAX];
+};
+
+
+#endif /*CO_NMT_BATCH_HPP_*/
@@ -0,0 +1,248 @@
+//====================================================================================================================//
+// File:          co_process_image.cpp                                                                                //
+// Description:   PDO process image in shared memory                                                                  //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_process_image.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::CoProcessImage()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoProcessImage::CoProcessImage()
+{
+   aszNameP[0] = 0;
+   ulSizeP     = 0;
+   ptsHeaderP  = nullptr;
+   ptsSlotP    = nullptr;
+   ptsCycleP   = nullptr;
+
+   ulUsedSlotCntP = 0;
+   ulSyncCntP     = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::~CoProcessImage()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoProcessImage::~CoProcessImage()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::canFrameReceived()                                                                                 //
+// store PDO data in the process image                                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoProcessImage::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   CoProcessImageSlot_ts * ptsSlotT;
+   uint32_t                ulSequenceT;
+
+   //---------------------------------------------------------------------------------------------------
+   // only PDOs with 11-bit identifier, RTR frames are not stored
+   //
+   if ((ptsHeaderP == nullptr) || ((tsFrameR.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a SYNC message closes the current cycle
+   //
+   if (tsFrameR.can_id == CO_PROCESS_IMAGE_COB_SYNC)
+   {
+      publishCycle(uqTimeStampV);
+      return;
+   }
+
+   if ((tsFrameR.can_id < CO_PROCESS_IMAGE_COB_FIRST) || (tsFrameR.can_id > CO_PROCESS_IMAGE_COB_LAST))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the sequence counter is odd while the slot is updated
+   //
+   ptsSlotT    = &ptsSlotP[tsFrameR.can_id - CO_PROCESS_IMAGE_COB_FIRST];
+   ulSequenceT = ptsSlotT->ulSequence;
+   if (ulSequenceT == 0)
+   {
+      auwUsedSlotP[ulUsedSlotCntP] = (uint16_t) (tsFrameR.can_id - CO_PROCESS_IMAGE_COB_FIRST);
+      ulUsedSlotCntP++;
+   }
+   __atomic_store_n(&ptsSlotT->ulSequence, ulSequenceT + 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   ptsSlotT->ubDlc       = tsFrameR.can_dlc;
+   ptsSlotT->ubFlags     = btLocalV ? CO_PROCESS_IMAGE_FLAG_LOCAL : 0;
+   ptsSlotT->uqTimeStamp = uqTimeStampV;
+   memcpy(&ptsSlotT->aubData[0], &tsFrameR.data[0], sizeof(ptsSlotT->aubData));
+
+   __atomic_store_n(&ptsSlotT->ulSequence, ulSequenceT + 2, __ATOMIC_RELEASE);
+
+   __atomic_store_n(&ptsHeaderP->uqFrameCount, ptsHeaderP->uqFrameCount + 1, __ATOMIC_RELAXED);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::close()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoProcessImage::close(void)
+{
+   if (ptsHeaderP != nullptr)
+   {
+      munmap(ptsHeaderP, ulSizeP);
+      shm_unlink(aszNameP);
+      ptsHeaderP = nullptr;
+      ptsSlotP   = nullptr;
+      ptsCycleP  = nullptr;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::open()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoProcessImage::open(const char * szNameV)
+{
+   int32_t  slFdT;
+   void *   pvMemT;
+
+   close();
+
+   if ((szNameV == nullptr) || (strlen(szNameV) >= sizeof(aszNameP)))
+   {
+      return (false);
+   }
+
+   ulSizeP = sizeof(CoProcessImageHeader_ts) + (CO_PROCESS_IMAGE_SLOTS * sizeof(CoProcessImageSlot_ts)) +
+             (2 * sizeof(CoProcessImageCycle_ts));
+
+   slFdT = shm_open(szNameV, O_CREAT | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+   if (slFdT < 0)
+   {
+      return (false);
+   }
+
+   if (ftruncate(slFdT, ulSizeP) < 0)
+   {
+      ::close(slFdT);
+      shm_unlink(szNameV);
+      return (false);
+   }
+
+   pvMemT = mmap(nullptr, ulSizeP, PROT_READ | PROT_WRITE, MAP_SHARED, slFdT, 0);
+   ::close(slFdT);
+   if (pvMemT == MAP_FAILED)
+   {
+      shm_unlink(szNameV);
+      return (false);
+   }
+
+   strcpy(aszNameP, szNameV);
+   ptsHeaderP = (CoProcessImageHeader_ts *) pvMemT;
+   ptsSlotP   = (CoProcessImageSlot_ts *) (ptsHeaderP + 1);
+   ptsCycleP  = (CoProcessImageCycle_ts *) (ptsSlotP + CO_PROCESS_IMAGE_SLOTS);
+
+   ulUsedSlotCntP = 0;
+   ulSyncCntP     = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // Clear the image, the magic value is written last: a reader which finds the magic value can
+   // rely on the rest of the header.
+   //
+   memset(pvMemT, 0, ulSizeP);
+   ptsHeaderP->uwVersion     = CO_PROCESS_IMAGE_VERSION;
+   ptsHeaderP->uwHeaderSize  = sizeof(CoProcessImageHeader_ts);
+   ptsHeaderP->ulSlotCount   = CO_PROCESS_IMAGE_SLOTS;
+   ptsHeaderP->ulSlotSize    = sizeof(CoProcessImageSlot_ts);
+   ptsHeaderP->ulCobIdFirst  = CO_PROCESS_IMAGE_COB_FIRST;
+   ptsHeaderP->ulCycleOffset = (uint32_t) ((uint8_t *) ptsCycleP - (uint8_t *) ptsHeaderP);
+   ptsHeaderP->ulCycleSize   = sizeof(CoProcessImageCycle_ts);
+   __atomic_store_n(&ptsHeaderP->ulMagic, CO_PROCESS_IMAGE_MAGIC, __ATOMIC_RELEASE);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoProcessImage::publishCycle()                                                                                     //
+// copy the slots into the hidden cycle snapshot and make it visible                                                  //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoProcessImage::publishCycle(uint64_t uqTimeStampV)
+{
+   CoProcessImageCycle_ts *   ptsCycleT;
+   uint32_t                   ulCycleSeqT;
+   uint32_t                   ulSequenceT;
+   uint16_t                   uwSlotT;
+
+   //---------------------------------------------------------------------------------------------------
+   // Readers normally access the snapshot (ulCycleSequence & 1), the other one is written here.
+   // A reader which stalled since the previous SYNC may still copy this snapshot, so its
+   // sequence counter is odd while it is updated. The writer is the only one modifying the
+   // slots, so they are copied without sequence check.
+   //
+   ulCycleSeqT = ptsHeaderP->ulCycleSequence;
+   ptsCycleT   = &ptsCycleP[(ulCycleSeqT + 1) & 1];
+   ulSequenceT = ptsCycleT->ulSequence;
+   __atomic_store_n(&ptsCycleT->ulSequence, ulSequenceT + 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   ulSyncCntP++;
+   ptsCycleT->uqSyncTimeStamp = uqTimeStampV;
+   ptsCycleT->ulSyncCount     = ulSyncCntP;
+   for (uint32_t ulIdxT = 0; ulIdxT < ulUsedSlotCntP; ulIdxT++)
+   {
+      uwSlotT = auwUsedSlotP[ulIdxT];
+      ptsCycleT->atsSlot[uwSlotT] = ptsSlotP[uwSlotT];
+   }
+   __atomic_store_n(&ptsCycleT->ulSequence, ulSequenceT + 2, __ATOMIC_RELEASE);
+
+   //---------------------------------------------------------------------------------------------------
+   // the release store makes the snapshot visible, a reader of the old snapshot repeats its copy
+   //
+   __atomic_store_n(&ptsHeaderP->ulCycleSequence, ulCycleSeqT + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,287 @@
+//====================================================================================================================//
+// File:          co_process_image.hpp                                                                                //
+// Description:   PDO process image in shared memory                                                                  //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_process_image.hpp
+** \brief   PDO process image in shared memory
+**
+** The process image is a POSIX shared memory object (/dev/shm/<name>) which holds the last
+** received data of each PDO. It is written by the CANopen master demo and can be read by any
+** number of other processes without system calls and without locks.
+**
+** Layout (all values in host byte order):
+**
+** | Offset      | Size       | Content                                          |
+** |-------------|------------|--------------------------------------------------|
+** | 0           | 64         | CoProcessImageHeader_ts                          |
+** | 64          | 32 * n     | CoProcessImageSlot_ts, one slot per COB-ID       |
+** | ulCycleOffs | 2 * cycle  | CoProcessImageCycle_ts, SYNC snapshots 0 and 1   |
+**
+** Slot \c i holds the PDO with the COB-ID \c ulCobIdFirst + i, the PDO COB-IDs of the
+** predefined connection set 181h .. 57Fh are covered. PDOs received from devices and PDOs
+** transmitted by the master are stored.
+**
+** Each slot is protected by a sequence counter: the counter is odd while the writer updates
+** the slot and is incremented by 2 for each PDO. A reader copies the slot and accepts the copy
+** if the counter was even and did not change during the copy, see readSlot(). The counter also
+** tells the reader whether a new PDO has been received since its last read.
+**
+** Readers which need the PDOs of one SYNC cycle as a whole use the cycle snapshots instead.
+** On each SYNC the writer copies the slots into the snapshot which is not visible to readers
+** and then increments \c ulCycleSequence of the header. The visible snapshot has the index
+** (ulCycleSequence & 1), it holds all PDOs received up to this SYNC. Each snapshot has its own
+** sequence counter which is odd while the writer updates it, like the counter of a slot. A
+** reader copies the slots it needs from the visible snapshot and accepts the copy if neither
+** \c ulCycleSequence nor the counter of the snapshot changed, see readCycle(). The writer never
+** waits for a reader and a reader only repeats its copy if a SYNC has been transmitted
+** meanwhile.
+*/
+#ifndef CO_PROCESS_IMAGE_HPP_
+#define CO_PROCESS_IMAGE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "co_can_tap.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_PROCESS_IMAGE_MAGIC     ((uint32_t) 0x49504F43)    // "COPI"
+#define  CO_PROCESS_IMAGE_VERSION   ((uint16_t)      2)
+
+#define  CO_PROCESS_IMAGE_COB_FIRST ((uint32_t)  0x180)        // first PDO COB-ID
+#define  CO_PROCESS_IMAGE_COB_LAST  ((uint32_t)  0x57F)        // last PDO COB-ID
+#define  CO_PROCESS_IMAGE_SLOTS     (CO_PROCESS_IMAGE_COB_LAST - CO_PROCESS_IMAGE_COB_FIRST + 1)
+
+#define  CO_PROCESS_IMAGE_COB_SYNC  ((uint32_t)  0x080)        // SYNC COB-ID, starts a new cycle
+
+#define  CO_PROCESS_IMAGE_FLAG_LOCAL   ((uint8_t)  0x01)       // PDO has been transmitted by the master
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoProcessImageHeader_s
+** \brief   Header of the process image
+**
+*/
+typedef struct CoProcessImageHeader_s {
+   uint32_t    ulMagic;          // CO_PROCESS_IMAGE_MAGIC
+   uint16_t    uwVersion;        // CO_PROCESS_IMAGE_VERSION
+   uint16_t    uwHeaderSize;     // size of this header in bytes
+   uint32_t    ulSlotCount;      // number of slots
+   uint32_t    ulSlotSize;       // size of one slot in bytes
+   uint32_t    ulCobIdFirst;     // COB-ID of slot 0
+   uint32_t    ulReserved;
+   uint64_t    uqFrameCount;     // number of PDOs written
+   uint32_t    ulCycleOffset;    // offset of cycle snapshot 0 in bytes
+   uint32_t    ulCycleSize;      // size of one cycle snapshot in bytes
+   uint32_t    ulCycleSequence;  // number of published cycle snapshots
+   uint8_t     aubReserved[20];
+} CoProcessImageHeader_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoProcessImageSlot_s
+** \brief   Data of one PDO
+**
+*/
+typedef struct CoProcessImageSlot_s {
+   uint32_t    ulSequence;       // sequence counter, odd during update, 0 if never written
+   uint8_t     ubDlc;            // data length code
+   uint8_t     ubFlags;          // CO_PROCESS_IMAGE_FLAG_...
+   uint16_t    uwReserved;
+   uint64_t    uqTimeStamp;      // monotonic reception time in nano-seconds
+   uint8_t     aubData[8];       // PDO data
+   uint8_t     aubReserved[8];
+} CoProcessImageSlot_ts;
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoProcessImageCycle_s
+** \brief   Snapshot of all PDOs at the time of a SYNC
+**
+*/
+typedef struct CoProcessImageCycle_s {
+   uint64_t                uqSyncTimeStamp;  // monotonic time of the SYNC in nano-seconds
+   uint32_t                ulSyncCount;      // number of SYNC messages since start
+   uint32_t                ulSequence;       // sequence counter, odd during update
+   uint8_t                 aubReserved[16];
+   CoProcessImageSlot_ts   atsSlot[CO_PROCESS_IMAGE_SLOTS];
+} CoProcessImageCycle_ts;
+
+static_assert(sizeof(CoProcessImageHeader_ts) == 64, "unexpected size of process image header");
+static_assert(sizeof(CoProcessImageSlot_ts)   == 32, "unexpected size of process image slot");
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoProcessImage
+** \brief   PDO process image in shared memory
+**
+** The process image is fed by the CAN tap, PDO data is written on reception of the frame
+** without any copy through Qt signals. There is exactly one writer.
+*/
+class CoProcessImage : public CoCanListener {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoProcessImage();
+
+   ~CoProcessImage();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   void           close(void);
+
+   bool           isOpen(void) const   { return (ptsHeaderP != nullptr); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ptsHeaderV - header of the mapped process image
+   ** \param[in]  ulFirstV   - index of the first slot
+   ** \param[in]  ulCountV   - number of slots
+   ** \param[out] ptsSlotV   - copy of the slots, at least \a ulCountV entries
+   ** \param[out] pulSyncV   - SYNC counter of the snapshot, may be nullptr
+   ** \return     cycle sequence of the copy, 0 if no SYNC has been transmitted yet
+   **
+   ** Lock-free read of consecutive slots from the last cycle snapshot, all slots belong to
+   ** the same SYNC cycle. The sequence counters of the copied slots are valid. This function
+   ** is intended for readers in other processes which map the process image read-only.
+   */
+   static uint32_t   readCycle(const CoProcessImageHeader_ts * ptsHeaderV,
+                               uint32_t ulFirstV, uint32_t ulCountV,
+                               CoProcessImageSlot_ts * ptsSlotV, uint32_t * pulSyncV)
+   {
+      const CoProcessImageCycle_ts *   ptsCycleT;
+      uint32_t                         ulSeqStartT;
+      uint32_t                         ulSeqEndT;
+      uint32_t                         ulCycleSeqStartT;
+      uint32_t                         ulCycleSeqEndT;
+      uint32_t                         ulSyncT;
+
+      if ((ulFirstV >= ptsHeaderV->ulSlotCount) || (ulCountV > (ptsHeaderV->ulSlotCount - ulFirstV)))
+      {
+         return (0);
+      }
+
+      do
+      {
+         ulSeqStartT      = __atomic_load_n(&ptsHeaderV->ulCycleSequence, __ATOMIC_ACQUIRE);
+         ptsCycleT        = (const CoProcessImageCycle_ts *) ((const uint8_t *) ptsHeaderV +
+                                                              ptsHeaderV->ulCycleOffset +
+                                                              ((ulSeqStartT & 1) * ptsHeaderV->ulCycleSize));
+         ulCycleSeqStartT = __atomic_load_n(&ptsCycleT->ulSequence, __ATOMIC_ACQUIRE);
+         ulSyncT          = ptsCycleT->ulSyncCount;
+         for (uint32_t ulSlotT = 0; ulSlotT < ulCountV; ulSlotT++)
+         {
+            ptsSlotV[ulSlotT] = ptsCycleT->atsSlot[ulFirstV + ulSlotT];
+         }
+         __atomic_thread_fence(__ATOMIC_ACQUIRE);
+         ulCycleSeqEndT   = __atomic_load_n(&ptsCycleT->ulSequence, __ATOMIC_RELAXED);
+         ulSeqEndT        = __atomic_load_n(&ptsHeaderV->ulCycleSequence, __ATOMIC_RELAXED);
+      } while (((ulCycleSeqStartT & 1) != 0) || (ulCycleSeqStartT != ulCycleSeqEndT) ||
+               (ulSeqStartT != ulSeqEndT));
+
+      if (pulSyncV != nullptr)
+      {
+         *pulSyncV = ulSyncT;
+      }
+      return (ulSeqStartT);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szNameV    - name of the shared memory object, e.g. "/canopen-demo-can1"
+   ** \return     true if the process image has been created
+   **
+   ** Create the shared memory object and clear the process image. The object is removed by
+   ** close().
+   */
+   bool           open(const char * szNameV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ptsSlotV   - slot inside the mapped process image
+   ** \param[out] ptsCopyV   - consistent copy of the slot
+   ** \return     sequence counter of the copy, 0 if the slot has never been written
+   **
+   ** Lock-free read of one slot, this function is intended for readers in other processes
+   ** which map the process image read-only.
+   */
+   static uint32_t   readSlot(const CoProcessImageSlot_ts * ptsSlotV, CoProcessImageSlot_ts * ptsCopyV)
+   {
+      uint32_t ulSeqStartT;
+      uint32_t ulSeqEndT;
+
+      do
+      {
+         ulSeqStartT      = __atomic_load_n(&ptsSlotV->ulSequence, __ATOMIC_ACQUIRE);
+         *ptsCopyV   = *ptsSlotV;
+         __atomic_thread_fence(__ATOMIC_ACQUIRE);
+         ulSeqEndT        = __atomic_load_n(&ptsSlotV->ulSequence, __ATOMIC_RELAXED);
+      } while (((ulSeqStartT & 1) != 0) || (ulSeqStartT != ulSeqEndT));
+
+      ptsCopyV->ulSequence = ulSeqStartT;
+      return (ulSeqStartT);
+   }
+
+private:
+
+   void           publishCycle(uint64_t uqTimeStampV);
+
+   char                       aszNameP[64];
+   uint32_t                   ulSizeP;
+   CoProcessImageHeader_ts *  ptsHeaderP;
+   CoProcessImageSlot_ts *    ptsSlotP;
+   CoProcessImageCycle_ts *   ptsCycleP;
+
+   //---------------------------------------------------------------------------------------------------
+   // Only slots which have been written at least once are copied into a cycle snapshot, the
+   // index of these slots is stored here.
+   //
+   uint16_t                   auwUsedSlotP[CO_PROCESS_IMAGE_SLOTS];
+   uint32_t                   ulUsedSlotCntP;
+   uint32_t                   ulSyncCntP;
+};
+
+
+#endif /*CO_PROCESS_IMAGE_HPP_*/
@@ -0,0 +1,355 @@
+//====================================================================================================================//
+// File:          co_recovery_scheduler.cpp                                                                           //
+// Description:   Recovery of devices after heartbeat loss                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_recovery_scheduler.hpp"
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::CoRecoveryScheduler()                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoRecoveryScheduler::CoRecoveryScheduler()
+{
+   ubBatchSizeP = 0;
+
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::lostNode()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoRecoveryScheduler::lostNode(uint8_t ubNodeIdV)
+{
+   RecoveryNode_s * ptsNodeT;
+   bool             btSegmentT = false;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_RECOVERY_NODE_MAX))
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a node which is already reset or waits for the reset keeps its state and backoff
+   //
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if ((ptsNodeT->ubState != eCO_RECOVERY_STATE_NONE) && (ptsNodeT->ubState != eCO_RECOVERY_STATE_RESCAN_WAIT))
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // Nodes behind a broken cable or connector lose their heartbeat within a few consumer
+   // periods. The segment failure is reported once, when the number of losses within the
+   // debounce time reaches the limit.
+   //
+   if ((ubLossCntP == 0) || ((uqTimeP - uqLossStartP) > CO_RECOVERY_DEBOUNCE))
+   {
+      uqLossStartP = uqTimeP;
+      ubLossCntP   = 0;
+   }
+   if (ubLossCntP < 255)
+   {
+      ubLossCntP++;
+   }
+   if (ubLossCntP == CO_RECOVERY_SEGMENT_MIN)
+   {
+      ulSegmentCntP++;
+      btSegmentT = true;
+   }
+
+   if (ptsNodeT->ulBackoff == 0)
+   {
+      ptsNodeT->ulBackoff = CO_RECOVERY_BACKOFF_BASE;
+   }
+   setState(*ptsNodeT, eCO_RECOVERY_STATE_LOST, uqTimeP + CO_RECOVERY_DEBOUNCE);
+
+   return (btSegmentT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::nextReset()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoRecoveryScheduler::nextReset(void)
+{
+   RecoveryNode_s * ptsNodeT;
+   uint8_t          ubNodeIdT = 0;
+
+   if ((ubResetTokenP == 0) || (ubRecoveryCntP == 0))
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the node which waits longest is reset first
+   //
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_RECOVERY_NODE_MAX; ubIdxT++)
+   {
+      if (atsNodeP[ubIdxT].ubState != eCO_RECOVERY_STATE_RESET_WAIT)
+      {
+         continue;
+      }
+      if ((ubNodeIdT == 0) || (atsNodeP[ubIdxT].uqDue < atsNodeP[ubNodeIdT - 1].uqDue))
+      {
+         ubNodeIdT = ubIdxT + 1;
+      }
+   }
+
+   if (ubNodeIdT == 0)
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the wait for the boot-up message is doubled with each reset which is not answered
+   //
+   ptsNodeT = &atsNodeP[ubNodeIdT - 1];
+   setState(*ptsNodeT, eCO_RECOVERY_STATE_RESET_SENT, uqTimeP + ptsNodeT->ulBackoff);
+   if (ptsNodeT->ulBackoff < (CO_RECOVERY_BACKOFF_MAX / 2))
+   {
+      ptsNodeT->ulBackoff = ptsNodeT->ulBackoff * 2;
+   }
+   else
+   {
+      ptsNodeT->ulBackoff = CO_RECOVERY_BACKOFF_MAX;
+   }
+   ubResetTokenP--;
+
+   return (ubNodeIdT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::nextRescan()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoRecoveryScheduler::nextRescan(void)
+{
+   uint8_t  ubNodeIdT = 0;
+
+   if ((ubRescanTokenP == 0) || (ubRecoveryCntP == 0))
+   {
+      return (0);
+   }
+
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_RECOVERY_NODE_MAX; ubIdxT++)
+   {
+      if (atsNodeP[ubIdxT].ubState != eCO_RECOVERY_STATE_RESCAN_WAIT)
+      {
+         continue;
+      }
+      if ((ubNodeIdT == 0) || (atsNodeP[ubIdxT].uqDue < atsNodeP[ubNodeIdT - 1].uqDue))
+      {
+         ubNodeIdT = ubIdxT + 1;
+      }
+   }
+
+   if (ubNodeIdT == 0)
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the recovery is finished, the next loss starts with the shortest backoff again
+   //
+   setState(atsNodeP[ubNodeIdT - 1], eCO_RECOVERY_STATE_NONE, 0);
+   atsNodeP[ubNodeIdT - 1].ulBackoff = 0;
+   ubRescanTokenP--;
+
+   return (ubNodeIdT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::nodeAlive()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoRecoveryScheduler::nodeAlive(uint8_t ubNodeIdV)
+{
+   RecoveryNode_s * ptsNodeT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_RECOVERY_NODE_MAX))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // A node which sends its heartbeat again does not need a reset. This also covers a node which
+   // has ignored the NMT reset, it would only be reset again after the backoff. A node which
+   // waits for its scan keeps its place in the queue.
+   //
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if (ptsNodeT->ubState == eCO_RECOVERY_STATE_RESCAN_WAIT)
+   {
+      return;
+   }
+   setState(*ptsNodeT, eCO_RECOVERY_STATE_NONE, 0);
+   ptsNodeT->ulBackoff = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::nodeBooted()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoRecoveryScheduler::nodeBooted(uint8_t ubNodeIdV)
+{
+   RecoveryNode_s * ptsNodeT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_RECOVERY_NODE_MAX))
+   {
+      return (false);
+   }
+
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if (ptsNodeT->ubState == eCO_RECOVERY_STATE_NONE)
+   {
+      return (false);
+   }
+
+   if (ptsNodeT->ubState != eCO_RECOVERY_STATE_RESCAN_WAIT)
+   {
+      setState(*ptsNodeT, eCO_RECOVERY_STATE_RESCAN_WAIT, uqTimeP);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::reset()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoRecoveryScheduler::reset(void)
+{
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_RECOVERY_NODE_MAX; ubIdxT++)
+   {
+      atsNodeP[ubIdxT].ubState   = eCO_RECOVERY_STATE_NONE;
+      atsNodeP[ubIdxT].ulBackoff = 0;
+      atsNodeP[ubIdxT].uqDue     = 0;
+   }
+
+   ubRecoveryCntP = 0;
+   ubResetTokenP  = ubBatchSizeP;
+   ubRescanTokenP = ubBatchSizeP;
+   uqIntervalP    = 0;
+   ubLossCntP     = 0;
+   uqLossStartP   = 0;
+   ulSegmentCntP  = 0;
+   uqTimeP        = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::setState()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoRecoveryScheduler::setState(RecoveryNode_s & tsNodeR, uint8_t ubStateV, uint64_t uqDueV)
+{
+   if ((tsNodeR.ubState == eCO_RECOVERY_STATE_NONE) && (ubStateV != eCO_RECOVERY_STATE_NONE))
+   {
+      ubRecoveryCntP++;
+   }
+   else if ((tsNodeR.ubState != eCO_RECOVERY_STATE_NONE) && (ubStateV == eCO_RECOVERY_STATE_NONE))
+   {
+      ubRecoveryCntP--;
+   }
+
+   tsNodeR.ubState = ubStateV;
+   tsNodeR.uqDue   = uqDueV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::state()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoRecoveryScheduler::state(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_RECOVERY_NODE_MAX))
+   {
+      return (eCO_RECOVERY_STATE_NONE);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ubState);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoRecoveryScheduler::tick()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoRecoveryScheduler::tick(uint32_t ulElapsedV)
+{
+   RecoveryNode_s * ptsNodeT;
+
+   uqTimeP += ulElapsedV;
+
+   //---------------------------------------------------------------------------------------------------
+   // start a new batch interval
+   //
+   if ((uqTimeP - uqIntervalP) >= CO_RECOVERY_INTERVAL)
+   {
+      uqIntervalP    = uqTimeP;
+      ubResetTokenP  = ubBatchSizeP;
+      ubRescanTokenP = ubBatchSizeP;
+   }
+
+   if (ubRecoveryCntP == 0)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // queue the nodes whose debounce time has elapsed and the nodes which have not answered the
+   // reset with a boot-up message
+   //
+   for (uint8_t ubIdxT = 0; ubIdxT < CO_RECOVERY_NODE_MAX; ubIdxT++)
+   {
+      ptsNodeT = &atsNodeP[ubIdxT];
+      if ((ptsNodeT->ubState != eCO_RECOVERY_STATE_LOST) && (ptsNodeT->ubState != eCO_RECOVERY_STATE_RESET_SENT))
+      {
+         continue;
+      }
+      if (uqTimeP >= ptsNodeT->uqDue)
+      {
+         setState(*ptsNodeT, eCO_RECOVERY_STATE_RESET_WAIT, uqTimeP);
+      }
+   }
+}
@@ -0,0 +1,243 @@
+//====================================================================================================================//
+// File:          co_recovery_scheduler.hpp                                                                           //
+// Description:   Recovery of devices after heartbeat loss                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_recovery_scheduler.hpp
+** \brief   Recovery of devices after heartbeat loss
+**
+*/
+#ifndef CO_RECOVERY_SCHEDULER_HPP_
+#define CO_RECOVERY_SCHEDULER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_RECOVERY_NODE_MAX       ((uint8_t)     127)        // highest node-ID
+
+#define  CO_RECOVERY_DEBOUNCE       ((uint32_t)  250000)       // debounce time in micro-seconds
+#define  CO_RECOVERY_INTERVAL       ((uint32_t) 1000000)       // batch interval in micro-seconds
+#define  CO_RECOVERY_BACKOFF_BASE   ((uint32_t) 2000000)       // first wait for boot-up in micro-seconds
+#define  CO_RECOVERY_BACKOFF_MAX    ((uint32_t) 64000000)      // longest wait for boot-up in micro-seconds
+#define  CO_RECOVERY_SEGMENT_MIN    ((uint8_t)       4)        // losses within debounce time of a segment
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoRecoveryState_e
+** \brief   Recovery state of a node
+**
+*/
+enum CoRecoveryState_e {
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat is present or the node is not supervised
+   //
+   eCO_RECOVERY_STATE_NONE = 0,
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat lost, the node is reset after the debounce time unless it shows up again
+   //
+   eCO_RECOVERY_STATE_LOST,
+
+   //---------------------------------------------------------------------------------------------------
+   // node is queued for an NMT reset
+   //
+   eCO_RECOVERY_STATE_RESET_WAIT,
+
+   //---------------------------------------------------------------------------------------------------
+   // NMT reset has been sent, waiting for the boot-up message
+   //
+   eCO_RECOVERY_STATE_RESET_SENT,
+
+   //---------------------------------------------------------------------------------------------------
+   // boot-up message received, the node is queued for the scan
+   //
+   eCO_RECOVERY_STATE_RESCAN_WAIT
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoRecoveryScheduler
+** \brief   Paced recovery of devices after heartbeat loss
+**
+** A lost heartbeat is reported by lostNode(). The node is not reset at once: if the node sends
+** its heartbeat or a boot-up message within the debounce time, nodeAlive() or nodeBooted()
+** cancel the recovery. At least CO_RECOVERY_SEGMENT_MIN losses within the debounce time are
+** reported as failure of a cable segment.
+**
+** The NMT resets are handed out by nextReset(), at most \c batchSize nodes per batch interval.
+** If a node does not send a boot-up message after the reset, it is reset again after an
+** exponential backoff (2 s, 4 s, 8 s, .. 64 s), so the nodes of a disconnected segment cause only
+** a few frames until the segment is connected again.
+**
+** Nodes which send a boot-up message are handed out by nextRescan() for a new scan, again at
+** most \c batchSize nodes per batch interval. The scan traffic of the recovery is bounded and
+** the remaining devices keep their bandwidth for PDOs.
+**
+**    LOST -> RESET_WAIT -> RESET_SENT -> RESCAN_WAIT -> NONE
+**                   ^-------------/ (no boot-up after backoff)
+*/
+class CoRecoveryScheduler {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoRecoveryScheduler();
+
+   uint8_t        batchSize(void) const         { return (ubBatchSizeP); }
+
+   bool           isEnabled(void) const         { return (ubBatchSizeP > 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     true if the loss completes a suspected segment failure
+   **
+   ** The heartbeat consumer has reported a lost heartbeat.
+   */
+   bool           lostNode(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     node-ID of the next node to reset, 0 if no reset is due
+   */
+   uint8_t        nextReset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     node-ID of the next node to scan, 0 if no scan is due
+   **
+   ** The recovery of the returned node is finished.
+   */
+   uint8_t        nextRescan(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The node has reported an NMT state other than boot-up. A node which has lost its heartbeat
+   ** and is not reset yet needs no recovery.
+   */
+   void           nodeAlive(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     true if the node is in recovery, its scan is started by nextRescan()
+   */
+   bool           nodeBooted(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of nodes in recovery
+   */
+   uint8_t        recoveryCount(void) const     { return (ubRecoveryCntP); }
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of suspected segment failures
+   */
+   uint32_t       segmentFailures(void) const   { return (ulSegmentCntP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubBatchSizeV  - resets and scans per batch interval, 0 disables the scheduler
+   */
+   void           setBatchSize(uint8_t ubBatchSizeV)   { ubBatchSizeP = ubBatchSizeV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     recovery state of the node, CoRecoveryState_e
+   */
+   uint8_t        state(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulElapsedV    - time since the last call in micro-seconds
+   **
+   ** Advance the scheduler time, the function is called with each timer tick.
+   */
+   void           tick(uint32_t ulElapsedV);
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // recovery data of one node
+   //
+   struct RecoveryNode_s {
+      uint8_t     ubState;       // current state, CoRecoveryState_e
+      uint32_t    ulBackoff;     // wait for boot-up after the next reset in micro-seconds
+      uint64_t    uqDue;         // time of the next step in micro-seconds
+   };
+
+   void           setState(RecoveryNode_s & tsNodeR, uint8_t ubStateV, uint64_t uqDueV);
+
+   uint8_t           ubBatchSizeP;
+   uint8_t           ubRecoveryCntP;
+
+   //-----------------------------------------------------------------------------------------
+   // resets and scans left in the current batch interval
+   //
+   uint8_t           ubResetTokenP;
+   uint8_t           ubRescanTokenP;
+   uint64_t          uqIntervalP;      // start of the current batch interval
+
+   //-----------------------------------------------------------------------------------------
+   // heartbeat losses within the debounce time, used for the segment failure detection
+   //
+   uint8_t           ubLossCntP;
+   uint64_t          uqLossStartP;
+   uint32_t          ulSegmentCntP;
+
+   //-----------------------------------------------------------------------------------------
+   // scheduler time in micro-seconds, advanced by tick()
+   //
+   uint64_t          uqTimeP;
+
+   RecoveryNode_s    atsNodeP[CO_RECOVERY_NODE_MAX];
+};
+
+
+#endif /*CO_RECOVERY_SCHEDULER_HPP_*/
@@ -0,0 +1,502 @@
+//====================================================================================================================//
+// File:          co_scan_scheduler.cpp                                                                               //
+// Description:   Scheduler for parallel device scans                                                                 //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_scan_scheduler.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  SCAN_COST                  (CO_SCAN_FRAMES_PER_NODE * CO_SCAN_BITS_PER_FRAME)
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::CoScanScheduler()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoScanScheduler::CoScanScheduler()
+{
+   ubMaxParallelP  = 1;
+   ubRetryMaxP     = CO_SCAN_RETRY_MAX;
+   ubBusLoadLimitP = 0;
+   ulBitrateP      = 500000;
+
+   reset();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::addNode()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::addNode(uint8_t ubNodeIdV, bool btVerifyV)
+{
+   ScanNode_s * ptsNodeT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a running SDO transfer is not interrupted, if the node has been reset it will run into a
+   // timeout and the scan is repeated
+   //
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if (ptsNodeT->btActive || clPendingP.contains(ubNodeIdV) || (ptsNodeT->ubState == eCO_SCAN_STATE_QUARANTINED))
+   {
+      return;
+   }
+
+   ptsNodeT->ubState     = eCO_SCAN_STATE_BOOTED;
+   ptsNodeT->ubResume    = btVerifyV ? eCO_SCAN_STATE_VERIFYING : eCO_SCAN_STATE_IDENTIFYING;
+   ptsNodeT->ubRetryCnt  = 0;
+   ptsNodeT->btDeferred  = false;
+   ptsNodeT->uqNotBefore = 0;
+   clPendingP.append(ubNodeIdV);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::deferNode()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::deferNode(uint8_t ubNodeIdV, uint32_t ulDelayV)
+{
+   ScanNode_s * ptsNodeT;
+
+   if (isActive(ubNodeIdV) == false)
+   {
+      return;
+   }
+
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   ptsNodeT->btActive    = false;
+   ptsNodeT->btDeferred  = true;
+   ptsNodeT->uqNotBefore = uqTimeP + ulDelayV;
+   ptsNodeT->ubResume    = ptsNodeT->ubState;
+   ptsNodeT->ubState     = eCO_SCAN_STATE_BOOTED;
+   ubActiveCntP--;
+   clPendingP.append(ubNodeIdV);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::isActive()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoScanScheduler::isActive(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return (false);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].btActive);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nextNode()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoScanScheduler::nextNode(void)
+{
+   ScanNode_s *   ptsNodeT;
+   uint8_t        ubNodeIdT;
+
+   if ((ubActiveCntP >= ubMaxParallelP) || clPendingP.isEmpty())
+   {
+      return (0);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // take the first node whose backoff time has elapsed, nodes waiting for a retry don't block
+   // the nodes queued behind them. Each node except deferred nodes is charged against the bus
+   // load budget.
+   //
+   for (int32_t slIdxT = 0; slIdxT < clPendingP.count(); slIdxT++)
+   {
+      ubNodeIdT = clPendingP.at(slIdxT);
+      ptsNodeT  = &atsNodeP[ubNodeIdT - 1];
+
+      if ((ubBusLoadLimitP > 0) && (ptsNodeT->btDeferred == false) && (ulBudgetP < SCAN_COST))
+      {
+         continue;
+      }
+
+      if (ptsNodeT->uqNotBefore <= uqTimeP)
+      {
+         clPendingP.removeAt(slIdxT);
+
+         if ((ubBusLoadLimitP > 0) && (ptsNodeT->btDeferred == false))
+         {
+            ulBudgetP -= SCAN_COST;
+         }
+         ptsNodeT->btDeferred = false;
+
+         ptsNodeT->ubState  = ptsNodeT->ubResume;
+         ptsNodeT->btActive = true;
+         ubActiveCntP++;
+
+         return (ubNodeIdT);
+      }
+   }
+
+   return (0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeIdentified()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::nodeIdentified(uint8_t ubNodeIdV)
+{
+   if (isActive(ubNodeIdV))
+   {
+      atsNodeP[ubNodeIdV - 1].ubState = eCO_SCAN_STATE_CONFIG_HEARTBEAT;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeConfigPdo()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::nodeConfigPdo(uint8_t ubNodeIdV)
+{
+   if (isActive(ubNodeIdV))
+   {
+      atsNodeP[ubNodeIdV - 1].ubState = eCO_SCAN_STATE_CONFIG_PDO;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeFailed()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::nodeFailed(uint8_t ubNodeIdV)
+{
+   if (isActive(ubNodeIdV))
+   {
+      atsNodeP[ubNodeIdV - 1].ubState  = eCO_SCAN_STATE_FAILED;
+      atsNodeP[ubNodeIdV - 1].btActive = false;
+      ubActiveCntP--;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeOperational()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::nodeOperational(uint8_t ubNodeIdV)
+{
+   if (isActive(ubNodeIdV))
+   {
+      atsNodeP[ubNodeIdV - 1].ubState  = eCO_SCAN_STATE_OPERATIONAL;
+      atsNodeP[ubNodeIdV - 1].btActive = false;
+      ubActiveCntP--;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeTimeout()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoScanScheduler::nodeTimeout(uint8_t ubNodeIdV)
+{
+   ScanNode_s * ptsNodeT;
+
+   if (isActive(ubNodeIdV) == false)
+   {
+      return (false);
+   }
+
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   ptsNodeT->btActive = false;
+   ubActiveCntP--;
+
+   //---------------------------------------------------------------------------------------------------
+   // park the node after the last retry
+   //
+   if (ptsNodeT->ubRetryCnt >= ubRetryMaxP)
+   {
+      ptsNodeT->ubState = eCO_SCAN_STATE_FAILED;
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // repeat the failed step after an exponential backoff
+   //
+   ptsNodeT->uqNotBefore = uqTimeP + (((uint64_t) CO_SCAN_BACKOFF_BASE * 1000) << ptsNodeT->ubRetryCnt);
+   ptsNodeT->ubRetryCnt++;
+   ptsNodeT->ubResume    = ptsNodeT->ubState;
+   ptsNodeT->ubState     = eCO_SCAN_STATE_BOOTED;
+   clPendingP.append(ubNodeIdV);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::nodeVerified()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::nodeVerified(uint8_t ubNodeIdV, bool btMatchV)
+{
+   if (isActive(ubNodeIdV))
+   {
+      if (btMatchV)
+      {
+         atsNodeP[ubNodeIdV - 1].ubState = eCO_SCAN_STATE_CONFIG_HEARTBEAT;
+      }
+      else
+      {
+         atsNodeP[ubNodeIdV - 1].ubState = eCO_SCAN_STATE_IDENTIFYING;
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::quarantineNode()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::quarantineNode(uint8_t ubNodeIdV)
+{
+   ScanNode_s * ptsNodeT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return;
+   }
+
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if (ptsNodeT->btActive)
+   {
+      ptsNodeT->btActive = false;
+      ubActiveCntP--;
+   }
+   clPendingP.removeAll(ubNodeIdV);
+
+   ptsNodeT->ubState    = eCO_SCAN_STATE_QUARANTINED;
+   ptsNodeT->btDeferred = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::reconfigureNode()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoScanScheduler::reconfigureNode(uint8_t ubNodeIdV)
+{
+   ScanNode_s * ptsNodeT;
+
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return (false);
+   }
+
+   ptsNodeT = &atsNodeP[ubNodeIdV - 1];
+   if ((ptsNodeT->ubState != eCO_SCAN_STATE_OPERATIONAL) || ptsNodeT->btActive || clPendingP.contains(ubNodeIdV))
+   {
+      return (false);
+   }
+
+   ptsNodeT->ubState     = eCO_SCAN_STATE_BOOTED;
+   ptsNodeT->ubResume    = eCO_SCAN_STATE_CONFIG_HEARTBEAT;
+   ptsNodeT->ubRetryCnt  = 0;
+   ptsNodeT->btDeferred  = true;
+   ptsNodeT->uqNotBefore = 0;
+   clPendingP.append(ubNodeIdV);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::releaseNode()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::releaseNode(uint8_t ubNodeIdV)
+{
+   if (state(ubNodeIdV) == eCO_SCAN_STATE_QUARANTINED)
+   {
+      atsNodeP[ubNodeIdV - 1].ubState    = eCO_SCAN_STATE_IDLE;
+      atsNodeP[ubNodeIdV - 1].ubRetryCnt = 0;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::reset()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::reset(void)
+{
+   clPendingP.clear();
+   for (uint8_t ubCntT = 0; ubCntT < CO_SCAN_NODE_MAX; ubCntT++)
+   {
+      atsNodeP[ubCntT].ubState     = eCO_SCAN_STATE_IDLE;
+      atsNodeP[ubCntT].ubResume    = eCO_SCAN_STATE_IDENTIFYING;
+      atsNodeP[ubCntT].ubRetryCnt  = 0;
+      atsNodeP[ubCntT].btActive    = false;
+      atsNodeP[ubCntT].btDeferred  = false;
+      atsNodeP[ubCntT].uqNotBefore = 0;
+   }
+   ubActiveCntP = 0;
+   ulBudgetP    = SCAN_COST;
+   uqTimeP      = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::retryCount()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoScanScheduler::retryCount(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return (0);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ubRetryCnt);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::setBusLoadLimit()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::setBusLoadLimit(uint8_t ubPercentV, uint32_t ulBitrateV)
+{
+   if (ubPercentV > 100)
+   {
+      ubPercentV = 100;
+   }
+
+   ubBusLoadLimitP = ubPercentV;
+   ulBitrateP      = ulBitrateV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::setMaxParallel()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::setMaxParallel(uint8_t ubMaxParallelV)
+{
+   if (ubMaxParallelV < 1)
+   {
+      ubMaxParallelV = 1;
+   }
+
+   ubMaxParallelP = ubMaxParallelV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::state()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint8_t CoScanScheduler::state(uint8_t ubNodeIdV) const
+{
+   if ((ubNodeIdV == 0) || (ubNodeIdV > CO_SCAN_NODE_MAX))
+   {
+      return (eCO_SCAN_STATE_IDLE);
+   }
+
+   return (atsNodeP[ubNodeIdV - 1].ubState);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::stateName()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+const char * CoScanScheduler::stateName(uint8_t ubStateV)
+{
+   switch (ubStateV)
+   {
+      case eCO_SCAN_STATE_IDLE:              return ("idle");
+      case eCO_SCAN_STATE_BOOTED:            return ("booted");
+      case eCO_SCAN_STATE_VERIFYING:         return ("verifying");
+      case eCO_SCAN_STATE_IDENTIFYING:       return ("identifying");
+      case eCO_SCAN_STATE_CONFIG_HEARTBEAT:  return ("configuring heartbeat");
+      case eCO_SCAN_STATE_CONFIG_PDO:        return ("configuring PDOs");
+      case eCO_SCAN_STATE_OPERATIONAL:       return ("operational");
+      case eCO_SCAN_STATE_FAILED:            return ("failed");
+      case eCO_SCAN_STATE_QUARANTINED:       return ("quarantined");
+      default:                               return ("unknown");
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoScanScheduler::tick()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoScanScheduler::tick(uint32_t ulElapsedV)
+{
+   uint64_t uqBitsT;
+
+   uqTimeP += ulElapsedV;
+
+   if (ubBusLoadLimitP == 0)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // bits available within the bus load budget for the elapsed time
+   //
+   uqBitsT  = (uint64_t) ulBitrateP * ubBusLoadLimitP * ulElapsedV;
+   uqBitsT  = uqBitsT / (100 * 1000000);
+   uqBitsT += ulBudgetP;
+
+   if (uqBitsT > SCAN_COST)
+   {
+      uqBitsT = SCAN_COST;
+   }
+   ulBudgetP = (uint32_t) uqBitsT;
+}
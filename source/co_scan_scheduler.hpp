@@ -0,0 +1,374 @@
+//====================================================================================================================//
+// File:          co_scan_scheduler.hpp                                                                               //
+// Description:   Scheduler for parallel device scans                                                                 //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_scan_scheduler.hpp
+** \brief   Scheduler for parallel device scans
+**
+*/
+#ifndef CO_SCAN_SCHEDULER_HPP_
+#define CO_SCAN_SCHEDULER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QList>
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SCAN_NODE_MAX           ((uint8_t)     127)        // highest node-ID
+
+//-------------------------------------------------------------------------------------------------------
+// Estimated number of CAN frames for one device scan: ComNodeGetInfo() reads 1000h, 1001h,
+// 1008h (segmented) and 1018h:01h .. 04h, the heartbeat configuration writes 1017h.
+//
+#define  CO_SCAN_FRAMES_PER_NODE    ((uint32_t)     24)
+
+//-------------------------------------------------------------------------------------------------------
+// Number of bits of a CAN frame with 8 data bytes and 11-bit identifier, including worst case
+// bit stuffing and interframe space
+//
+#define  CO_SCAN_BITS_PER_FRAME     ((uint32_t)    135)
+
+#define  CO_SCAN_RETRY_MAX          ((uint8_t)       3)        // default number of retries
+#define  CO_SCAN_BACKOFF_BASE       ((uint32_t)    200)        // first retry delay in milli-seconds
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoScanState_e
+** \brief   Scan state of a node
+**
+*/
+enum CoScanState_e {
+   //---------------------------------------------------------------------------------------------------
+   // no boot-up message received
+   //
+   eCO_SCAN_STATE_IDLE = 0,
+
+   //---------------------------------------------------------------------------------------------------
+   // boot-up message received, node is queued for identification
+   //
+   eCO_SCAN_STATE_BOOTED,
+
+   //---------------------------------------------------------------------------------------------------
+   // identity is cached, the serial number is read to verify the cached entry
+   //
+   eCO_SCAN_STATE_VERIFYING,
+
+   //---------------------------------------------------------------------------------------------------
+   // identity objects are read by ComNodeGetInfo()
+   //
+   eCO_SCAN_STATE_IDENTIFYING,
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat producer time is written by ComNodeSetHbProdTime()
+   //
+   eCO_SCAN_STATE_CONFIG_HEARTBEAT,
+
+   //---------------------------------------------------------------------------------------------------
+   // PDO inhibit times are written by the SDO probe
+   //
+   eCO_SCAN_STATE_CONFIG_PDO,
+
+   //---------------------------------------------------------------------------------------------------
+   // node is configured and has been set to operational or waits for the NMT start
+   //
+   eCO_SCAN_STATE_OPERATIONAL,
+
+   //---------------------------------------------------------------------------------------------------
+   // node did not respond within the allowed number of retries, it is parked until the next
+   // boot-up message
+   //
+   eCO_SCAN_STATE_FAILED,
+
+   //---------------------------------------------------------------------------------------------------
+   // two devices use the node-ID, the node is not scanned until the collision is resolved
+   //
+   eCO_SCAN_STATE_QUARANTINED
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoScanScheduler
+** \brief   Scheduler for parallel device scans
+**
+** Node-IDs of devices which sent a boot-up message are queued by addNode(). The scheduler
+** hands out up to \c maxParallel nodes at the same time via nextNode(), each node is scanned
+** by its own SDO transfer. Each node runs through the states of CoScanState_e:
+**
+**    BOOTED -> IDENTIFYING -> CONFIG_HEARTBEAT -> OPERATIONAL
+**
+** For nodes with a cached identity the full identification is replaced by a verification of
+** the serial number:
+**
+**    BOOTED -> VERIFYING -> CONFIG_HEARTBEAT -> OPERATIONAL
+**                       \-> IDENTIFYING (serial number does not match)
+**
+** With a PDO inhibit time plan the state CONFIG_PDO follows CONFIG_HEARTBEAT. A node can be
+** deferred by deferNode(), e.g. to start its heartbeat in a given phase: it frees its scan
+** slot and continues with the same state after the delay. An operational node is configured
+** again after reconfigureNode(), starting with CONFIG_HEARTBEAT.
+**
+** An SDO timeout frees the scan slot and queues the node again, the step which failed is
+** repeated after an exponential backoff (200 ms, 400 ms, 800 ms, ..). After the last retry
+** the node is set to FAILED and is no longer queued, so a dead device can't block the scan
+** of other devices. A new boot-up message starts the sequence again.
+**
+** A node-ID used by two devices is set to QUARANTINED by quarantineNode(): the node is
+** removed from the queue and boot-up messages are ignored until releaseNode() is called.
+**
+** An optional bus load limit paces the start of new scans: a token bucket is refilled by
+** tick() with the bits available within the bus load budget, each scan start consumes the
+** estimated number of bits of a complete scan.
+*/
+class CoScanScheduler {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoScanScheduler();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  btVerifyV     - identity is cached and only needs to be verified
+   **
+   ** Queue a node for scanning after reception of a boot-up message. The call is ignored if
+   ** the node is already queued, scanned or quarantined.
+   */
+   void           addNode(uint8_t ubNodeIdV, bool btVerifyV = false);
+
+   uint8_t        activeCount(void) const       { return (ubActiveCntP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  ulDelayV      - delay in micro-seconds
+   **
+   ** Free the scan slot of an active node and hand it out again by nextNode() after the delay,
+   ** with its current state. The deferred node is not charged against the bus load budget.
+   */
+   void           deferNode(uint8_t ubNodeIdV, uint32_t ulDelayV);
+
+   bool           isActive(uint8_t ubNodeIdV) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     true if no node is queued or scanned
+   */
+   bool           isIdle(void) const            { return ((ubActiveCntP == 0) && clPendingP.isEmpty()); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     node-ID of the next node to scan, 0 if no scan may be started
+   **
+   ** The returned node is marked as active, its state (see state()) defines the SDO transfer
+   ** to start: eCO_SCAN_STATE_VERIFYING, eCO_SCAN_STATE_IDENTIFYING,
+   ** eCO_SCAN_STATE_CONFIG_HEARTBEAT or eCO_SCAN_STATE_CONFIG_PDO.
+   */
+   uint8_t        nextNode(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The identity of the node has been read, the node stays active for the heartbeat
+   ** configuration.
+   */
+   void           nodeIdentified(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The heartbeat of the node is configured, the node stays active for the configuration of
+   ** the PDO inhibit times.
+   */
+   void           nodeConfigPdo(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The configuration of the node has failed without a chance of a retry, the node is set to
+   ** FAILED. This frees one scan slot.
+   */
+   void           nodeFailed(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The node is configured, this frees one scan slot.
+   */
+   void           nodeOperational(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     true if the node is queued for a retry, false if the node has failed
+   **
+   ** An SDO transfer to the node timed out, this frees one scan slot.
+   */
+   bool           nodeTimeout(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  btMatchV      - serial number matches the cached entry
+   **
+   ** The cached identity has been checked. On a match the node continues with the heartbeat
+   ** configuration, otherwise the identity must be read. The node stays active in both cases.
+   */
+   void           nodeVerified(uint8_t ubNodeIdV, bool btMatchV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     true if the node has been queued
+   **
+   ** Queue an operational node for a new heartbeat configuration, e.g. after the heartbeat plan
+   ** has changed. Nodes in other states are configured with the new plan anyway.
+   */
+   bool           reconfigureNode(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** Stop the scan of a node-ID which is used by two devices. A running scan frees its slot,
+   ** the result of its SDO transfer is ignored.
+   */
+   void           quarantineNode(uint8_t ubNodeIdV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   **
+   ** The collision of a quarantined node is resolved, the node is set to IDLE and is scanned
+   ** after its next boot-up message.
+   */
+   void           releaseNode(uint8_t ubNodeIdV);
+
+   uint8_t        retryCount(uint8_t ubNodeIdV) const;
+
+   void           reset(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubPercentV    - bus load limit in percent, 0 disables the limit
+   ** \param[in]  ulBitrateV    - bitrate in bit/s
+   */
+   void           setBusLoadLimit(uint8_t ubPercentV, uint32_t ulBitrateV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubMaxParallelV - maximum number of concurrent scans, minimum value is 1
+   */
+   void           setMaxParallel(uint8_t ubMaxParallelV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubRetryMaxV   - number of retries after an SDO timeout
+   */
+   void           setRetryMax(uint8_t ubRetryMaxV)     { ubRetryMaxP = ubRetryMaxV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \return     scan state of the node, CoScanState_e
+   */
+   uint8_t        state(uint8_t ubNodeIdV) const;
+
+   static const char *  stateName(uint8_t ubStateV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     scheduler time in micro-seconds
+   */
+   uint64_t       time(void) const              { return (uqTimeP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulElapsedV    - time since the last call in micro-seconds
+   **
+   ** Advance the scheduler time and refill the bus load budget, the function is called with
+   ** each timer tick.
+   */
+   void           tick(uint32_t ulElapsedV);
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // scan data of one node
+   //
+   struct ScanNode_s {
+      uint8_t     ubState;       // current state, CoScanState_e
+      uint8_t     ubResume;      // state to resume after a retry
+      uint8_t     ubRetryCnt;    // number of retries
+      bool        btActive;      // SDO transfer is running
+      bool        btDeferred;    // queued by deferNode() or reconfigureNode()
+      uint64_t    uqNotBefore;   // earliest time of next attempt in micro-seconds
+   };
+
+   uint8_t           ubMaxParallelP;
+   uint8_t           ubActiveCntP;
+   uint8_t           ubRetryMaxP;
+   uint8_t           ubBusLoadLimitP;
+   uint32_t          ulBitrateP;
+
+   //-----------------------------------------------------------------------------------------
+   // bus load budget in bits, the budget is limited to one scan
+   //
+   uint32_t          ulBudgetP;
+
+   //-----------------------------------------------------------------------------------------
+   // scheduler time in micro-seconds, advanced by tick()
+   //
+   uint64_t          uqTimeP;
+
+   QList<uint8_t>    clPendingP;
+   ScanNode_s        atsNodeP[CO_SCAN_NODE_MAX];
+};
+
+
+#endif /*CO_SCAN_SCHEDULER_HPP_*/
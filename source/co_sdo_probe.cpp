@@ -0,0 +1,411 @@
+//====================================================================================================================//
+// File:          co_sdo_probe.cpp                                                                                    //
+// Description:   Expedited SDO transfers on a raw CAN socket                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_sdo_probe.hpp"
+
+#include "co_latency.hpp"
+
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  SDO_COB_ID_REQUEST         ((uint32_t)  0x600)
+#define  SDO_COB_ID_RESPONSE        ((uint32_t)  0x580)
+
+#define  SDO_CCS_DOWNLOAD_INIT      ((uint8_t)    0x20)        // client command: initiate download
+#define  SDO_SCS_DOWNLOAD_INIT      ((uint8_t)    0x60)        // server command: initiate download response
+#define  SDO_CCS_UPLOAD_INIT        ((uint8_t)    0x40)        // client command: initiate upload
+#define  SDO_SCS_UPLOAD_INIT        ((uint8_t)    0x40)        // server command: initiate upload response
+#define  SDO_CS_ABORT               ((uint8_t)    0x80)
+#define  SDO_CS_MASK                ((uint8_t)    0xE0)
+#define  SDO_FLAG_EXPEDITED         ((uint8_t)    0x02)
+#define  SDO_FLAG_SIZE              ((uint8_t)    0x01)
+
+#define  PROBE_TIMER_PERIOD         ((uint32_t)     10)        // timeout check in milli-seconds
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::CoSdoProbe()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSdoProbe::CoSdoProbe(QObject * pclParentV)
+   : QObject(pclParentV)
+{
+   slSocketP     = -1;
+   ulTimeoutP    = 200;
+   ubPendingCntP = 0;
+   pclNotifierP  = nullptr;
+   pclLatencyP   = nullptr;
+
+   memset(&atsTransferP[0], 0, sizeof(atsTransferP));
+
+   connect(&clTimerP, &QTimer::timeout, this, &CoSdoProbe::onTimerEvent);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::~CoSdoProbe()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSdoProbe::~CoSdoProbe()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::close()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSdoProbe::close(void)
+{
+   clTimerP.stop();
+
+   if (pclNotifierP != nullptr)
+   {
+      pclNotifierP->setEnabled(false);
+      delete pclNotifierP;
+      pclNotifierP = nullptr;
+   }
+
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+   }
+
+   memset(&atsTransferP[0], 0, sizeof(atsTransferP));
+   ubPendingCntP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::download()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoSdoProbe::download(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV,
+                          uint8_t ubSizeV)
+{
+   struct can_frame  tsFrameT;
+
+   if ((ubSizeV == 0) || (ubSizeV > 4))
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // expedited download with size indication, the number of unused bytes is given in bits 2..3
+   //
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_dlc = 8;
+   tsFrameT.data[0] = SDO_CCS_DOWNLOAD_INIT | SDO_FLAG_EXPEDITED | SDO_FLAG_SIZE | ((4 - ubSizeV) << 2);
+   tsFrameT.data[1] = (uint8_t) (uwIndexV);
+   tsFrameT.data[2] = (uint8_t) (uwIndexV >> 8);
+   tsFrameT.data[3] = ubSubIndexV;
+   for (uint8_t ubByteT = 0; ubByteT < ubSizeV; ubByteT++)
+   {
+      tsFrameT.data[4 + ubByteT] = (uint8_t) (ulValueV >> (ubByteT * 8));
+   }
+
+   return (send(tsFrameT, ubNodeIdV, true));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::onSocketEvent()                                                                                        //
+// evaluate SDO responses                                                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSdoProbe::onSocketEvent(void)
+{
+   struct can_frame  tsFrameT;
+   Transfer_s *      ptsTransferT;
+   uint8_t           ubNodeIdT;
+   uint16_t          uwIndexT;
+   uint32_t          ulValueT;
+
+   while (::read(slSocketP, &tsFrameT, sizeof(tsFrameT)) == (ssize_t) sizeof(tsFrameT))
+   {
+      ubNodeIdT = (uint8_t) (tsFrameT.can_id - SDO_COB_ID_RESPONSE);
+      if ((ubNodeIdT == 0) || (ubNodeIdT > CO_SDO_PROBE_NODE_MAX) || (tsFrameT.can_dlc != 8))
+      {
+         continue;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // responses to transfers of the CANopen master library are ignored
+      //
+      ptsTransferT = &atsTransferP[ubNodeIdT - 1];
+      uwIndexT   = (uint16_t) (tsFrameT.data[1] | (tsFrameT.data[2] << 8));
+      if ((ptsTransferT->btPending == false) || (uwIndexT != ptsTransferT->uwIndex) ||
+          (tsFrameT.data[3] != ptsTransferT->ubSubIndex))
+      {
+         continue;
+      }
+
+      ptsTransferT->btPending = false;
+      ubPendingCntP--;
+
+      if (pclLatencyP != nullptr)
+      {
+         pclLatencyP->record(CoCanTap::timeStamp() - ptsTransferT->uqSent);
+      }
+
+      ulValueT = (uint32_t) tsFrameT.data[4]         | ((uint32_t) tsFrameT.data[5] <<  8) |
+                 ((uint32_t) tsFrameT.data[6] << 16) | ((uint32_t) tsFrameT.data[7] << 24);
+
+      if (ptsTransferT->btDownload)
+      {
+         if (tsFrameT.data[0] == SDO_CS_ABORT)
+         {
+            emit downloadFailed(ubNodeIdT, uwIndexT, tsFrameT.data[3], ulValueT);
+         }
+         else if (tsFrameT.data[0] == SDO_SCS_DOWNLOAD_INIT)
+         {
+            emit downloadFinished(ubNodeIdT, uwIndexT, tsFrameT.data[3]);
+         }
+         else
+         {
+            emit downloadFailed(ubNodeIdT, uwIndexT, tsFrameT.data[3], CO_SDO_ABORT_PROTOCOL);
+         }
+      }
+      else if (tsFrameT.data[0] == SDO_CS_ABORT)
+      {
+         emit uploadFailed(ubNodeIdT, uwIndexT, tsFrameT.data[3], ulValueT);
+      }
+      else if (((tsFrameT.data[0] & SDO_CS_MASK) == SDO_SCS_UPLOAD_INIT) &&
+               ((tsFrameT.data[0] & SDO_FLAG_EXPEDITED) != 0))
+      {
+         //-----------------------------------------------------------------------------------
+         // mask unused bytes if the size is indicated
+         //
+         if ((tsFrameT.data[0] & SDO_FLAG_SIZE) != 0)
+         {
+            uint8_t ubUnusedT = (tsFrameT.data[0] >> 2) & 0x03;
+            if (ubUnusedT > 0)
+            {
+               ulValueT = ulValueT & (0xFFFFFFFF >> (ubUnusedT * 8));
+            }
+         }
+         emit uploadFinished(ubNodeIdT, uwIndexT, tsFrameT.data[3], ulValueT);
+      }
+      else
+      {
+         //-----------------------------------------------------------------------------------
+         // a segmented transfer is not supported by the probe
+         //
+         emit uploadFailed(ubNodeIdT, uwIndexT, tsFrameT.data[3], CO_SDO_ABORT_PROTOCOL);
+      }
+   }
+
+   if (ubPendingCntP == 0)
+   {
+      clTimerP.stop();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::onTimerEvent()                                                                                         //
+// check for response timeout                                                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSdoProbe::onTimerEvent(void)
+{
+   uint64_t uqTimeT = timeStamp();
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_SDO_PROBE_NODE_MAX; ubNodeIdT++)
+   {
+      Transfer_s * ptsTransferT = &atsTransferP[ubNodeIdT - 1];
+
+      if ((ptsTransferT->btPending) && (ptsTransferT->uqDeadline <= uqTimeT))
+      {
+         ptsTransferT->btPending = false;
+         ubPendingCntP--;
+         if (ptsTransferT->btDownload)
+         {
+            emit downloadFailed(ubNodeIdT, ptsTransferT->uwIndex, ptsTransferT->ubSubIndex, CO_SDO_ABORT_TIMEOUT);
+         }
+         else
+         {
+            emit uploadFailed(ubNodeIdT, ptsTransferT->uwIndex, ptsTransferT->ubSubIndex, CO_SDO_ABORT_TIMEOUT);
+         }
+      }
+   }
+
+   if (ubPendingCntP == 0)
+   {
+      clTimerP.stop();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::open()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoSdoProbe::open(const char * szInterfaceV)
+{
+   struct ifreq         tsIfReqT;
+   struct sockaddr_can  tsAddrT;
+   struct can_filter    tsFilterT;
+
+   close();
+
+   if ((szInterfaceV == nullptr) || (strlen(szInterfaceV) >= IFNAMSIZ))
+   {
+      return (false);
+   }
+
+   slSocketP = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   memset(&tsIfReqT, 0, sizeof(tsIfReqT));
+   strncpy(tsIfReqT.ifr_name, szInterfaceV, IFNAMSIZ - 1);
+   if (::ioctl(slSocketP, SIOCGIFINDEX, &tsIfReqT) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // receive SDO responses 581h .. 5FFh only
+   //
+   tsFilterT.can_id   = SDO_COB_ID_RESPONSE;
+   tsFilterT.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | 0x780;
+   setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_FILTER, &tsFilterT, sizeof(tsFilterT));
+
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.can_family  = AF_CAN;
+   tsAddrT.can_ifindex = tsIfReqT.ifr_ifindex;
+   if (::bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0)
+   {
+      close();
+      return (false);
+   }
+
+   pclNotifierP = new QSocketNotifier(slSocketP, QSocketNotifier::Read, this);
+   connect(pclNotifierP, &QSocketNotifier::activated, this, &CoSdoProbe::onSocketEvent);
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::send()                                                                                                 //
+// transmit an SDO request and start the response timeout                                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoSdoProbe::send(struct can_frame & tsFrameR, uint8_t ubNodeIdV, bool btDownloadV)
+{
+   Transfer_s *   ptsTransferT;
+
+   if ((slSocketP < 0) || (ubNodeIdV == 0) || (ubNodeIdV > CO_SDO_PROBE_NODE_MAX))
+   {
+      return (false);
+   }
+
+   ptsTransferT = &atsTransferP[ubNodeIdV - 1];
+   if (ptsTransferT->btPending)
+   {
+      return (false);
+   }
+
+   tsFrameR.can_id = SDO_COB_ID_REQUEST + ubNodeIdV;
+   if (::write(slSocketP, &tsFrameR, sizeof(tsFrameR)) != (ssize_t) sizeof(tsFrameR))
+   {
+      return (false);
+   }
+
+   ptsTransferT->btPending  = true;
+   ptsTransferT->btDownload = btDownloadV;
+   ptsTransferT->uwIndex    = (uint16_t) (tsFrameR.data[1] | (tsFrameR.data[2] << 8));
+   ptsTransferT->ubSubIndex = tsFrameR.data[3];
+   ptsTransferT->uqDeadline = timeStamp() + ulTimeoutP;
+   ptsTransferT->uqSent     = CoCanTap::timeStamp();
+   ubPendingCntP++;
+
+   if (clTimerP.isActive() == false)
+   {
+      clTimerP.start(PROBE_TIMER_PERIOD);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::timeStamp()                                                                                            //
+// monotonic time in milli-seconds                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoSdoProbe::timeStamp(void)
+{
+   struct timespec tsTimeT;
+
+   clock_gettime(CLOCK_MONOTONIC, &tsTimeT);
+   return (((uint64_t) tsTimeT.tv_sec * 1000) + ((uint64_t) tsTimeT.tv_nsec / 1000000));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSdoProbe::upload()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoSdoProbe::upload(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV)
+{
+   struct can_frame  tsFrameT;
+
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_dlc = 8;
+   tsFrameT.data[0] = SDO_CCS_UPLOAD_INIT;
+   tsFrameT.data[1] = (uint8_t) (uwIndexV);
+   tsFrameT.data[2] = (uint8_t) (uwIndexV >> 8);
+   tsFrameT.data[3] = ubSubIndexV;
+
+   return (send(tsFrameT, ubNodeIdV, false));
+}
@@ -0,0 +1,190 @@
+//====================================================================================================================//
+// File:          co_sdo_probe.hpp                                                                                    //
+// Description:   Expedited SDO transfers on a raw CAN socket                                                         //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_sdo_probe.hpp
+** \brief   Expedited SDO transfers on a raw CAN socket
+**
+*/
+#ifndef CO_SDO_PROBE_HPP_
+#define CO_SDO_PROBE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+
+#include <stdint.h>
+
+#include <linux/can.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SDO_PROBE_NODE_MAX      ((uint8_t)     127)        // highest node-ID
+
+#define  CO_SDO_ABORT_TIMEOUT       ((uint32_t) 0x05040000)    // SDO protocol timed out
+#define  CO_SDO_ABORT_PROTOCOL      ((uint32_t) 0x05040001)    // command specifier not valid
+
+
+class CoLatencyHistogram;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSdoProbe
+** \brief   Expedited SDO transfers on a raw CAN socket
+**
+** The probe reads and writes single objects of up to 4 bytes with an expedited SDO transfer.
+** It uses its own raw socket on the CAN interface and does not occupy the SDO client of the
+** CANopen master library. The socket only receives SDO responses (580h .. 5FFh). One transfer
+** per node can be pending, transfers to different nodes run in parallel.
+**
+** The probe must only be used for a node while the CANopen master library has no SDO transfer
+** running to the same node.
+*/
+class CoSdoProbe : public QObject {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSdoProbe(QObject * pclParentV = nullptr);
+
+   ~CoSdoProbe();
+
+   void           close(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uwIndexV      - object index
+   ** \param[in]  ubSubIndexV   - object sub-index
+   ** \param[in]  ulValueV      - object value
+   ** \param[in]  ubSizeV       - size of the object in bytes, 1 .. 4
+   ** \return     true if the request has been sent
+   **
+   ** The result is reported by the signals downloadFinished() or downloadFailed().
+   */
+   bool           download(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV,
+                           uint8_t ubSizeV);
+
+   bool           isOpen(void) const   { return (slSocketP >= 0); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szInterfaceV  - name of the CAN interface, e.g. "can1"
+   ** \return     true if the socket has been opened
+   */
+   bool           open(const char * szInterfaceV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclHistogramV - histogram for the round-trip time, nullptr to disable
+   **
+   ** The time from the transmission of a request until the reception of the matching response
+   ** is recorded in nano-seconds. Timed out transfers are not recorded.
+   */
+   void           setLatency(CoLatencyHistogram * pclHistogramV)   { pclLatencyP = pclHistogramV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTimeoutV    - response timeout in milli-seconds
+   */
+   void           setTimeout(uint32_t ulTimeoutV)   { ulTimeoutP = ulTimeoutV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID
+   ** \param[in]  uwIndexV      - object index
+   ** \param[in]  ubSubIndexV   - object sub-index
+   ** \return     true if the request has been sent
+   **
+   ** The result is reported by the signals uploadFinished() or uploadFailed().
+   */
+   bool           upload(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV);
+
+signals:
+   void           downloadFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV);
+
+   void           downloadFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV);
+
+   void           uploadFinished(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV);
+
+   void           uploadFailed(uint8_t ubNodeIdV, uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV);
+
+private slots:
+
+   void           onSocketEvent(void);
+
+   void           onTimerEvent(void);
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // pending transfer of one node
+   //
+   struct Transfer_s {
+      bool        btPending;
+      bool        btDownload;
+      uint16_t    uwIndex;
+      uint8_t     ubSubIndex;
+      uint64_t    uqDeadline;    // monotonic time in milli-seconds
+      uint64_t    uqSent;        // monotonic time of the request in nano-seconds
+   };
+
+   bool           send(struct can_frame & tsFrameR, uint8_t ubNodeIdV, bool btDownloadV);
+
+   static uint64_t   timeStamp(void);
+
+   int32_t           slSocketP;
+   uint32_t          ulTimeoutP;
+   uint8_t           ubPendingCntP;
+
+   QSocketNotifier * pclNotifierP;
+   QTimer            clTimerP;
+
+   CoLatencyHistogram * pclLatencyP;
+
+   Transfer_s        atsTransferP[CO_SDO_PROBE_NODE_MAX];
+};
+
+
+#endif /*CO_SDO_PROBE_HPP_*/
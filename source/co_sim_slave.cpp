@@ -0,0 +1,717 @@
+//====================================================================================================================//
+// File:          co_sim_slave.cpp                                                                                    //
+// Description:   Simulated CANopen slave                                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_sim_slave.hpp"
+
+#include <string.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  MS_TO_NS(ms)               ((uint64_t) (ms) * 1000000)
+
+#define  COB_ID_EMCY                ((uint32_t)  0x080)
+#define  COB_ID_TPDO1               ((uint32_t)  0x180)
+#define  COB_ID_SDO_TX              ((uint32_t)  0x580)
+#define  COB_ID_NMT_EC              ((uint32_t)  0x700)
+#define  COB_ID_LSS_SLAVE           ((uint32_t)  0x7E4)
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::CoSimSlave()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSimSlave::CoSimSlave()
+{
+   ubNodeIdP        = 0;
+   ptsConfigP       = nullptr;
+   pclTapP          = nullptr;
+
+   ubStateP         = eCO_SIM_STATE_BOOTUP;
+   ubErrorRegP      = 0;
+   uwHeartbeatP     = 0;
+   ulSerialP        = 0;
+
+   btLssConfigP     = false;
+   ubLssPosP        = 0;
+   ubLssSelectP     = 0;
+   ubPendingIdP     = CO_SIM_NODE_ID_NONE;
+
+   uqBootTimeP      = 0;
+   uqHeartbeatTimeP = 0;
+   uqEmcyTimeP      = 0;
+   uqPdoTimeP       = 0;
+
+   memset(&tsSdoResponseP, 0, sizeof(tsSdoResponseP));
+   uqSdoTimeP       = 0;
+   ulSdoOffsetP     = 0;
+   btSdoSegmentedP  = false;
+
+   ulEmcyCntP       = 0;
+   ulPdoCntP        = 0;
+   ulTxErrCntP      = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::init()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::init(uint8_t ubNodeIdV, const CoSimConfig_ts * ptsConfigV, CoCanTap * pclTapV, uint64_t uqTimeV)
+{
+   uint64_t uqDelayT = 0;
+
+   ubNodeIdP    = ubNodeIdV;
+   ubPendingIdP = ubNodeIdV;
+   ptsConfigP   = ptsConfigV;
+   pclTapP      = pclTapV;
+   ulSerialP    = ptsConfigP->ulSerialBase + ubNodeIdP;
+
+   //---------------------------------------------------------------------------------------------------
+   // The boot delay of each node is spread over the configured range. The value is derived
+   // from the node-ID, so a simulation run can be repeated with the same timing.
+   //
+   if (ptsConfigP->ulBootDelay > 0)
+   {
+      uqDelayT = MS_TO_NS(((uint32_t) ubNodeIdP * 2654435761UL) % (ptsConfigP->ulBootDelay + 1));
+   }
+
+   reset(uqTimeV, uqDelayT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::receiveLss()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::receiveLss(const struct can_frame & tsFrameR, uint64_t uqTimeV)
+{
+   uint8_t  aubDataT[8];
+   uint32_t aulIdentityT[4];
+   uint32_t ulIdNumberT;
+   uint32_t ulMaskT;
+   uint8_t  ubIdxT;
+   uint8_t  ubBitT;
+   uint8_t  ubSubT;
+   uint8_t  ubNextT;
+
+   if (tsFrameR.can_dlc != 8)
+   {
+      return;
+   }
+
+   memset(&aubDataT[0], 0, sizeof(aubDataT));
+   aubDataT[0] = tsFrameR.data[0];
+
+   aulIdentityT[0] = ptsConfigP->ulVendorId;
+   aulIdentityT[1] = ptsConfigP->ulProductCode;
+   aulIdentityT[2] = ptsConfigP->ulRevision;
+   aulIdentityT[3] = ulSerialP;
+
+   ulIdNumberT = (uint32_t) tsFrameR.data[1]         | ((uint32_t) tsFrameR.data[2] <<  8) |
+                 ((uint32_t) tsFrameR.data[3] << 16) | ((uint32_t) tsFrameR.data[4] << 24);
+
+   switch (tsFrameR.data[0])
+   {
+      //-------------------------------------------------------------------------------------------
+      // switch state global, an unconfigured slave with a valid pending node-ID boots
+      //
+      case 0x04:
+         if (tsFrameR.data[1] == 0x01)
+         {
+            btLssConfigP = true;
+         }
+         else if (btLssConfigP)
+         {
+            btLssConfigP = false;
+            if ((ubNodeIdP == CO_SIM_NODE_ID_NONE) && (ubPendingIdP != CO_SIM_NODE_ID_NONE))
+            {
+               ubNodeIdP = ubPendingIdP;
+               reset(uqTimeV, MS_TO_NS(1));
+            }
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // configure node-ID, 1 .. 127 or 255
+      //
+      case 0x11:
+         if (btLssConfigP)
+         {
+            if (((tsFrameR.data[1] >= 1) && (tsFrameR.data[1] <= 127)) ||
+                (tsFrameR.data[1] == CO_SIM_NODE_ID_NONE))
+            {
+               ubPendingIdP = tsFrameR.data[1];
+            }
+            else
+            {
+               aubDataT[1] = 0x01;
+            }
+            transmit(COB_ID_LSS_SLAVE, &aubDataT[0], 8);
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // store configuration, there is nothing to store in the simulation
+      //
+      case 0x17:
+         if (btLssConfigP)
+         {
+            transmit(COB_ID_LSS_SLAVE, &aubDataT[0], 8);
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // switch state selective, the four identity values are sent in sequence and a complete
+      // match selects the slave
+      //
+      case 0x40:
+      case 0x41:
+      case 0x42:
+      case 0x43:
+         ubIdxT = tsFrameR.data[0] - 0x40;
+         if (ubIdxT == 0)
+         {
+            ubLssSelectP = 0;
+         }
+         if ((ubIdxT != ubLssSelectP) || (ulIdNumberT != aulIdentityT[ubIdxT]))
+         {
+            ubLssSelectP = 0;
+            break;
+         }
+
+         ubLssSelectP++;
+         if (ubLssSelectP == 4)
+         {
+            ubLssSelectP = 0;
+            btLssConfigP = true;
+            aubDataT[0]  = 0x44;
+            transmit(COB_ID_LSS_SLAVE, &aubDataT[0], 8);
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // Fastscan, only unconfigured slaves in waiting state take part
+      //
+      case 0x51:
+         if ((ubNodeIdP != CO_SIM_NODE_ID_NONE) || btLssConfigP)
+         {
+            break;
+         }
+
+         ubBitT      = tsFrameR.data[5];
+         ubSubT      = tsFrameR.data[6];
+         ubNextT     = tsFrameR.data[7];
+
+         aubDataT[0] = 0x4F;
+         if (ubBitT == 0x80)
+         {
+            ubLssPosP = 0;
+            transmit(COB_ID_LSS_SLAVE, &aubDataT[0], 8);
+            break;
+         }
+
+         if ((ubBitT > 31) || (ubSubT > 3) || (ubNextT > 3) || (ubSubT != ubLssPosP))
+         {
+            break;
+         }
+
+         ulMaskT = 0xFFFFFFFF << ubBitT;
+         if (((ulIdNumberT ^ aulIdentityT[ubSubT]) & ulMaskT) != 0)
+         {
+            break;
+         }
+
+         //-----------------------------------------------------------------------------------
+         // a complete match of the last value selects the slave
+         //
+         if ((ubBitT == 0) && (ubNextT < ubSubT))
+         {
+            btLssConfigP = true;
+         }
+         ubLssPosP = ubNextT;
+         transmit(COB_ID_LSS_SLAVE, &aubDataT[0], 8);
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::receiveNmt()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::receiveNmt(uint8_t ubCommandV, uint64_t uqTimeV)
+{
+   //---------------------------------------------------------------------------------------------------
+   // NMT commands are ignored until the boot-up message has been sent
+   //
+   if (ubStateP == eCO_SIM_STATE_BOOTUP)
+   {
+      return;
+   }
+
+   switch (ubCommandV)
+   {
+      case 0x01:
+         ubStateP = eCO_SIM_STATE_OPERATIONAL;
+         if (ptsConfigP->ulPdoPeriod > 0)
+         {
+            uqPdoTimeP = uqTimeV + MS_TO_NS(ptsConfigP->ulPdoPeriod);
+         }
+         break;
+
+      case 0x02:
+         ubStateP = eCO_SIM_STATE_STOPPED;
+         break;
+
+      case 0x80:
+         ubStateP = eCO_SIM_STATE_PREOPERATIONAL;
+         break;
+
+      case 0x81:
+      case 0x82:
+         ubNodeIdP = ubPendingIdP;
+         reset(uqTimeV, MS_TO_NS(1));
+         break;
+
+      default:
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::receiveSdo()                                                                                           //
+// SDO server, the response is transmitted by tick() after the configured latency                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::receiveSdo(const struct can_frame & tsFrameR, uint64_t uqTimeV)
+{
+   uint16_t uwIndexT    = (uint16_t) tsFrameR.data[1] | ((uint16_t) tsFrameR.data[2] << 8);
+   uint8_t  ubSubIndexT = tsFrameR.data[3];
+   uint32_t ulValueT    = 0;
+   uint8_t  ubSizeT     = 0;
+   uint32_t ulNameLenT;
+
+   if ((ubStateP == eCO_SIM_STATE_BOOTUP) || (ubStateP == eCO_SIM_STATE_STOPPED) || (tsFrameR.can_dlc != 8))
+   {
+      return;
+   }
+
+   memset(&tsSdoResponseP, 0, sizeof(tsSdoResponseP));
+   tsSdoResponseP.can_id  = COB_ID_SDO_TX + ubNodeIdP;
+   tsSdoResponseP.can_dlc = 8;
+   memcpy(&tsSdoResponseP.data[1], &tsFrameR.data[1], 3);
+   uqSdoTimeP = uqTimeV + MS_TO_NS(ptsConfigP->ulSdoLatency);
+
+   ulNameLenT = (uint32_t) strlen(ptsConfigP->aszDeviceName);
+
+   switch (tsFrameR.data[0] & 0xE0)
+   {
+      //-------------------------------------------------------------------------------------------
+      // initiate upload
+      //
+      case 0x40:
+         btSdoSegmentedP = false;
+         switch (uwIndexT)
+         {
+            case 0x1000:
+               ulValueT = ptsConfigP->ulDeviceType;
+               ubSizeT  = 4;
+               break;
+
+            case 0x1001:
+               ulValueT = ubErrorRegP;
+               ubSizeT  = 1;
+               break;
+
+            case 0x1008:
+               if (ulNameLenT > 4)
+               {
+                  btSdoSegmentedP = true;
+                  ulSdoOffsetP    = 0;
+                  tsSdoResponseP.data[0] = 0x41;
+                  tsSdoResponseP.data[4] = (uint8_t) (ulNameLenT);
+                  tsSdoResponseP.data[5] = (uint8_t) (ulNameLenT >> 8);
+                  return;
+               }
+               memcpy(&ulValueT, &ptsConfigP->aszDeviceName[0], ulNameLenT);
+               ubSizeT = (ulNameLenT > 0) ? (uint8_t) ulNameLenT : 1;
+               break;
+
+            case 0x1017:
+               ulValueT = uwHeartbeatP;
+               ubSizeT  = 2;
+               break;
+
+            case 0x1018:
+               switch (ubSubIndexT)
+               {
+                  case 0:  ulValueT = 4;                                       ubSizeT = 1;   break;
+                  case 1:  ulValueT = ptsConfigP->ulVendorId;                  ubSizeT = 4;   break;
+                  case 2:  ulValueT = ptsConfigP->ulProductCode;               ubSizeT = 4;   break;
+                  case 3:  ulValueT = ptsConfigP->ulRevision;                  ubSizeT = 4;   break;
+                  case 4:  ulValueT = ulSerialP;                               ubSizeT = 4;   break;
+                  default:
+                     sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_NO_SUB);
+                     return;
+               }
+               break;
+
+            default:
+               sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_NO_OBJECT);
+               return;
+         }
+
+         if ((uwIndexT != 0x1018) && (ubSubIndexT != 0))
+         {
+            sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_NO_SUB);
+            return;
+         }
+
+         //-----------------------------------------------------------------------------------
+         // expedited response, size indicated
+         //
+         tsSdoResponseP.data[0] = (uint8_t) (0x43 | ((4 - ubSizeT) << 2));
+         tsSdoResponseP.data[4] = (uint8_t) (ulValueT);
+         tsSdoResponseP.data[5] = (uint8_t) (ulValueT >>  8);
+         tsSdoResponseP.data[6] = (uint8_t) (ulValueT >> 16);
+         tsSdoResponseP.data[7] = (uint8_t) (ulValueT >> 24);
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // upload segment
+      //
+      case 0x60:
+         if (btSdoSegmentedP == false)
+         {
+            sdoAbort(0, 0, CO_SIM_SDO_ABORT_CMD);
+            return;
+         }
+         sdoUploadSegment(tsFrameR.data[0] & 0x10);
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // initiate download, only expedited transfer to 1017h is supported
+      //
+      case 0x20:
+         btSdoSegmentedP = false;
+         if ((tsFrameR.data[0] & 0x02) == 0)
+         {
+            sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_CMD);
+            return;
+         }
+
+         if ((uwIndexT == 0x1017) && (ubSubIndexT == 0))
+         {
+            uwHeartbeatP = (uint16_t) tsFrameR.data[4] | ((uint16_t) tsFrameR.data[5] << 8);
+            uqHeartbeatTimeP = (uwHeartbeatP > 0) ? (uqTimeV + MS_TO_NS(uwHeartbeatP)) : 0;
+            tsSdoResponseP.data[0] = 0x60;
+         }
+         else if ((uwIndexT == 0x1000) || (uwIndexT == 0x1001) || (uwIndexT == 0x1008) || (uwIndexT == 0x1018))
+         {
+            sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_READ_ONLY);
+            return;
+         }
+         else
+         {
+            sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_NO_OBJECT);
+            return;
+         }
+         break;
+
+      //-------------------------------------------------------------------------------------------
+      // abort by client: no response
+      //
+      case 0x80:
+         btSdoSegmentedP = false;
+         uqSdoTimeP      = 0;
+         break;
+
+      default:
+         sdoAbort(uwIndexT, ubSubIndexT, CO_SIM_SDO_ABORT_CMD);
+         break;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::receiveSync()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::receiveSync(void)
+{
+   if ((ubStateP == eCO_SIM_STATE_OPERATIONAL) && ptsConfigP->btPdoEnable && (ptsConfigP->ulPdoPeriod == 0))
+   {
+      transmitPdo();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::reset()                                                                                                //
+// reset of the slave, the boot-up message is sent after the given delay                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::reset(uint64_t uqTimeV, uint64_t uqDelayV)
+{
+   ubStateP         = eCO_SIM_STATE_BOOTUP;
+   ubErrorRegP      = 0;
+   uwHeartbeatP     = ptsConfigP->uwHeartbeat;
+
+   uqBootTimeP      = uqTimeV + uqDelayV;
+   uqHeartbeatTimeP = 0;
+   uqEmcyTimeP      = 0;
+   uqPdoTimeP       = 0;
+
+   uqSdoTimeP       = 0;
+   btSdoSegmentedP  = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::sdoAbort()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::sdoAbort(uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV)
+{
+   btSdoSegmentedP = false;
+
+   tsSdoResponseP.data[0] = 0x80;
+   tsSdoResponseP.data[1] = (uint8_t) (uwIndexV);
+   tsSdoResponseP.data[2] = (uint8_t) (uwIndexV >> 8);
+   tsSdoResponseP.data[3] = ubSubIndexV;
+   tsSdoResponseP.data[4] = (uint8_t) (ulAbortV);
+   tsSdoResponseP.data[5] = (uint8_t) (ulAbortV >>  8);
+   tsSdoResponseP.data[6] = (uint8_t) (ulAbortV >> 16);
+   tsSdoResponseP.data[7] = (uint8_t) (ulAbortV >> 24);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::sdoUploadSegment()                                                                                     //
+// next segment of the device name (1008h)                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::sdoUploadSegment(uint8_t ubToggleV)
+{
+   uint32_t ulNameLenT = (uint32_t) strlen(ptsConfigP->aszDeviceName);
+   uint32_t ulSizeT;
+
+   //---------------------------------------------------------------------------------------------------
+   // the toggle bit of the first segment is 0 and alternates with each segment
+   //
+   if (ubToggleV != (((ulSdoOffsetP / 7) & 1) << 4))
+   {
+      sdoAbort(0x1008, 0, CO_SIM_SDO_ABORT_TOGGLE);
+      return;
+   }
+
+   ulSizeT = ulNameLenT - ulSdoOffsetP;
+   if (ulSizeT > 7)
+   {
+      ulSizeT = 7;
+   }
+
+   memset(&tsSdoResponseP.data[0], 0, sizeof(tsSdoResponseP.data));
+   tsSdoResponseP.data[0] = (uint8_t) (ubToggleV | ((7 - ulSizeT) << 1));
+   memcpy(&tsSdoResponseP.data[1], &ptsConfigP->aszDeviceName[ulSdoOffsetP], ulSizeT);
+   ulSdoOffsetP += ulSizeT;
+
+   if (ulSdoOffsetP >= ulNameLenT)
+   {
+      tsSdoResponseP.data[0] |= 0x01;
+      btSdoSegmentedP = false;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::setHeartbeat()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::setHeartbeat(uint16_t uwTimeV, uint64_t uqTimeV)
+{
+   //---------------------------------------------------------------------------------------------------
+   // before the boot-up message the heartbeat is scheduled by the boot-up
+   //
+   uwHeartbeatP     = uwTimeV;
+   uqHeartbeatTimeP = 0;
+   if ((uwHeartbeatP > 0) && (ubStateP != eCO_SIM_STATE_BOOTUP))
+   {
+      uqHeartbeatTimeP = uqTimeV + MS_TO_NS(uwHeartbeatP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::tick()                                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::tick(uint64_t uqTimeV)
+{
+   uint8_t aubDataT[8];
+
+   //---------------------------------------------------------------------------------------------------
+   // boot-up message, the slave enters pre-operational state
+   //
+   if (ubStateP == eCO_SIM_STATE_BOOTUP)
+   {
+      if ((uqTimeV < uqBootTimeP) || (ubNodeIdP == CO_SIM_NODE_ID_NONE))
+      {
+         return;
+      }
+
+      aubDataT[0] = eCO_SIM_STATE_BOOTUP;
+      transmit(COB_ID_NMT_EC + ubNodeIdP, &aubDataT[0], 1);
+      ubStateP = eCO_SIM_STATE_PREOPERATIONAL;
+
+      if (uwHeartbeatP > 0)
+      {
+         uqHeartbeatTimeP = uqTimeV + MS_TO_NS(uwHeartbeatP);
+      }
+      if (ptsConfigP->ulEmcyPeriod > 0)
+      {
+         uqEmcyTimeP = uqTimeV + MS_TO_NS(ptsConfigP->ulEmcyPeriod);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // delayed SDO response
+   //
+   if ((uqSdoTimeP != 0) && (uqTimeV >= uqSdoTimeP))
+   {
+      uqSdoTimeP = 0;
+      transmit(tsSdoResponseP.can_id, &tsSdoResponseP.data[0], 8);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // heartbeat producer
+   //
+   if ((uqHeartbeatTimeP != 0) && (uqTimeV >= uqHeartbeatTimeP))
+   {
+      aubDataT[0] = ubStateP;
+      transmit(COB_ID_NMT_EC + ubNodeIdP, &aubDataT[0], 1);
+      uqHeartbeatTimeP += MS_TO_NS(uwHeartbeatP);
+      if (uqHeartbeatTimeP <= uqTimeV)
+      {
+         uqHeartbeatTimeP = uqTimeV + MS_TO_NS(uwHeartbeatP);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // EMCY injection: generic error, the error register is set
+   //
+   if ((uqEmcyTimeP != 0) && (uqTimeV >= uqEmcyTimeP) && (ubStateP != eCO_SIM_STATE_STOPPED))
+   {
+      ulEmcyCntP++;
+      ubErrorRegP = 0x01;
+      aubDataT[0] = 0x00;
+      aubDataT[1] = 0x10;
+      aubDataT[2] = ubErrorRegP;
+      aubDataT[3] = (uint8_t) (ulEmcyCntP);
+      aubDataT[4] = (uint8_t) (ulEmcyCntP >>  8);
+      aubDataT[5] = (uint8_t) (ulEmcyCntP >> 16);
+      aubDataT[6] = (uint8_t) (ulEmcyCntP >> 24);
+      aubDataT[7] = 0x00;
+      transmit(COB_ID_EMCY + ubNodeIdP, &aubDataT[0], 8);
+      uqEmcyTimeP = uqTimeV + MS_TO_NS(ptsConfigP->ulEmcyPeriod);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // cyclic TPDO1
+   //
+   if ((uqPdoTimeP != 0) && (uqTimeV >= uqPdoTimeP))
+   {
+      if ((ubStateP == eCO_SIM_STATE_OPERATIONAL) && ptsConfigP->btPdoEnable)
+      {
+         transmitPdo();
+         uqPdoTimeP += MS_TO_NS(ptsConfigP->ulPdoPeriod);
+         if (uqPdoTimeP <= uqTimeV)
+         {
+            uqPdoTimeP = uqTimeV + MS_TO_NS(ptsConfigP->ulPdoPeriod);
+         }
+      }
+      else
+      {
+         uqPdoTimeP = 0;
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::transmit()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::transmit(uint32_t ulCanIdV, const uint8_t * pubDataV, uint8_t ubDlcV)
+{
+   struct can_frame tsFrameT;
+
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_id  = ulCanIdV;
+   tsFrameT.can_dlc = ubDlcV;
+   memcpy(&tsFrameT.data[0], pubDataV, ubDlcV);
+
+   if (pclTapP->write(tsFrameT) == false)
+   {
+      ulTxErrCntP++;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimSlave::transmitPdo()                                                                                          //
+// TPDO1: PDO counter and node-ID                                                                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimSlave::transmitPdo(void)
+{
+   uint8_t aubDataT[8];
+
+   ulPdoCntP++;
+   aubDataT[0] = (uint8_t) (ulPdoCntP);
+   aubDataT[1] = (uint8_t) (ulPdoCntP >>  8);
+   aubDataT[2] = (uint8_t) (ulPdoCntP >> 16);
+   aubDataT[3] = (uint8_t) (ulPdoCntP >> 24);
+   aubDataT[4] = ubNodeIdP;
+   aubDataT[5] = ubErrorRegP;
+   aubDataT[6] = 0;
+   aubDataT[7] = 0;
+   transmit(COB_ID_TPDO1 + ubNodeIdP, &aubDataT[0], 8);
+}
@@ -0,0 +1,253 @@
+//====================================================================================================================//
+// File:          co_sim_slave.hpp                                                                                    //
+// Description:   Simulated CANopen slave                                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_sim_slave.hpp
+** \brief   Simulated CANopen slave
+**
+*/
+#ifndef CO_SIM_SLAVE_HPP_
+#define CO_SIM_SLAVE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "co_can_tap.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SIM_NAME_SIZE           ((uint32_t)     32)
+#define  CO_SIM_NODE_ID_NONE        ((uint8_t)     255)        // node-ID of an unconfigured slave
+
+#define  CO_SIM_SDO_ABORT_CMD       ((uint32_t) 0x05040001)    // command specifier not valid
+#define  CO_SIM_SDO_ABORT_TOGGLE    ((uint32_t) 0x05030000)    // toggle bit not alternated
+#define  CO_SIM_SDO_ABORT_READ_ONLY ((uint32_t) 0x06010002)    // attempt to write a read only object
+#define  CO_SIM_SDO_ABORT_NO_OBJECT ((uint32_t) 0x06020000)    // object does not exist
+#define  CO_SIM_SDO_ABORT_NO_SUB    ((uint32_t) 0x06090011)    // sub-index does not exist
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoSimState_e
+** \brief   NMT state of a simulated slave
+**
+** The values are the states transmitted in the heartbeat message.
+*/
+enum CoSimState_e {
+   eCO_SIM_STATE_BOOTUP          = 0x00,
+   eCO_SIM_STATE_STOPPED         = 0x04,
+   eCO_SIM_STATE_OPERATIONAL     = 0x05,
+   eCO_SIM_STATE_PREOPERATIONAL  = 0x7F
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoSimConfig_s
+** \brief   Configuration of simulated slaves
+**
+** All times are given in milli-seconds, a value of 0 disables the function.
+*/
+typedef struct CoSimConfig_s {
+   uint32_t    ulDeviceType;                       // object 1000h
+   char        aszDeviceName[CO_SIM_NAME_SIZE];    // object 1008h
+   uint32_t    ulVendorId;                         // object 1018h:01h
+   uint32_t    ulProductCode;                      // object 1018h:02h
+   uint32_t    ulRevision;                         // object 1018h:03h
+   uint32_t    ulSerialBase;                       // object 1018h:04h = ulSerialBase + node-ID
+   uint32_t    ulBootDelay;                        // boot-up within 0 .. ulBootDelay
+   uint16_t    uwHeartbeat;                        // initial value of object 1017h
+   uint32_t    ulEmcyPeriod;                       // period of EMCY messages
+   uint32_t    ulSdoLatency;                       // delay of SDO responses
+   uint32_t    ulPdoPeriod;                        // period of TPDO1, 0: on each SYNC
+   bool        btPdoEnable;                        // transmit TPDO1 in operational state
+} CoSimConfig_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSimSlave
+** \brief   Simulated CANopen slave
+**
+** The slave implements the NMT slave state machine, boot-up and heartbeat producer, an SDO
+** server with a minimal object dictionary (1000h, 1001h, 1008h, 1017h, 1018h), EMCY
+** injection and a cyclic or synchronous TPDO1. All frames are transmitted through a
+** CoCanTap, timing is driven by tick().
+**
+** A slave initialised with node-ID CO_SIM_NODE_ID_NONE does not boot. It waits for an LSS
+** master, which finds it by Fastscan and assigns a node-ID.
+*/
+class CoSimSlave {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSimSlave();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNodeIdV     - node-ID of the slave
+   ** \param[in]  ptsConfigV    - configuration, must stay valid while the slave is used
+   ** \param[in]  pclTapV       - opened CAN tap for transmission
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** Power-on of the slave, the boot-up message is transmitted after the boot delay.
+   */
+   void           init(uint8_t ubNodeIdV, const CoSimConfig_ts * ptsConfigV, CoCanTap * pclTapV, uint64_t uqTimeV);
+
+   uint8_t        nodeId(void) const               { return (ubNodeIdP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubCommandV    - NMT command specifier
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   */
+   void           receiveNmt(uint8_t ubCommandV, uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsFrameR      - LSS request
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** LSS slave: Fastscan, switch state global, configure and store node-ID.
+   */
+   void           receiveLss(const struct can_frame & tsFrameR, uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsFrameR      - SDO request
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   */
+   void           receiveSdo(const struct can_frame & tsFrameR, uint64_t uqTimeV);
+
+   void           receiveSync(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulSerialV     - serial number (1018h:04h), must be called after init()
+   */
+   void           setSerialNumber(uint32_t ulSerialV)   { ulSerialP = ulSerialV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uwTimeV       - heartbeat producer time (1017h) in [ms], 0 stops the heartbeat
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** Local write of 1017h, e.g. to simulate a device which has lost its connection to the bus.
+   ** The next reset restores the configured heartbeat producer time.
+   */
+   void           setHeartbeat(uint16_t uwTimeV, uint64_t uqTimeV);
+
+   uint8_t        state(void) const                { return (ubStateP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** Transmit all messages which are due at \a uqTimeV.
+   */
+   void           tick(uint64_t uqTimeV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of frames which could not be transmitted
+   */
+   uint32_t       txErrors(void) const             { return (ulTxErrCntP); }
+
+private:
+
+   void           reset(uint64_t uqTimeV, uint64_t uqDelayV);
+
+   void           sdoAbort(uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulAbortV);
+
+   void           sdoUploadSegment(uint8_t ubToggleV);
+
+   void           transmit(uint32_t ulCanIdV, const uint8_t * pubDataV, uint8_t ubDlcV);
+
+   void           transmitPdo(void);
+
+   //-----------------------------------------------------------------------------------------
+   // configuration
+   //
+   uint8_t                    ubNodeIdP;
+   const CoSimConfig_ts *     ptsConfigP;
+   CoCanTap *                 pclTapP;
+
+   //-----------------------------------------------------------------------------------------
+   // NMT state and object dictionary
+   //
+   uint8_t                    ubStateP;
+   uint8_t                    ubErrorRegP;         // object 1001h
+   uint16_t                   uwHeartbeatP;        // object 1017h
+   uint32_t                   ulSerialP;           // object 1018h:04h
+
+   //-----------------------------------------------------------------------------------------
+   // LSS slave: the pending node-ID becomes active with the next reset, an unconfigured
+   // slave boots when it leaves the configuration state
+   //
+   bool                       btLssConfigP;
+   uint8_t                    ubLssPosP;           // identity value checked by the next Fastscan
+   uint8_t                    ubLssSelectP;        // identity values matched by switch state selective
+   uint8_t                    ubPendingIdP;
+
+   //-----------------------------------------------------------------------------------------
+   // time of the next message in nano-seconds, 0 if not scheduled
+   //
+   uint64_t                   uqBootTimeP;
+   uint64_t                   uqHeartbeatTimeP;
+   uint64_t                   uqEmcyTimeP;
+   uint64_t                   uqPdoTimeP;
+
+   //-----------------------------------------------------------------------------------------
+   // SDO server: the response is delayed by the configured latency, only one transfer is
+   // handled at a time
+   //
+   struct can_frame           tsSdoResponseP;
+   uint64_t                   uqSdoTimeP;
+   uint32_t                   ulSdoOffsetP;        // offset of segmented upload of 1008h
+   bool                       btSdoSegmentedP;
+
+   uint32_t                   ulEmcyCntP;
+   uint32_t                   ulPdoCntP;
+   uint32_t                   ulTxErrCntP;
+};
+
+
+#endif /*CO_SIM_SLAVE_HPP_*/
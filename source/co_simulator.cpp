@@ -0,0 +1,559 @@
+//====================================================================================================================//
+// File:          co_simulator.cpp                                                                                    //
+// Description:   CANopen slave simulator                                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+
+#include "co_simulator.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TIMER_CYCLE_PERIOD         ((uint32_t)      1)        // timer period in milli-seconds
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    parseValue(QCommandLineParser & clCmdParserR, const QCommandLineOption & clOptionR,
+                          uint32_t ulMaxV, uint32_t & ulValueR);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+   QCoreApplication clAppT(argc, argv);
+   QCoreApplication::setApplicationName("canopen-sim");
+   QCoreApplication::setApplicationVersion("1.0");
+
+   //---------------------------------------------------------------------------------------------------
+   // create the main class
+   //
+   CoSimulator clMainT;
+
+   QObject::connect(&clMainT, &CoSimulator::finished,          &clAppT,  &QCoreApplication::quit);
+
+   QTimer::singleShot(10, &clMainT, SLOT(runCmdParser()));
+
+   clAppT.exec();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// parseValue()                                                                                                       //
+// evaluate an integer option, decimal or hexadecimal with prefix 0x                                                  //
+//--------------------------------------------------------------------------------------------------------------------//
+static void parseValue(QCommandLineParser & clCmdParserR, const QCommandLineOption & clOptionR,
+                       uint32_t ulMaxV, uint32_t & ulValueR)
+{
+   bool     btOkT;
+   uint32_t ulValueT;
+
+   if (clCmdParserR.isSet(clOptionR))
+   {
+      ulValueT = clCmdParserR.value(clOptionR).toUInt(&btOkT, 0);
+      if ((btOkT == false) || (ulValueT > ulMaxV))
+      {
+         fprintf(stderr, "Error: value of option --%s out of range \n\n", qPrintable(clOptionR.names().at(0)));
+         clCmdParserR.showHelp(0);
+      }
+      ulValueR = ulValueT;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::CoSimulator()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSimulator::CoSimulator()
+{
+   ubNodeFirstP = 1;
+   ubNodeLastP     = CO_SIM_NODE_MAX;
+   ubUnconfiguredP = 0;
+   ubDuplicateP    = 0;
+   uwSlaveCntP     = 0;
+   pclCanRxP       = nullptr;
+
+   //---------------------------------------------------------------------------------------------------
+   // default identity and timing of the slaves
+   //
+   memset(&tsConfigP, 0, sizeof(tsConfigP));
+   tsConfigP.ulDeviceType  = 0x00000191;
+   strcpy(tsConfigP.aszDeviceName, "CANopen Sim");
+   tsConfigP.ulVendorId    = 0x0000000E;
+   tsConfigP.ulProductCode = 0x00001000;
+   tsConfigP.ulRevision    = 0x00010000;
+   tsConfigP.ulSerialBase  = 0x00100000;
+   tsConfigP.ulBootDelay   = 1000;
+   tsConfigP.btPdoEnable   = true;
+
+   connect(&clTimerP, &QTimer::timeout, this, &CoSimulator::onTimerEvent);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::~CoSimulator()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSimulator::~CoSimulator()
+{
+   stop();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::canFrameReceived()                                                                                    //
+// dispatch frames to the slaves                                                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   uint32_t ulCanIdT;
+   uint16_t uwSlaveT;
+
+   Q_UNUSED(btLocalV);
+
+   if ((tsFrameR.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0)
+   {
+      return;
+   }
+   ulCanIdT = tsFrameR.can_id;
+
+   //---------------------------------------------------------------------------------------------------
+   // NMT command: node-ID 0 addresses all slaves
+   //
+   if ((ulCanIdT == 0x000) && (tsFrameR.can_dlc == 2))
+   {
+      for (uwSlaveT = 0; uwSlaveT < uwSlaveCntP; uwSlaveT++)
+      {
+         if ((tsFrameR.data[1] == 0) || (tsFrameR.data[1] == aclSlaveP[uwSlaveT].nodeId()))
+         {
+            aclSlaveP[uwSlaveT].receiveNmt(tsFrameR.data[0], uqTimeStampV);
+         }
+      }
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // SYNC
+   //
+   if (ulCanIdT == 0x080)
+   {
+      for (uwSlaveT = 0; uwSlaveT < uwSlaveCntP; uwSlaveT++)
+      {
+         aclSlaveP[uwSlaveT].receiveSync();
+      }
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // LSS request
+   //
+   if (ulCanIdT == 0x7E5)
+   {
+      for (uwSlaveT = 0; uwSlaveT < uwSlaveCntP; uwSlaveT++)
+      {
+         aclSlaveP[uwSlaveT].receiveLss(tsFrameR, uqTimeStampV);
+      }
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // SDO request, the response is sent immediately if no latency is configured
+   //
+   if ((ulCanIdT > 0x600) && (ulCanIdT <= 0x67F))
+   {
+      for (uwSlaveT = 0; uwSlaveT < uwSlaveCntP; uwSlaveT++)
+      {
+         if (aclSlaveP[uwSlaveT].nodeId() == (uint8_t) (ulCanIdT - 0x600))
+         {
+            aclSlaveP[uwSlaveT].receiveSdo(tsFrameR, uqTimeStampV);
+            aclSlaveP[uwSlaveT].tick(uqTimeStampV);
+         }
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::onCanRxEvent()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::onCanRxEvent(void)
+{
+   clCanTapP.process();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::onTimerEvent()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::onTimerEvent(void)
+{
+   uint64_t uqTimeT = CoCanTap::timeStamp();
+
+   for (uint16_t uwSlaveT = 0; uwSlaveT < uwSlaveCntP; uwSlaveT++)
+   {
+      aclSlaveP[uwSlaveT].tick(uqTimeT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::runCmdParser()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::runCmdParser(void)
+{
+   QCommandLineParser   clCmdParserT;
+   uint32_t             ulValueT;
+
+   //---------------------------------------------------------------------------------------------------
+   // setup command line parser, options are added in alphabetical order
+   //
+   clCmdParserT.setApplicationDescription(tr("CANopen slave simulator"));
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -h, --help
+   //
+   clCmdParserT.addHelpOption();
+
+   //---------------------------------------------------------------------------------------------------
+   // argument <interface> is required
+   //
+   clCmdParserT.addPositionalArgument("interface",
+                                      tr("CAN interface, e.g. vcan0"));
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --boot-delay <ms>
+   //
+   QCommandLineOption clOptBootDelayT("boot-delay",
+         tr("Boot-up of the slaves within <ms> after start, default 1000"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptBootDelayT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --device-name <name>
+   //
+   QCommandLineOption clOptDeviceNameT("device-name",
+         tr("Device name (1008h), default \"CANopen Sim\""),
+         tr("name"));
+   clCmdParserT.addOption(clOptDeviceNameT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --device-type <value>
+   //
+   QCommandLineOption clOptDeviceTypeT("device-type",
+         tr("Device type (1000h), default 0x00000191"),
+         tr("value"));
+   clCmdParserT.addOption(clOptDeviceTypeT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --duplicate <id>
+   //
+   QCommandLineOption clOptDuplicateT("duplicate",
+         tr("Simulate a second slave with node-ID <id> and its own serial number"),
+         tr("id"));
+   clCmdParserT.addOption(clOptDuplicateT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --emcy-period <ms>
+   //
+   QCommandLineOption clOptEmcyPeriodT("emcy-period",
+         tr("Transmit an EMCY message every <ms>"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptEmcyPeriodT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --heartbeat <ms>
+   //
+   QCommandLineOption clOptHeartbeatT("heartbeat",
+         tr("Initial heartbeat producer time (1017h) in [ms]"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptHeartbeatT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --no-pdo
+   //
+   QCommandLineOption clOptNoPdoT("no-pdo",
+         tr("Do not transmit TPDO1 in operational state"));
+   clCmdParserT.addOption(clOptNoPdoT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --nodes <first-last>
+   //
+   QCommandLineOption clOptNodesT("nodes",
+         tr("Node-IDs of the slaves, default 1-127"),
+         tr("first-last"));
+   clCmdParserT.addOption(clOptNodesT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --pdo-period <ms>
+   //
+   QCommandLineOption clOptPdoPeriodT("pdo-period",
+         tr("Transmit TPDO1 every <ms>, default on each SYNC"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptPdoPeriodT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --product-code <value>
+   //
+   QCommandLineOption clOptProductCodeT("product-code",
+         tr("Product code (1018h:02h)"),
+         tr("value"));
+   clCmdParserT.addOption(clOptProductCodeT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --revision-number <value>
+   //
+   QCommandLineOption clOptRevisionT("revision-number",
+         tr("Revision number (1018h:03h)"),
+         tr("value"));
+   clCmdParserT.addOption(clOptRevisionT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --sdo-latency <ms>
+   //
+   QCommandLineOption clOptSdoLatencyT("sdo-latency",
+         tr("Delay of SDO responses in [ms]"),
+         tr("ms"));
+   clCmdParserT.addOption(clOptSdoLatencyT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --serial-number <value>
+   //
+   QCommandLineOption clOptSerialT("serial-number",
+         tr("Serial number (1018h:04h) of node 0, the node-ID is added"),
+         tr("value"));
+   clCmdParserT.addOption(clOptSerialT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --unconfigured <n>
+   //
+   QCommandLineOption clOptUnconfiguredT("unconfigured",
+         tr("Number of additional slaves without node-ID, commissioned by LSS"),
+         tr("n"));
+   clCmdParserT.addOption(clOptUnconfiguredT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: --vendor-id <value>
+   //
+   QCommandLineOption clOptVendorIdT("vendor-id",
+         tr("Vendor ID (1018h:01h)"),
+         tr("value"));
+   clCmdParserT.addOption(clOptVendorIdT);
+
+   //---------------------------------------------------------------------------------------------------
+   // command line option: -v, --version
+   //
+   clCmdParserT.addVersionOption();
+
+   //---------------------------------------------------------------------------------------------------
+   // Process the actual command line arguments given by the user
+   //
+   clCmdParserT.process(*QCoreApplication::instance());
+   const QStringList clArgsT = clCmdParserT.positionalArguments();
+   if (clArgsT.size() != 1)
+   {
+      fprintf(stdout, "%s\n", qPrintable(tr("Error: Must specify CAN interface.\n")));
+      clCmdParserT.showHelp(0);
+   }
+   clInterfaceP = clArgsT.at(0);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate range of node-IDs
+   //
+   if (clCmdParserT.isSet(clOptNodesT))
+   {
+      QString  clNodesT = clCmdParserT.value(clOptNodesT);
+      int32_t  slDashT  = clNodesT.indexOf('-');
+      bool     btFirstOkT;
+      bool     btLastOkT;
+      uint32_t ulFirstT;
+      uint32_t ulLastT;
+
+      if (slDashT < 0)
+      {
+         ulFirstT  = clNodesT.toUInt(&btFirstOkT, 10);
+         ulLastT   = ulFirstT;
+         btLastOkT = btFirstOkT;
+      }
+      else
+      {
+         ulFirstT = clNodesT.left(slDashT).toUInt(&btFirstOkT, 10);
+         ulLastT  = clNodesT.mid(slDashT + 1).toUInt(&btLastOkT, 10);
+      }
+
+      if ((btFirstOkT == false) || (btLastOkT == false) ||
+          (ulFirstT < 1) || (ulLastT > CO_SIM_NODE_MAX) || (ulFirstT > ulLastT))
+      {
+         fprintf(stderr, "%s \n\n", qPrintable(tr("Error: node-ID range out of range")));
+         clCmdParserT.showHelp(0);
+      }
+      ubNodeFirstP = (uint8_t) ulFirstT;
+      ubNodeLastP  = (uint8_t) ulLastT;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate identity
+   //
+   if (clCmdParserT.isSet(clOptDeviceNameT))
+   {
+      strncpy(tsConfigP.aszDeviceName, qPrintable(clCmdParserT.value(clOptDeviceNameT)), CO_SIM_NAME_SIZE - 1);
+      tsConfigP.aszDeviceName[CO_SIM_NAME_SIZE - 1] = 0;
+   }
+   parseValue(clCmdParserT, clOptDeviceTypeT,   0xFFFFFFFF, tsConfigP.ulDeviceType);
+   parseValue(clCmdParserT, clOptVendorIdT,     0xFFFFFFFF, tsConfigP.ulVendorId);
+   parseValue(clCmdParserT, clOptProductCodeT,  0xFFFFFFFF, tsConfigP.ulProductCode);
+   parseValue(clCmdParserT, clOptRevisionT,     0xFFFFFFFF, tsConfigP.ulRevision);
+   parseValue(clCmdParserT, clOptSerialT,       0xFFFFFF00, tsConfigP.ulSerialBase);
+
+   //---------------------------------------------------------------------------------------------------
+   // evaluate timing
+   //
+   parseValue(clCmdParserT, clOptBootDelayT,    600000,     tsConfigP.ulBootDelay);
+   parseValue(clCmdParserT, clOptEmcyPeriodT,   600000,     tsConfigP.ulEmcyPeriod);
+   parseValue(clCmdParserT, clOptSdoLatencyT,   10000,      tsConfigP.ulSdoLatency);
+   parseValue(clCmdParserT, clOptPdoPeriodT,    600000,     tsConfigP.ulPdoPeriod);
+
+   ulValueT = tsConfigP.uwHeartbeat;
+   parseValue(clCmdParserT, clOptHeartbeatT,    0xFFFF,     ulValueT);
+   tsConfigP.uwHeartbeat = (uint16_t) ulValueT;
+
+   tsConfigP.btPdoEnable = (clCmdParserT.isSet(clOptNoPdoT) == false);
+
+   ulValueT = 0;
+   parseValue(clCmdParserT, clOptUnconfiguredT, CO_SIM_NODE_MAX, ulValueT);
+   ubUnconfiguredP = (uint8_t) ulValueT;
+
+   ulValueT = 0;
+   parseValue(clCmdParserT, clOptDuplicateT,    CO_SIM_NODE_MAX, ulValueT);
+   ubDuplicateP = (uint8_t) ulValueT;
+
+   start();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::start()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::start(void)
+{
+   uint64_t uqTimeT;
+
+   if (clCanTapP.open(qPrintable(clInterfaceP)) == false)
+   {
+      fprintf(stderr, "Failed to open %s.\n", qPrintable(clInterfaceP));
+      emit finished();
+      return;
+   }
+   clCanTapP.addListener(this);
+
+   pclCanRxP = new QSocketNotifier(clCanTapP.handle(), QSocketNotifier::Read, this);
+   connect(pclCanRxP, &QSocketNotifier::activated, this, &CoSimulator::onCanRxEvent);
+
+   //---------------------------------------------------------------------------------------------------
+   // power-on of all slaves
+   //
+   uqTimeT     = CoCanTap::timeStamp();
+   uwSlaveCntP = 0;
+   for (uint8_t ubNodeIdT = ubNodeFirstP; ubNodeIdT <= ubNodeLastP; ubNodeIdT++)
+   {
+      aclSlaveP[uwSlaveCntP].init(ubNodeIdT, &tsConfigP, &clCanTapP, uqTimeT);
+      uwSlaveCntP++;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // unconfigured slaves get serial numbers above those of the configured slaves
+   //
+   for (uint8_t ubIdxT = 0; ubIdxT < ubUnconfiguredP; ubIdxT++)
+   {
+      aclSlaveP[uwSlaveCntP].init(CO_SIM_NODE_ID_NONE, &tsConfigP, &clCanTapP, uqTimeT);
+      aclSlaveP[uwSlaveCntP].setSerialNumber(tsConfigP.ulSerialBase + 0x80 + ubIdxT);
+      uwSlaveCntP++;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the duplicate slave shares the node-ID with another slave, its serial number follows those
+   // of the unconfigured slaves
+   //
+   if (ubDuplicateP > 0)
+   {
+      aclSlaveP[uwSlaveCntP].init(ubDuplicateP, &tsConfigP, &clCanTapP, uqTimeT);
+      aclSlaveP[uwSlaveCntP].setSerialNumber(tsConfigP.ulSerialBase + 0xFF);
+      uwSlaveCntP++;
+
+      fprintf(stdout, "Simulating a second node with node-ID %d.\n", ubDuplicateP);
+   }
+
+   fprintf(stdout, "Simulating nodes %d .. %d and %d unconfigured nodes on %s, use CTRL-C to quit.\n",
+           ubNodeFirstP, ubNodeLastP, ubUnconfiguredP, qPrintable(clInterfaceP));
+
+   clTimerP.setTimerType(Qt::PreciseTimer);
+   clTimerP.start(TIMER_CYCLE_PERIOD);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSimulator::stop()                                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSimulator::stop(void)
+{
+   clTimerP.stop();
+
+   if (pclCanRxP != nullptr)
+   {
+      pclCanRxP->setEnabled(false);
+      delete pclCanRxP;
+      pclCanRxP = nullptr;
+   }
+   clCanTapP.close();
+}
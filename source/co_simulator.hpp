@@ -0,0 +1,123 @@
+//====================================================================================================================//
+// File:          co_simulator.hpp                                                                                    //
+// Description:   CANopen slave simulator                                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_simulator.hpp
+** \brief   CANopen slave simulator
+**
+*/
+#ifndef CO_SIMULATOR_HPP_
+#define CO_SIMULATOR_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+
+#include "co_can_tap.hpp"
+#include "co_sim_slave.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SIM_NODE_MAX            ((uint8_t)     127)
+#define  CO_SIM_SLAVE_MAX           ((uint16_t)    255)        // configured, unconfigured and duplicate slaves
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSimulator
+** \brief   CANopen slave simulator
+**
+** The simulator runs up to 127 CANopen slaves on one CAN interface, usually a virtual CAN
+** interface. All slaves share one raw socket, received frames are dispatched to the slaves
+** by their CAN-ID. Additional slaves without node-ID can be commissioned by an LSS master.
+*/
+class CoSimulator : public QObject, public CoCanListener {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSimulator();
+
+   ~CoSimulator();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   void           start();
+
+   void           stop();
+
+public slots:
+
+   void           onCanRxEvent(void);
+
+   void           onTimerEvent(void);
+
+   void           runCmdParser(void);
+
+signals:
+
+   void           finished();
+
+private:
+
+   QString              clInterfaceP;
+   uint8_t              ubNodeFirstP;
+   uint8_t              ubNodeLastP;
+   uint8_t              ubUnconfiguredP;
+   uint8_t              ubDuplicateP;     // node-ID of a second slave, 0 for none
+
+   //-----------------------------------------------------------------------------------------
+   // the slaves of the node-ID range come first, followed by the unconfigured slaves and the
+   // duplicate slave
+   //
+   CoSimConfig_ts       tsConfigP;
+   uint16_t             uwSlaveCntP;
+   CoSimSlave           aclSlaveP[CO_SIM_SLAVE_MAX];
+
+   CoCanTap             clCanTapP;
+   QSocketNotifier *    pclCanRxP;
+   QTimer               clTimerP;         // tick of the slaves
+};
+
+
+#endif /*CO_SIMULATOR_HPP_*/
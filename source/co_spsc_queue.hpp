@@ -0,0 +1,133 @@
+//====================================================================================================================//
+// File:          co_spsc_queue.hpp                                                                                   //
+// Description:   Lock-free single producer / single consumer queue                                                   //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_spsc_queue.hpp
+** \brief   Lock-free single producer / single consumer queue
+**
+*/
+#ifndef CO_SPSC_QUEUE_HPP_
+#define CO_SPSC_QUEUE_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSpscQueue
+** \brief   Bounded lock-free queue for one producer and one consumer
+**
+** The queue holds up to \c SIZE - 1 elements, \c SIZE must be a power of two. The producer
+** only writes the tail index and the consumer only writes the head index, so no locking and
+** no system call is required on either side. Elements are copied, the queue never allocates
+** memory after construction.
+*/
+template <typename T, uint32_t SIZE>
+class CoSpscQueue {
+
+   static_assert((SIZE >= 2) && ((SIZE & (SIZE - 1)) == 0), "SIZE must be a power of two");
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSpscQueue() : ulHeadP(0), ulTailP(0)  { }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsElementR  - element to store
+   ** \return     false if the queue is full
+   **
+   ** This function must only be called by the producer.
+   */
+   bool push(const T & tsElementR)
+   {
+      uint32_t ulTailT = ulTailP.load(std::memory_order_relaxed);
+      uint32_t ulNextT = (ulTailT + 1) & (SIZE - 1);
+
+      if (ulNextT == ulHeadP.load(std::memory_order_acquire))
+      {
+         return (false);
+      }
+
+      atsElementP[ulTailT] = tsElementR;
+      ulTailP.store(ulNextT, std::memory_order_release);
+      return (true);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[out] tsElementR  - element read from the queue
+   ** \return     false if the queue is empty
+   **
+   ** This function must only be called by the consumer.
+   */
+   bool pop(T & tsElementR)
+   {
+      uint32_t ulHeadT = ulHeadP.load(std::memory_order_relaxed);
+
+      if (ulHeadT == ulTailP.load(std::memory_order_acquire))
+      {
+         return (false);
+      }
+
+      tsElementR = atsElementP[ulHeadT];
+      ulHeadP.store((ulHeadT + 1) & (SIZE - 1), std::memory_order_release);
+      return (true);
+   }
+
+   bool isEmpty(void) const
+   {
+      return (ulHeadP.load(std::memory_order_acquire) == ulTailP.load(std::memory_order_acquire));
+   }
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // head and tail are padded to separate cache lines to avoid false sharing between
+   // producer and consumer
+   //
+   std::atomic<uint32_t>   ulHeadP;
+   uint8_t                 aubPadHeadP[64 - sizeof(std::atomic<uint32_t>)];
+   std::atomic<uint32_t>   ulTailP;
+   uint8_t                 aubPadTailP[64 - sizeof(std::atomic<uint32_t>)];
+   T                       atsElementP[SIZE];
+};
+
+
+#endif /*CO_SPSC_QUEUE_HPP_*/
@@ -0,0 +1,393 @@
+//====================================================================================================================//
+// File:          co_stack_thread.cpp                                                                                 //
+// Description:   Real-time thread for the CANopen master stack                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_stack_thread.hpp"
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  EPOLL_ID_TIMER             ((uint32_t)      0)
+#define  EPOLL_ID_CAN_TAP           ((uint32_t)      1)
+#define  EPOLL_ID_STOP              ((uint32_t)      2)
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void       initMutex(pthread_mutex_t * ptsMutexV);
+
+static void       initSharedMutex(void);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Static variables                                                                                                   **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static pthread_once_t   tsSharedOnceS = PTHREAD_ONCE_INIT;
+static pthread_mutex_t  tsSharedMutexS;
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::CoStackThread()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoStackThread::CoStackThread(uint8_t ubNetV, uint32_t ulTickPeriodV, bool btSharedLockV, QObject * pclParentV)
+   : QThread(pclParentV)
+{
+   ubNetworkP     = ubNetV;
+   ulTickPeriodP  = ulTickPeriodV;
+   slCpuP         = -1;
+   slRtPriorityP  = 0;
+   pclCanTapP     = nullptr;
+   btCanProcessP  = true;
+   pclLatencyP    = nullptr;
+   uqArrivalP     = 0;
+
+   btNotifiedP       = false;
+   ulEventDropCntP   = 0;
+   ulTickOverrunCntP = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // The shared mutex lives as long as the process, it is never destroyed.
+   //
+   initMutex(&tsStackMutexP);
+   if (btSharedLockV)
+   {
+      pthread_once(&tsSharedOnceS, initSharedMutex);
+      ptsStackMutexP = &tsSharedMutexS;
+   }
+   else
+   {
+      ptsStackMutexP = &tsStackMutexP;
+   }
+
+   slEventFdP = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   slStopFdP  = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if ((slEventFdP < 0) || (slStopFdP < 0))
+   {
+      qFatal("Couldn't create eventfd for stack thread");
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::~CoStackThread()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoStackThread::~CoStackThread()
+{
+   stop();
+
+   ::close(slEventFdP);
+   ::close(slStopFdP);
+
+   pthread_mutex_destroy(&tsStackMutexP);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::clearNotification()                                                                                 //
+// acknowledge the eventfd before the queue is drained by the application                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoStackThread::clearNotification(void)
+{
+   uint64_t uqCounterT;
+
+   //---------------------------------------------------------------------------------------------------
+   // The eventfd is read before the flag is cleared. An event posted in between finds the flag
+   // still set and does not write the eventfd, it is fetched by the following queue drain.
+   // Clearing the flag first would let the read consume the write of such an event and leave
+   // the flag set without a pending wake-up. The exchange synchronises with the producer which
+   // has set the flag, so its event is visible to the drain.
+   //
+   if (::read(slEventFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+   {
+      // nothing pending, avoid compiler warning
+   }
+   btNotifiedP.exchange(false, std::memory_order_acq_rel);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::fetchEvent()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoStackThread::fetchEvent(CoStackEvent_ts & tsEventR)
+{
+   return (clEventQueueP.pop(tsEventR));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::postEvent()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoStackThread::postEvent(const CoStackEvent_ts & tsEventR)
+{
+   CoStackEvent_ts   tsEventT   = tsEventR;
+   uint64_t          uqCounterT = 1;
+
+   tsEventT.uqTimeStamp = (uqArrivalP != 0) ? uqArrivalP : CoCanTap::timeStamp();
+
+   if (clEventQueueP.push(tsEventT) == false)
+   {
+      ulEventDropCntP.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // only the first event after a wake-up requires a system call
+   //
+   if (btNotifiedP.exchange(true, std::memory_order_acq_rel) == false)
+   {
+      if (::write(slEventFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+      {
+         // counter overflow is not possible here, avoid compiler warning
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::recordLatency()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoStackThread::recordLatency(uint8_t ubPathV, uint64_t uqStartV)
+{
+   if (pclLatencyP != nullptr)
+   {
+      pclLatencyP->record(ubPathV, CoCanTap::timeStamp() - uqStartV);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::run()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoStackThread::run()
+{
+   struct epoll_event   atsEventT[3];
+   struct epoll_event   tsEpollT;
+   struct itimerspec    tsTimerSpecT;
+   int32_t              slEpollFdT;
+   int32_t              slTimerFdT;
+   int32_t              slEventCntT;
+   uint64_t             uqExpireCntT;
+   uint64_t             uqStartT;
+   uint64_t             uqArrivalT;
+   bool                 btRunT = true;
+
+   //---------------------------------------------------------------------------------------------------
+   // bind the thread to a CPU
+   //
+   if (slCpuP >= 0)
+   {
+      cpu_set_t tsCpuSetT;
+      CPU_ZERO(&tsCpuSetT);
+      CPU_SET(slCpuP, &tsCpuSetT);
+      if (pthread_setaffinity_np(pthread_self(), sizeof(tsCpuSetT), &tsCpuSetT) != 0)
+      {
+         fprintf(stderr, "Stack thread: failed to set CPU affinity to CPU %d\n", slCpuP);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // set real-time priority, this requires CAP_SYS_NICE
+   //
+   if (slRtPriorityP > 0)
+   {
+      struct sched_param tsSchedParamT;
+      memset(&tsSchedParamT, 0, sizeof(tsSchedParamT));
+      tsSchedParamT.sched_priority = slRtPriorityP;
+      if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &tsSchedParamT) != 0)
+      {
+         fprintf(stderr, "Stack thread: failed to set SCHED_FIFO priority %d\n", slRtPriorityP);
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // setup the periodic tick
+   //
+   slTimerFdT = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   slEpollFdT = ::epoll_create1(EPOLL_CLOEXEC);
+   if ((slTimerFdT < 0) || (slEpollFdT < 0))
+   {
+      qFatal("Stack thread: couldn't create timerfd / epoll");
+   }
+
+   tsTimerSpecT.it_interval.tv_sec  = ulTickPeriodP / 1000000;
+   tsTimerSpecT.it_interval.tv_nsec = (ulTickPeriodP % 1000000) * 1000;
+   tsTimerSpecT.it_value            = tsTimerSpecT.it_interval;
+   ::timerfd_settime(slTimerFdT, 0, &tsTimerSpecT, nullptr);
+
+   memset(&tsEpollT, 0, sizeof(tsEpollT));
+   tsEpollT.events   = EPOLLIN;
+   tsEpollT.data.u32 = EPOLL_ID_TIMER;
+   ::epoll_ctl(slEpollFdT, EPOLL_CTL_ADD, slTimerFdT, &tsEpollT);
+
+   tsEpollT.data.u32 = EPOLL_ID_STOP;
+   ::epoll_ctl(slEpollFdT, EPOLL_CTL_ADD, slStopFdP, &tsEpollT);
+
+   if ((pclCanTapP != nullptr) && (pclCanTapP->isOpen()))
+   {
+      tsEpollT.data.u32 = EPOLL_ID_CAN_TAP;
+      ::epoll_ctl(slEpollFdT, EPOLL_CTL_ADD, pclCanTapP->handle(), &tsEpollT);
+   }
+
+   while (btRunT)
+   {
+      slEventCntT = ::epoll_wait(slEpollFdT, &atsEventT[0], 3, -1);
+
+      for (int32_t slIdxT = 0; slIdxT < slEventCntT; slIdxT++)
+      {
+         switch (atsEventT[slIdxT].data.u32)
+         {
+            //-----------------------------------------------------------------------------------
+            // timer tick: more than one expiration means the thread has missed a tick, the
+            // stack timer is advanced for each expiration
+            //
+            case EPOLL_ID_TIMER:
+               if (::read(slTimerFdT, &uqExpireCntT, sizeof(uqExpireCntT)) == sizeof(uqExpireCntT))
+               {
+                  if (uqExpireCntT > 1)
+                  {
+                     ulTickOverrunCntP.fetch_add((uint32_t) (uqExpireCntT - 1), std::memory_order_relaxed);
+                  }
+
+                  lock();
+                  uqStartT = CoCanTap::timeStamp();
+                  ComMgrProcess(ubNetworkP);
+                  recordLatency(eCO_LATENCY_MGR_PROCESS, uqStartT);
+                  while (uqExpireCntT > 0)
+                  {
+                     uqStartT = CoCanTap::timeStamp();
+                     ComMgrNetTimerEvent(ubNetworkP);
+                     recordLatency(eCO_LATENCY_NET_TIMER_EVENT, uqStartT);
+                     uqExpireCntT--;
+                  }
+                  unlock();
+               }
+               break;
+
+            //-----------------------------------------------------------------------------------
+            // CAN frames pending
+            //
+            case EPOLL_ID_CAN_TAP:
+               uqArrivalT = CoCanTap::timeStamp();
+               if ((pclCanTapP->process() > 0) && btCanProcessP)
+               {
+                  lock();
+                  uqArrivalP = uqArrivalT;
+                  uqStartT   = CoCanTap::timeStamp();
+                  ComMgrProcess(ubNetworkP);
+                  recordLatency(eCO_LATENCY_MGR_PROCESS, uqStartT);
+                  uqArrivalP = 0;
+                  unlock();
+               }
+               break;
+
+            case EPOLL_ID_STOP:
+               btRunT = false;
+               break;
+
+            default:
+               break;
+         }
+      }
+   }
+
+   ::close(slTimerFdT);
+   ::close(slEpollFdT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoStackThread::stop()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoStackThread::stop(void)
+{
+   uint64_t uqCounterT = 1;
+
+   if (isRunning())
+   {
+      if (::write(slStopFdP, &uqCounterT, sizeof(uqCounterT)) < 0)
+      {
+         // avoid compiler warning
+      }
+      wait();
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// initMutex()                                                                                                        //
+// initialise a stack mutex with priority inheritance                                                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+static void initMutex(pthread_mutex_t * ptsMutexV)
+{
+   pthread_mutexattr_t  tsMutexAttrT;
+
+   pthread_mutexattr_init(&tsMutexAttrT);
+   pthread_mutexattr_setprotocol(&tsMutexAttrT, PTHREAD_PRIO_INHERIT);
+   pthread_mutex_init(ptsMutexV, &tsMutexAttrT);
+   pthread_mutexattr_destroy(&tsMutexAttrT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// initSharedMutex()                                                                                                  //
+// initialise the stack mutex shared by all networks, called once                                                     //
+//--------------------------------------------------------------------------------------------------------------------//
+static void initSharedMutex(void)
+{
+   initMutex(&tsSharedMutexS);
+}
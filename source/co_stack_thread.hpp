@@ -0,0 +1,288 @@
+//====================================================================================================================//
+// File:          co_stack_thread.hpp                                                                                 //
+// Description:   Real-time thread for the CANopen master stack                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_stack_thread.hpp
+** \brief   Real-time thread for the CANopen master stack
+**
+*/
+#ifndef CO_STACK_THREAD_HPP_
+#define CO_STACK_THREAD_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <QtCore/QThread>
+
+#include <atomic>
+
+#include <pthread.h>
+
+#include "canopen_master.h"
+
+#include "co_can_tap.hpp"
+#include "co_latency.hpp"
+#include "co_spsc_queue.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_STACK_EVENT_QUEUE_SIZE  ((uint32_t)   1024)       // number of entries in event queue, power of two
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoStackEvent_e
+** \brief   Type of event passed from the stack thread to the application
+**
+** Each value corresponds to a signal of the class QCoEvent.
+*/
+enum CoStackEvent_e {
+   eCO_STACK_EVENT_EMCY_RECEIVE = 0,
+   eCO_STACK_EVENT_LSS_RECEIVE,
+   eCO_STACK_EVENT_MGR_BUS,
+   eCO_STACK_EVENT_NMT_HEARTBEAT,
+   eCO_STACK_EVENT_NMT_ID_COLLISION,
+   eCO_STACK_EVENT_NMT_MASTER_DETECTION,
+   eCO_STACK_EVENT_NMT_STATE_CHANGE,
+   eCO_STACK_EVENT_PDO_RECEIVE,
+   eCO_STACK_EVENT_PDO_TIMEOUT,
+   eCO_STACK_EVENT_SDO_OBJECT_READY,
+   eCO_STACK_EVENT_SDO_TIMEOUT
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoStackEvent_s
+** \brief   Event record passed from the stack thread to the application
+**
+** Data which is only valid inside the callback of the CANopen master library (EMCY data,
+** CoObject_ts, CpState_ts) is copied into the record on the stack thread. The time stamp is the
+** reception time of the frames processed when the event was raised, or the time of posting if
+** the event was raised by the stack timer.
+*/
+typedef struct CoStackEvent_s {
+   uint8_t     ubType;           // event type, CoStackEvent_e
+   uint8_t     ubNet;            // CANopen network
+   uint8_t     ubNodeId;         // node-ID
+   uint8_t     ubValue;          // NMT state, detection result, LSS protocol
+   uint16_t    uwIndex;          // object index or PDO number
+   uint8_t     ubSubIndex;       // object sub-index
+   uint8_t     aubData[8];       // EMCY data
+   uint32_t    ulCount;          // EMCY messages suppressed by the rate limit before this one
+   CoObject_ts tsCoObj;          // copy of SDO object
+   CpState_ts  tsBusState;       // copy of bus state
+   uint64_t    uqTimeStamp;      // monotonic time stamp in nano-seconds
+} CoStackEvent_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoStackThread
+** \brief   Thread running the CANopen master stack
+**
+** The thread calls ComMgrNetTimerEvent() from a timerfd tick and ComMgrProcess() on each tick
+** and, if a CAN tap is assigned, on each frame reception. The thread can run with SCHED_FIFO
+** priority and can be bound to a single CPU.
+**
+** Events of the stack are passed to the application through a lock-free queue, the application
+** is woken up through an eventfd (see eventHandle()). All calls of the CANopen master API from
+** other threads must be protected by a CoStackLocker.
+**
+** By default the stack threads of all networks share one stack lock, because the CANopen master
+** library is not known to be re-entrant across networks. A thread with its own lock runs its
+** network in parallel to the others, this requires a library which keeps the networks separate.
+*/
+class CoStackThread : public QThread {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubNetV        - CANopen network
+   ** \param[in]  ulTickPeriodV - tick period in micro-seconds
+   ** \param[in]  btSharedLockV - use the stack lock shared by all networks, false for an own lock
+   */
+   CoStackThread(uint8_t ubNetV, uint32_t ulTickPeriodV, bool btSharedLockV = true,
+                 QObject * pclParentV = nullptr);
+
+   ~CoStackThread();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclCanTapV    - opened CAN tap, nullptr for timer processing only
+   ** \param[in]  btProcessV    - call ComMgrProcess() on frame reception
+   **
+   ** The tap is drained inside the stack thread, its listeners are called from the stack thread.
+   ** If \a btProcessV is true frames received by the tap trigger ComMgrProcess().
+   */
+   void           setCanTap(CoCanTap * pclCanTapV, bool btProcessV = true)
+                  { pclCanTapP = pclCanTapV; btCanProcessP = btProcessV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  slCpuV        - CPU the thread is bound to, -1 for no affinity
+   */
+   void           setCpu(int32_t slCpuV)                 { slCpuP = slCpuV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclLatencyV   - histograms for the execution time of the stack functions
+   */
+   void           setLatency(CoLatency * pclLatencyV)    { pclLatencyP = pclLatencyV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  slPriorityV   - SCHED_FIFO priority (1 .. 99), 0 for normal scheduling
+   */
+   void           setRtPriority(int32_t slPriorityV)     { slRtPriorityP = slPriorityV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     eventfd which becomes readable when events are pending
+   */
+   int32_t        eventHandle(void) const                { return (slEventFdP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[out] tsEventR      - event record
+   ** \return     false if no event is pending
+   **
+   ** The function must only be called by the application thread.
+   */
+   bool           fetchEvent(CoStackEvent_ts & tsEventR);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsEventR      - event record
+   **
+   ** Store an event for the application thread. The function is called by the signal handlers of
+   ** QCoEvent, which run while the stack lock is held. This serialises the producers, so the
+   ** single producer requirement of the queue is fulfilled. The time stamp of the record is set
+   ** by this function.
+   */
+   void           postEvent(const CoStackEvent_ts & tsEventR);
+
+   void           clearNotification(void);
+
+   uint32_t       droppedEvents(void) const     { return (ulEventDropCntP.load(std::memory_order_relaxed)); }
+
+   uint32_t       tickOverruns(void) const      { return (ulTickOverrunCntP.load(std::memory_order_relaxed)); }
+
+   void           lock(void)                    { pthread_mutex_lock(ptsStackMutexP);   }
+
+   void           unlock(void)                  { pthread_mutex_unlock(ptsStackMutexP); }
+
+   void           stop(void);
+
+protected:
+
+   void           run() override;
+
+private:
+
+   void           recordLatency(uint8_t ubPathV, uint64_t uqStartV);
+
+   uint8_t                 ubNetworkP;
+   uint32_t                ulTickPeriodP;
+   int32_t                 slCpuP;
+   int32_t                 slRtPriorityP;
+
+   CoCanTap *              pclCanTapP;
+   bool                    btCanProcessP;
+
+   //-----------------------------------------------------------------------------------------
+   // The arrival time is the reception time of the frames passed to ComMgrProcess(), it is
+   // only valid while the stack lock is held.
+   //
+   CoLatency *             pclLatencyP;
+   uint64_t                uqArrivalP;
+
+   //-----------------------------------------------------------------------------------------
+   // The stack mutex uses priority inheritance, so a low priority thread holding the lock
+   // can't block the stack thread for longer than its own critical section. The pointer
+   // refers to the shared stack mutex or to the own mutex of the thread.
+   //
+   pthread_mutex_t         tsStackMutexP;
+   pthread_mutex_t *       ptsStackMutexP;
+
+   int32_t                 slEventFdP;          // wake-up of application thread
+   int32_t                 slStopFdP;           // wake-up of stack thread for termination
+
+   std::atomic<bool>       btNotifiedP;
+   std::atomic<uint32_t>   ulEventDropCntP;
+   std::atomic<uint32_t>   ulTickOverrunCntP;
+
+   CoSpscQueue<CoStackEvent_ts, CO_STACK_EVENT_QUEUE_SIZE> clEventQueueP;
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoStackLocker
+** \brief   Scoped lock of the CANopen master stack
+**
+** The locker does nothing if no stack thread is running.
+*/
+class CoStackLocker {
+
+public:
+   CoStackLocker(CoStackThread * pclThreadV) : pclThreadP(pclThreadV)
+   {
+      if (pclThreadP != nullptr)
+      {
+         pclThreadP->lock();
+      }
+   }
+
+   ~CoStackLocker()
+   {
+      if (pclThreadP != nullptr)
+      {
+         pclThreadP->unlock();
+      }
+   }
+
+private:
+   CoStackThread *   pclThreadP;
+};
+
+
+#endif /*CO_STACK_THREAD_HPP_*/
@@ -0,0 +1,412 @@
+//====================================================================================================================//
+// File:          co_supervisor.cpp                                                                                   //
+// Description:   Heartbeat and PDO deadline supervision                                                              //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_supervisor.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  FUNCTION_HEARTBEAT         ((uint32_t)     14)        // function code of COB-ID 700h
+#define  FUNCTION_TPDO1             ((uint32_t)      3)        // function code of COB-ID 180h
+#define  FUNCTION_TPDO4             ((uint32_t)      9)        // function code of COB-ID 480h
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::CoSupervisor()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSupervisor::CoSupervisor()
+{
+   pclLoggerP     = nullptr;
+   ubNetworkP     = 0;
+   ulTickPeriodP  = 10000;
+   btStartedP     = false;
+
+   ulMissCntP.store(0);
+   ulNearMissCntP.store(0);
+
+   for (uint8_t ubTypeT = 0; ubTypeT < CO_SUPERVISOR_TYPE_MAX; ubTypeT++)
+   {
+      aulTimeoutP[ubTypeT].store(0);
+   }
+
+   for (uint32_t ulEntryT = 0; ulEntryT < CO_SUPERVISOR_ENTRY_MAX; ulEntryT++)
+   {
+      Entry_s & tsEntryR = atsEntryP[ulEntryT];
+
+      CoTimingWheel::init(tsEntryR.tsTimer, ulEntryT);
+      tsEntryR.btMissed = false;
+      tsEntryR.uqLastSeen.store(0);
+      tsEntryR.ulCount.store(0);
+      tsEntryR.ulIntervalMin.store(UINT32_MAX);
+      tsEntryR.ulIntervalMax.store(0);
+      tsEntryR.uqIntervalSum.store(0);
+      tsEntryR.ulMissCount.store(0);
+      tsEntryR.ulNearMissCount.store(0);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::canFrameReceived()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   uint32_t ulEntryT;
+   uint64_t uqLastT;
+   uint32_t ulIntervalT;
+   uint32_t ulTimeoutT;
+
+   if (btLocalV || ((tsFrameR.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0))
+   {
+      return;
+   }
+
+   ulEntryT = entryIndex(tsFrameR.can_id & CAN_SFF_MASK);
+   if (ulEntryT >= CO_SUPERVISOR_ENTRY_MAX)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The boot-up message is not a heartbeat: the heartbeat producer of the device is
+   // configured by the device scan afterwards.
+   //
+   if ((ulEntryT < CO_SUPERVISOR_NODE_MAX) && ((tsFrameR.can_dlc == 0) || (tsFrameR.data[0] == 0)))
+   {
+      return;
+   }
+
+   Entry_s & tsEntryR = atsEntryP[ulEntryT];
+   ulTimeoutT = timeout(ulEntryT);
+
+   uqLastT = tsEntryR.uqLastSeen.load(std::memory_order_relaxed);
+   tsEntryR.uqLastSeen.store(uqTimeStampV, std::memory_order_release);
+
+   //---------------------------------------------------------------------------------------------------
+   // the deadline timer of the entry is started by tick() after the first frame
+   //
+   if (uqLastT == 0)
+   {
+      if (ulTimeoutT != 0)
+      {
+         clFirstFrameP.push((uint16_t) ulEntryT);
+      }
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // frames read in one batch of the tap have the same time stamp
+   //
+   if (uqTimeStampV <= uqLastT)
+   {
+      return;
+   }
+
+   if ((uqTimeStampV - uqLastT) >= ((uint64_t) UINT32_MAX * 1000))
+   {
+      ulIntervalT = UINT32_MAX;
+   }
+   else
+   {
+      ulIntervalT = (uint32_t) ((uqTimeStampV - uqLastT) / 1000);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the tap thread is the only writer of the statistics
+   //
+   tsEntryR.ulCount.store(tsEntryR.ulCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   tsEntryR.uqIntervalSum.store(tsEntryR.uqIntervalSum.load(std::memory_order_relaxed) + ulIntervalT,
+                                std::memory_order_relaxed);
+   if (ulIntervalT < tsEntryR.ulIntervalMin.load(std::memory_order_relaxed))
+   {
+      tsEntryR.ulIntervalMin.store(ulIntervalT, std::memory_order_relaxed);
+   }
+   if (ulIntervalT > tsEntryR.ulIntervalMax.load(std::memory_order_relaxed))
+   {
+      tsEntryR.ulIntervalMax.store(ulIntervalT, std::memory_order_relaxed);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // An interval above the deadline is a miss, it is reported by tick(). A near miss is an
+   // interval between 80 % and 100 % of the deadline.
+   //
+   if ((ulTimeoutT != 0) && (ulIntervalT <= ulTimeoutT) &&
+       (((uint64_t) ulIntervalT * 100) > ((uint64_t) ulTimeoutT * CO_SUPERVISOR_NEAR_MISS)))
+   {
+      tsEntryR.ulNearMissCount.fetch_add(1, std::memory_order_relaxed);
+      ulNearMissCntP.fetch_add(1, std::memory_order_relaxed);
+
+      if (pclLoggerP != nullptr)
+      {
+         pclLoggerP->print("can%d: NID %03d - COB-ID %03Xh near miss, interval %u us, deadline %u us\n",
+                           ubNetworkP, (ulEntryT % CO_SUPERVISOR_NODE_MAX) + 1, cobId(ulEntryT),
+                           ulIntervalT, ulTimeoutT);
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::checkDeadline()                                                                                      //
+// check an entry whose deadline timer expired                                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::checkDeadline(uint32_t ulEntryV, uint64_t uqTimeV)
+{
+   Entry_s &   tsEntryR   = atsEntryP[ulEntryV];
+   uint32_t    ulTimeoutT = timeout(ulEntryV);
+   uint64_t    uqLastT    = tsEntryR.uqLastSeen.load(std::memory_order_acquire);
+
+   if (ulTimeoutT == 0)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // A frame has been received within the deadline: the timer is moved to the deadline of the
+   // last frame.
+   //
+   if ((uqLastT >= uqTimeV) || ((uqTimeV - uqLastT) < ((uint64_t) ulTimeoutT * 1000)))
+   {
+      if (tsEntryR.btMissed)
+      {
+         tsEntryR.btMissed = false;
+         if (pclLoggerP != nullptr)
+         {
+            pclLoggerP->print("can%d: NID %03d - COB-ID %03Xh received again\n",
+                              ubNetworkP, (ulEntryV % CO_SUPERVISOR_NODE_MAX) + 1, cobId(ulEntryV));
+         }
+      }
+      clWheelP.start(tsEntryR.tsTimer, deadlineTick(uqLastT, ulTimeoutT));
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The deadline is missed: the miss is reported once, the entry is checked again after
+   // each further deadline.
+   //
+   if (tsEntryR.btMissed == false)
+   {
+      tsEntryR.btMissed = true;
+      tsEntryR.ulMissCount.fetch_add(1, std::memory_order_relaxed);
+      ulMissCntP.fetch_add(1, std::memory_order_relaxed);
+
+      if (pclLoggerP != nullptr)
+      {
+         pclLoggerP->print("can%d: NID %03d - COB-ID %03Xh deadline missed, no frame for %u ms\n",
+                           ubNetworkP, (ulEntryV % CO_SUPERVISOR_NODE_MAX) + 1, cobId(ulEntryV),
+                           (uint32_t) ((uqTimeV - uqLastT) / 1000000));
+      }
+   }
+   clWheelP.start(tsEntryR.tsTimer, deadlineTick(uqTimeV, ulTimeoutT));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::cobId()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoSupervisor::cobId(uint32_t ulEntryV)
+{
+   uint32_t ulTypeT   = ulEntryV / CO_SUPERVISOR_NODE_MAX;
+   uint32_t ulNodeIdT = (ulEntryV % CO_SUPERVISOR_NODE_MAX) + 1;
+
+   if (ulTypeT == eCO_SUPERVISOR_HEARTBEAT)
+   {
+      return (0x700 + ulNodeIdT);
+   }
+
+   return (0x080 + (ulTypeT << 8) + ulNodeIdT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::deadlineTick()                                                                                       //
+// first tick at or after the deadline                                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+uint64_t CoSupervisor::deadlineTick(uint64_t uqTimeV, uint32_t ulTimeoutV) const
+{
+   uint64_t uqTickT = (uint64_t) ulTickPeriodP * 1000;
+
+   return ((uqTimeV + ((uint64_t) ulTimeoutV * 1000) + uqTickT - 1) / uqTickT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::entryIndex()                                                                                         //
+// entry of a COB-ID, CO_SUPERVISOR_ENTRY_MAX if the COB-ID is not supervised                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoSupervisor::entryIndex(canid_t tvCanIdV)
+{
+   uint32_t ulFunctionT = tvCanIdV >> 7;
+   uint32_t ulNodeIdT   = tvCanIdV & 0x7F;
+
+   if (ulNodeIdT == 0)
+   {
+      return (CO_SUPERVISOR_ENTRY_MAX);
+   }
+
+   if (ulFunctionT == FUNCTION_HEARTBEAT)
+   {
+      return (ulNodeIdT - 1);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the transmit PDOs of the devices have the odd function codes 3, 5, 7 and 9
+   //
+   if ((ulFunctionT >= FUNCTION_TPDO1) && (ulFunctionT <= FUNCTION_TPDO4) && ((ulFunctionT & 1) != 0))
+   {
+      return ((((ulFunctionT - 1) / 2) * CO_SUPERVISOR_NODE_MAX) + ulNodeIdT - 1);
+   }
+
+   return (CO_SUPERVISOR_ENTRY_MAX);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::setLogger()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::setLogger(CoLogger * pclLoggerV, uint8_t ubNetV)
+{
+   pclLoggerP = pclLoggerV;
+   ubNetworkP = ubNetV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::setPdoTimeout()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::setPdoTimeout(uint32_t ulTimeoutV)
+{
+   for (uint8_t ubTypeT = eCO_SUPERVISOR_TPDO1; ubTypeT < CO_SUPERVISOR_TYPE_MAX; ubTypeT++)
+   {
+      aulTimeoutP[ubTypeT].store(ulTimeoutV, std::memory_order_relaxed);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::setTickPeriod()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::setTickPeriod(uint32_t ulTickPeriodV)
+{
+   if (ulTickPeriodV > 0)
+   {
+      ulTickPeriodP = ulTickPeriodV;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::statistics()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoSupervisor::statistics(uint32_t ulEntryV, CoSupervisorStats_ts & tsStatsR) const
+{
+   uint64_t uqSumT;
+
+   if ((ulEntryV >= CO_SUPERVISOR_ENTRY_MAX) || (atsEntryP[ulEntryV].uqLastSeen.load(std::memory_order_relaxed) == 0))
+   {
+      return (false);
+   }
+
+   const Entry_s & tsEntryR = atsEntryP[ulEntryV];
+
+   tsStatsR.ulCobId         = cobId(ulEntryV);
+   tsStatsR.ulCount         = tsEntryR.ulCount.load(std::memory_order_relaxed);
+   tsStatsR.ulIntervalMax   = tsEntryR.ulIntervalMax.load(std::memory_order_relaxed);
+   tsStatsR.ulMissCount     = tsEntryR.ulMissCount.load(std::memory_order_relaxed);
+   tsStatsR.ulNearMissCount = tsEntryR.ulNearMissCount.load(std::memory_order_relaxed);
+
+   uqSumT = tsEntryR.uqIntervalSum.load(std::memory_order_relaxed);
+   if (tsStatsR.ulCount > 0)
+   {
+      tsStatsR.ulIntervalMin  = tsEntryR.ulIntervalMin.load(std::memory_order_relaxed);
+      tsStatsR.ulIntervalMean = (uint32_t) (uqSumT / tsStatsR.ulCount);
+   }
+   else
+   {
+      tsStatsR.ulIntervalMin  = 0;
+      tsStatsR.ulIntervalMean = 0;
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSupervisor::tick()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSupervisor::tick(uint64_t uqTimeV)
+{
+   uint64_t          uqTickT = uqTimeV / ((uint64_t) ulTickPeriodP * 1000);
+   uint16_t          uwEntryT;
+   CoWheelTimer_ts * ptsTimerT;
+
+   if (btStartedP == false)
+   {
+      clWheelP.reset(uqTickT);
+      btStartedP = true;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // start the deadline timers of entries which received their first frame
+   //
+   while (clFirstFrameP.pop(uwEntryT))
+   {
+      Entry_s & tsEntryR = atsEntryP[uwEntryT];
+
+      clWheelP.start(tsEntryR.tsTimer, deadlineTick(tsEntryR.uqLastSeen.load(std::memory_order_acquire),
+                                                     timeout(uwEntryT)));
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // only the timers which expire up to now are checked
+   //
+   clWheelP.advance(uqTickT);
+   while ((ptsTimerT = clWheelP.nextExpired()) != nullptr)
+   {
+      checkDeadline(ptsTimerT->ulId, uqTimeV);
+   }
+}
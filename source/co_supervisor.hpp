@@ -0,0 +1,256 @@
+//====================================================================================================================//
+// File:          co_supervisor.hpp                                                                                   //
+// Description:   Heartbeat and PDO deadline supervision                                                              //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_supervisor.hpp
+** \brief   Heartbeat and PDO deadline supervision
+**
+** The supervisor watches the heartbeat and the transmit PDOs 1 to 4 of all 127 devices on the
+** master side. Each supervised frame has a deadline timer in a hierarchical timing wheel, so
+** a timer tick only touches the timers which expire in this tick, the node table is never
+** scanned.
+**
+** Frames are passed by the CAN tap: the reception time is stored and the statistics of the
+** inter-arrival time are updated. The deadline timer is not restarted on each frame. When the
+** timer expires, the time of the last frame is checked and the timer is moved to the new
+** deadline, so a periodic frame costs one timer operation per deadline instead of one per
+** frame.
+**
+** A frame whose interval exceeds 80 % of the deadline is reported as near miss. A deadline
+** miss is reported once, the frame is checked again after each further deadline until it is
+** received again. The resolution of the deadline check is the tick period, a frame which is
+** late by less than one tick may not be reported as miss, it is still visible in the maximum
+** interval.
+*/
+#ifndef CO_SUPERVISOR_HPP_
+#define CO_SUPERVISOR_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "co_can_tap.hpp"
+#include "co_logger.hpp"
+#include "co_spsc_queue.hpp"
+#include "co_timing_wheel.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SUPERVISOR_NODE_MAX     ((uint8_t)     127)        // highest node-ID
+#define  CO_SUPERVISOR_TYPE_MAX     ((uint8_t)       5)        // heartbeat and TPDO 1 .. 4
+#define  CO_SUPERVISOR_ENTRY_MAX    ((uint32_t)    635)        // CO_SUPERVISOR_TYPE_MAX * CO_SUPERVISOR_NODE_MAX
+#define  CO_SUPERVISOR_NEAR_MISS    ((uint32_t)     80)        // near miss limit in percent of the deadline
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoSupervisorType_e
+** \brief   Supervised frames of a device
+**
+*/
+enum CoSupervisorType_e {
+   eCO_SUPERVISOR_HEARTBEAT = 0,             // COB-ID 700h + node-ID
+   eCO_SUPERVISOR_TPDO1,                     // COB-ID 180h + node-ID
+   eCO_SUPERVISOR_TPDO2,                     // COB-ID 280h + node-ID
+   eCO_SUPERVISOR_TPDO3,                     // COB-ID 380h + node-ID
+   eCO_SUPERVISOR_TPDO4                      // COB-ID 480h + node-ID
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoSupervisorStats_s
+** \brief   Statistics of one supervised frame
+**
+*/
+typedef struct CoSupervisorStats_s {
+   uint32_t    ulCobId;          // COB-ID of the frame
+   uint32_t    ulCount;          // number of measured intervals
+   uint32_t    ulIntervalMin;    // inter-arrival time in micro-seconds
+   uint32_t    ulIntervalMean;
+   uint32_t    ulIntervalMax;
+   uint32_t    ulMissCount;      // number of deadline misses
+   uint32_t    ulNearMissCount;  // number of intervals above CO_SUPERVISOR_NEAR_MISS
+} CoSupervisorStats_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSupervisor
+** \brief   Heartbeat and PDO deadline supervision
+**
+** The function canFrameReceived() is called in the thread which processes the CAN tap, the
+** functions tick() and statistics() must be called by one other thread. The tap thread passes
+** the first frame of each entry through a lock-free queue, the timing wheel is only used by
+** tick().
+*/
+class CoSupervisor : public CoCanListener {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSupervisor();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of deadline misses of all entries
+   */
+   uint32_t       misses(void) const            { return (ulMissCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of near misses of all entries
+   */
+   uint32_t       nearMisses(void) const        { return (ulNearMissCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTimeoutV    - deadline of the heartbeat in micro-seconds, 0 disables it
+   **
+   ** The deadline may be changed while the supervision is running, it is used from the next
+   ** check on. A heartbeat which has not been supervised before must be enabled before the tap
+   ** is processed.
+   */
+   void           setHeartbeatTimeout(uint32_t ulTimeoutV)
+                  { aulTimeoutP[eCO_SUPERVISOR_HEARTBEAT].store(ulTimeoutV, std::memory_order_relaxed); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  pclLoggerV    - logger for deadline misses and near misses
+   ** \param[in]  ubNetV        - CANopen network, used for the output
+   */
+   void           setLogger(CoLogger * pclLoggerV, uint8_t ubNetV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTimeoutV    - deadline of the TPDOs in micro-seconds, 0 disables it
+   **
+   ** The function must be called before the tap is processed.
+   */
+   void           setPdoTimeout(uint32_t ulTimeoutV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulTickPeriodV - period of tick() in micro-seconds
+   **
+   ** The period is the resolution of the deadline supervision.
+   */
+   void           setTickPeriod(uint32_t ulTickPeriodV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulEntryV      - entry, 0 .. CO_SUPERVISOR_ENTRY_MAX - 1
+   ** \param[out] tsStatsR      - statistics of the entry
+   ** \return     false if no frame of the entry has been received
+   **
+   ** The entry \c ulEntryV belongs to the node-ID (ulEntryV % 127) + 1 and the type
+   ** (ulEntryV / 127), see CoSupervisorType_e.
+   */
+   bool           statistics(uint32_t ulEntryV, CoSupervisorStats_ts & tsStatsR) const;
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTimeV       - monotonic time in nano-seconds
+   **
+   ** Check the deadlines which expire up to \a uqTimeV, the function is called with each timer
+   ** tick.
+   */
+   void           tick(uint64_t uqTimeV);
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // Supervision data of one frame. The reception data is written by the tap thread, the
+   // timer and the miss data by tick().
+   //
+   struct Entry_s {
+      CoWheelTimer_ts         tsTimer;          // deadline timer
+      bool                    btMissed;         // deadline missed, no frame received since
+      std::atomic<uint64_t>   uqLastSeen;       // reception time of the last frame, 0 = none
+      std::atomic<uint32_t>   ulCount;          // number of measured intervals
+      std::atomic<uint32_t>   ulIntervalMin;    // inter-arrival time in micro-seconds
+      std::atomic<uint32_t>   ulIntervalMax;
+      std::atomic<uint64_t>   uqIntervalSum;
+      std::atomic<uint32_t>   ulMissCount;
+      std::atomic<uint32_t>   ulNearMissCount;
+   };
+
+   static uint32_t   cobId(uint32_t ulEntryV);
+
+   void           checkDeadline(uint32_t ulEntryV, uint64_t uqTimeV);
+
+   uint64_t       deadlineTick(uint64_t uqTimeV, uint32_t ulTimeoutV) const;
+
+   static uint32_t   entryIndex(canid_t tvCanIdV);
+
+   uint32_t       timeout(uint32_t ulEntryV) const
+                  { return (aulTimeoutP[ulEntryV / CO_SUPERVISOR_NODE_MAX].load(std::memory_order_relaxed)); }
+
+   CoLogger *        pclLoggerP;
+   uint8_t           ubNetworkP;
+
+   //-----------------------------------------------------------------------------------------
+   // deadline of each type in micro-seconds, 0 if the type is not supervised
+   //
+   std::atomic<uint32_t>   aulTimeoutP[CO_SUPERVISOR_TYPE_MAX];
+
+   //-----------------------------------------------------------------------------------------
+   // The timing wheel is advanced by tick(), the wheel time starts with the first call.
+   //
+   uint32_t          ulTickPeriodP;
+   bool              btStartedP;
+   CoTimingWheel     clWheelP;
+
+   //-----------------------------------------------------------------------------------------
+   // entries which received their first frame, filled by the tap thread
+   //
+   CoSpscQueue<uint16_t, 1024>   clFirstFrameP;
+
+   std::atomic<uint32_t>         ulMissCntP;
+   std::atomic<uint32_t>         ulNearMissCntP;
+
+   Entry_s           atsEntryP[CO_SUPERVISOR_ENTRY_MAX];
+};
+
+
+#endif /*CO_SUPERVISOR_HPP_*/
@@ -0,0 +1,268 @@
+//====================================================================================================================//
+// File:          co_sync_producer.cpp                                                                                //
+// Description:   High-resolution SYNC producer                                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_sync_producer.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  SLEEP_STEP_MAX             ((uint64_t) 100000000)     // longest sleep, limits the delay of stop() in [ns]
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::CoSyncProducer()                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSyncProducer::CoSyncProducer(QObject * pclParentV)
+   : QThread(pclParentV)
+{
+   ulCobIdP       = CO_SYNC_COB_ID;
+   ulCycleP       = 1000;
+   slRtPriorityP  = 0;
+   btStopP        = false;
+
+   ulCycleCntP     = 0;
+   ulMissCntP      = 0;
+   ulFailCntP      = 0;
+   uqCompensationP = 0;
+   uqIntervalMinP  = 0;
+   uqIntervalMaxP  = 0;
+   uqLastTransmitP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::~CoSyncProducer()                                                                                  //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoSyncProducer::~CoSyncProducer()
+{
+   stop();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::recordCycle()                                                                                      //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSyncProducer::recordCycle(uint64_t uqDeadlineV, uint64_t uqTransmitV)
+{
+   uint64_t uqIntervalT;
+
+   clErrorP.record(uqTransmitV - uqDeadlineV);
+
+   //---------------------------------------------------------------------------------------------------
+   // the interval is only valid if the previous cycle has been transmitted
+   //
+   if (uqLastTransmitP != 0)
+   {
+      uqIntervalT = uqTransmitV - uqLastTransmitP;
+      if ((uqIntervalMinP.load(std::memory_order_relaxed) == 0) ||
+          (uqIntervalT < uqIntervalMinP.load(std::memory_order_relaxed)))
+      {
+         uqIntervalMinP.store(uqIntervalT, std::memory_order_relaxed);
+      }
+      if (uqIntervalT > uqIntervalMaxP.load(std::memory_order_relaxed))
+      {
+         uqIntervalMaxP.store(uqIntervalT, std::memory_order_relaxed);
+      }
+   }
+   uqLastTransmitP = uqTransmitV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::run()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSyncProducer::run()
+{
+   struct can_frame  tsFrameT;
+   uint64_t          uqCycleT;
+   uint64_t          uqCycleNumT = 1;
+   uint64_t          uqStartT;
+   uint64_t          uqDeadlineT;
+   uint64_t          uqWakeUpT;
+   uint64_t          uqNowT;
+   uint64_t          uqCompensationT = 0;
+   uint64_t          uqSkipT;
+
+   //---------------------------------------------------------------------------------------------------
+   // set real-time priority, this requires CAP_SYS_NICE
+   //
+   if (slRtPriorityP > 0)
+   {
+      struct sched_param tsSchedParamT;
+      memset(&tsSchedParamT, 0, sizeof(tsSchedParamT));
+      tsSchedParamT.sched_priority = slRtPriorityP;
+      if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &tsSchedParamT) != 0)
+      {
+         fprintf(stderr, "SYNC producer: failed to set SCHED_FIFO priority %d\n", slRtPriorityP);
+      }
+   }
+
+   if (ulCycleP < CO_SYNC_CYCLE_MIN)
+   {
+      ulCycleP = CO_SYNC_CYCLE_MIN;
+   }
+   uqCycleT = (uint64_t) ulCycleP * 1000;
+
+   memset(&tsFrameT, 0, sizeof(tsFrameT));
+   tsFrameT.can_id  = ulCobIdP;
+   tsFrameT.can_dlc = 0;
+
+   uqLastTransmitP = 0;
+   uqStartT        = CoCanTap::timeStamp();
+
+   while (btStopP.load(std::memory_order_relaxed) == false)
+   {
+      //-------------------------------------------------------------------------------------------
+      // The deadline is derived from the cycle number, the thread wakes up before the deadline
+      // by its filtered wake-up latency plus a guard time. The compensation is limited to half
+      // of the cycle.
+      //
+      uqDeadlineT = uqStartT + (uqCycleNumT * uqCycleT);
+      uqWakeUpT   = uqDeadlineT - uqCompensationT - CO_SYNC_GUARD_TIME;
+      sleepUntil(uqWakeUpT);
+
+      if (btStopP.load(std::memory_order_relaxed))
+      {
+         break;
+      }
+
+      uqNowT = CoCanTap::timeStamp();
+      if (uqNowT > uqWakeUpT)
+      {
+         uqCompensationT = uqCompensationT - (uqCompensationT / 16) + ((uqNowT - uqWakeUpT) / 16);
+         if (uqCompensationT > ((uqCycleT / 2) - CO_SYNC_GUARD_TIME))
+         {
+            uqCompensationT = (uqCycleT / 2) - CO_SYNC_GUARD_TIME;
+         }
+         uqCompensationP.store(uqCompensationT, std::memory_order_relaxed);
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // The thread is too late for this cycle if the deadline has passed by more than half a
+      // cycle, a late SYNC message would shorten the following cycle. This cycle and all
+      // cycles whose deadline has passed are skipped, so the next deadline lies in the future.
+      //
+      if (uqNowT > (uqDeadlineT + (uqCycleT / 2)))
+      {
+         uqSkipT = ((uqNowT - uqDeadlineT) / uqCycleT) + 1;
+         ulMissCntP.fetch_add((uint32_t) uqSkipT, std::memory_order_relaxed);
+         uqCycleNumT    += uqSkipT;
+         uqLastTransmitP = 0;
+         continue;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // busy wait for the exact deadline
+      //
+      while ((uqNowT = CoCanTap::timeStamp()) < uqDeadlineT)
+      {
+      }
+
+      if (clCanTapP.write(tsFrameT))
+      {
+         recordCycle(uqDeadlineT, uqNowT);
+         ulCycleCntP.fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+         ulFailCntP.fetch_add(1, std::memory_order_relaxed);
+         uqLastTransmitP = 0;
+      }
+
+      uqCycleNumT++;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::sleepUntil()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSyncProducer::sleepUntil(uint64_t uqTimeV)
+{
+   struct timespec tsTimeT;
+   uint64_t        uqWakeUpT;
+   uint64_t        uqNowT;
+
+   //---------------------------------------------------------------------------------------------------
+   // long cycles are split into steps, so stop() doesn't have to wait for the end of the cycle
+   //
+   while ((uqNowT = CoCanTap::timeStamp()) < uqTimeV)
+   {
+      if (btStopP.load(std::memory_order_relaxed))
+      {
+         break;
+      }
+
+      uqWakeUpT = uqTimeV;
+      if ((uqTimeV - uqNowT) > SLEEP_STEP_MAX)
+      {
+         uqWakeUpT = uqNowT + SLEEP_STEP_MAX;
+      }
+
+      tsTimeT.tv_sec  = (time_t) (uqWakeUpT / 1000000000);
+      tsTimeT.tv_nsec = (long)   (uqWakeUpT % 1000000000);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tsTimeT, nullptr);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoSyncProducer::stop()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoSyncProducer::stop(void)
+{
+   if (isRunning())
+   {
+      btStopP.store(true, std::memory_order_relaxed);
+      wait();
+   }
+   clCanTapP.close();
+}
@@ -0,0 +1,195 @@
+//====================================================================================================================//
+// File:          co_sync_producer.hpp                                                                                //
+// Description:   High-resolution SYNC producer                                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_sync_producer.hpp
+** \brief   High-resolution SYNC producer
+**
+** The SYNC producer of the CANopen master library is driven by the stack timer tick, so the
+** SYNC cycle is a multiple of the tick period and its jitter is in the range of the tick. The
+** class CoSyncProducer transmits the SYNC message from a separate thread on a raw SocketCAN
+** socket, the transmission times are absolute deadlines of CLOCK_MONOTONIC. Cycle times below
+** one milli-second are possible.
+*/
+#ifndef CO_SYNC_PRODUCER_HPP_
+#define CO_SYNC_PRODUCER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <QtCore/QThread>
+
+#include "co_can_tap.hpp"
+#include "co_latency.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_SYNC_COB_ID             ((uint32_t)  0x080)        // default COB-ID of the SYNC message
+#define  CO_SYNC_CYCLE_MIN          ((uint32_t)    100)        // minimum cycle time in micro-seconds
+#define  CO_SYNC_GUARD_TIME         ((uint64_t)  20000)        // busy-wait time before a deadline in [ns]
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoSyncProducer
+** \brief   SYNC producer thread
+**
+** The thread sleeps with clock_nanosleep() until shortly before the deadline of the next SYNC
+** message and waits for the exact deadline in a busy loop. The wake-up latency of the thread is
+** measured in each cycle and the thread wakes up earlier by the filtered latency, so the busy
+** loop stays short. The deadlines are calculated from the start time and the cycle number,
+** therefore errors of single cycles don't accumulate.
+**
+** For each cycle the transmission error (time the frame is passed to the kernel minus the
+** deadline) and the interval to the previous SYNC message are recorded. A cycle which is more
+** than half a cycle late is skipped and counted as missed.
+**
+** All statistics can be read from any thread while the producer is running.
+*/
+class CoSyncProducer : public QThread {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoSyncProducer(QObject * pclParentV = nullptr);
+
+   ~CoSyncProducer();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     filtered wake-up latency of the thread in nano-seconds
+   */
+   uint64_t       compensation(void) const      { return (uqCompensationP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of transmitted SYNC messages
+   */
+   uint32_t       cycles(void) const            { return (ulCycleCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     histogram of the transmission time after the deadline in nano-seconds
+   */
+   const CoLatencyHistogram & error(void) const { return (clErrorP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     shortest time between two SYNC messages in nano-seconds
+   */
+   uint64_t       intervalMin(void) const       { return (uqIntervalMinP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     longest time between two SYNC messages in nano-seconds
+   */
+   uint64_t       intervalMax(void) const       { return (uqIntervalMaxP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of SYNC messages which could not be written to the socket
+   */
+   uint32_t       failedFrames(void) const      { return (ulFailCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of skipped cycles
+   */
+   uint32_t       missedCycles(void) const      { return (ulMissCntP.load(std::memory_order_relaxed)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szInterfaceV  - CAN interface, e.g. can1
+   ** \return     true if the socket is open
+   */
+   bool           open(const char * szInterfaceV)  { return (clCanTapP.open(szInterfaceV, false)); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulCobIdV      - COB-ID of the SYNC message
+   */
+   void           setCobId(uint32_t ulCobIdV)   { ulCobIdP = ulCobIdV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ulCycleV      - cycle time in micro-seconds, at least CO_SYNC_CYCLE_MIN
+   */
+   void           setCycle(uint32_t ulCycleV)   { ulCycleP = ulCycleV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  slPriorityV   - SCHED_FIFO priority (1 .. 99), 0 for normal scheduling
+   */
+   void           setRtPriority(int32_t slPriorityV)  { slRtPriorityP = slPriorityV; }
+
+   void           stop(void);
+
+protected:
+
+   void           run() override;
+
+private:
+
+   void           recordCycle(uint64_t uqDeadlineV, uint64_t uqTransmitV);
+
+   void           sleepUntil(uint64_t uqTimeV);
+
+   CoCanTap                clCanTapP;
+   uint32_t                ulCobIdP;
+   uint32_t                ulCycleP;
+   int32_t                 slRtPriorityP;
+   std::atomic<bool>       btStopP;
+
+   std::atomic<uint32_t>   ulCycleCntP;
+   std::atomic<uint32_t>   ulMissCntP;
+   std::atomic<uint32_t>   ulFailCntP;
+   std::atomic<uint64_t>   uqCompensationP;
+   std::atomic<uint64_t>   uqIntervalMinP;
+   std::atomic<uint64_t>   uqIntervalMaxP;
+   uint64_t                uqLastTransmitP;
+   CoLatencyHistogram      clErrorP;
+};
+
+
+#endif /*CO_SYNC_PRODUCER_HPP_*/
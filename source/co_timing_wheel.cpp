@@ -0,0 +1,263 @@
+//====================================================================================================================//
+// File:          co_timing_wheel.cpp                                                                                 //
+// Description:   Hierarchical timing wheel                                                                           //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_timing_wheel.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  LEVEL1_SHIFT               (CO_WHEEL_LEVEL0_BITS)
+#define  LEVEL2_SHIFT               (CO_WHEEL_LEVEL0_BITS + CO_WHEEL_LEVELN_BITS)
+
+#define  LEVEL1_FIRST               (CO_WHEEL_LEVEL0_SLOTS)
+#define  LEVEL2_FIRST               (CO_WHEEL_LEVEL0_SLOTS + CO_WHEEL_LEVELN_SLOTS)
+
+#define  LEVEL0_MASK                ((uint64_t) (CO_WHEEL_LEVEL0_SLOTS - 1))
+#define  LEVELN_MASK                ((uint64_t) (CO_WHEEL_LEVELN_SLOTS - 1))
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::CoTimingWheel()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTimingWheel::CoTimingWheel()
+{
+   uqNowP   = 0;
+   ulCountP = 0;
+
+   for (uint32_t ulSlotT = 0; ulSlotT < CO_WHEEL_SLOT_MAX; ulSlotT++)
+   {
+      atsSlotP[ulSlotT].ptsNext = &atsSlotP[ulSlotT];
+      atsSlotP[ulSlotT].ptsPrev = &atsSlotP[ulSlotT];
+   }
+
+   tsExpiredP.ptsNext = &tsExpiredP;
+   tsExpiredP.ptsPrev = &tsExpiredP;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::advance()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+uint32_t CoTimingWheel::advance(uint64_t uqTickV)
+{
+   CoWheelTimer_ts * ptsHeadT;
+   uint32_t          ulExpiredT = 0;
+
+   while (uqNowP <= uqTickV)
+   {
+      //-------------------------------------------------------------------------------------------
+      // At the start of each round of the first level the next slot of level 1 is moved down,
+      // at the start of each round of level 1 the next slot of level 2 is moved to level 1
+      // before.
+      //
+      if ((uqNowP & LEVEL0_MASK) == 0)
+      {
+         if (((uqNowP >> LEVEL1_SHIFT) & LEVELN_MASK) == 0)
+         {
+            cascade(LEVEL2_FIRST + (uint32_t) ((uqNowP >> LEVEL2_SHIFT) & LEVELN_MASK));
+         }
+         cascade(LEVEL1_FIRST + (uint32_t) ((uqNowP >> LEVEL1_SHIFT) & LEVELN_MASK));
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // all timers of the current slot expire with this tick
+      //
+      ptsHeadT = &atsSlotP[uqNowP & LEVEL0_MASK];
+      while (ptsHeadT->ptsNext != ptsHeadT)
+      {
+         CoWheelTimer_ts * ptsTimerT = ptsHeadT->ptsNext;
+
+         unlink(*ptsTimerT);
+         link(tsExpiredP, *ptsTimerT);
+         ulExpiredT++;
+      }
+
+      uqNowP++;
+   }
+
+   return (ulExpiredT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::cancel()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::cancel(CoWheelTimer_ts & tsTimerR)
+{
+   if (isPending(tsTimerR))
+   {
+      unlink(tsTimerR);
+      ulCountP--;
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::cascade()                                                                                           //
+// move all timers of an upper level slot to the lower levels                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::cascade(uint32_t ulSlotV)
+{
+   CoWheelTimer_ts * ptsHeadT = &atsSlotP[ulSlotV];
+
+   while (ptsHeadT->ptsNext != ptsHeadT)
+   {
+      CoWheelTimer_ts * ptsTimerT = ptsHeadT->ptsNext;
+
+      unlink(*ptsTimerT);
+      insert(*ptsTimerT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::init()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::init(CoWheelTimer_ts & tsTimerR, uint32_t ulIdV)
+{
+   tsTimerR.ptsNext  = nullptr;
+   tsTimerR.ptsPrev  = nullptr;
+   tsTimerR.uqExpiry = 0;
+   tsTimerR.ulId     = ulIdV;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::insert()                                                                                            //
+// link a timer into the slot of its expiry tick                                                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::insert(CoWheelTimer_ts & tsTimerR)
+{
+   uint64_t uqExpiryT = tsTimerR.uqExpiry;
+   uint32_t ulSlotT;
+
+   //---------------------------------------------------------------------------------------------------
+   // A timer in the past is put into the current slot. The level is selected by the distance
+   // to the current tick, a timer of level 1 or 2 is cascaded at the latest when the first
+   // level reaches the start of its slot.
+   //
+   if (uqExpiryT < uqNowP)
+   {
+      uqExpiryT = uqNowP;
+   }
+
+   if ((uqExpiryT - uqNowP) < CO_WHEEL_LEVEL0_SLOTS)
+   {
+      ulSlotT = (uint32_t) (uqExpiryT & LEVEL0_MASK);
+   }
+   else if ((uqExpiryT - uqNowP) < ((uint64_t) 1 << LEVEL2_SHIFT))
+   {
+      ulSlotT = LEVEL1_FIRST + (uint32_t) ((uqExpiryT >> LEVEL1_SHIFT) & LEVELN_MASK);
+   }
+   else
+   {
+      ulSlotT = LEVEL2_FIRST + (uint32_t) ((uqExpiryT >> LEVEL2_SHIFT) & LEVELN_MASK);
+   }
+
+   link(atsSlotP[ulSlotT], tsTimerR);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::link()                                                                                              //
+// append a timer to a list                                                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::link(CoWheelTimer_ts & tsHeadR, CoWheelTimer_ts & tsTimerR)
+{
+   tsTimerR.ptsNext          = &tsHeadR;
+   tsTimerR.ptsPrev          = tsHeadR.ptsPrev;
+   tsHeadR.ptsPrev->ptsNext  = &tsTimerR;
+   tsHeadR.ptsPrev           = &tsTimerR;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::nextExpired()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoWheelTimer_ts * CoTimingWheel::nextExpired(void)
+{
+   CoWheelTimer_ts * ptsTimerT = tsExpiredP.ptsNext;
+
+   if (ptsTimerT == &tsExpiredP)
+   {
+      return (nullptr);
+   }
+
+   unlink(*ptsTimerT);
+   ulCountP--;
+
+   return (ptsTimerT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::start()                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::start(CoWheelTimer_ts & tsTimerR, uint64_t uqExpiryV)
+{
+   cancel(tsTimerR);
+
+   if (uqExpiryV > (uqNowP + CO_WHEEL_RANGE - 1))
+   {
+      uqExpiryV = uqNowP + CO_WHEEL_RANGE - 1;
+   }
+
+   tsTimerR.uqExpiry = uqExpiryV;
+   insert(tsTimerR);
+   ulCountP++;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTimingWheel::unlink()                                                                                            //
+// remove a timer from its list                                                                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTimingWheel::unlink(CoWheelTimer_ts & tsTimerR)
+{
+   tsTimerR.ptsPrev->ptsNext = tsTimerR.ptsNext;
+   tsTimerR.ptsNext->ptsPrev = tsTimerR.ptsPrev;
+   tsTimerR.ptsNext          = nullptr;
+   tsTimerR.ptsPrev          = nullptr;
+}
@@ -0,0 +1,186 @@
+//====================================================================================================================//
+// File:          co_timing_wheel.hpp                                                                                 //
+// Description:   Hierarchical timing wheel                                                                           //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_timing_wheel.hpp
+** \brief   Hierarchical timing wheel
+**
+** The wheel has three levels: 256 slots of one tick, 64 slots of 256 ticks and 64 slots of
+** 16384 ticks, so timers up to 2^20 ticks (2.9 hours at 10 ms) in the future are handled.
+** Starting and cancelling a timer is O(1), a tick processes one slot of the first level. Every
+** 256 ticks the timers of one slot of the next level are moved down (cascaded), each timer is
+** moved at most twice during its lifetime.
+**
+** Timers are owned by the caller and are linked into the slots, the wheel never allocates
+** memory. The wheel is not thread-safe.
+*/
+#ifndef CO_TIMING_WHEEL_HPP_
+#define CO_TIMING_WHEEL_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_WHEEL_LEVEL0_BITS       ((uint32_t)      8)        // 256 slots on the first level
+#define  CO_WHEEL_LEVELN_BITS       ((uint32_t)      6)        // 64 slots on the upper levels
+#define  CO_WHEEL_LEVEL0_SLOTS      ((uint32_t)    256)
+#define  CO_WHEEL_LEVELN_SLOTS      ((uint32_t)     64)
+#define  CO_WHEEL_SLOT_MAX          ((uint32_t)    384)        // 256 + 2 * 64
+#define  CO_WHEEL_RANGE             ((uint64_t) 1048576)       // 2^20 ticks
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoWheelTimer_s
+** \brief   Timer of the timing wheel
+**
+** The timer is idle if \c ptsNext is nullptr.
+*/
+typedef struct CoWheelTimer_s {
+   struct CoWheelTimer_s * ptsNext;          // list of the slot
+   struct CoWheelTimer_s * ptsPrev;
+   uint64_t                uqExpiry;         // expiry tick
+   uint32_t                ulId;             // defined by the owner of the timer
+} CoWheelTimer_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoTimingWheel
+** \brief   Hierarchical timing wheel
+**
+*/
+class CoTimingWheel {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoTimingWheel();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTickV       - current tick
+   ** \return     number of expired timers
+   **
+   ** Process all ticks up to and including \a uqTickV. Expired timers are moved to the list of
+   ** expired timers, see nextExpired().
+   */
+   uint32_t       advance(uint64_t uqTickV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsTimerR      - timer
+   **
+   ** Stop a running or expired timer, the call is ignored for an idle timer.
+   */
+   void           cancel(CoWheelTimer_ts & tsTimerR);
+
+   uint32_t       count(void) const             { return (ulCountP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsTimerR      - timer
+   ** \param[in]  ulIdV         - identifier of the timer
+   **
+   ** Initialise a timer before its first use, the timer is idle afterwards.
+   */
+   static void    init(CoWheelTimer_ts & tsTimerR, uint32_t ulIdV);
+
+   static bool    isPending(const CoWheelTimer_ts & tsTimerR)    { return (tsTimerR.ptsNext != nullptr); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     expired timer, nullptr if no more timer has expired
+   **
+   ** The returned timer is idle and may be started again.
+   */
+   CoWheelTimer_ts * nextExpired(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     next tick to process
+   */
+   uint64_t       now(void) const               { return (uqNowP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  uqTickV       - first tick to process
+   **
+   ** Set the time of the wheel, all timers must be idle.
+   */
+   void           reset(uint64_t uqTickV)       { uqNowP = uqTickV; }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  tsTimerR      - timer
+   ** \param[in]  uqExpiryV     - expiry tick
+   **
+   ** Start the timer, a running timer is restarted. A timer in the past expires with the next
+   ** tick, a timer beyond CO_WHEEL_RANGE is limited to this range.
+   */
+   void           start(CoWheelTimer_ts & tsTimerR, uint64_t uqExpiryV);
+
+private:
+
+   void           cascade(uint32_t ulSlotV);
+
+   void           insert(CoWheelTimer_ts & tsTimerR);
+
+   static void    link(CoWheelTimer_ts & tsHeadR, CoWheelTimer_ts & tsTimerR);
+
+   static void    unlink(CoWheelTimer_ts & tsTimerR);
+
+   //-----------------------------------------------------------------------------------------
+   // next tick to process
+   //
+   uint64_t          uqNowP;
+   uint32_t          ulCountP;
+
+   //-----------------------------------------------------------------------------------------
+   // Slot lists of all levels and the list of expired timers, each list is a ring with the
+   // head as sentinel element.
+   //
+   CoWheelTimer_ts   atsSlotP[CO_WHEEL_SLOT_MAX];
+   CoWheelTimer_ts   tsExpiredP;
+};
+
+
+#endif /*CO_TIMING_WHEEL_HPP_*/
@@ -0,0 +1,384 @@
+//====================================================================================================================//
+// File:          co_trace_recorder.cpp                                                                               //
+// Description:   Binary trace of CAN frames and CANopen events                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_trace_recorder.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::CoTraceRecorder()                                                                                 //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceRecorder::CoTraceRecorder()
+{
+   aszFileP[0]  = 0;
+   ulRecordCntP = 0;
+   ulFileCntP   = 0;
+   ulFileSeqP   = 0;
+   btOpenP      = false;
+
+   btWriteLockP.clear();
+   ptsFileP     = nullptr;
+   uqWriteCntP  = 0;
+
+   ptsNextP     = nullptr;
+   ptsRetiredP  = nullptr;
+   ulWrapCntP   = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::~CoTraceRecorder()                                                                                //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceRecorder::~CoTraceRecorder()
+{
+   close();
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::beginRecord()                                                                                     //
+// lock the recorder and return the next record, switch to the next file if required                                  //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceRecord_ts * CoTraceRecorder::beginRecord(void)
+{
+   TraceFile_ts * ptsNextT;
+
+   while (btWriteLockP.test_and_set(std::memory_order_acquire))
+   {
+      // writers only collide if a library event is emitted outside the stack thread
+   }
+
+   if (ptsFileP == nullptr)
+   {
+      btWriteLockP.clear(std::memory_order_release);
+      return (nullptr);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The file is full: continue with the prepared file. If service() did not prepare it in
+   // time the oldest records of the current file are overwritten.
+   //
+   if (uqWriteCntP >= ulRecordCntP)
+   {
+      ptsNextT = ptsNextP.exchange(nullptr, std::memory_order_acq_rel);
+      if (ptsNextT != nullptr)
+      {
+         ptsRetiredP.store(ptsFileP, std::memory_order_release);
+         ptsFileP    = ptsNextT;
+         uqWriteCntP = 0;
+      }
+      else
+      {
+         ulWrapCntP.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+
+   return (&ptsFileP->ptsRecord[uqWriteCntP % ulRecordCntP]);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::canFrameReceived()                                                                                //
+// store a CAN frame received by the CAN tap                                                                          //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV)
+{
+   CoTraceRecord_ts * ptsRecordT;
+
+   ptsRecordT = beginRecord();
+   if (ptsRecordT != nullptr)
+   {
+      ptsRecordT->uqTimeStamp = uqTimeStampV;
+      ptsRecordT->ubType      = eCO_TRACE_CAN_FRAME;
+      ptsRecordT->ubNet       = 0;
+      ptsRecordT->ubNodeId    = 0;
+      ptsRecordT->ubValue     = btLocalV ? CO_TRACE_FLAG_LOCAL : 0;
+      ptsRecordT->uwIndex     = 0;
+      ptsRecordT->ubSubIndex  = 0;
+      ptsRecordT->ubDlc       = tsFrameR.can_dlc;
+      ptsRecordT->ulValue     = tsFrameR.can_id;
+      memcpy(&ptsRecordT->aubData[0], &tsFrameR.data[0], sizeof(ptsRecordT->aubData));
+
+      endRecord(ptsRecordT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::close()                                                                                           //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::close(void)
+{
+   if (btOpenP == false)
+   {
+      return;
+   }
+
+   while (btWriteLockP.test_and_set(std::memory_order_acquire))
+   {
+      // wait for a writer to finish
+   }
+   unmapFile(ptsFileP);
+   ptsFileP = nullptr;
+   btWriteLockP.clear(std::memory_order_release);
+
+   unmapFile(ptsNextP.exchange(nullptr));
+   unmapFile(ptsRetiredP.exchange(nullptr));
+
+   btOpenP = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::endRecord()                                                                                       //
+// publish the record and unlock the recorder                                                                         //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::endRecord(CoTraceRecord_ts * ptsRecordV)
+{
+   ptsRecordV->ulRecordNr = (uint32_t) uqWriteCntP;
+   uqWriteCntP++;
+   __atomic_store_n(&ptsFileP->ptsHeader->uqWriteCount, uqWriteCntP, __ATOMIC_RELEASE);
+
+   btWriteLockP.clear(std::memory_order_release);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::mapFile()                                                                                         //
+// create and map a trace file                                                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceRecorder::TraceFile_ts * CoTraceRecorder::mapFile(uint32_t ulFileSeqV)
+{
+   char              aszNameT[sizeof(aszFileP) + 12];
+   TraceFile_ts *    ptsFileT;
+   struct timespec   tsTimeT;
+   uint32_t          ulSizeT;
+   int32_t           slFdT;
+   void *            pvMemT;
+
+   snprintf(aszNameT, sizeof(aszNameT), "%s.%u", aszFileP, ulFileSeqV % ulFileCntP);
+   ulSizeT = sizeof(CoTraceHeader_ts) + (ulRecordCntP * sizeof(CoTraceRecord_ts));
+
+   slFdT = ::open(aszNameT, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+   if (slFdT < 0)
+   {
+      return (nullptr);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // Reserve the disk space now, a write to a page without backing store would raise SIGBUS
+   // when the file system is full.
+   //
+   if ((ftruncate(slFdT, ulSizeT) < 0) || (posix_fallocate(slFdT, 0, ulSizeT) != 0))
+   {
+      ::close(slFdT);
+      return (nullptr);
+   }
+
+   pvMemT = mmap(nullptr, ulSizeT, PROT_READ | PROT_WRITE, MAP_SHARED, slFdT, 0);
+   ::close(slFdT);
+   if (pvMemT == MAP_FAILED)
+   {
+      return (nullptr);
+   }
+
+   ptsFileT = new TraceFile_ts;
+   ptsFileT->ptsHeader = (CoTraceHeader_ts *) pvMemT;
+   ptsFileT->ptsRecord = (CoTraceRecord_ts *) (ptsFileT->ptsHeader + 1);
+   ptsFileT->ulSize    = ulSizeT;
+
+   //---------------------------------------------------------------------------------------------------
+   // Clearing the file touches every page, so the writer doesn't take page faults later on.
+   // The magic value is written last.
+   //
+   memset(pvMemT, 0, ulSizeT);
+   ptsFileT->ptsHeader->uwVersion     = CO_TRACE_VERSION;
+   ptsFileT->ptsHeader->uwHeaderSize  = sizeof(CoTraceHeader_ts);
+   ptsFileT->ptsHeader->ulRecordSize  = sizeof(CoTraceRecord_ts);
+   ptsFileT->ptsHeader->ulRecordCount = ulRecordCntP;
+   ptsFileT->ptsHeader->ulFileSeq     = ulFileSeqV;
+   ptsFileT->ptsHeader->uqMonoTime    = CoCanTap::timeStamp();
+   clock_gettime(CLOCK_REALTIME, &tsTimeT);
+   ptsFileT->ptsHeader->uqRealTime    = ((uint64_t) tsTimeT.tv_sec * 1000000000) + (uint64_t) tsTimeT.tv_nsec;
+   __atomic_store_n(&ptsFileT->ptsHeader->ulMagic, CO_TRACE_MAGIC, __ATOMIC_RELEASE);
+
+   return (ptsFileT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::open()                                                                                            //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoTraceRecorder::open(const char * szFileV, uint32_t ulRecordsV, uint32_t ulFilesV)
+{
+   char              aszNameT[sizeof(aszFileP) + 12];
+   CoTraceHeader_ts  tsHeaderT;
+   bool              btFoundT = false;
+   int32_t           slFdT;
+
+   close();
+
+   if ((szFileV == nullptr) || (strlen(szFileV) >= sizeof(aszFileP)) || (ulRecordsV == 0) || (ulFilesV < 2))
+   {
+      return (false);
+   }
+
+   strcpy(aszFileP, szFileV);
+   ulRecordCntP = ulRecordsV;
+   ulFileCntP   = ulFilesV;
+   ulFileSeqP   = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // find the most recent file of a previous run
+   //
+   for (uint32_t ulFileT = 0; ulFileT < ulFileCntP; ulFileT++)
+   {
+      snprintf(aszNameT, sizeof(aszNameT), "%s.%u", aszFileP, ulFileT);
+      slFdT = ::open(aszNameT, O_RDONLY | O_CLOEXEC);
+      if (slFdT < 0)
+      {
+         continue;
+      }
+
+      if ((pread(slFdT, &tsHeaderT, sizeof(tsHeaderT), 0) == (ssize_t) sizeof(tsHeaderT)) &&
+          (tsHeaderT.ulMagic == CO_TRACE_MAGIC))
+      {
+         if ((btFoundT == false) || (tsHeaderT.ulFileSeq >= ulFileSeqP))
+         {
+            ulFileSeqP = tsHeaderT.ulFileSeq + 1;
+            btFoundT   = true;
+         }
+      }
+      ::close(slFdT);
+   }
+
+   ptsFileP = mapFile(ulFileSeqP);
+   if (ptsFileP == nullptr)
+   {
+      return (false);
+   }
+   ulFileSeqP++;
+   uqWriteCntP = 0;
+   btOpenP     = true;
+
+   service();
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::record()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::record(uint8_t ubTypeV, uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubValueV,
+                             uint16_t uwIndexV, uint8_t ubSubIndexV, uint32_t ulValueV)
+{
+   CoTraceRecord_ts * ptsRecordT;
+
+   ptsRecordT = beginRecord();
+   if (ptsRecordT != nullptr)
+   {
+      ptsRecordT->uqTimeStamp = CoCanTap::timeStamp();
+      ptsRecordT->ubType      = ubTypeV;
+      ptsRecordT->ubNet       = ubNetV;
+      ptsRecordT->ubNodeId    = ubNodeIdV;
+      ptsRecordT->ubValue     = ubValueV;
+      ptsRecordT->uwIndex     = uwIndexV;
+      ptsRecordT->ubSubIndex  = ubSubIndexV;
+      ptsRecordT->ubDlc       = 0;
+      ptsRecordT->ulValue     = ulValueV;
+      memset(&ptsRecordT->aubData[0], 0, sizeof(ptsRecordT->aubData));
+
+      endRecord(ptsRecordT);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::service()                                                                                         //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::service(void)
+{
+   TraceFile_ts * ptsFileT;
+
+   if (btOpenP == false)
+   {
+      return;
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // The replaced file must be released before the next one is prepared: the writer only
+   // retires a file when it takes the prepared one.
+   //
+   unmapFile(ptsRetiredP.exchange(nullptr, std::memory_order_acq_rel));
+
+   if (ptsNextP.load(std::memory_order_acquire) == nullptr)
+   {
+      ptsFileT = mapFile(ulFileSeqP);
+      if (ptsFileT != nullptr)
+      {
+         ulFileSeqP++;
+         ptsNextP.store(ptsFileT, std::memory_order_release);
+      }
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceRecorder::unmapFile()                                                                                       //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceRecorder::unmapFile(TraceFile_ts * ptsFileV)
+{
+   if (ptsFileV != nullptr)
+   {
+      msync(ptsFileV->ptsHeader, ptsFileV->ulSize, MS_ASYNC);
+      munmap(ptsFileV->ptsHeader, ptsFileV->ulSize);
+      delete ptsFileV;
+   }
+}
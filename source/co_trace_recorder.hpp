@@ -0,0 +1,250 @@
+//====================================================================================================================//
+// File:          co_trace_recorder.hpp                                                                               //
+// Description:   Binary trace of CAN frames and CANopen events                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_trace_recorder.hpp
+** \brief   Binary trace of CAN frames and CANopen events
+**
+** The trace recorder writes fixed-size records into memory-mapped files. Each file starts
+** with a CoTraceHeader_ts followed by \c ulRecordCount records of type CoTraceRecord_ts. The
+** records of a file form a ring: record number \c n is stored at index
+** (n % ulRecordCount), \c uqWriteCount of the header holds the number of records written to
+** the file.
+**
+** Records are written into the page cache only, the kernel writes the pages to the file
+** in the background. The trace therefore survives a crash of the application.
+**
+** The files are used in turns: <file>.0, <file>.1, ... When a file is full the recorder
+** continues with the next file, which has been prepared in advance by service(). The file
+** with the highest \c ulFileSeq holds the most recent records.
+*/
+#ifndef CO_TRACE_RECORDER_HPP_
+#define CO_TRACE_RECORDER_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "co_can_tap.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  CO_TRACE_MAGIC             ((uint32_t) 0x52544F43)    // "COTR"
+#define  CO_TRACE_VERSION           ((uint16_t)      1)
+
+#define  CO_TRACE_FILE_RECORDS      ((uint32_t)  65536)        // records per file, 2 MiB
+#define  CO_TRACE_FILE_COUNT        ((uint32_t)      4)        // number of files used in turns
+
+#define  CO_TRACE_FLAG_LOCAL        ((uint8_t)    0x01)        // frame has been transmitted by this host
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \enum    CoTraceType_e
+** \brief   Type of a trace record
+**
+*/
+enum CoTraceType_e {
+   eCO_TRACE_CAN_FRAME = 1,            // CAN frame, ulValue: CAN-ID, ubValue: CO_TRACE_FLAG_...
+   eCO_TRACE_EMCY_RECEIVE,             // EMCY received, data in the corresponding CAN frame
+   eCO_TRACE_LSS_RECEIVE,              // ubValue: LSS protocol
+   eCO_TRACE_MGR_BUS,                  // ubValue: error state, aubData: type, rcv / trm counter
+   eCO_TRACE_NMT_HEARTBEAT,            // heartbeat of ubNodeId is missing
+   eCO_TRACE_NMT_MASTER_DETECTION,     // ubValue: detection result
+   eCO_TRACE_NMT_STATE_CHANGE,         // ubValue: NMT state
+   eCO_TRACE_PDO_RECEIVE,              // uwIndex: PDO number
+   eCO_TRACE_PDO_TIMEOUT,              // uwIndex: PDO number
+   eCO_TRACE_SDO_OBJECT_READY,         // ubValue: marker, ulValue: abort code
+   eCO_TRACE_SDO_TIMEOUT               // uwIndex / ubSubIndex: object
+};
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoTraceHeader_s
+** \brief   Header of a trace file
+**
+*/
+typedef struct CoTraceHeader_s {
+   uint32_t    ulMagic;          // CO_TRACE_MAGIC
+   uint16_t    uwVersion;        // CO_TRACE_VERSION
+   uint16_t    uwHeaderSize;     // size of this header in bytes
+   uint32_t    ulRecordSize;     // size of one record in bytes
+   uint32_t    ulRecordCount;    // number of records in the file
+   uint32_t    ulFileSeq;        // sequence number of the file, incremented on each rotation
+   uint32_t    ulReserved;
+   uint64_t    uqWriteCount;     // number of records written to this file
+   uint64_t    uqMonoTime;       // CLOCK_MONOTONIC when the file was started, in nano-seconds
+   uint64_t    uqRealTime;       // CLOCK_REALTIME when the file was started, in nano-seconds
+   uint8_t     aubReserved[16];
+} CoTraceHeader_ts;
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \struct  CoTraceRecord_s
+** \brief   Trace record
+**
+*/
+typedef struct CoTraceRecord_s {
+   uint64_t    uqTimeStamp;      // CLOCK_MONOTONIC in nano-seconds
+   uint32_t    ulRecordNr;       // record number inside the file
+   uint8_t     ubType;           // CoTraceType_e
+   uint8_t     ubNet;            // CANopen network
+   uint8_t     ubNodeId;         // node-ID
+   uint8_t     ubValue;          // type specific value
+   uint16_t    uwIndex;          // object index or PDO number
+   uint8_t     ubSubIndex;       // object sub-index
+   uint8_t     ubDlc;            // data length code of a CAN frame
+   uint32_t    ulValue;          // CAN-ID or SDO abort code
+   uint8_t     aubData[8];       // data of a CAN frame
+} CoTraceRecord_ts;
+
+static_assert(sizeof(CoTraceHeader_ts) == 64, "unexpected size of trace header");
+static_assert(sizeof(CoTraceRecord_ts) == 32, "unexpected size of trace record");
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoTraceRecorder
+** \brief   Binary trace of CAN frames and CANopen events
+**
+** CAN frames are received from the CAN tap, CANopen events are passed by direct connections
+** to the QCoEvent signals. Writing a record only copies 32 bytes into the mapped file, no
+** system call is executed. Writers are serialised by a spin lock, which is uncontended in
+** normal operation.
+**
+** Opening, mapping and unmapping of files is done by service(), which must be called
+** cyclically from the application thread.
+*/
+class CoTraceRecorder : public CoCanListener {
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoTraceRecorder();
+
+   ~CoTraceRecorder();
+
+   void           canFrameReceived(const struct can_frame & tsFrameR, uint64_t uqTimeStampV, bool btLocalV) override;
+
+   void           close(void);
+
+   bool           isOpen(void) const   { return (btOpenP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szFileV    - base name of the trace files, the file index is appended
+   ** \param[in]  ulRecordsV - number of records per file
+   ** \param[in]  ulFilesV   - number of files used in turns
+   ** \return     true if the first file has been created
+   **
+   ** The recorder continues with the file following the most recent one of a previous run,
+   ** so the trace of the previous run is overwritten last.
+   */
+   bool           open(const char * szFileV, uint32_t ulRecordsV = CO_TRACE_FILE_RECORDS,
+                       uint32_t ulFilesV = CO_TRACE_FILE_COUNT);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  ubTypeV    - record type, CoTraceType_e
+   ** \param[in]  ubNetV     - CANopen network
+   ** \param[in]  ubNodeIdV  - node-ID
+   ** \param[in]  ubValueV   - type specific value
+   ** \param[in]  uwIndexV   - object index or PDO number
+   ** \param[in]  ubSubIndexV- object sub-index
+   ** \param[in]  ulValueV   - type specific value
+   **
+   ** Write a CANopen event record, the function can be called from any thread.
+   */
+   void           record(uint8_t ubTypeV, uint8_t ubNetV, uint8_t ubNodeIdV, uint8_t ubValueV = 0,
+                         uint16_t uwIndexV = 0, uint8_t ubSubIndexV = 0, uint32_t ulValueV = 0);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** Prepare the next file and release a file which has been replaced. The function must be
+   ** called cyclically by the application thread.
+   */
+   void           service(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of records which overwrote older records of the same file because
+   **             the next file was not ready
+   */
+   uint32_t       wrappedRecords(void) const    { return (ulWrapCntP.load(std::memory_order_relaxed)); }
+
+private:
+
+   //-----------------------------------------------------------------------------------------
+   // mapping of one trace file
+   //
+   typedef struct TraceFile_s {
+      CoTraceHeader_ts *   ptsHeader;
+      CoTraceRecord_ts *   ptsRecord;
+      uint32_t             ulSize;
+   } TraceFile_ts;
+
+   TraceFile_ts *    mapFile(uint32_t ulFileSeqV);
+
+   void              unmapFile(TraceFile_ts * ptsFileV);
+
+   CoTraceRecord_ts *   beginRecord(void);
+
+   void              endRecord(CoTraceRecord_ts * ptsRecordV);
+
+   char                          aszFileP[256];
+   uint32_t                      ulRecordCntP;
+   uint32_t                      ulFileCntP;
+   uint32_t                      ulFileSeqP;          // sequence number of next file to map
+   bool                          btOpenP;
+
+   std::atomic_flag              btWriteLockP;
+   TraceFile_ts *                ptsFileP;            // file in use, protected by btWriteLockP
+   uint64_t                      uqWriteCntP;         // records written to ptsFileP
+
+   std::atomic<TraceFile_ts *>   ptsNextP;            // prepared by service()
+   std::atomic<TraceFile_ts *>   ptsRetiredP;         // released by service()
+   std::atomic<uint32_t>         ulWrapCntP;
+};
+
+
+#endif /*CO_TRACE_RECORDER_HPP_*/
@@ -0,0 +1,364 @@
+//====================================================================================================================//
+// File:          co_trace_replay.cpp                                                                                 //
+// Description:   Replay of a recorded trace on a CAN interface                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_trace_replay.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/can/raw.h>
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::CoTraceReplay()                                                                                     //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceReplay::CoTraceReplay(QObject * pclParentV)
+   : QThread(pclParentV)
+{
+   aszFileP[0] = 0;
+   ulFileCntP  = 0;
+   slSocketP   = -1;
+   flSpeedP    = 1.0;
+   btStopP     = false;
+   ulFrameCntP = 0;
+   ulFailCntP  = 0;
+   uqDurationP = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::~CoTraceReplay()                                                                                    //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+CoTraceReplay::~CoTraceReplay()
+{
+   stop();
+
+   if (slSocketP >= 0)
+   {
+      ::close(slSocketP);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::open()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoTraceReplay::open(const char * szFileV, const char * szInterfaceV)
+{
+   char                 aszNameT[sizeof(aszFileP) + 12];
+   uint32_t             aulSeqT[CO_TRACE_FILE_COUNT];
+   CoTraceHeader_ts     tsHeaderT;
+   struct ifreq         tsIfReqT;
+   struct sockaddr_can  tsAddrT;
+   struct can_filter    tsFilterT;
+   int32_t              slFdT;
+   uint32_t             ulPosT;
+
+   if ((szFileV == nullptr) || (strlen(szFileV) >= sizeof(aszFileP)) ||
+       (szInterfaceV == nullptr) || (strlen(szInterfaceV) >= IFNAMSIZ))
+   {
+      return (false);
+   }
+   strcpy(aszFileP, szFileV);
+
+   //---------------------------------------------------------------------------------------------------
+   // collect the trace files, sorted by their sequence number
+   //
+   ulFileCntP = 0;
+   for (uint32_t ulFileT = 0; ulFileT < CO_TRACE_FILE_COUNT; ulFileT++)
+   {
+      snprintf(aszNameT, sizeof(aszNameT), "%s.%u", aszFileP, ulFileT);
+      slFdT = ::open(aszNameT, O_RDONLY | O_CLOEXEC);
+      if (slFdT < 0)
+      {
+         continue;
+      }
+
+      if ((pread(slFdT, &tsHeaderT, sizeof(tsHeaderT), 0) == (ssize_t) sizeof(tsHeaderT)) &&
+          (tsHeaderT.ulMagic == CO_TRACE_MAGIC) && (tsHeaderT.ulRecordSize == sizeof(CoTraceRecord_ts)))
+      {
+         ulPosT = ulFileCntP;
+         while ((ulPosT > 0) && (aulSeqT[ulPosT - 1] > tsHeaderT.ulFileSeq))
+         {
+            aulSeqT[ulPosT]     = aulSeqT[ulPosT - 1];
+            aulFileIdxP[ulPosT] = aulFileIdxP[ulPosT - 1];
+            ulPosT--;
+         }
+         aulSeqT[ulPosT]     = tsHeaderT.ulFileSeq;
+         aulFileIdxP[ulPosT] = ulFileT;
+         ulFileCntP++;
+      }
+      ::close(slFdT);
+   }
+
+   if (ulFileCntP == 0)
+   {
+      return (false);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // open a raw socket for transmission, received frames are not needed
+   //
+   slSocketP = ::socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+   if (slSocketP < 0)
+   {
+      return (false);
+   }
+
+   memset(&tsIfReqT, 0, sizeof(tsIfReqT));
+   strncpy(tsIfReqT.ifr_name, szInterfaceV, IFNAMSIZ - 1);
+   if (::ioctl(slSocketP, SIOCGIFINDEX, &tsIfReqT) < 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+      return (false);
+   }
+
+   memset(&tsFilterT, 0, sizeof(tsFilterT));
+   tsFilterT.can_id   = CAN_EFF_FLAG;
+   tsFilterT.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK;
+   setsockopt(slSocketP, SOL_CAN_RAW, CAN_RAW_FILTER, &tsFilterT, sizeof(tsFilterT));
+
+   memset(&tsAddrT, 0, sizeof(tsAddrT));
+   tsAddrT.can_family  = AF_CAN;
+   tsAddrT.can_ifindex = tsIfReqT.ifr_ifindex;
+   if (::bind(slSocketP, (struct sockaddr *) &tsAddrT, sizeof(tsAddrT)) < 0)
+   {
+      ::close(slSocketP);
+      slSocketP = -1;
+      return (false);
+   }
+
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::replayFile()                                                                                        //
+// replay the frames of one trace file                                                                                //
+//--------------------------------------------------------------------------------------------------------------------//
+bool CoTraceReplay::replayFile(const char * szNameV, uint64_t & uqStartR, uint64_t & uqBaseR)
+{
+   const CoTraceHeader_ts *   ptsHeaderT;
+   const CoTraceRecord_ts *   ptsRecordT;
+   struct can_frame           tsFrameT;
+   uint64_t                   uqWriteCntT;
+   uint64_t                   uqFirstT;
+   uint32_t                   ulSizeT = 0;
+   bool                       btSentT;
+   int32_t                    slFdT;
+   void *                     pvMemT;
+
+   slFdT = ::open(szNameV, O_RDONLY | O_CLOEXEC);
+   if (slFdT < 0)
+   {
+      return (true);
+   }
+
+   pvMemT = MAP_FAILED;
+   if (lseek(slFdT, 0, SEEK_END) >= (off_t) sizeof(CoTraceHeader_ts))
+   {
+      ulSizeT = (uint32_t) lseek(slFdT, 0, SEEK_END);
+      pvMemT  = mmap(nullptr, ulSizeT, PROT_READ, MAP_PRIVATE, slFdT, 0);
+   }
+   ::close(slFdT);
+   if (pvMemT == MAP_FAILED)
+   {
+      return (true);
+   }
+
+   ptsHeaderT = (const CoTraceHeader_ts *) pvMemT;
+   ptsRecordT = (const CoTraceRecord_ts *) (ptsHeaderT + 1);
+
+   //---------------------------------------------------------------------------------------------------
+   // a file which has wrapped starts with the record following the most recent one
+   //
+   uqWriteCntT = ptsHeaderT->uqWriteCount;
+   uqFirstT    = 0;
+   if (uqWriteCntT > ptsHeaderT->ulRecordCount)
+   {
+      uqFirstT = uqWriteCntT - ptsHeaderT->ulRecordCount;
+   }
+   if (ulSizeT < (sizeof(CoTraceHeader_ts) + ((uint64_t) ptsHeaderT->ulRecordCount * sizeof(CoTraceRecord_ts))))
+   {
+      uqWriteCntT = 0;
+   }
+
+   for (uint64_t uqRecordT = uqFirstT; uqRecordT < uqWriteCntT; uqRecordT++)
+   {
+      const CoTraceRecord_ts * ptsEntryT = &ptsRecordT[uqRecordT % ptsHeaderT->ulRecordCount];
+
+      if (btStopP.load(std::memory_order_relaxed))
+      {
+         munmap(pvMemT, ulSizeT);
+         return (false);
+      }
+
+      if ((ptsEntryT->ubType != eCO_TRACE_CAN_FRAME) || ((ptsEntryT->ubValue & CO_TRACE_FLAG_LOCAL) != 0))
+      {
+         continue;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // the time of the first frame is the reference for the timing of all other frames
+      //
+      if (uqBaseR == 0)
+      {
+         uqBaseR  = ptsEntryT->uqTimeStamp;
+         uqStartR = CoCanTap::timeStamp();
+      }
+      if ((flSpeedP > 0) && (ptsEntryT->uqTimeStamp > uqBaseR))
+      {
+         sleepUntil(uqStartR + (uint64_t) ((double) (ptsEntryT->uqTimeStamp - uqBaseR) / flSpeedP));
+      }
+
+      memset(&tsFrameT, 0, sizeof(tsFrameT));
+      tsFrameT.can_id  = ptsEntryT->ulValue;
+      tsFrameT.can_dlc = (ptsEntryT->ubDlc <= 8) ? ptsEntryT->ubDlc : 8;
+      memcpy(&tsFrameT.data[0], &ptsEntryT->aubData[0], sizeof(tsFrameT.data));
+
+      //-------------------------------------------------------------------------------------------
+      // the transmit queue of the interface may be full at maximum speed, try again later
+      //
+      btSentT = true;
+      while (::write(slSocketP, &tsFrameT, sizeof(tsFrameT)) != (ssize_t) sizeof(tsFrameT))
+      {
+         if ((errno != ENOBUFS) || btStopP.load(std::memory_order_relaxed))
+         {
+            btSentT = false;
+            break;
+         }
+         usleep(100);
+      }
+
+      if (btSentT)
+      {
+         ulFrameCntP++;
+      }
+      else
+      {
+         ulFailCntP++;
+      }
+   }
+
+   munmap(pvMemT, ulSizeT);
+   return (true);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::run()                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceReplay::run()
+{
+   char     aszNameT[sizeof(aszFileP) + 12];
+   uint64_t uqStartT = 0;
+   uint64_t uqBaseT  = 0;
+
+   ulFrameCntP = 0;
+   ulFailCntP  = 0;
+
+   for (uint32_t ulFileT = 0; ulFileT < ulFileCntP; ulFileT++)
+   {
+      snprintf(aszNameT, sizeof(aszNameT), "%s.%u", aszFileP, aulFileIdxP[ulFileT]);
+      if (replayFile(aszNameT, uqStartT, uqBaseT) == false)
+      {
+         break;
+      }
+   }
+
+   uqDurationP = (uqBaseT != 0) ? (CoCanTap::timeStamp() - uqStartT) : 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::sleepUntil()                                                                                        //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceReplay::sleepUntil(uint64_t uqTimeV)
+{
+   struct timespec tsTimeT;
+   uint64_t        uqWakeUpT;
+   uint64_t        uqNowT;
+
+   //---------------------------------------------------------------------------------------------------
+   // Long gaps of the trace are split into steps of 100 ms, so stop() doesn't have to wait for
+   // the end of the gap.
+   //
+   while ((uqNowT = CoCanTap::timeStamp()) < uqTimeV)
+   {
+      if (btStopP.load(std::memory_order_relaxed))
+      {
+         break;
+      }
+
+      uqWakeUpT = uqTimeV;
+      if ((uqTimeV - uqNowT) > 100000000)
+      {
+         uqWakeUpT = uqNowT + 100000000;
+      }
+
+      tsTimeT.tv_sec  = (time_t) (uqWakeUpT / 1000000000);
+      tsTimeT.tv_nsec = (long)   (uqWakeUpT % 1000000000);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tsTimeT, nullptr);
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// CoTraceReplay::stop()                                                                                              //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+void CoTraceReplay::stop(void)
+{
+   if (isRunning())
+   {
+      btStopP.store(true, std::memory_order_relaxed);
+      wait();
+   }
+}
@@ -0,0 +1,139 @@
+//====================================================================================================================//
+// File:          co_trace_replay.hpp                                                                                 //
+// Description:   Replay of a recorded trace on a CAN interface                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_trace_replay.hpp
+** \brief   Replay of a recorded trace on a CAN interface
+**
+** The replay reads the files written by CoTraceRecorder and transmits the recorded CAN frames
+** on a CAN interface, usually a virtual CAN interface (vcan). Only frames received from other
+** devices are replayed; frames which had been transmitted by the master are generated again by
+** the CANopen master library while it processes the replayed traffic.
+*/
+#ifndef CO_TRACE_REPLAY_HPP_
+#define CO_TRACE_REPLAY_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <QtCore/QThread>
+
+#include "co_trace_recorder.hpp"
+
+
+//-----------------------------------------------------------------------------------------------------------
+/*!
+** \class   CoTraceReplay
+** \brief   Replay of a recorded trace on a CAN interface
+**
+** The frames are transmitted by a separate thread at the recorded timing, scaled by the replay
+** speed. A speed of 0 transmits the frames as fast as possible.
+*/
+class CoTraceReplay : public QThread {
+
+   Q_OBJECT
+
+public:
+   //--------------------------------------------------------------------------------------------------------
+   CoTraceReplay(QObject * pclParentV = nullptr);
+
+   ~CoTraceReplay();
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     duration of the replay in nano-seconds
+   */
+   uint64_t       duration(void) const          { return (uqDurationP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of frames which could not be transmitted
+   */
+   uint32_t       failedFrames(void) const      { return (ulFailCntP); }
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  szFileV       - base name of the trace files, see CoTraceRecorder::open()
+   ** \param[in]  szInterfaceV  - CAN interface used for transmission, e.g. vcan0
+   ** \return     true if at least one trace file has been found and the interface is open
+   **
+   ** The trace files are ordered by their sequence number, the records of each file are
+   ** replayed from the oldest to the most recent one.
+   */
+   bool           open(const char * szFileV, const char * szInterfaceV);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \param[in]  flSpeedV      - time scale, 1.0 for original timing, 0 for maximum speed
+   */
+   void           setSpeed(double flSpeedV)     { flSpeedP = flSpeedV; }
+
+   void           stop(void);
+
+   //---------------------------------------------------------------------------------------------------
+   /*!
+   ** \return     number of transmitted frames
+   */
+   uint32_t       transmittedFrames(void) const { return (ulFrameCntP); }
+
+protected:
+
+   void           run() override;
+
+private:
+
+   bool           replayFile(const char * szNameV, uint64_t & uqStartR, uint64_t & uqBaseR);
+
+   void           sleepUntil(uint64_t uqTimeV);
+
+   char                    aszFileP[256];
+   uint32_t                aulFileIdxP[CO_TRACE_FILE_COUNT];   // file index ordered by sequence
+   uint32_t                ulFileCntP;
+
+   int32_t                 slSocketP;
+   double                  flSpeedP;
+   std::atomic<bool>       btStopP;
+
+   uint32_t                ulFrameCntP;
+   uint32_t                ulFailCntP;
+   uint64_t                uqDurationP;
+};
+
+
+#endif /*CO_TRACE_REPLAY_HPP_*/
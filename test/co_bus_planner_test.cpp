@@ -0,0 +1,215 @@
+//====================================================================================================================//
+// File:          co_bus_planner_test.cpp                                                                             //
+// Description:   Unit test of CoBusPlanner                                                                           //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_bus_planner.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testDisabled(void);
+static void    testGrowth(void);
+static void    testOverBudget(void);
+static void    testPhase(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testDisabled();
+   testGrowth();
+   testOverBudget();
+   testPhase();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testDisabled()                                                                                                     //
+// without a budget the fixed producer time is used                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testDisabled(void)
+{
+   CoBusPlanner clPlannerT;
+
+   CO_TEST_CHECK(clPlannerT.isEnabled() == false);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 500);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 1500);
+   CO_TEST_EQUAL(clPlannerT.inhibitTime(), 0);
+
+   clPlannerT.setHeartbeatTime(200);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 200);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 600);
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= 20; ubNodeIdT++)
+   {
+      CO_TEST_CHECK(clPlannerT.addNode(ubNodeIdT) == false);
+   }
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 200);
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(1, 12345), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testGrowth()                                                                                                       //
+// the plan is made for a power of two of devices and only changes if this number is exceeded                         //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testGrowth(void)
+{
+   CoBusPlanner clPlannerT;
+
+   //---------------------------------------------------------------------------------------------------
+   // 500 kbit/s, 30 % budget, 20 % for PDOs: 50000 bit/s remain for the heartbeats
+   //
+   clPlannerT.setBudget(500000, 30, 20);
+   CO_TEST_CHECK(clPlannerT.isEnabled());
+   CO_TEST_EQUAL(clPlannerT.nodeCount(), CO_PLAN_NODE_MIN);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), CO_PLAN_HEARTBEAT_MIN);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 170);
+   CO_TEST_EQUAL(clPlannerT.inhibitTime(), 432);
+
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= 8; ubNodeIdT++)
+   {
+      CO_TEST_CHECK(clPlannerT.addNode(ubNodeIdT) == false);
+   }
+   CO_TEST_CHECK(clPlannerT.addNode(8) == false);
+   CO_TEST_CHECK(clPlannerT.addNode(0) == false);
+   CO_TEST_CHECK(clPlannerT.addNode(CO_PLAN_NODE_MAX + 1) == false);
+   CO_TEST_EQUAL(clPlannerT.nodeCount(), 8);
+
+   CO_TEST_CHECK(clPlannerT.addNode(100));
+   CO_TEST_EQUAL(clPlannerT.nodeCount(), 16);
+   CO_TEST_EQUAL(clPlannerT.inhibitTime(), 864);
+
+   //---------------------------------------------------------------------------------------------------
+   // all devices: 127 * 65 bit within 50000 bit/s is 166 ms, rounded up to the timer tick
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_PLAN_NODE_MAX; ubNodeIdT++)
+   {
+      clPlannerT.addNode(ubNodeIdT);
+   }
+   CO_TEST_EQUAL(clPlannerT.nodeCount(), CO_PLAN_NODE_MAX);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 170);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 275);
+   CO_TEST_EQUAL(clPlannerT.inhibitTime(), 6858);
+   CO_TEST_CHECK(clPlannerT.isOverBudget() == false);
+
+   clPlannerT.reset();
+   CO_TEST_EQUAL(clPlannerT.nodeCount(), CO_PLAN_NODE_MIN);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), CO_PLAN_HEARTBEAT_MIN);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testOverBudget()                                                                                                   //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testOverBudget(void)
+{
+   CoBusPlanner clPlannerT;
+
+   //---------------------------------------------------------------------------------------------------
+   // 125 kbit/s, 5 % budget: 6250 bit/s for 127 heartbeats
+   //
+   clPlannerT.setBudget(125000, 5, 0);
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_PLAN_NODE_MAX; ubNodeIdT++)
+   {
+      clPlannerT.addNode(ubNodeIdT);
+   }
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 1330);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 2015);
+   CO_TEST_EQUAL(clPlannerT.inhibitTime(), 0);
+   CO_TEST_CHECK(clPlannerT.isOverBudget() == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // the PDOs use the whole budget
+   //
+   clPlannerT.setBudget(125000, 10, 10);
+   CO_TEST_CHECK(clPlannerT.isOverBudget());
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), CO_PLAN_HEARTBEAT_MAX);
+   CO_TEST_EQUAL(clPlannerT.consumerTime(), 15020);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testPhase()                                                                                                        //
+// the phases of all node-IDs are different and spread over the producer time                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testPhase(void)
+{
+   CoBusPlanner clPlannerT;
+   bool         abtPhaseT[128] = { false };
+   bool         btUniqueT = true;
+   uint32_t     ulDelayT;
+   uint32_t     ulPhaseT;
+
+   clPlannerT.setBudget(500000, 30, 0);
+   CO_TEST_EQUAL(clPlannerT.heartbeatTime(), 100);
+
+   //---------------------------------------------------------------------------------------------------
+   // node 1 has half of the period as phase
+   //
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(1, 0), 50000);
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(1, 30000), 20000);
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(1, 260000), 90000);
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(64, 0), 781);
+   CO_TEST_EQUAL(clPlannerT.phaseDelay(0, 0), 0);
+
+   //---------------------------------------------------------------------------------------------------
+   // each node-ID has its own 1/128 of the period
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_PLAN_NODE_MAX; ubNodeIdT++)
+   {
+      ulDelayT = clPlannerT.phaseDelay(ubNodeIdT, 0);
+      ulPhaseT = ((ulDelayT * 128) + 50000) / 100000;
+      if ((ulPhaseT >= 128) || abtPhaseT[ulPhaseT])
+      {
+         btUniqueT = false;
+      }
+      else
+      {
+         abtPhaseT[ulPhaseT] = true;
+      }
+   }
+   CO_TEST_CHECK(btUniqueT);
+}
@@ -0,0 +1,260 @@
+//====================================================================================================================//
+// File:          co_emcy_history_test.cpp                                                                            //
+// Description:   Unit test of CoEmcyHistory                                                                          //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_emcy_history.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_NODE_ID               ((uint8_t)      10)
+#define  MS_TO_NS(ms)               ((uint64_t) (ms) * 1000000)
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static bool    recordEmcy(CoEmcyHistory & clHistoryR, uint16_t uwCodeV, uint8_t ubRegisterV, uint64_t uqTimeV,
+                          uint32_t & ulSuppressedR);
+static void    testCoalesce(void);
+static void    testOrder(void);
+static void    testRate(void);
+static void    testStorm(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testCoalesce();
+   testOrder();
+   testStorm();
+   testRate();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// recordEmcy()                                                                                                       //
+// record an EMCY of the test node, the manufacturer specific field holds the low byte of the time in [ms]            //
+//--------------------------------------------------------------------------------------------------------------------//
+static bool recordEmcy(CoEmcyHistory & clHistoryR, uint16_t uwCodeV, uint8_t ubRegisterV, uint64_t uqTimeV,
+                       uint32_t & ulSuppressedR)
+{
+   uint8_t aubDataT[8] = { 0 };
+
+   aubDataT[0] = (uint8_t) (uwCodeV & 0xFF);
+   aubDataT[1] = (uint8_t) (uwCodeV >> 8);
+   aubDataT[2] = ubRegisterV;
+   aubDataT[3] = (uint8_t) (uqTimeV / 1000000);
+
+   return (clHistoryR.record(TEST_NODE_ID, &aubDataT[0], uqTimeV, ulSuppressedR));
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testCoalesce()                                                                                                     //
+// an EMCY of a stored error updates this entry and makes it the latest one                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testCoalesce(void)
+{
+   CoEmcyHistory  clHistoryT;
+   CoEmcyEntry_ts tsEntryT;
+   uint32_t       ulSuppressedT;
+
+   clHistoryT.setRate(0);
+   recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(1), ulSuppressedT);
+   recordEmcy(clHistoryT, 0x2000, 0x01, MS_TO_NS(2), ulSuppressedT);
+   recordEmcy(clHistoryT, 0x3000, 0x01, MS_TO_NS(3), ulSuppressedT);
+   recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(4), ulSuppressedT);
+
+   //---------------------------------------------------------------------------------------------------
+   // the same code with another error register is another error
+   //
+   recordEmcy(clHistoryT, 0x2000, 0x05, MS_TO_NS(5), ulSuppressedT);
+
+   CO_TEST_EQUAL(clHistoryT.count(TEST_NODE_ID), 5);
+   CO_TEST_EQUAL(clHistoryT.count(TEST_NODE_ID + 1), 0);
+
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 0, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x2000);
+   CO_TEST_EQUAL(tsEntryT.ubRegister, 0x05);
+
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 1, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x1000);
+   CO_TEST_EQUAL(tsEntryT.ulCount, 2);
+   CO_TEST_EQUAL(tsEntryT.uqFirst, MS_TO_NS(1));
+   CO_TEST_EQUAL(tsEntryT.uqLast, MS_TO_NS(4));
+   CO_TEST_EQUAL(tsEntryT.aubManufacturer[0], 4);
+
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 2, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x3000);
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 3, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x2000);
+   CO_TEST_EQUAL(tsEntryT.ubRegister, 0x01);
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 4, tsEntryT) == false);
+
+   clHistoryT.reset();
+   CO_TEST_EQUAL(clHistoryT.count(TEST_NODE_ID), 0);
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 0, tsEntryT) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testOrder()                                                                                                        //
+// a new error replaces the least recently seen entry of a full ring                                                  //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testOrder(void)
+{
+   CoEmcyHistory  clHistoryT;
+   CoEmcyEntry_ts tsEntryT;
+   uint32_t       ulSuppressedT;
+
+   clHistoryT.setRate(0);
+   for (uint32_t ulIdxT = 0; ulIdxT < CO_EMCY_HISTORY_DEPTH; ulIdxT++)
+   {
+      recordEmcy(clHistoryT, (uint16_t) (0x5000 + ulIdxT), 0x01, MS_TO_NS(ulIdxT), ulSuppressedT);
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // 0x5000 is the latest error now, so 0x5001 is replaced
+   //
+   recordEmcy(clHistoryT, 0x5000, 0x01, MS_TO_NS(100), ulSuppressedT);
+   recordEmcy(clHistoryT, 0x6000, 0x01, MS_TO_NS(101), ulSuppressedT);
+
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 0, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x6000);
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 1, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x5000);
+   CO_TEST_EQUAL(tsEntryT.ulCount, 2);
+
+   for (uint32_t ulIdxT = 2; ulIdxT < CO_EMCY_HISTORY_DEPTH; ulIdxT++)
+   {
+      CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, ulIdxT, tsEntryT));
+      CO_TEST_EQUAL(tsEntryT.uwCode, 0x5000 + CO_EMCY_HISTORY_DEPTH + 1 - ulIdxT);
+   }
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, CO_EMCY_HISTORY_DEPTH, tsEntryT) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testRate()                                                                                                         //
+// notifications above the rate are suppressed and counted                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testRate(void)
+{
+   CoEmcyHistory  clHistoryT;
+   uint32_t       ulSuppressedT;
+
+   //---------------------------------------------------------------------------------------------------
+   // default: burst of 5 notifications, afterwards one every 200 ms
+   //
+   for (uint32_t ulIdxT = 0; ulIdxT < CO_EMCY_RATE_DEFAULT; ulIdxT++)
+   {
+      CO_TEST_CHECK(recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(1000), ulSuppressedT));
+      CO_TEST_EQUAL(ulSuppressedT, 0);
+   }
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(1000), ulSuppressedT) == false);
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x2000, 0x01, MS_TO_NS(1100), ulSuppressedT) == false);
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x2000, 0x01, MS_TO_NS(1199), ulSuppressedT) == false);
+
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x2000, 0x01, MS_TO_NS(1200), ulSuppressedT));
+   CO_TEST_EQUAL(ulSuppressedT, 3);
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x2000, 0x01, MS_TO_NS(1300), ulSuppressedT) == false);
+   CO_TEST_EQUAL(clHistoryT.count(TEST_NODE_ID), 10);
+
+   //---------------------------------------------------------------------------------------------------
+   // the bucket is full again after one second
+   //
+   for (uint32_t ulIdxT = 0; ulIdxT < CO_EMCY_RATE_DEFAULT; ulIdxT++)
+   {
+      CO_TEST_CHECK(recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(3000), ulSuppressedT));
+   }
+   CO_TEST_CHECK(recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(3000), ulSuppressedT) == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // no limit
+   //
+   clHistoryT.setRate(0);
+   for (uint32_t ulIdxT = 0; ulIdxT < 100; ulIdxT++)
+   {
+      CO_TEST_CHECK(recordEmcy(clHistoryT, 0x1000, 0x01, MS_TO_NS(3000), ulSuppressedT));
+   }
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testStorm()                                                                                                        //
+// a repeated error does not push the other errors out of the ring                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testStorm(void)
+{
+   CoEmcyHistory  clHistoryT;
+   CoEmcyEntry_ts tsEntryT;
+   uint32_t       ulSuppressedT;
+   uint32_t       ulFoundT = 0;
+
+   for (uint32_t ulIdxT = 0; ulIdxT < CO_EMCY_HISTORY_DEPTH; ulIdxT++)
+   {
+      recordEmcy(clHistoryT, (uint16_t) (0x8000 + ulIdxT), 0x80, MS_TO_NS(ulIdxT), ulSuppressedT);
+   }
+   for (uint32_t ulIdxT = 0; ulIdxT < 10000; ulIdxT++)
+   {
+      recordEmcy(clHistoryT, 0x8003, 0x80, MS_TO_NS(10 + ulIdxT), ulSuppressedT);
+   }
+
+   CO_TEST_CHECK(clHistoryT.entry(TEST_NODE_ID, 0, tsEntryT));
+   CO_TEST_EQUAL(tsEntryT.uwCode, 0x8003);
+   CO_TEST_EQUAL(tsEntryT.ulCount, 10001);
+
+   for (uint32_t ulIdxT = 0; ulIdxT < CO_EMCY_HISTORY_DEPTH; ulIdxT++)
+   {
+      if (clHistoryT.entry(TEST_NODE_ID, ulIdxT, tsEntryT) && ((tsEntryT.uwCode & 0xFFF8) == 0x8000))
+      {
+         ulFoundT |= (uint32_t) 1 << (tsEntryT.uwCode & 0x07);
+      }
+   }
+   CO_TEST_EQUAL(ulFoundT, 0xFF);
+   CO_TEST_EQUAL(clHistoryT.count(TEST_NODE_ID), CO_EMCY_HISTORY_DEPTH + 10000);
+}
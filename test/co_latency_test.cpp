@@ -0,0 +1,225 @@
+//====================================================================================================================//
+// File:          co_latency_test.cpp                                                                                 //
+// Description:   Unit test of CoLatencyHistogram and CoLatency                                                       //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_latency.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_TICK_PERIOD           ((uint32_t)   1000)        // tick period in micro-seconds
+#define  TEST_TICK_PERIOD_NS        ((uint64_t) 1000000)       // tick period in nano-seconds
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testHistogramExact(void);
+static void    testHistogramPrecision(void);
+static void    testHistogramStatistics(void);
+static void    testTickOverrun(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testHistogramExact();
+   testHistogramPrecision();
+   testHistogramStatistics();
+   testTickOverrun();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testHistogramExact()                                                                                               //
+// small values have a bucket of their own                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testHistogramExact(void)
+{
+   CoLatencyHistogram clHistogramT;
+
+   CO_TEST_EQUAL(clHistogramT.percentile(500), 0);
+   CO_TEST_EQUAL(clHistogramT.mean(), 0);
+
+   for (uint64_t uqValueT = 0; uqValueT < 32; uqValueT++)
+   {
+      clHistogramT.record(uqValueT);
+   }
+
+   CO_TEST_EQUAL(clHistogramT.count(), 32);
+   CO_TEST_EQUAL(clHistogramT.sum(), 496);
+   CO_TEST_EQUAL(clHistogramT.maximum(), 31);
+   CO_TEST_EQUAL(clHistogramT.mean(), 15);
+   CO_TEST_EQUAL(clHistogramT.percentile(0), 0);
+   CO_TEST_EQUAL(clHistogramT.percentile(500), 15);
+   CO_TEST_EQUAL(clHistogramT.percentile(1000), 31);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testHistogramPrecision()                                                                                           //
+// the upper bound of a bucket is above the value by less than 1/16 of the value                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testHistogramPrecision(void)
+{
+   CoLatencyHistogram clHistogramT;
+   uint64_t           uqLimitT;
+   bool               btBoundT = true;
+
+   //---------------------------------------------------------------------------------------------------
+   // The larger value keeps the percentile from being limited to the maximum, values are taken
+   // around each power of two.
+   //
+   for (uint32_t ulShiftT = 5; ulShiftT < 36; ulShiftT++)
+   {
+      for (int64_t sqOffsetT = -3; sqOffsetT <= 3; sqOffsetT++)
+      {
+         uint64_t uqValueT = (((uint64_t) 1) << ulShiftT) + sqOffsetT;
+
+         clHistogramT.reset();
+         clHistogramT.record(uqValueT);
+         clHistogramT.record(((uint64_t) 1) << 37);
+
+         uqLimitT = clHistogramT.percentile(500);
+         if ((uqLimitT < uqValueT) || ((uqLimitT - uqValueT) >= (uqValueT / 16)))
+         {
+            fprintf(stderr, "value %llu: bucket limit %llu\n", (unsigned long long) uqValueT,
+                    (unsigned long long) uqLimitT);
+            btBoundT = false;
+         }
+      }
+   }
+   CO_TEST_CHECK(btBoundT);
+
+   //---------------------------------------------------------------------------------------------------
+   // values which are too large are reported as maximum
+   //
+   clHistogramT.reset();
+   clHistogramT.record(((uint64_t) 1) << 40);
+   clHistogramT.record(((uint64_t) 1) << 42);
+   CO_TEST_EQUAL(clHistogramT.percentile(500), ((uint64_t) 1) << 42);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testHistogramStatistics()                                                                                          //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testHistogramStatistics(void)
+{
+   CoLatencyHistogram clHistogramT;
+
+   for (uint64_t uqValueT = 1; uqValueT <= 100; uqValueT++)
+   {
+      clHistogramT.record(uqValueT * 1000);
+   }
+
+   CO_TEST_EQUAL(clHistogramT.count(), 100);
+   CO_TEST_EQUAL(clHistogramT.mean(), 50500);
+   CO_TEST_EQUAL(clHistogramT.maximum(), 100000);
+
+   CO_TEST_CHECK(clHistogramT.percentile(500) >= 50000);
+   CO_TEST_CHECK(clHistogramT.percentile(500) < 50000 + (50000 / 16));
+   CO_TEST_CHECK(clHistogramT.percentile(990) >= 99000);
+   CO_TEST_EQUAL(clHistogramT.percentile(1000), 100000);
+
+   clHistogramT.reset();
+   CO_TEST_EQUAL(clHistogramT.count(), 0);
+   CO_TEST_EQUAL(clHistogramT.maximum(), 0);
+   CO_TEST_EQUAL(clHistogramT.percentile(990), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testTickOverrun()                                                                                                  //
+// a tick delayed by more than one period is an overrun, the path with the largest share is its cause                 //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testTickOverrun(void)
+{
+   CoLatency clLatencyT(TEST_TICK_PERIOD);
+   uint64_t  uqTimeT = 1000000000;
+
+   CO_TEST_CHECK(clLatencyT.beginTick(uqTimeT) == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // the slot runs inside ComMgrProcess(), its time is not counted twice
+   //
+   clLatencyT.recordLocal(eCO_LATENCY_SLOT_PDO_RECEIVE, 3000000);
+   clLatencyT.recordLocal(eCO_LATENCY_MGR_PROCESS,      3500000);
+   clLatencyT.recordLocal(eCO_LATENCY_NET_TIMER_EVENT,  1000000);
+   clLatencyT.endTick(uqTimeT + 4500000);
+
+   uqTimeT += TEST_TICK_PERIOD_NS + 4500000;
+   CO_TEST_CHECK(clLatencyT.beginTick(uqTimeT));
+   CO_TEST_EQUAL(clLatencyT.overruns(), 1);
+   CO_TEST_EQUAL(clLatencyT.overrunPath(), eCO_LATENCY_SLOT_PDO_RECEIVE);
+   CO_TEST_EQUAL(clLatencyT.overrunPathTime(), 3000000);
+   CO_TEST_EQUAL(clLatencyT.histogram(eCO_LATENCY_TICK_LATENESS).maximum(), 4500000);
+   CO_TEST_EQUAL(clLatencyT.histogram(eCO_LATENCY_TIMER_TICK).maximum(), 4500000);
+
+   //---------------------------------------------------------------------------------------------------
+   // the stack itself is the cause, the path sums of the last tick are cleared
+   //
+   clLatencyT.recordLocal(eCO_LATENCY_MGR_PROCESS, 2500000);
+   uqTimeT += TEST_TICK_PERIOD_NS + 2500000;
+   CO_TEST_CHECK(clLatencyT.beginTick(uqTimeT));
+   CO_TEST_EQUAL(clLatencyT.overruns(), 2);
+   CO_TEST_EQUAL(clLatencyT.overrunPath(), eCO_LATENCY_MGR_PROCESS);
+   CO_TEST_EQUAL(clLatencyT.overrunPathTime(), 2500000);
+
+   //---------------------------------------------------------------------------------------------------
+   // a delay of up to one period is only lateness
+   //
+   uqTimeT += TEST_TICK_PERIOD_NS + TEST_TICK_PERIOD_NS;
+   CO_TEST_CHECK(clLatencyT.beginTick(uqTimeT) == false);
+   CO_TEST_EQUAL(clLatencyT.overruns(), 2);
+   CO_TEST_EQUAL(clLatencyT.histogram(eCO_LATENCY_TICK_LATENESS).count(), 3);
+
+   clLatencyT.reset();
+   CO_TEST_EQUAL(clLatencyT.overruns(), 0);
+   CO_TEST_EQUAL(clLatencyT.histogram(eCO_LATENCY_SLOT_PDO_RECEIVE).count(), 0);
+   CO_TEST_CHECK(clLatencyT.beginTick(uqTimeT + (10 * TEST_TICK_PERIOD_NS)) == false);
+}
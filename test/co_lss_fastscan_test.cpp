@@ -0,0 +1,277 @@
+//====================================================================================================================//
+// File:          co_lss_fastscan_test.cpp                                                                            //
+// Description:   Unit test of CoLssFastscan                                                                          //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_lss_fastscan.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_DEVICE_MAX            ((uint8_t)       4)        // simulated devices
+#define  TEST_REQUEST_MAX           ((uint32_t)    132)        // requests of one search, w/o confirmation
+
+
+//-------------------------------------------------------------------------------------------------------
+// unconfigured device which answers Fastscan requests, ubSub == CO_LSS_FASTSCAN_SUB_MAX is the
+// configuration state
+//
+typedef struct TestDevice_s {
+   uint32_t    aulIdentity[CO_LSS_FASTSCAN_SUB_MAX];
+   uint8_t     ubSub;
+} TestDevice_ts;
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static bool    answer(TestDevice_ts * ptsDeviceV, uint8_t ubCountV, const CoLssFastscan & clFastscanV);
+static bool    search(TestDevice_ts * ptsDeviceV, uint8_t ubCountV, CoLssFastscan & clFastscanR);
+static void    testLimits(void);
+static void    testLowest(void);
+static void    testSingle(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testSingle();
+   testLimits();
+   testLowest();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// answer()                                                                                                           //
+// evaluate the request by all devices, true if at least one device answers                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static bool answer(TestDevice_ts * ptsDeviceV, uint8_t ubCountV, const CoLssFastscan & clFastscanV)
+{
+   uint32_t ulMaskT    = ~(((uint32_t) 1 << clFastscanV.bitChecked()) - 1);
+   bool     btAnswerT  = false;
+
+   for (uint8_t ubIdxT = 0; ubIdxT < ubCountV; ubIdxT++)
+   {
+      TestDevice_ts * ptsDeviceT = &ptsDeviceV[ubIdxT];
+
+      if (ptsDeviceT->ubSub != clFastscanV.sub())
+      {
+         continue;
+      }
+      if ((ptsDeviceT->aulIdentity[ptsDeviceT->ubSub] & ulMaskT) != (clFastscanV.idNumber() & ulMaskT))
+      {
+         continue;
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // a verified device moves to the next value, after the serial number to configuration state
+      //
+      if (clFastscanV.isVerify())
+      {
+         ptsDeviceT->ubSub = clFastscanV.next();
+         if (ptsDeviceT->ubSub == 0)
+         {
+            ptsDeviceT->ubSub = CO_LSS_FASTSCAN_SUB_MAX;
+         }
+      }
+      btAnswerT = true;
+   }
+
+   return (btAnswerT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// search()                                                                                                           //
+// run the search like CoLssMaster, true if all four values are verified                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+static bool search(TestDevice_ts * ptsDeviceV, uint8_t ubCountV, CoLssFastscan & clFastscanR)
+{
+   uint32_t ulRequestCntT = 0;
+
+   //---------------------------------------------------------------------------------------------------
+   // the confirmation restarts the Fastscan of all unconfigured devices, a configured device
+   // boots with its node-ID and takes no part
+   //
+   for (uint8_t ubIdxT = 0; ubIdxT < ubCountV; ubIdxT++)
+   {
+      if (ptsDeviceV[ubIdxT].ubSub < CO_LSS_FASTSCAN_SUB_MAX)
+      {
+         ptsDeviceV[ubIdxT].ubSub = 0;
+      }
+   }
+
+   clFastscanR.start();
+   while (ulRequestCntT < (2 * TEST_REQUEST_MAX))
+   {
+      bool btAnswerT = answer(ptsDeviceV, ubCountV, clFastscanR);
+
+      ulRequestCntT++;
+      if (clFastscanR.isVerify() == false)
+      {
+         clFastscanR.checked(btAnswerT);
+      }
+      else if (btAnswerT == false)
+      {
+         return (false);
+      }
+      else if (clFastscanR.verified())
+      {
+         CO_TEST_EQUAL(ulRequestCntT, TEST_REQUEST_MAX);
+         return (true);
+      }
+   }
+
+   return (false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testLimits()                                                                                                       //
+// identity values with all bits cleared or set                                                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testLimits(void)
+{
+   TestDevice_ts  atsDeviceT[] = { { { 0x00000000, 0xFFFFFFFF, 0x80000000, 0x00000001 }, 0 } };
+   CoLssFastscan  clFastscanT;
+
+   CO_TEST_CHECK(search(&atsDeviceT[0], 1, clFastscanT));
+   CO_TEST_EQUAL(clFastscanT.identity(0), 0x00000000);
+   CO_TEST_EQUAL(clFastscanT.identity(1), 0xFFFFFFFF);
+   CO_TEST_EQUAL(clFastscanT.identity(2), 0x80000000);
+   CO_TEST_EQUAL(clFastscanT.identity(3), 0x00000001);
+   CO_TEST_EQUAL(clFastscanT.identity(CO_LSS_FASTSCAN_SUB_MAX), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testLowest()                                                                                                       //
+// of several devices the one with the lowest identity is found first, each device is found once                      //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testLowest(void)
+{
+   TestDevice_ts  atsDeviceT[TEST_DEVICE_MAX] = {
+                     { { 0x00000123, 0x00000002, 0x00010000, 0x00001005 }, 0 },
+                     { { 0x00000123, 0x00000002, 0x00010000, 0x00001003 }, 0 },
+                     { { 0x00000123, 0x00000001, 0x00020000, 0x00001009 }, 0 },
+                     { { 0x00000456, 0x00000001, 0x00010000, 0x00001001 }, 0 } };
+   static const uint8_t aubOrderS[TEST_DEVICE_MAX] = { 2, 1, 0, 3 };
+   CoLssFastscan  clFastscanT;
+
+   for (uint8_t ubFoundT = 0; ubFoundT < TEST_DEVICE_MAX; ubFoundT++)
+   {
+      const TestDevice_ts * ptsDeviceT = &atsDeviceT[aubOrderS[ubFoundT]];
+
+      CO_TEST_CHECK(search(&atsDeviceT[0], TEST_DEVICE_MAX, clFastscanT));
+      for (uint8_t ubSubT = 0; ubSubT < CO_LSS_FASTSCAN_SUB_MAX; ubSubT++)
+      {
+         CO_TEST_EQUAL(clFastscanT.identity(ubSubT), ptsDeviceT->aulIdentity[ubSubT]);
+      }
+      CO_TEST_EQUAL(ptsDeviceT->ubSub, CO_LSS_FASTSCAN_SUB_MAX);
+   }
+
+   CO_TEST_CHECK(search(&atsDeviceT[0], TEST_DEVICE_MAX, clFastscanT) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testSingle()                                                                                                       //
+// parameters of the requests for one device                                                                          //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testSingle(void)
+{
+   CoLssFastscan  clFastscanT;
+
+   CO_TEST_EQUAL(clFastscanT.sub(), 0);
+   CO_TEST_EQUAL(clFastscanT.next(), 0);
+   CO_TEST_EQUAL(clFastscanT.bitChecked(), 31);
+   CO_TEST_EQUAL(clFastscanT.idNumber(), 0);
+   CO_TEST_CHECK(clFastscanT.verified() == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // vendor-ID 0xA5A5A5A5: a response keeps the checked bit cleared
+   //
+   for (int32_t slBitT = 31; slBitT >= 0; slBitT--)
+   {
+      CO_TEST_EQUAL(clFastscanT.bitChecked(), slBitT);
+      CO_TEST_CHECK(clFastscanT.isVerify() == false);
+      clFastscanT.checked(((0xA5A5A5A5 >> slBitT) & 1) == 0);
+   }
+   CO_TEST_CHECK(clFastscanT.isVerify());
+   CO_TEST_EQUAL(clFastscanT.idNumber(), 0xA5A5A5A5);
+   CO_TEST_EQUAL(clFastscanT.bitChecked(), 0);
+   CO_TEST_EQUAL(clFastscanT.next(), 1);
+
+   //---------------------------------------------------------------------------------------------------
+   // further bit checks are ignored until the value is verified
+   //
+   clFastscanT.checked(false);
+   CO_TEST_EQUAL(clFastscanT.idNumber(), 0xA5A5A5A5);
+
+   CO_TEST_CHECK(clFastscanT.verified() == false);
+   CO_TEST_EQUAL(clFastscanT.identity(0), 0xA5A5A5A5);
+   CO_TEST_EQUAL(clFastscanT.sub(), 1);
+   CO_TEST_EQUAL(clFastscanT.next(), 1);
+   CO_TEST_EQUAL(clFastscanT.bitChecked(), 31);
+   CO_TEST_EQUAL(clFastscanT.idNumber(), 0);
+
+   //---------------------------------------------------------------------------------------------------
+   // the verification of the serial number requests the vendor-ID as next value
+   //
+   for (uint8_t ubSubT = 1; ubSubT < CO_LSS_FASTSCAN_SUB_MAX; ubSubT++)
+   {
+      for (uint8_t ubBitT = 0; ubBitT < 32; ubBitT++)
+      {
+         clFastscanT.checked(false);
+      }
+      CO_TEST_EQUAL(clFastscanT.next(), (ubSubT + 1) & 0x03);
+      CO_TEST_EQUAL(clFastscanT.verified(), ubSubT == (CO_LSS_FASTSCAN_SUB_MAX - 1));
+   }
+   CO_TEST_EQUAL(clFastscanT.identity(3), 0xFFFFFFFF);
+
+   clFastscanT.start();
+   CO_TEST_EQUAL(clFastscanT.identity(0), 0);
+   CO_TEST_EQUAL(clFastscanT.sub(), 0);
+}
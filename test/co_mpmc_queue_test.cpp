@@ -0,0 +1,185 @@
+//====================================================================================================================//
+// File:          co_mpmc_queue_test.cpp                                                                              //
+// Description:   Unit test of CoMpmcQueue                                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_mpmc_queue.hpp"
+#include "co_test.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_THREAD_CNT            ((uint32_t)      4)        // producer and consumer threads
+#define  TEST_ELEMENT_CNT           ((uint32_t) 200000)        // elements of each producer
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testFillAndDrain(void);
+static void    testThreads(void);
+static void    testWrapAround(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testFillAndDrain();
+   testWrapAround();
+   testThreads();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testFillAndDrain()                                                                                                 //
+// the queue holds SIZE elements in FIFO order                                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testFillAndDrain(void)
+{
+   CoMpmcQueue<uint32_t, 8>   clQueueT;
+   uint32_t                   ulValueT = 0;
+
+   CO_TEST_CHECK(clQueueT.pop(ulValueT) == false);
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 8; ulIdxT++)
+   {
+      CO_TEST_CHECK(clQueueT.push(100 + ulIdxT));
+   }
+   CO_TEST_CHECK(clQueueT.push(200) == false);
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 8; ulIdxT++)
+   {
+      ulValueT = 0;
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, 100 + ulIdxT);
+   }
+   CO_TEST_CHECK(clQueueT.pop(ulValueT) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testThreads()                                                                                                      //
+// several producers and consumers, each element is received exactly once                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testThreads(void)
+{
+   static CoMpmcQueue<uint32_t, 64>  clQueueS;
+   static std::atomic<uint32_t>      ulReceivedS(0);
+   static std::atomic<uint64_t>      uqSumS(0);
+   std::vector<std::thread>          clThreadT;
+   uint64_t                          uqExpectT;
+   uint32_t                          ulValueT;
+
+   for (uint32_t ulThreadT = 0; ulThreadT < TEST_THREAD_CNT; ulThreadT++)
+   {
+      clThreadT.emplace_back([ulThreadT]() {
+         for (uint32_t ulIdxT = 0; ulIdxT < TEST_ELEMENT_CNT; ulIdxT++)
+         {
+            while (clQueueS.push((ulThreadT * TEST_ELEMENT_CNT) + ulIdxT) == false)
+            {
+               std::this_thread::yield();
+            }
+         }
+      });
+
+      clThreadT.emplace_back([]() {
+         uint32_t ulElementT;
+
+         while (ulReceivedS.load() < (TEST_THREAD_CNT * TEST_ELEMENT_CNT))
+         {
+            if (clQueueS.pop(ulElementT))
+            {
+               uqSumS += ulElementT;
+               ulReceivedS++;
+            }
+            else
+            {
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+
+   for (std::thread & clThreadR : clThreadT)
+   {
+      clThreadR.join();
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // the elements are the numbers 0 .. n - 1
+   //
+   uqExpectT = ((uint64_t) TEST_THREAD_CNT * TEST_ELEMENT_CNT);
+   uqExpectT = (uqExpectT * (uqExpectT - 1)) / 2;
+
+   CO_TEST_EQUAL(ulReceivedS.load(), TEST_THREAD_CNT * TEST_ELEMENT_CNT);
+   CO_TEST_EQUAL(uqSumS.load(), uqExpectT);
+   CO_TEST_CHECK(clQueueS.pop(ulValueT) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testWrapAround()                                                                                                   //
+// the sequence numbers of the cells wrap around many times                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testWrapAround(void)
+{
+   CoMpmcQueue<uint32_t, 2>   clQueueT;
+   uint32_t                   ulValueT = 0;
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 100; ulIdxT++)
+   {
+      CO_TEST_CHECK(clQueueT.push(ulIdxT));
+      CO_TEST_CHECK(clQueueT.push(ulIdxT + 1000));
+      CO_TEST_CHECK(clQueueT.push(0) == false);
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, ulIdxT);
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, ulIdxT + 1000);
+   }
+   CO_TEST_CHECK(clQueueT.pop(ulValueT) == false);
+}
@@ -0,0 +1,172 @@
+//====================================================================================================================//
+// File:          co_nmt_batch_test.cpp                                                                               //
+// Description:   Unit test of CoNmtBatch                                                                             //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_nmt_batch.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testAll(void);
+static void    testGroups(void);
+static void    testRemove(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testAll();
+   testGroups();
+   testRemove();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testAll()                                                                                                          //
+// all devices are released together when the scan has settled                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testAll(void)
+{
+   CoNmtBatch  clBatchT;
+   uint8_t     aubNodeIdT[CO_NMT_BATCH_NODE_MAX];
+
+   CO_TEST_CHECK(clBatchT.isEnabled() == false);
+   clBatchT.setGroupSize(CO_NMT_BATCH_ALL);
+   CO_TEST_CHECK(clBatchT.isEnabled());
+   CO_TEST_EQUAL(clBatchT.release(true, 10000000, &aubNodeIdT[0]), 0);
+
+   clBatchT.addNode(30, 1000);
+   clBatchT.addNode(3, 2000);
+   clBatchT.addNode(17, 3000);
+   clBatchT.addNode(17, 4000);
+   clBatchT.addNode(0, 5000);
+   clBatchT.addNode(CO_NMT_BATCH_NODE_MAX + 1, 5000);
+   CO_TEST_EQUAL(clBatchT.count(), 3);
+   CO_TEST_CHECK(clBatchT.isWaiting(17));
+
+   //---------------------------------------------------------------------------------------------------
+   // the settle time starts with the last added device, also if it was added before
+   //
+   CO_TEST_EQUAL(clBatchT.release(false, 4000 + CO_NMT_BATCH_SETTLE, &aubNodeIdT[0]), 0);
+   CO_TEST_EQUAL(clBatchT.release(true, 4000 + CO_NMT_BATCH_SETTLE - 1, &aubNodeIdT[0]), 0);
+   CO_TEST_EQUAL(clBatchT.release(true, 4000 + CO_NMT_BATCH_SETTLE, nullptr), 0);
+
+   CO_TEST_EQUAL(clBatchT.release(true, 4000 + CO_NMT_BATCH_SETTLE, &aubNodeIdT[0]), 3);
+   CO_TEST_EQUAL(aubNodeIdT[0], 3);
+   CO_TEST_EQUAL(aubNodeIdT[1], 17);
+   CO_TEST_EQUAL(aubNodeIdT[2], 30);
+   CO_TEST_EQUAL(clBatchT.count(), 0);
+   CO_TEST_CHECK(clBatchT.isWaiting(17) == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // a shorter settle time
+   //
+   clBatchT.setSettleTime(1000);
+   clBatchT.addNode(5, 100000);
+   CO_TEST_EQUAL(clBatchT.release(true, 100999, &aubNodeIdT[0]), 0);
+   CO_TEST_EQUAL(clBatchT.release(true, 101000, &aubNodeIdT[0]), 1);
+   CO_TEST_EQUAL(aubNodeIdT[0], 5);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testGroups()                                                                                                       //
+// a full group is released while the scan is running, the rest after the scan                                      //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testGroups(void)
+{
+   CoNmtBatch  clBatchT;
+   uint8_t     aubNodeIdT[CO_NMT_BATCH_NODE_MAX];
+
+   clBatchT.setGroupSize(4);
+   for (uint8_t ubNodeIdT = 10; ubNodeIdT > 0; ubNodeIdT--)
+   {
+      clBatchT.addNode(ubNodeIdT, 1000);
+   }
+
+   CO_TEST_EQUAL(clBatchT.release(false, 1000, &aubNodeIdT[0]), 4);
+   CO_TEST_EQUAL(aubNodeIdT[0], 1);
+   CO_TEST_EQUAL(aubNodeIdT[3], 4);
+   CO_TEST_EQUAL(clBatchT.release(false, 1000, &aubNodeIdT[0]), 4);
+   CO_TEST_EQUAL(aubNodeIdT[0], 5);
+   CO_TEST_EQUAL(aubNodeIdT[3], 8);
+   CO_TEST_EQUAL(clBatchT.count(), 2);
+
+   CO_TEST_EQUAL(clBatchT.release(false, 1000 + CO_NMT_BATCH_SETTLE, &aubNodeIdT[0]), 0);
+   CO_TEST_EQUAL(clBatchT.release(true, 1000 + CO_NMT_BATCH_SETTLE, &aubNodeIdT[0]), 2);
+   CO_TEST_EQUAL(aubNodeIdT[0], 9);
+   CO_TEST_EQUAL(aubNodeIdT[1], 10);
+   CO_TEST_EQUAL(clBatchT.count(), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testRemove()                                                                                                       //
+// a removed device is not released                                                                                   //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testRemove(void)
+{
+   CoNmtBatch  clBatchT;
+   uint8_t     aubNodeIdT[CO_NMT_BATCH_NODE_MAX];
+
+   clBatchT.setGroupSize(2);
+   clBatchT.addNode(7, 0);
+   clBatchT.addNode(8, 0);
+   clBatchT.removeNode(7);
+   clBatchT.removeNode(7);
+   clBatchT.removeNode(0);
+   CO_TEST_EQUAL(clBatchT.count(), 1);
+   CO_TEST_CHECK(clBatchT.isWaiting(7) == false);
+
+   CO_TEST_EQUAL(clBatchT.release(false, 0, &aubNodeIdT[0]), 0);
+   clBatchT.addNode(9, 0);
+   CO_TEST_EQUAL(clBatchT.release(false, 0, &aubNodeIdT[0]), 2);
+   CO_TEST_EQUAL(aubNodeIdT[0], 8);
+   CO_TEST_EQUAL(aubNodeIdT[1], 9);
+
+   clBatchT.addNode(1, 0);
+   clBatchT.reset();
+   CO_TEST_EQUAL(clBatchT.count(), 0);
+   CO_TEST_EQUAL(clBatchT.release(true, CO_NMT_BATCH_SETTLE, &aubNodeIdT[0]), 0);
+}
@@ -0,0 +1,286 @@
+//====================================================================================================================//
+// File:          co_recovery_scheduler_test.cpp                                                                      //
+// Description:   Unit test of CoRecoveryScheduler                                                                    //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_recovery_scheduler.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_TICK                  ((uint32_t)  10000)        // timer tick in micro-seconds
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testBackoff(void);
+static void    testBatch(void);
+static void    testDebounce(void);
+static void    testRecovery(void);
+static void    testSegment(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testDebounce();
+   testRecovery();
+   testBatch();
+   testBackoff();
+   testSegment();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testBackoff()                                                                                                      //
+// a node which does not boot is reset again after 2 s, 4 s, 8 s, .. 64 s                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testBackoff(void)
+{
+   static const uint32_t  aulBackoffS[] = { 2, 4, 8, 16, 32, 64, 64 };
+   CoRecoveryScheduler    clRecoveryT;
+   uint64_t               uqTimeT    = 0;
+   uint64_t               uqResetT   = 0;
+   uint32_t               ulResetCntT = 0;
+
+   clRecoveryT.setBatchSize(1);
+   clRecoveryT.reset();
+   clRecoveryT.lostNode(9);
+
+   while (ulResetCntT <= (sizeof(aulBackoffS) / sizeof(aulBackoffS[0])))
+   {
+      clRecoveryT.tick(TEST_TICK);
+      uqTimeT += TEST_TICK;
+
+      if (clRecoveryT.nextReset() == 9)
+      {
+         if (ulResetCntT > 0)
+         {
+            CO_TEST_EQUAL(uqTimeT - uqResetT, (uint64_t) aulBackoffS[ulResetCntT - 1] * 1000000);
+         }
+         uqResetT = uqTimeT;
+         ulResetCntT++;
+      }
+      CO_TEST_CHECK(uqTimeT < 300000000);
+      if (uqTimeT >= 300000000)
+      {
+         break;
+      }
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // a heartbeat ends the recovery, the next loss starts with the shortest backoff
+   //
+   clRecoveryT.nodeAlive(9);
+   CO_TEST_EQUAL(clRecoveryT.state(9), eCO_RECOVERY_STATE_NONE);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 0);
+
+   clRecoveryT.tick(CO_RECOVERY_INTERVAL);
+   clRecoveryT.lostNode(9);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 9);
+   clRecoveryT.tick(CO_RECOVERY_BACKOFF_BASE);
+   CO_TEST_EQUAL(clRecoveryT.state(9), eCO_RECOVERY_STATE_RESET_WAIT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testBatch()                                                                                                        //
+// resets and scans are limited per batch interval, the node which waits longest is first                             //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testBatch(void)
+{
+   CoRecoveryScheduler clRecoveryT;
+
+   clRecoveryT.setBatchSize(2);
+   clRecoveryT.reset();
+
+   clRecoveryT.lostNode(40);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE / 2);
+   clRecoveryT.lostNode(30);
+   clRecoveryT.lostNode(20);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE / 2);
+   CO_TEST_EQUAL(clRecoveryT.state(40), eCO_RECOVERY_STATE_RESET_WAIT);
+   CO_TEST_EQUAL(clRecoveryT.state(30), eCO_RECOVERY_STATE_LOST);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE / 2);
+
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 40);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 20);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 0);
+   CO_TEST_EQUAL(clRecoveryT.state(30), eCO_RECOVERY_STATE_RESET_WAIT);
+
+   clRecoveryT.tick(CO_RECOVERY_INTERVAL);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 30);
+
+   //---------------------------------------------------------------------------------------------------
+   // the scans are handed out in the order of the boot-up messages
+   //
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(30));
+   clRecoveryT.tick(TEST_TICK);
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(20));
+   clRecoveryT.tick(TEST_TICK);
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(40));
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(40));
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 3);
+
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 30);
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 20);
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 0);
+   clRecoveryT.tick(CO_RECOVERY_INTERVAL);
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 40);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testDebounce()                                                                                                     //
+// a node which shows up within the debounce time is not reset                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testDebounce(void)
+{
+   CoRecoveryScheduler clRecoveryT;
+
+   CO_TEST_CHECK(clRecoveryT.isEnabled() == false);
+   clRecoveryT.setBatchSize(2);
+   clRecoveryT.reset();
+   CO_TEST_CHECK(clRecoveryT.isEnabled());
+
+   CO_TEST_CHECK(clRecoveryT.lostNode(5) == false);
+   CO_TEST_CHECK(clRecoveryT.lostNode(0) == false);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_LOST);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 1);
+
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE - TEST_TICK);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 0);
+   clRecoveryT.nodeAlive(5);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_NONE);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 0);
+
+   //---------------------------------------------------------------------------------------------------
+   // a boot-up message within the debounce time starts the scan without reset
+   //
+   clRecoveryT.lostNode(6);
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(6));
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(7) == false);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE);
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 0);
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 6);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testRecovery()                                                                                                     //
+// states of a node from the heartbeat loss to the new scan                                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testRecovery(void)
+{
+   CoRecoveryScheduler clRecoveryT;
+
+   clRecoveryT.setBatchSize(2);
+   clRecoveryT.reset();
+
+   clRecoveryT.lostNode(5);
+   clRecoveryT.tick(CO_RECOVERY_DEBOUNCE);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_RESET_WAIT);
+
+   //---------------------------------------------------------------------------------------------------
+   // another loss report of a node in recovery is ignored
+   //
+   CO_TEST_CHECK(clRecoveryT.lostNode(5) == false);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_RESET_WAIT);
+
+   CO_TEST_EQUAL(clRecoveryT.nextReset(), 5);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_RESET_SENT);
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 0);
+
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(5));
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_RESCAN_WAIT);
+
+   //---------------------------------------------------------------------------------------------------
+   // the heartbeat of the booted node does not remove it from the queue of the scans
+   //
+   clRecoveryT.nodeAlive(5);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_RESCAN_WAIT);
+
+   CO_TEST_EQUAL(clRecoveryT.nextRescan(), 5);
+   CO_TEST_EQUAL(clRecoveryT.state(5), eCO_RECOVERY_STATE_NONE);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), 0);
+   CO_TEST_CHECK(clRecoveryT.nodeBooted(5) == false);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testSegment()                                                                                                      //
+// several losses within the debounce time are reported once as segment failure                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testSegment(void)
+{
+   CoRecoveryScheduler clRecoveryT;
+
+   clRecoveryT.setBatchSize(2);
+   clRecoveryT.reset();
+
+   //---------------------------------------------------------------------------------------------------
+   // losses which are farther apart
+   //
+   for (uint8_t ubNodeIdT = 1; ubNodeIdT <= CO_RECOVERY_SEGMENT_MIN; ubNodeIdT++)
+   {
+      CO_TEST_CHECK(clRecoveryT.lostNode(ubNodeIdT) == false);
+      clRecoveryT.tick(CO_RECOVERY_DEBOUNCE + TEST_TICK);
+   }
+   CO_TEST_EQUAL(clRecoveryT.segmentFailures(), 0);
+
+   for (uint8_t ubNodeIdT = 11; ubNodeIdT < 11 + CO_RECOVERY_SEGMENT_MIN - 1; ubNodeIdT++)
+   {
+      CO_TEST_CHECK(clRecoveryT.lostNode(ubNodeIdT) == false);
+      clRecoveryT.tick(TEST_TICK);
+   }
+   CO_TEST_CHECK(clRecoveryT.lostNode(20));
+   CO_TEST_CHECK(clRecoveryT.lostNode(21) == false);
+   CO_TEST_EQUAL(clRecoveryT.segmentFailures(), 1);
+   CO_TEST_EQUAL(clRecoveryT.recoveryCount(), (2 * CO_RECOVERY_SEGMENT_MIN) + 1);
+}
@@ -0,0 +1,360 @@
+//====================================================================================================================//
+// File:          co_scan_scheduler_test.cpp                                                                          //
+// Description:   Unit test of CoScanScheduler                                                                        //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_scan_scheduler.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testBusLoadLimit(void);
+static void    testDefer(void);
+static void    testParallel(void);
+static void    testQuarantine(void);
+static void    testReconfigure(void);
+static void    testRetry(void);
+static void    testSequence(void);
+static void    testVerify(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testSequence();
+   testParallel();
+   testRetry();
+   testVerify();
+   testDefer();
+   testQuarantine();
+   testReconfigure();
+   testBusLoadLimit();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testBusLoadLimit()                                                                                                 //
+// a new scan is only started if the budget covers the frames of one scan                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testBusLoadLimit(void)
+{
+   CoScanScheduler clSchedulerT;
+   uint32_t        ulScanTimeT;
+
+   //---------------------------------------------------------------------------------------------------
+   // 10 % of 500 kbit/s: the bits of one scan are available after ulScanTimeT micro-seconds
+   //
+   ulScanTimeT = (CO_SCAN_FRAMES_PER_NODE * CO_SCAN_BITS_PER_FRAME * 1000000) / 50000;
+
+   clSchedulerT.setMaxParallel(8);
+   clSchedulerT.setBusLoadLimit(10, 500000);
+   clSchedulerT.addNode(1);
+   clSchedulerT.addNode(2);
+
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 1);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.tick(ulScanTimeT / 2);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.tick(ulScanTimeT / 2 + 1);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 2);
+
+   //---------------------------------------------------------------------------------------------------
+   // the budget is limited to one scan, a long idle time does not allow a burst
+   //
+   clSchedulerT.addNode(3);
+   clSchedulerT.addNode(4);
+   clSchedulerT.tick(ulScanTimeT * 10);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 3);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   //---------------------------------------------------------------------------------------------------
+   // a deferred node is not charged
+   //
+   clSchedulerT.deferNode(1, 0);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testDefer()                                                                                                        //
+// a deferred node frees its slot and continues with its state after the delay                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testDefer(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   clSchedulerT.addNode(5);
+   clSchedulerT.addNode(6);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 5);
+   clSchedulerT.nodeIdentified(5);
+
+   clSchedulerT.deferNode(5, 1000);
+   CO_TEST_EQUAL(clSchedulerT.activeCount(), 0);
+   CO_TEST_EQUAL(clSchedulerT.state(5), eCO_SCAN_STATE_BOOTED);
+   CO_TEST_EQUAL(clSchedulerT.retryCount(5), 0);
+
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 6);
+   clSchedulerT.nodeOperational(6);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.tick(1000);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 5);
+   CO_TEST_EQUAL(clSchedulerT.state(5), eCO_SCAN_STATE_CONFIG_HEARTBEAT);
+
+   //---------------------------------------------------------------------------------------------------
+   // an inactive node can't be deferred
+   //
+   clSchedulerT.deferNode(6, 0);
+   CO_TEST_EQUAL(clSchedulerT.state(6), eCO_SCAN_STATE_OPERATIONAL);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testParallel()                                                                                                     //
+// the number of active nodes is limited, queued nodes are scanned in the order of their boot-up                      //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testParallel(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   clSchedulerT.setMaxParallel(2);
+   clSchedulerT.addNode(10);
+   clSchedulerT.addNode(3);
+   clSchedulerT.addNode(7);
+   clSchedulerT.addNode(3);
+   clSchedulerT.addNode(0);
+   clSchedulerT.addNode(CO_SCAN_NODE_MAX + 1);
+
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 10);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 3);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+   CO_TEST_EQUAL(clSchedulerT.activeCount(), 2);
+
+   //---------------------------------------------------------------------------------------------------
+   // a boot-up of an active node does not restart its scan
+   //
+   clSchedulerT.addNode(10);
+   clSchedulerT.nodeOperational(3);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 7);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.nodeFailed(10);
+   clSchedulerT.nodeOperational(7);
+   CO_TEST_EQUAL(clSchedulerT.state(10), eCO_SCAN_STATE_FAILED);
+   CO_TEST_CHECK(clSchedulerT.isIdle());
+
+   //---------------------------------------------------------------------------------------------------
+   // the minimum is one scan
+   //
+   clSchedulerT.setMaxParallel(0);
+   clSchedulerT.addNode(1);
+   clSchedulerT.addNode(2);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 1);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testQuarantine()                                                                                                   //
+// a quarantined node is not scanned until it is released and boots again                                           //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testQuarantine(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   clSchedulerT.addNode(4);
+   clSchedulerT.addNode(8);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 4);
+
+   clSchedulerT.quarantineNode(4);
+   clSchedulerT.quarantineNode(8);
+   CO_TEST_EQUAL(clSchedulerT.activeCount(), 0);
+   CO_TEST_CHECK(clSchedulerT.isIdle());
+   CO_TEST_EQUAL(clSchedulerT.state(4), eCO_SCAN_STATE_QUARANTINED);
+
+   clSchedulerT.addNode(4);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.releaseNode(4);
+   CO_TEST_EQUAL(clSchedulerT.state(4), eCO_SCAN_STATE_IDLE);
+   clSchedulerT.addNode(4);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 4);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testReconfigure()                                                                                                  //
+// only an operational node is queued for a new heartbeat configuration                                              //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testReconfigure(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   clSchedulerT.addNode(9);
+   CO_TEST_CHECK(clSchedulerT.reconfigureNode(9) == false);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 9);
+   CO_TEST_CHECK(clSchedulerT.reconfigureNode(9) == false);
+   clSchedulerT.nodeOperational(9);
+
+   CO_TEST_CHECK(clSchedulerT.reconfigureNode(9));
+   CO_TEST_CHECK(clSchedulerT.reconfigureNode(9) == false);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 9);
+   CO_TEST_EQUAL(clSchedulerT.state(9), eCO_SCAN_STATE_CONFIG_HEARTBEAT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testRetry()                                                                                                        //
+// a timeout repeats the failed step after an exponential backoff, the node fails after the last retry               //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testRetry(void)
+{
+   CoScanScheduler clSchedulerT;
+   uint32_t        ulBackoffT = CO_SCAN_BACKOFF_BASE * 1000;
+
+   clSchedulerT.setRetryMax(2);
+   clSchedulerT.addNode(12);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 12);
+   clSchedulerT.nodeIdentified(12);
+
+   CO_TEST_CHECK(clSchedulerT.nodeTimeout(12));
+   CO_TEST_EQUAL(clSchedulerT.retryCount(12), 1);
+   CO_TEST_CHECK(clSchedulerT.isIdle() == false);
+   clSchedulerT.tick(ulBackoffT - 1);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+   clSchedulerT.tick(1);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 12);
+   CO_TEST_EQUAL(clSchedulerT.state(12), eCO_SCAN_STATE_CONFIG_HEARTBEAT);
+
+   //---------------------------------------------------------------------------------------------------
+   // the second backoff is twice as long, a node waiting for its retry does not block others
+   //
+   CO_TEST_CHECK(clSchedulerT.nodeTimeout(12));
+   clSchedulerT.addNode(13);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 13);
+   clSchedulerT.nodeOperational(13);
+   clSchedulerT.tick(ulBackoffT);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+   clSchedulerT.tick(ulBackoffT);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 12);
+
+   CO_TEST_CHECK(clSchedulerT.nodeTimeout(12) == false);
+   CO_TEST_EQUAL(clSchedulerT.state(12), eCO_SCAN_STATE_FAILED);
+   CO_TEST_CHECK(clSchedulerT.isIdle());
+
+   //---------------------------------------------------------------------------------------------------
+   // a new boot-up starts the scan again without retries
+   //
+   clSchedulerT.addNode(12);
+   CO_TEST_EQUAL(clSchedulerT.retryCount(12), 0);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 12);
+   CO_TEST_EQUAL(clSchedulerT.state(12), eCO_SCAN_STATE_IDENTIFYING);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testSequence()                                                                                                     //
+// states of a node during a complete scan                                                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testSequence(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   CO_TEST_CHECK(clSchedulerT.isIdle());
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 0);
+
+   clSchedulerT.addNode(1);
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_BOOTED);
+   CO_TEST_CHECK(clSchedulerT.isIdle() == false);
+
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 1);
+   CO_TEST_CHECK(clSchedulerT.isActive(1));
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_IDENTIFYING);
+
+   clSchedulerT.nodeIdentified(1);
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_CONFIG_HEARTBEAT);
+
+   clSchedulerT.nodeConfigPdo(1);
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_CONFIG_PDO);
+   CO_TEST_EQUAL(clSchedulerT.activeCount(), 1);
+
+   clSchedulerT.nodeOperational(1);
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_OPERATIONAL);
+   CO_TEST_CHECK(clSchedulerT.isActive(1) == false);
+   CO_TEST_CHECK(clSchedulerT.isIdle());
+
+   //---------------------------------------------------------------------------------------------------
+   // events of an inactive node are ignored
+   //
+   clSchedulerT.nodeIdentified(1);
+   CO_TEST_CHECK(clSchedulerT.nodeTimeout(1) == false);
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_OPERATIONAL);
+
+   clSchedulerT.reset();
+   CO_TEST_EQUAL(clSchedulerT.state(1), eCO_SCAN_STATE_IDLE);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testVerify()                                                                                                       //
+// a cached identity is verified, a mismatch reads the identity                                                       //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testVerify(void)
+{
+   CoScanScheduler clSchedulerT;
+
+   clSchedulerT.setMaxParallel(2);
+   clSchedulerT.addNode(20, true);
+   clSchedulerT.addNode(21, true);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 20);
+   CO_TEST_EQUAL(clSchedulerT.nextNode(), 21);
+   CO_TEST_EQUAL(clSchedulerT.state(20), eCO_SCAN_STATE_VERIFYING);
+
+   clSchedulerT.nodeVerified(20, true);
+   clSchedulerT.nodeVerified(21, false);
+   CO_TEST_EQUAL(clSchedulerT.state(20), eCO_SCAN_STATE_CONFIG_HEARTBEAT);
+   CO_TEST_EQUAL(clSchedulerT.state(21), eCO_SCAN_STATE_IDENTIFYING);
+   CO_TEST_EQUAL(clSchedulerT.activeCount(), 2);
+}
@@ -0,0 +1,163 @@
+//====================================================================================================================//
+// File:          co_spsc_queue_test.cpp                                                                              //
+// Description:   Unit test of CoSpscQueue                                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_spsc_queue.hpp"
+#include "co_test.hpp"
+
+#include <thread>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_ELEMENT_CNT           ((uint32_t) 1000000)       // elements passed between the threads
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static void    testFillAndDrain(void);
+static void    testThreads(void);
+static void    testWrapAround(void);
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testFillAndDrain();
+   testWrapAround();
+   testThreads();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testFillAndDrain()                                                                                                 //
+// the queue holds SIZE - 1 elements in FIFO order                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testFillAndDrain(void)
+{
+   CoSpscQueue<uint32_t, 8>   clQueueT;
+   uint32_t                   ulValueT = 0;
+
+   CO_TEST_CHECK(clQueueT.isEmpty());
+   CO_TEST_CHECK(clQueueT.pop(ulValueT) == false);
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 7; ulIdxT++)
+   {
+      CO_TEST_CHECK(clQueueT.push(100 + ulIdxT));
+   }
+   CO_TEST_CHECK(clQueueT.push(200) == false);
+   CO_TEST_CHECK(clQueueT.isEmpty() == false);
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 7; ulIdxT++)
+   {
+      ulValueT = 0;
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, 100 + ulIdxT);
+   }
+   CO_TEST_CHECK(clQueueT.pop(ulValueT) == false);
+   CO_TEST_CHECK(clQueueT.isEmpty());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testThreads()                                                                                                      //
+// one producer and one consumer thread, no element is lost or reordered                                             //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testThreads(void)
+{
+   static CoSpscQueue<uint32_t, 64>  clQueueS;
+   uint32_t                          ulExpectT = 0;
+   uint32_t                          ulValueT;
+   bool                              btOrderT  = true;
+
+   std::thread clProducerT([]() {
+      for (uint32_t ulIdxT = 0; ulIdxT < TEST_ELEMENT_CNT; ulIdxT++)
+      {
+         while (clQueueS.push(ulIdxT) == false)
+         {
+            std::this_thread::yield();
+         }
+      }
+   });
+
+   while (ulExpectT < TEST_ELEMENT_CNT)
+   {
+      if (clQueueS.pop(ulValueT))
+      {
+         if (ulValueT != ulExpectT)
+         {
+            btOrderT = false;
+         }
+         ulExpectT++;
+      }
+   }
+   clProducerT.join();
+
+   CO_TEST_CHECK(btOrderT);
+   CO_TEST_CHECK(clQueueS.isEmpty());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testWrapAround()                                                                                                   //
+// the indices wrap around many times                                                                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testWrapAround(void)
+{
+   CoSpscQueue<uint32_t, 4>   clQueueT;
+   uint32_t                   ulValueT = 0;
+
+   for (uint32_t ulIdxT = 0; ulIdxT < 100; ulIdxT++)
+   {
+      CO_TEST_CHECK(clQueueT.push(ulIdxT));
+      CO_TEST_CHECK(clQueueT.push(ulIdxT + 1000));
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, ulIdxT);
+      CO_TEST_CHECK(clQueueT.pop(ulValueT));
+      CO_TEST_EQUAL(ulValueT, ulIdxT + 1000);
+   }
+   CO_TEST_CHECK(clQueueT.isEmpty());
+}
@@ -0,0 +1,117 @@
+//====================================================================================================================//
+// File:          co_test.hpp                                                                                         //
+// Description:   Checks of the unit tests                                                                            //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+//------------------------------------------------------------------------------------------------------
+/*!
+** \file    co_test.hpp
+** \brief   Checks of the unit tests
+**
+** Each unit test is a program without Qt and without CAN interface. A failed check prints the
+** location and the expression to stderr, the exit code of the test is the result of
+** coTestResult().
+*/
+#ifndef CO_TEST_HPP_
+#define CO_TEST_HPP_
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+//-------------------------------------------------------------------------------------------------------------
+// check a condition, the test continues after a failed check
+//
+#define  CO_TEST_CHECK(cond)        coTestCheck((cond), #cond, __FILE__, __LINE__)
+
+//-------------------------------------------------------------------------------------------------------------
+// check two integer values, both values are printed if they are not equal
+//
+#define  CO_TEST_EQUAL(a, b)        coTestEqual((int64_t) (a), (int64_t) (b), #a, #b, __FILE__, __LINE__)
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Functions                                                                                                          **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+//-------------------------------------------------------------------------------------------------------------
+// number of failed checks of the test program
+//
+static uint32_t ulTestFailCntS = 0;
+
+
+static inline void coTestCheck(bool btConditionV, const char * szExprV, const char * szFileV, int32_t slLineV)
+{
+   if (btConditionV == false)
+   {
+      fprintf(stderr, "%s:%d: check failed: %s\n", szFileV, slLineV, szExprV);
+      ulTestFailCntS++;
+   }
+}
+
+
+static inline void coTestEqual(int64_t sqValueV, int64_t sqExpectV, const char * szValueV, const char * szExpectV,
+                               const char * szFileV, int32_t slLineV)
+{
+   if (sqValueV != sqExpectV)
+   {
+      fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", szFileV, slLineV, szValueV, szExpectV,
+              (long long) sqValueV, (long long) sqExpectV);
+      ulTestFailCntS++;
+   }
+}
+
+
+//-------------------------------------------------------------------------------------------------------------
+// exit code of the test program
+//
+static inline int coTestResult(void)
+{
+   if (ulTestFailCntS > 0)
+   {
+      fprintf(stderr, "%u check(s) failed\n", ulTestFailCntS);
+      return (1);
+   }
+   return (0);
+}
+
+
+#endif /*CO_TEST_HPP_*/
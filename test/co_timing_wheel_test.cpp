@@ -0,0 +1,271 @@
+//====================================================================================================================//
+// File:          co_timing_wheel_test.cpp                                                                            //
+// Description:   Unit test of CoTimingWheel                                                                          //
+//                                                                                                                    //
+// Copyright (C) MicroControl GmbH & Co. KG                                                                           //
+// 53844 Troisdorf - Germany                                                                                          //
+// www.microcontrol.net                                                                                               //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the   //
+// following conditions are met:                                                                                      //
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions, the following   //
+//    disclaimer and the referenced file 'LICENSE'.                                                                   //
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       //
+//    following disclaimer in the documentation and/or other materials provided with the distribution.                //
+// 3. Neither the name of MicroControl nor the names of its contributors may be used to endorse or promote products   //
+//    derived from this software without specific prior written permission.                                           //
+//                                                                                                                    //
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance     //
+// with the License.                                                                                                  //
+// You may obtain a copy of the License at                                                                            //
+//                                                                                                                    //
+//    http://www.apache.org/licenses/LICENSE-2.0                                                                      //
+//                                                                                                                    //
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed   //
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for  //
+// the specific language governing permissions and limitations under the License.                                     //                                                                                  //
+//                                                                                                                    //
+//====================================================================================================================//
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Include files                                                                                                      **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#include "co_timing_wheel.hpp"
+#include "co_test.hpp"
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Definitions                                                                                                        **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+#define  TEST_TIMER_CNT             ((uint32_t)    500)        // timers of the random test
+#define  TEST_TICK_CNT              ((uint64_t) 3000000)       // ticks of the random test
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Internal functions                                                                                                 **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t   randomValue(void);
+static void       testCancel(void);
+static void       testLimits(void);
+static void       testLevels(void);
+static void       testRandom(void);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*\
+** Static variables                                                                                                   **
+**                                                                                                                    **
+\*--------------------------------------------------------------------------------------------------------------------*/
+
+static uint32_t   ulRandomS = 0x12345678;
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// main()                                                                                                             //
+//                                                                                                                    //
+//--------------------------------------------------------------------------------------------------------------------//
+int main(void)
+{
+   testLevels();
+   testCancel();
+   testLimits();
+   testRandom();
+
+   return (coTestResult());
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// randomValue()                                                                                                      //
+// pseudo random numbers (xorshift), the sequence is the same for each run                                            //
+//--------------------------------------------------------------------------------------------------------------------//
+static uint32_t randomValue(void)
+{
+   ulRandomS ^= ulRandomS << 13;
+   ulRandomS ^= ulRandomS >> 17;
+   ulRandomS ^= ulRandomS << 5;
+
+   return (ulRandomS);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testCancel()                                                                                                       //
+// a cancelled timer does not expire, a restarted timer expires once with its new time                                //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testCancel(void)
+{
+   CoTimingWheel     clWheelT;
+   CoWheelTimer_ts   tsTimerAT;
+   CoWheelTimer_ts   tsTimerBT;
+
+   CoTimingWheel::init(tsTimerAT, 1);
+   CoTimingWheel::init(tsTimerBT, 2);
+   CO_TEST_CHECK(CoTimingWheel::isPending(tsTimerAT) == false);
+
+   clWheelT.cancel(tsTimerAT);
+   CO_TEST_EQUAL(clWheelT.count(), 0);
+
+   clWheelT.start(tsTimerAT, 1000);
+   clWheelT.start(tsTimerBT, 1000);
+   CO_TEST_CHECK(CoTimingWheel::isPending(tsTimerAT));
+   CO_TEST_EQUAL(clWheelT.count(), 2);
+
+   clWheelT.cancel(tsTimerAT);
+   clWheelT.start(tsTimerBT, 2000);
+   CO_TEST_EQUAL(clWheelT.count(), 1);
+
+   CO_TEST_EQUAL(clWheelT.advance(1999), 0);
+   CO_TEST_EQUAL(clWheelT.advance(2000), 1);
+   CO_TEST_CHECK(clWheelT.nextExpired() == &tsTimerBT);
+   CO_TEST_CHECK(clWheelT.nextExpired() == nullptr);
+   CO_TEST_CHECK(CoTimingWheel::isPending(tsTimerBT) == false);
+
+   //---------------------------------------------------------------------------------------------------
+   // an expired timer which has not been fetched can be cancelled
+   //
+   clWheelT.start(tsTimerAT, 2100);
+   CO_TEST_EQUAL(clWheelT.advance(2200), 1);
+   clWheelT.cancel(tsTimerAT);
+   CO_TEST_EQUAL(clWheelT.count(), 0);
+   CO_TEST_CHECK(clWheelT.nextExpired() == nullptr);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testLevels()                                                                                                       //
+// timers of all levels expire with their tick                                                                        //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testLevels(void)
+{
+   static const uint64_t  auqExpiryS[] = { 0, 1, 255, 256, 257, 16383, 16384, 16385, 500000, 1048575 };
+   const uint32_t         ulTimerCntT  = sizeof(auqExpiryS) / sizeof(auqExpiryS[0]);
+   CoTimingWheel          clWheelT;
+   CoWheelTimer_ts        atsTimerT[ulTimerCntT];
+   CoWheelTimer_ts *      ptsTimerT;
+
+   for (uint32_t ulIdxT = 0; ulIdxT < ulTimerCntT; ulIdxT++)
+   {
+      CoTimingWheel::init(atsTimerT[ulIdxT], ulIdxT);
+      clWheelT.start(atsTimerT[ulIdxT], auqExpiryS[ulIdxT]);
+   }
+
+   for (uint32_t ulIdxT = 0; ulIdxT < ulTimerCntT; ulIdxT++)
+   {
+      if (auqExpiryS[ulIdxT] > 0)
+      {
+         CO_TEST_EQUAL(clWheelT.advance(auqExpiryS[ulIdxT] - 1), 0);
+      }
+      CO_TEST_EQUAL(clWheelT.advance(auqExpiryS[ulIdxT]), 1);
+
+      ptsTimerT = clWheelT.nextExpired();
+      CO_TEST_CHECK(ptsTimerT != nullptr);
+      if (ptsTimerT != nullptr)
+      {
+         CO_TEST_EQUAL(ptsTimerT->ulId, ulIdxT);
+      }
+   }
+
+   CO_TEST_EQUAL(clWheelT.count(), 0);
+   CO_TEST_EQUAL(clWheelT.now(), 1048576);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testLimits()                                                                                                       //
+// a timer in the past expires with the next tick, a timer beyond the range is limited                               //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testLimits(void)
+{
+   CoTimingWheel     clWheelT;
+   CoWheelTimer_ts   tsTimerT;
+
+   CoTimingWheel::init(tsTimerT, 7);
+   clWheelT.reset(5000);
+
+   clWheelT.start(tsTimerT, 10);
+   CO_TEST_EQUAL(clWheelT.advance(5000), 1);
+   CO_TEST_CHECK(clWheelT.nextExpired() == &tsTimerT);
+
+   clWheelT.start(tsTimerT, 10 * CO_WHEEL_RANGE);
+   CO_TEST_EQUAL(clWheelT.advance(5000 + CO_WHEEL_RANGE - 1), 0);
+   CO_TEST_EQUAL(clWheelT.advance(5000 + CO_WHEEL_RANGE), 1);
+   CO_TEST_CHECK(clWheelT.nextExpired() == &tsTimerT);
+}
+
+
+//--------------------------------------------------------------------------------------------------------------------//
+// testRandom()                                                                                                       //
+// timers with random expiry times, which are cancelled and restarted at random ticks                                 //
+//--------------------------------------------------------------------------------------------------------------------//
+static void testRandom(void)
+{
+   static CoTimingWheel    clWheelS;
+   static CoWheelTimer_ts  atsTimerS[TEST_TIMER_CNT];
+   CoWheelTimer_ts *       ptsTimerT;
+   uint64_t                uqTickT    = 0;
+   uint32_t                ulLateT    = 0;
+   uint32_t                ulLostT    = 0;
+   uint32_t                ulExpiredT = 0;
+
+   clWheelS.reset(1);
+   for (uint32_t ulIdxT = 0; ulIdxT < TEST_TIMER_CNT; ulIdxT++)
+   {
+      CoTimingWheel::init(atsTimerS[ulIdxT], ulIdxT);
+      clWheelS.start(atsTimerS[ulIdxT], 1 + (randomValue() % CO_WHEEL_RANGE));
+   }
+
+   while (uqTickT < TEST_TICK_CNT)
+   {
+      //-------------------------------------------------------------------------------------------
+      // advance by a random number of ticks, each expired timer must expire within this step
+      //
+      uint64_t uqLastT = uqTickT;
+
+      uqTickT += 1 + (randomValue() % 300);
+      clWheelS.advance(uqTickT);
+
+      while ((ptsTimerT = clWheelS.nextExpired()) != nullptr)
+      {
+         if ((ptsTimerT->uqExpiry <= uqLastT) || (ptsTimerT->uqExpiry > uqTickT))
+         {
+            ulLateT++;
+         }
+         ulExpiredT++;
+         clWheelS.start(*ptsTimerT, uqTickT + 1 + (randomValue() % (CO_WHEEL_RANGE / (1 + (randomValue() % 64)))));
+      }
+
+      //-------------------------------------------------------------------------------------------
+      // restart one random timer
+      //
+      ptsTimerT = &atsTimerS[randomValue() % TEST_TIMER_CNT];
+      if (randomValue() & 1)
+      {
+         clWheelS.cancel(*ptsTimerT);
+      }
+      clWheelS.start(*ptsTimerT, uqTickT + 1 + (randomValue() % CO_WHEEL_RANGE));
+   }
+
+   //---------------------------------------------------------------------------------------------------
+   // no timer has been lost
+   //
+   for (uint32_t ulIdxT = 0; ulIdxT < TEST_TIMER_CNT; ulIdxT++)
+   {
+      if ((CoTimingWheel::isPending(atsTimerS[ulIdxT]) == false) || (atsTimerS[ulIdxT].uqExpiry <= uqTickT))
+      {
+         ulLostT++;
+      }
+   }
+
+   CO_TEST_EQUAL(ulLateT, 0);
+   CO_TEST_EQUAL(ulLostT, 0);
+   CO_TEST_EQUAL(clWheelS.count(), TEST_TIMER_CNT);
+   CO_TEST_CHECK(ulExpiredT > TEST_TIMER_CNT);
+}